@@ -0,0 +1,118 @@
+"""Compare cochannel against queue.Queue and collections.deque for passing
+values from a producer thread to a consumer thread.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_channel.py
+"""
+from collections import deque
+from queue import Queue
+import threading
+from time import perf_counter, sleep
+
+from cotoolz import cochannel
+
+
+_done = object()
+
+
+def run_cochannel(n, capacity):
+    sink, source = cochannel(capacity)
+
+    def produce():
+        send = sink.send
+        for value in range(n):
+            send(value)
+        sink.close()
+
+    thread = threading.Thread(target=produce)
+    start = perf_counter()
+    thread.start()
+    count = sum(1 for _ in source)
+    thread.join()
+    assert count == n
+    return perf_counter() - start
+
+
+def run_queue(n, capacity):
+    q = Queue(capacity)
+
+    def produce():
+        put = q.put
+        for value in range(n):
+            put(value)
+        put(_done)
+
+    thread = threading.Thread(target=produce)
+    start = perf_counter()
+    thread.start()
+    get = q.get
+    count = 0
+    while get() is not _done:
+        count += 1
+    thread.join()
+    assert count == n
+    return perf_counter() - start
+
+
+def run_deque(n, capacity):
+    # deque has no blocking, so both sides poll
+    d = deque()
+
+    def produce():
+        append = d.append
+        for value in range(n):
+            while len(d) >= capacity:
+                sleep(0)
+            append(value)
+        append(_done)
+
+    thread = threading.Thread(target=produce)
+    start = perf_counter()
+    thread.start()
+    popleft = d.popleft
+    count = 0
+    while True:
+        try:
+            value = popleft()
+        except IndexError:
+            sleep(0)
+            continue
+        if value is _done:
+            break
+        count += 1
+    thread.join()
+    assert count == n
+    return perf_counter() - start
+
+
+def bench(run, n, capacity, reps):
+    return min(run(n, capacity) for _ in range(reps))
+
+
+def main(n=200000, reps=3):
+    print('%8s %14s %14s %16s %10s %10s' % (
+        'capacity',
+        'Queue ns/elt',
+        'deque ns/elt',
+        'cochannel ns/elt',
+        'vs Queue',
+        'vs deque',
+    ))
+    for capacity in (16, 256, 4096):
+        q = bench(run_queue, n, capacity, reps)
+        d = bench(run_deque, n, capacity, reps)
+        c = bench(run_cochannel, n, capacity, reps)
+        print('%8d %14.1f %14.1f %16.1f %9.2fx %9.2fx' % (
+            capacity,
+            q / n * 1e9,
+            d / n * 1e9,
+            c / n * 1e9,
+            q / c,
+            d / c,
+        ))
+
+
+if __name__ == '__main__':
+    main()
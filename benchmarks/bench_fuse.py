@@ -0,0 +1,68 @@
+"""Time the per-element cost of ``comap(f, comap(f, ... comap(f, src)))`` as
+the chain gets deeper, with and without construction-time fusion.
+
+The unfused chains keep a reference to every layer, which stops them from
+being fused. ``overhead`` is the time per element minus the time spent in
+``f`` itself.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_fuse.py
+"""
+from itertools import repeat
+from timeit import repeat as timeit_repeat
+
+from cotoolz import comap
+
+
+f = abs
+
+
+def fused(depth):
+    # a nested expression, like generated code, so each inner layer is a
+    # temporary
+    return eval(
+        'comap(f, ' * depth + 'repeat(1)' + ')' * depth,
+        {'comap': comap, 'f': f, 'repeat': repeat},
+    )
+
+
+def unfused(depth):
+    layers = [comap(f, repeat(1))]
+    for _ in range(depth - 1):
+        layers.append(comap(f, layers[-1]))
+    return layers[-1], layers
+
+
+def per_element(stmt, globals, number, reps):
+    return min(timeit_repeat(
+        stmt,
+        globals=globals,
+        number=number,
+        repeat=reps,
+    )) / number * 1e9
+
+
+def main(number=200000, reps=5, depths=(1, 2, 4, 8, 16)):
+    call = per_element('f(1)', {'f': f}, number, reps)
+    print('f(1): %.1f ns' % call)
+    print('%6s %12s %12s %14s %14s' % (
+        'depth', 'fused ns', 'unfused ns', 'fused ovh', 'unfused ovh'))
+    for depth in depths:
+        cm = fused(depth)
+        assert len(cm.fused) == depth - 1
+        a = per_element('step()', {'step': cm.__next__}, number, reps)
+        cm, layers = unfused(depth)
+        b = per_element('step()', {'step': cm.__next__}, number, reps)
+        print('%6d %12.1f %12.1f %14.1f %14.1f' % (
+            depth,
+            a,
+            b,
+            a - depth * call,
+            b - depth * call,
+        ))
+
+
+if __name__ == '__main__':
+    main()
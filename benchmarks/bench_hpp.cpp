@@ -0,0 +1,115 @@
+/* Time pipelines built with cotoolz.hpp.
+ *
+ * Build and run from the root of the repository after building cotoolz in
+ * place:
+ *
+ *     $ g++ -O2 -std=c++14 -Icotoolz/include $(python3-config --includes) \
+ *           benchmarks/bench_hpp.cpp -o bench_hpp \
+ *           $(python3-config --ldflags --embed)
+ *     $ PYTHONPATH=. ./bench_hpp
+ */
+#include <chrono>
+#include <cstdio>
+
+#include "cotoolz/cotoolz.hpp"
+
+namespace ctz = cotoolz;
+
+template<typename F>
+static void
+bench(const char *name, long n, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    long checksum = f(n);
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::printf("%-28s %8.1f ns/step (checksum %ld)\n", name, ns / n, checksum);
+}
+
+/* Run ``src`` and return the value it assigns to ``result``. */
+static ctz::ref
+run(const char *src)
+{
+    ctz::ref globals = ctz::ref::checked(PyDict_New());
+    if (PyDict_SetItemString(globals.get(),
+                             "__builtins__",
+                             PyEval_GetBuiltins())) {
+        throw ctz::error();
+    }
+    ctz::ref::checked(PyRun_String(src,
+                                   Py_file_input,
+                                   globals.get(),
+                                   globals.get()));
+    PyObject *result = PyDict_GetItemString(globals.get(), "result");
+    if (!result) {
+        PyErr_SetString(PyExc_KeyError, "result");
+        throw ctz::error();
+    }
+    return ctz::ref::borrow(result);
+}
+
+int
+main()
+{
+    Py_Initialize();
+    try {
+        ctz::import();
+        const long n = 1000000;
+
+        bench("native | native | native", n, [](long n) {
+            auto p = (ctz::native([](long a) { return a + 1; }) |
+                      ctz::native([](long a) { return a * 2; }) |
+                      ctz::native([](long a) { return a - 1; }));
+            long total = 0;
+            for (long m = 0; m < n; ++m) {
+                total += p(m);
+            }
+            return total;
+        });
+
+        bench("source | native | native", n, [](long n) {
+            auto p = (ctz::source<long>(ctz::coiter::make(run("result = iter(range(10 ** 9))"))) |
+                      (ctz::native([](long a) { return a + 1; }) |
+                       ctz::native([](long a) { return a * 2; })));
+            long total = 0;
+            for (long m = 0; m < n; ++m) {
+                total += p.next();
+            }
+            return total;
+        });
+
+        bench("native | python | native", n, [](long n) {
+            ctz::coroutine c(run("def echo():\n"
+                                 "    value = None\n"
+                                 "    while True:\n"
+                                 "        value = yield value\n"
+                                 "result = echo()\n"));
+            c.next();
+            auto p = (ctz::native([](long a) { return a + 1; }) |
+                      ctz::python<long>(std::move(c)) |
+                      ctz::native([](long a) { return a * 2; }));
+            long total = 0;
+            for (long m = 0; m < n; ++m) {
+                total += p(m);
+            }
+            return total;
+        });
+
+        bench("comap(f, comap(g, range))", n, [](long n) {
+            ctz::ref inner = run("result = iter(range(10 ** 9))");
+            ctz::comap g = ctz::comap::make(run("result = lambda a: a + 1"), inner);
+            ctz::ref gref = g.release();
+            ctz::comap f = ctz::comap::make(run("result = lambda a: a * 2"), gref);
+            long total = 0;
+            for (long m = 0; m < n; ++m) {
+                total += ctz::from_python<long>(f.next());
+            }
+            return total;
+        });
+    }
+    catch (const ctz::error&) {
+        PyErr_Print();
+        return 1;
+    }
+    return Py_FinalizeEx() < 0;
+}
@@ -0,0 +1,62 @@
+"""Compare comerge against heapq.merge for merging many sorted streams.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_merge.py
+"""
+import heapq
+from operator import itemgetter
+import random
+from timeit import repeat as timeit_repeat
+
+from cotoolz import comerge
+
+
+def make_inputs(k, total, kind, seed=0):
+    r = random.Random(seed)
+    per = total // k
+    if kind == 'int':
+        def make():
+            return r.randrange(1 << 30)
+    elif kind == 'float':
+        make = r.random
+    elif kind == 'str':
+        def make():
+            return '%09d' % r.randrange(10 ** 9)
+    else:
+        def make():
+            return (r.random(), None)
+    return [sorted(make() for _ in range(per)) for _ in range(k)]
+
+
+def bench(merge, inputs, kwargs, reps):
+    return min(timeit_repeat(
+        lambda: sum(1 for _ in merge(*inputs, **kwargs)),
+        number=1,
+        repeat=reps,
+    ))
+
+
+def main(total=200000, reps=5):
+    print('%-8s %6s %14s %14s %8s' % (
+        'kind', 'k', 'heapq ns/elt', 'comerge ns/elt', 'speedup',
+    ))
+    for kind in ('int', 'float', 'str', 'key'):
+        kwargs = {'key': itemgetter(0)} if kind == 'key' else {}
+        for k in (8, 16, 32, 64, 128, 256):
+            inputs = make_inputs(k, total, kind)
+            n = sum(map(len, inputs))
+            h = bench(heapq.merge, inputs, kwargs, reps)
+            c = bench(comerge, inputs, kwargs, reps)
+            print('%-8s %6d %14.1f %14.1f %7.2fx' % (
+                kind,
+                k,
+                h / n * 1e9,
+                c / n * 1e9,
+                h / c,
+            ))
+
+
+if __name__ == '__main__':
+    main()
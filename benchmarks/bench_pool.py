@@ -0,0 +1,86 @@
+"""Measure how copool scales independent pipelines from 1 to N threads.
+
+copool is concurrent but not parallel: each worker holds the GIL while it
+steps a task, on a free-threaded build too. CPU-bound steps do not scale and
+the table shows the scheduling overhead. With ``--blocking`` each step sleeps
+instead, which releases the GIL, so the steps of different workers overlap.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_pool.py [--blocking]
+"""
+import os
+import sys
+from time import perf_counter, sleep
+
+from cotoolz import comap, copool
+
+
+def work(n):
+    total = 0
+    for m in range(n):
+        total += m * m % 7
+    return total
+
+
+def block(n):
+    sleep(n / 1e6)
+
+
+def pipelines(n, length, cost, blocking=False):
+    f = block if blocking else work
+    return [comap(f, [cost] * length) for _ in range(n)]
+
+
+def sequential(n, length, cost, blocking):
+    start = perf_counter()
+    for pipeline in pipelines(n, length, cost, blocking):
+        for _ in pipeline:
+            pass
+    return perf_counter() - start
+
+
+def pooled(workers, n, length, cost, blocking):
+    pool = copool(workers)
+    for pipeline in pipelines(n, length, cost, blocking):
+        pool.spawn(pipeline)
+    start = perf_counter()
+    pool.run()
+    return perf_counter() - start, pool.stats()
+
+
+def main(n=64, length=500, cost=200, reps=3, blocking=False):
+    print('steps: %s' % ('blocking' if blocking else 'CPU-bound'))
+    baseline = min(sequential(n, length, cost, blocking) for _ in range(reps))
+    print('sequential: %.3fs' % baseline)
+    print('%8s %10s %10s %12s %8s %10s' % (
+        'workers', 'seconds', 'speedup', 'efficiency', 'steals', 'idle'))
+    # blocking steps can overlap past the number of CPUs
+    most = 8 if blocking else os.cpu_count() or 1
+    workers = 1
+    counts = []
+    while workers < most:
+        counts.append(workers)
+        workers *= 2
+    counts.append(most)
+    for workers in counts:
+        t, stats = min(
+            (pooled(workers, n, length, cost, blocking) for _ in range(reps)),
+            key=lambda r: r[0],
+        )
+        print('%8d %10.3f %9.2fx %11.0f%% %8d %9.1f%%' % (
+            workers,
+            t,
+            baseline / t,
+            baseline / t / workers * 100,
+            stats['steals'],
+            stats['idle_ns'] / 1e9 / (t * workers) * 100,
+        ))
+
+
+if __name__ == '__main__':
+    if '--blocking' in sys.argv[1:]:
+        main(n=16, length=50, blocking=True)
+    else:
+        main()
@@ -0,0 +1,73 @@
+"""Time the per-row cost of getting named rows out of ``cozip``: turning each
+tuple into a ``namedtuple``, asking ``cozip`` for struct sequence records with
+``names``, and plain tuples for reference. ``read`` also reads every field of
+the row by name, or by index for the tuples.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_record.py
+"""
+from collections import namedtuple
+from itertools import repeat
+from timeit import repeat as timeit_repeat
+
+from cotoolz import cozip
+
+
+def per_row(stmt, globals, number, reps):
+    return min(timeit_repeat(
+        stmt,
+        globals=globals,
+        number=number,
+        repeat=reps,
+    )) / number * 1e9
+
+
+def names(width):
+    return tuple('f%d' % n for n in range(width))
+
+
+def sources(width):
+    return [repeat(n) for n in range(width)]
+
+
+def main(number=200000, reps=5, widths=(2, 4, 8)):
+    print('%6s %-12s %10s %10s' % ('width', 'rows', 'next ns', 'read ns'))
+    for width in widths:
+        fields = names(width)
+        row_type = namedtuple('row_type', fields)
+        cases = [
+            (
+                'tuple',
+                cozip(*sources(width)),
+                'step()',
+                ' '.join('row[%d];' % n for n in range(width)),
+            ),
+            (
+                'namedtuple',
+                cozip(*sources(width)),
+                'make(step())',
+                ' '.join('row.%s;' % f for f in fields),
+            ),
+            (
+                'names',
+                cozip(*sources(width), names=fields),
+                'step()',
+                ' '.join('row.%s;' % f for f in fields),
+            ),
+        ]
+        for label, cz, make_row, read in cases:
+            globals = {'step': cz.__next__, 'make': row_type._make}
+            a = per_row(make_row, globals, number, reps)
+            b = per_row(
+                'row = %s; %s' % (make_row, read),
+                globals,
+                number,
+                reps,
+            )
+            print('%6d %-12s %10.1f %10.1f' % (width, label, a, b))
+
+
+if __name__ == '__main__':
+    main()
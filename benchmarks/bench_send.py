@@ -0,0 +1,180 @@
+"""Time the per-element cost of stepping coiter, comap, and cozip.
+
+Without arguments this times the build on ``PYTHONPATH``. ``--compare``
+builds the tree twice into temporary directories, once as the default build
+and once with ``COTOOLZ_STATS=1``, and times both. It checks that the default
+build carries no counters at all: each node must be exactly
+``sizeof(ctz_stats)`` bytes smaller than in the instrumented build, so the
+default build is the uninstrumented baseline and the table shows what turning
+the counters on costs::
+
+    $ python benchmarks/bench_send.py --compare
+
+    $ python setup.py build_ext --inplace --force
+    $ PYTHONPATH=. python benchmarks/bench_send.py
+"""
+import argparse
+from glob import glob
+from itertools import repeat
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from timeit import repeat as timeit_repeat
+
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# sizeof(ctz_stats): six uint64_t counters
+STATS_SIZE = 6 * 8
+
+
+def source():
+    return repeat(1)
+
+
+def identity(a):
+    return a
+
+
+def cases():
+    from cotoolz import coiter, comap, cozip
+
+    return {
+        'coiter next': lambda: coiter(source()).__next__,
+        'comap next': lambda: comap(identity, source()).__next__,
+        'comap send': lambda: comap(identity, source()).send,
+        'cozip next': lambda: cozip(source(), source()).__next__,
+        'cozip send': lambda: cozip(source(), source()).send,
+    }
+
+
+def measure(number, reps):
+    import cotoolz
+
+    ns = {}
+    for name, make in sorted(cases().items()):
+        step = make()
+        if name.endswith('send'):
+            stmt = 'step(None)'
+        else:
+            stmt = 'step()'
+        best = min(timeit_repeat(
+            stmt,
+            globals={'step': step},
+            number=number,
+            repeat=reps,
+        ))
+        ns[name] = best / number * 1e9
+    return {
+        'stats_enabled': cotoolz.stats_enabled,
+        'sizes': {
+            tp.__name__: tp.__basicsize__
+            for tp in (cotoolz.coiter, cotoolz.comap, cotoolz.cozip)
+        },
+        'ns': ns,
+    }
+
+
+def build(dest, stats):
+    env = dict(os.environ)
+    env.pop('COTOOLZ_STATS', None)
+    if stats:
+        env['COTOOLZ_STATS'] = '1'
+    os.makedirs(dest)
+    proc = subprocess.run(
+        [
+            sys.executable,
+            'setup.py',
+            'egg_info', '--egg-base', dest,
+            'build', '--build-base', dest,
+        ],
+        cwd=ROOT,
+        env=env,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.STDOUT,
+    )
+    if proc.returncode:
+        sys.stdout.write(proc.stdout.decode('utf-8', 'replace'))
+        raise subprocess.CalledProcessError(proc.returncode, proc.args)
+    lib, = glob(os.path.join(dest, 'lib*'))
+    return lib
+
+
+def run(lib, number, reps):
+    env = dict(os.environ)
+    env['PYTHONPATH'] = lib
+    out = subprocess.check_output(
+        [
+            sys.executable,
+            os.path.abspath(__file__),
+            '--json',
+            '--number', str(number),
+            '--reps', str(reps),
+        ],
+        cwd=lib,
+        env=env,
+    )
+    return json.loads(out.decode('utf-8'))
+
+
+def compare(number, reps):
+    tmp = tempfile.mkdtemp()
+    try:
+        default = run(build(os.path.join(tmp, 'default'), False), number, reps)
+        stats = run(build(os.path.join(tmp, 'stats'), True), number, reps)
+    finally:
+        shutil.rmtree(tmp)
+
+    assert not default['stats_enabled'], 'default build has stats enabled'
+    assert stats['stats_enabled'], 'COTOOLZ_STATS=1 build has stats disabled'
+
+    print('%-12s %10s %10s' % ('type', 'default B', 'stats B'))
+    for name, size in sorted(default['sizes'].items()):
+        print('%-12s %10d %10d' % (name, size, stats['sizes'][name]))
+    print()
+    print('%-12s %10s %10s %10s' % ('case', 'default ns', 'stats ns', 'cost'))
+    for name, ns in sorted(default['ns'].items()):
+        print('%-12s %10.1f %10.1f %+9.1f%%' % (
+            name,
+            ns,
+            stats['ns'][name],
+            (stats['ns'][name] / ns - 1) * 100,
+        ))
+
+    for name, size in default['sizes'].items():
+        extra = stats['sizes'][name] - size
+        assert extra == STATS_SIZE, (
+            '%s is %d bytes larger with COTOOLZ_STATS, expected %d' % (
+                name,
+                extra,
+                STATS_SIZE,
+            )
+        )
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--compare', action='store_true')
+    parser.add_argument('--json', action='store_true')
+    parser.add_argument('--number', type=int, default=1000000)
+    parser.add_argument('--reps', type=int, default=5)
+    args = parser.parse_args(argv)
+
+    if args.compare:
+        compare(args.number, args.reps)
+        return
+
+    result = measure(args.number, args.reps)
+    if args.json:
+        json.dump(result, sys.stdout)
+        return
+    print('stats_enabled: %s' % result['stats_enabled'])
+    for name, ns in sorted(result['ns'].items()):
+        print('%-12s %6.1f ns/step' % (name, ns))
+
+
+if __name__ == '__main__':
+    main()
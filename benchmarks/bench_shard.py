@@ -0,0 +1,59 @@
+"""Measure how coshard scales a CPU bound comap stage from 1 to N cores.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_shard.py
+"""
+import os
+from time import perf_counter
+
+from cotoolz import comap, coshard
+
+
+def work(n):
+    # a pure Python loop so the GIL is held the whole time
+    total = 0
+    for m in range(n):
+        total += m * m % 7
+    return total
+
+
+def drive(it):
+    start = perf_counter()
+    for _ in it:
+        pass
+    return perf_counter() - start
+
+
+def bench(make, reps):
+    return min(drive(make()) for _ in range(reps))
+
+
+def main(n=2000, cost=5000, chunksize=16, reps=3):
+    cores = os.cpu_count() or 1
+    baseline = bench(lambda: comap(work, [cost] * n), reps)
+    print('comap: %.3fs (%.1f us/value)' % (baseline, baseline / n * 1e6))
+    print('%8s %10s %10s %12s' % ('workers', 'seconds', 'speedup',
+                                  'efficiency'))
+    workers = 1
+    counts = []
+    while workers < cores:
+        counts.append(workers)
+        workers *= 2
+    counts.append(cores)
+    for workers in counts:
+        t = bench(
+            lambda: coshard(work, [cost] * n, workers, chunksize),
+            reps,
+        )
+        print('%8d %10.3f %9.2fx %11.0f%%' % (
+            workers,
+            t,
+            baseline / t,
+            baseline / t / workers * 100,
+        ))
+
+
+if __name__ == '__main__':
+    main()
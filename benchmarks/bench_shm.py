@@ -0,0 +1,130 @@
+"""Compare coshm against multiprocessing.Queue and multiprocessing.Pipe for
+moving bytes from a producer process to a consumer process.
+
+The consumer only takes the length of each payload, so coshm never copies a
+payload out of the ring while the others have to unpickle or copy it into a
+new bytes object.
+
+::
+
+    $ python setup.py build_ext --inplace
+    $ PYTHONPATH=. python benchmarks/bench_shm.py
+"""
+import multiprocessing
+from multiprocessing.shared_memory import SharedMemory
+from time import perf_counter
+
+from cotoolz import coshm, coshm_sink
+
+
+_ctx = multiprocessing.get_context('fork')
+
+
+def produce_shm(buf, payload, n):
+    sink = coshm_sink(buf)
+    send = sink.send
+    for _ in range(n):
+        send(payload)
+    sink.close()
+
+
+def run_shm(payload, n, ring_size):
+    shm = SharedMemory(create=True, size=ring_size)
+    try:
+        sink, source = coshm(shm.buf)
+        proc = _ctx.Process(target=produce_shm, args=(shm.buf, payload, n))
+        start = perf_counter()
+        proc.start()
+        total = sum(len(view) for view in source)
+        elapsed = perf_counter() - start
+        proc.join()
+        sink.close()
+        source.close()
+        shm.close()
+    finally:
+        shm.unlink()
+    assert total == len(payload) * n
+    return elapsed
+
+
+def produce_queue(q, payload, n):
+    put = q.put
+    for _ in range(n):
+        put(payload)
+    put(None)
+
+
+def run_queue(payload, n, ring_size):
+    q = _ctx.Queue(max(ring_size // max(len(payload), 1), 1))
+    proc = _ctx.Process(target=produce_queue, args=(q, payload, n))
+    start = perf_counter()
+    proc.start()
+    get = q.get
+    total = 0
+    while True:
+        value = get()
+        if value is None:
+            break
+        total += len(value)
+    elapsed = perf_counter() - start
+    proc.join()
+    assert total == len(payload) * n
+    return elapsed
+
+
+def produce_pipe(conn, payload, n):
+    send_bytes = conn.send_bytes
+    for _ in range(n):
+        send_bytes(payload)
+    conn.close()
+
+
+def run_pipe(payload, n, ring_size):
+    recv_conn, send_conn = _ctx.Pipe(duplex=False)
+    proc = _ctx.Process(target=produce_pipe, args=(send_conn, payload, n))
+    start = perf_counter()
+    proc.start()
+    send_conn.close()
+    recv_bytes = recv_conn.recv_bytes
+    total = 0
+    try:
+        while True:
+            total += len(recv_bytes())
+    except EOFError:
+        pass
+    elapsed = perf_counter() - start
+    proc.join()
+    assert total == len(payload) * n
+    return elapsed
+
+
+def bench(run, payload, n, ring_size, reps):
+    return min(run(payload, n, ring_size) for _ in range(reps))
+
+
+def main(total=1 << 30, ring_size=1 << 24, reps=3):
+    print('%10s %12s %12s %12s %10s' % (
+        'payload',
+        'Queue GB/s',
+        'Pipe GB/s',
+        'coshm GB/s',
+        'vs Queue',
+    ))
+    for size in (64, 1024, 16384, 262144, 1 << 20):
+        payload = b'x' * size
+        n = max(total // size // (64 if size < 1024 else 1), 1000)
+        nbytes = size * n
+        q = bench(run_queue, payload, n, ring_size, reps)
+        p = bench(run_pipe, payload, n, ring_size, reps)
+        c = bench(run_shm, payload, n, ring_size, reps)
+        print('%10d %12.2f %12.2f %12.2f %9.2fx' % (
+            size,
+            nbytes / q / 1e9,
+            nbytes / p / 1e9,
+            nbytes / c / 1e9,
+            q / c,
+        ))
+
+
+if __name__ == '__main__':
+    main()
@@ -1,8 +1,29 @@
 from . import curried
-from ._coiter import coiter
+from ._coaggregate import (
+    cocount,
+    comax,
+    comean,
+    comin,
+    cosum,
+    covar,
+)
+from ._cochain import cochain
+from ._cochannel import cochannel
+from ._coiter import coiter, stats_enabled, usdt_enabled
+from ._cointerleave import cointerleave
 from ._comap import comap
+from ._comerge import comerge
+from ._copartition import copartition
+from ._copool import copool
+from ._coprefetch import coprefetch
+from ._coroute import coroute
+from ._coscheduler import coscheduler
+from ._coshard import coshard
+from ._coshm import coshm, coshm_sink, coshm_source
+from ._cowindow import cowindow
 from ._cozip import cozip
 from ._emptycoroutine import emptycoroutine
+from ._graph import graph, profile
 from .include import get_include
 
 
@@ -10,10 +31,34 @@ __version__ = '0.1.6'
 
 
 __all__ = [
+    'cochain',
+    'cochannel',
+    'cocount',
     'coiter',
+    'cointerleave',
     'comap',
+    'comax',
+    'comean',
+    'comerge',
+    'comin',
+    'copartition',
+    'copool',
+    'coprefetch',
+    'coroute',
+    'coscheduler',
+    'coshard',
+    'coshm',
+    'coshm_sink',
+    'coshm_source',
+    'cosum',
+    'covar',
+    'cowindow',
     'cozip',
     'curried',
     'emptycoroutine',
     'get_include',
+    'graph',
+    'profile',
+    'stats_enabled',
+    'usdt_enabled',
 ]
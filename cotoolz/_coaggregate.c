@@ -0,0 +1,1118 @@
+#include <Python.h>
+#include <math.h>
+#include <structmember.h>
+
+#include "cotoolz/coaggregate.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
+
+/* The number of independent accumulators used when summing a buffer of
+   doubles. Splitting the sum breaks the dependency between iterations so the
+   additions can be pipelined. */
+#define COAGGREGATE_LANES 4
+
+/* Add ``x`` to a compensated sum.
+ *
+ * This is Neumaier's variant of Kahan summation, the same algorithm that
+ * ``sum`` uses for floats.
+ */
+static inline void
+coaggregate_neumaier(double *sum, double *comp, double x)
+{
+    double t = *sum + x;
+
+    if (fabs(*sum) >= fabs(x)) {
+        *comp += (*sum - t) + x;
+    }
+    else {
+        *comp += (x - t) + *sum;
+    }
+    *sum = t;
+}
+
+static inline double
+coaggregate_neumaier_total(double sum, double comp)
+{
+    /* The compensation is nan when the sum overflowed to inf. */
+    if (comp && isfinite(comp)) {
+        return sum + comp;
+    }
+    return sum;
+}
+
+/* Sum a buffer of doubles with one compensated sum per lane. */
+static void
+coaggregate_sum_doubles(const double *xs,
+                        Py_ssize_t n,
+                        double *sum,
+                        double *comp)
+{
+    double s[COAGGREGATE_LANES] = {0.0};
+    double c[COAGGREGATE_LANES] = {0.0};
+    Py_ssize_t ix = 0;
+    int lane;
+
+    for (;ix + COAGGREGATE_LANES <= n;ix += COAGGREGATE_LANES) {
+        for (lane = 0;lane < COAGGREGATE_LANES;++lane) {
+            coaggregate_neumaier(&s[lane], &c[lane], xs[ix + lane]);
+        }
+    }
+    for (;ix < n;++ix) {
+        coaggregate_neumaier(&s[0], &c[0], xs[ix]);
+    }
+
+    *sum = 0.0;
+    *comp = 0.0;
+    for (lane = 0;lane < COAGGREGATE_LANES;++lane) {
+        coaggregate_neumaier(sum, comp, s[lane]);
+        *comp += c[lane];
+    }
+}
+
+/* Sum the squared deviations of a buffer of doubles from ``mean``. */
+static double
+coaggregate_sum_squares(const double *xs, Py_ssize_t n, double mean)
+{
+    double s[COAGGREGATE_LANES] = {0.0};
+    double d;
+    Py_ssize_t ix = 0;
+    int lane;
+
+    for (;ix + COAGGREGATE_LANES <= n;ix += COAGGREGATE_LANES) {
+        for (lane = 0;lane < COAGGREGATE_LANES;++lane) {
+            d = xs[ix + lane] - mean;
+            s[lane] += d * d;
+        }
+    }
+    for (;ix < n;++ix) {
+        d = xs[ix] - mean;
+        s[0] += d * d;
+    }
+    return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+static inline int
+coaggregate_add_overflows(long a, long b)
+{
+    return (b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b);
+}
+
+static PyTypeObject *coaggregate_types[] = {
+    &PyCosum_Type,
+    &PyComin_Type,
+    &PyComax_Type,
+    &PyCocount_Type,
+    &PyComean_Type,
+    &PyCovar_Type,
+};
+
+static PyObject *
+inner_coaggregate_new(PyTypeObject *cls, coaggregate_kind kind, PyObject *arg)
+{
+    coaggregate *self;
+    long start;
+    int overflow;
+    Py_ssize_t ddof = 0;
+
+    if (kind == COAGGREGATE_VAR && arg) {
+        if ((ddof = PyNumber_AsSsize_t(arg, PyExc_OverflowError)) == -1 &&
+            PyErr_Occurred()) {
+            return NULL;
+        }
+        if (ddof < 0) {
+            PyErr_SetString(PyExc_ValueError,
+                            "covar() ddof must be non-negative");
+            return NULL;
+        }
+    }
+
+    if (!(self = (coaggregate*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    self->ag_kind = kind;
+    self->ag_mode = COAGGREGATE_SUM_INT;
+    self->ag_int = 0;
+    self->ag_sum = 0.0;
+    self->ag_comp = 0.0;
+    self->ag_obj = NULL;
+    self->ag_count = 0;
+    self->ag_ddof = ddof;
+
+    if (kind == COAGGREGATE_SUM && arg) {
+        if (PyLong_CheckExact(arg)) {
+            start = PyLong_AsLongAndOverflow(arg, &overflow);
+            if (!overflow) {
+                self->ag_int = start;
+                return (PyObject*) self;
+            }
+        }
+        else if (PyFloat_CheckExact(arg)) {
+            self->ag_mode = COAGGREGATE_SUM_FLOAT;
+            self->ag_sum = PyFloat_AS_DOUBLE(arg);
+            return (PyObject*) self;
+        }
+        Py_INCREF(arg);
+        self->ag_obj = arg;
+        self->ag_mode = COAGGREGATE_SUM_OBJECT;
+    }
+    return (PyObject*) self;
+}
+
+PyObject *
+PyCoaggregate_New(coaggregate_kind kind, PyObject *arg)
+{
+    if (kind < COAGGREGATE_SUM || kind > COAGGREGATE_VAR) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return inner_coaggregate_new(coaggregate_types[kind], kind, arg);
+}
+
+static int
+coaggregate_traverse(coaggregate *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->ag_obj);
+    return 0;
+}
+
+static int
+coaggregate_clear(coaggregate *self)
+{
+    Py_CLEAR(self->ag_obj);
+    return 0;
+}
+
+static void
+coaggregate_dealloc(coaggregate *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->ag_obj);
+    Py_TYPE(self)->tp_free(self);
+}
+
+static int
+coaggregate_sum_add(coaggregate *self, PyObject *value)
+{
+    PyObject *total;
+    long x;
+    int overflow;
+
+    switch (self->ag_mode) {
+    case COAGGREGATE_SUM_INT:
+        if (PyLong_CheckExact(value) || PyBool_Check(value)) {
+            x = PyLong_AsLongAndOverflow(value, &overflow);
+            if (!overflow && !coaggregate_add_overflows(self->ag_int, x)) {
+                self->ag_int += x;
+                return 0;
+            }
+        }
+        else if (PyFloat_CheckExact(value)) {
+            self->ag_mode = COAGGREGATE_SUM_FLOAT;
+            self->ag_sum = (double) self->ag_int;
+            self->ag_comp = 0.0;
+            coaggregate_neumaier(&self->ag_sum,
+                                 &self->ag_comp,
+                                 PyFloat_AS_DOUBLE(value));
+            return 0;
+        }
+        if (!(self->ag_obj = PyLong_FromLong(self->ag_int))) {
+            return -1;
+        }
+        self->ag_mode = COAGGREGATE_SUM_OBJECT;
+        break;
+    case COAGGREGATE_SUM_FLOAT:
+        if (PyFloat_CheckExact(value)) {
+            coaggregate_neumaier(&self->ag_sum,
+                                 &self->ag_comp,
+                                 PyFloat_AS_DOUBLE(value));
+            return 0;
+        }
+        if (PyLong_CheckExact(value) || PyBool_Check(value)) {
+            x = PyLong_AsLongAndOverflow(value, &overflow);
+            if (!overflow) {
+                coaggregate_neumaier(&self->ag_sum,
+                                     &self->ag_comp,
+                                     (double) x);
+                return 0;
+            }
+        }
+        if (!(self->ag_obj = PyFloat_FromDouble(
+                  coaggregate_neumaier_total(self->ag_sum, self->ag_comp)))) {
+            return -1;
+        }
+        self->ag_mode = COAGGREGATE_SUM_OBJECT;
+        break;
+    case COAGGREGATE_SUM_OBJECT:
+        break;
+    }
+
+    if (!(total = PyNumber_Add(self->ag_obj, value))) {
+        return -1;
+    }
+    Py_SETREF(self->ag_obj, total);
+    return 0;
+}
+
+/* Check if ``value`` should replace ``best``.
+ *
+ * Like ``min`` and ``max``, only a strictly better value replaces the best
+ * value so the first of equal values is kept.
+ *
+ * Returns
+ * -------
+ * better : int
+ *     1 if ``value`` is better, 0 if it is not, -1 on failure.
+ */
+static inline int
+coaggregate_better(PyObject *value, PyObject *best, int op)
+{
+    double da;
+    double db;
+    long la;
+    long lb;
+    int oa;
+    int ob;
+
+    if (PyFloat_CheckExact(value) && PyFloat_CheckExact(best)) {
+        da = PyFloat_AS_DOUBLE(value);
+        db = PyFloat_AS_DOUBLE(best);
+        return (op == Py_LT) ? da < db : da > db;
+    }
+    if (PyLong_CheckExact(value) && PyLong_CheckExact(best)) {
+        la = PyLong_AsLongAndOverflow(value, &oa);
+        lb = PyLong_AsLongAndOverflow(best, &ob);
+        if (!oa && !ob) {
+            return (op == Py_LT) ? la < lb : la > lb;
+        }
+    }
+    return PyObject_RichCompareBool(value, best, op);
+}
+
+static int
+coaggregate_minmax_add(coaggregate *self, PyObject *value)
+{
+    int better;
+
+    if (!self->ag_obj) {
+        Py_INCREF(value);
+        self->ag_obj = value;
+        return 0;
+    }
+    better = coaggregate_better(value,
+                                self->ag_obj,
+                                (self->ag_kind == COAGGREGATE_MIN) ?
+                                Py_LT :
+                                Py_GT);
+    if (better > 0) {
+        Py_INCREF(value);
+        Py_SETREF(self->ag_obj, value);
+    }
+    return (better < 0) ? -1 : 0;
+}
+
+/* Add a value to the running mean and sum of squared deviations with
+   Welford's algorithm. */
+static inline void
+coaggregate_welford(coaggregate *self, double x)
+{
+    double delta = x - self->ag_sum;
+
+    ++self->ag_count;
+    self->ag_sum += delta / self->ag_count;
+    self->ag_comp += delta * (x - self->ag_sum);
+}
+
+/* Add a single value to the aggregate.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure.
+ */
+static int
+coaggregate_add(coaggregate *self, PyObject *value)
+{
+    double x;
+
+    if (value == Py_None) {
+        return 0;
+    }
+
+    switch (self->ag_kind) {
+    case COAGGREGATE_SUM:
+        if (coaggregate_sum_add(self, value)) {
+            return -1;
+        }
+        break;
+    case COAGGREGATE_MIN:
+    case COAGGREGATE_MAX:
+        if (coaggregate_minmax_add(self, value)) {
+            return -1;
+        }
+        break;
+    case COAGGREGATE_COUNT:
+        break;
+    case COAGGREGATE_MEAN:
+    case COAGGREGATE_VAR:
+        if (PyFloat_CheckExact(value)) {
+            x = PyFloat_AS_DOUBLE(value);
+        }
+        else if ((x = PyFloat_AsDouble(value)) == -1.0 && PyErr_Occurred()) {
+            return -1;
+        }
+        coaggregate_welford(self, x);
+        return 0;
+    }
+    ++self->ag_count;
+    return 0;
+}
+
+static int
+coaggregate_minmax_doubles(coaggregate *self,
+                           const double *xs,
+                           Py_ssize_t n)
+{
+    PyObject *best;
+    double old;
+    double b;
+    Py_ssize_t ix;
+    int err;
+
+    if (self->ag_obj && PyFloat_CheckExact(self->ag_obj)) {
+        old = b = PyFloat_AS_DOUBLE(self->ag_obj);
+        ix = 0;
+    }
+    else {
+        old = b = xs[0];
+        ix = 1;
+    }
+
+    if (self->ag_kind == COAGGREGATE_MIN) {
+        for (;ix < n;++ix) {
+            if (xs[ix] < b) {
+                b = xs[ix];
+            }
+        }
+    }
+    else {
+        for (;ix < n;++ix) {
+            if (xs[ix] > b) {
+                b = xs[ix];
+            }
+        }
+    }
+
+    if (self->ag_obj && PyFloat_CheckExact(self->ag_obj) && b == old) {
+        return 0;
+    }
+    if (!(best = PyFloat_FromDouble(b))) {
+        return -1;
+    }
+    err = coaggregate_minmax_add(self, best);
+    Py_DECREF(best);
+    return err;
+}
+
+static int
+inner_coaggregate_send_doubles(coaggregate *self,
+                               const double *xs,
+                               Py_ssize_t n)
+{
+    PyObject *f;
+    PyObject *total;
+    double sum;
+    double comp;
+    double mean;
+    double delta;
+    double m2;
+    double na;
+
+    if (n <= 0) {
+        return 0;
+    }
+
+    switch (self->ag_kind) {
+    case COAGGREGATE_SUM:
+        coaggregate_sum_doubles(xs, n, &sum, &comp);
+        if (self->ag_mode == COAGGREGATE_SUM_INT) {
+            self->ag_mode = COAGGREGATE_SUM_FLOAT;
+            self->ag_sum = (double) self->ag_int;
+            self->ag_comp = 0.0;
+        }
+        if (self->ag_mode == COAGGREGATE_SUM_FLOAT) {
+            coaggregate_neumaier(&self->ag_sum, &self->ag_comp, sum);
+            self->ag_comp += comp;
+        }
+        else {
+            if (!(f = PyFloat_FromDouble(
+                      coaggregate_neumaier_total(sum, comp)))) {
+                return -1;
+            }
+            total = PyNumber_Add(self->ag_obj, f);
+            Py_DECREF(f);
+            if (!total) {
+                return -1;
+            }
+            Py_SETREF(self->ag_obj, total);
+        }
+        break;
+    case COAGGREGATE_MIN:
+    case COAGGREGATE_MAX:
+        if (coaggregate_minmax_doubles(self, xs, n)) {
+            return -1;
+        }
+        break;
+    case COAGGREGATE_COUNT:
+        break;
+    case COAGGREGATE_MEAN:
+    case COAGGREGATE_VAR:
+        /* Compute the mean and sum of squared deviations of the batch in two
+           passes and merge them with the running values (Chan et al.). */
+        coaggregate_sum_doubles(xs, n, &sum, &comp);
+        mean = coaggregate_neumaier_total(sum, comp) / n;
+        m2 = coaggregate_sum_squares(xs, n, mean);
+        na = (double) self->ag_count;
+        delta = mean - self->ag_sum;
+        self->ag_count += n;
+        self->ag_sum += delta * n / self->ag_count;
+        self->ag_comp += m2 + delta * delta * na * n / self->ag_count;
+        return 0;
+    }
+    self->ag_count += n;
+    return 0;
+}
+
+int
+PyCoaggregate_SendDoubles(PyObject *ag, const double *values, Py_ssize_t n)
+{
+    if (!PyCoaggregate_Check(ag)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return inner_coaggregate_send_doubles((coaggregate*) ag, values, n) ?
+        1 :
+        0;
+}
+
+static PyObject *
+coaggregate_value(coaggregate *self)
+{
+    PyObject *ret;
+
+    switch (self->ag_kind) {
+    case COAGGREGATE_SUM:
+        if (self->ag_mode == COAGGREGATE_SUM_INT) {
+            return PyLong_FromLong(self->ag_int);
+        }
+        if (self->ag_mode == COAGGREGATE_SUM_FLOAT) {
+            return PyFloat_FromDouble(
+                coaggregate_neumaier_total(self->ag_sum, self->ag_comp));
+        }
+        ret = self->ag_obj;
+        break;
+    case COAGGREGATE_MIN:
+    case COAGGREGATE_MAX:
+        ret = self->ag_obj ? self->ag_obj : Py_None;
+        break;
+    case COAGGREGATE_COUNT:
+        return PyLong_FromUnsignedLongLong(self->ag_count);
+    case COAGGREGATE_MEAN:
+        if (!self->ag_count) {
+            Py_RETURN_NONE;
+        }
+        return PyFloat_FromDouble(self->ag_sum);
+    case COAGGREGATE_VAR:
+        if (self->ag_count <= (uint64_t) self->ag_ddof) {
+            Py_RETURN_NONE;
+        }
+        return PyFloat_FromDouble(self->ag_comp /
+                                  (self->ag_count - self->ag_ddof));
+    default:
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    Py_INCREF(ret);
+    return ret;
+}
+
+PyObject *
+PyCoaggregate_Value(PyObject *ag)
+{
+    if (!PyCoaggregate_Check(ag)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coaggregate_value((coaggregate*) ag);
+}
+
+PyDoc_STRVAR(coaggregate_send_doc,
+             "Aggregate a value.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to aggregate. None is not aggregated, so\n"
+             "    ``next`` yields the current aggregate.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "aggregate : any\n"
+             "    The aggregate of all of the values sent so far.\n");
+
+static PyObject *
+inner_coaggregate_send(coaggregate *self, PyObject *value)
+{
+    CTZ_STATS_INCR(self->ag_stats, sends);
+    if (coaggregate_add(self, value)) {
+        return NULL;
+    }
+    return coaggregate_value(self);
+}
+
+static PyObject *
+coaggregate_send(coaggregate *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coaggregate_send, self, 0);
+    ret = inner_coaggregate_send(self, value);
+    CTZ_PROBE_RETURN(coaggregate_send, self, 0, ret);
+    return ret;
+}
+
+PyObject *
+PyCoaggregate_Send(PyObject *ag, PyObject *value)
+{
+    if (!PyCoaggregate_Check(ag)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coaggregate_send((coaggregate*) ag, value);
+}
+
+static PyObject *
+coaggregate_next(coaggregate *self)
+{
+    return coaggregate_send(self, Py_None);
+}
+
+/* Check if a buffer format is a native double. */
+static inline int
+coaggregate_is_double(const char *format)
+{
+    if (!format) {
+        return 0;
+    }
+    if (*format == '@' || *format == '=') {
+        ++format;
+    }
+    return format[0] == 'd' && format[1] == '\0';
+}
+
+PyDoc_STRVAR(coaggregate_send_many_doc,
+             "Aggregate many values.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "values : iterable\n"
+             "    The values to aggregate. Contiguous buffers of doubles,\n"
+             "    like ``array.array('d')``, are aggregated without creating\n"
+             "    a Python object per value.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "aggregate : any\n"
+             "    The aggregate of all of the values sent so far.\n");
+
+static PyObject *
+coaggregate_send_many(coaggregate *self, PyObject *values)
+{
+    Py_buffer view;
+    PyObject *it;
+    PyObject *value;
+    int err;
+
+    CTZ_STATS_INCR(self->ag_stats, sends);
+    if (PyObject_CheckBuffer(values)) {
+        if (PyObject_GetBuffer(values,
+                               &view,
+                               PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)) {
+            PyErr_Clear();
+        }
+        else if (coaggregate_is_double(view.format)) {
+            err = inner_coaggregate_send_doubles(self,
+                                                 view.buf,
+                                                 view.len / sizeof(double));
+            PyBuffer_Release(&view);
+            if (err) {
+                return NULL;
+            }
+            return coaggregate_value(self);
+        }
+        else {
+            PyBuffer_Release(&view);
+        }
+    }
+
+    if (!(it = PyObject_GetIter(values))) {
+        return NULL;
+    }
+    while ((value = PyIter_Next(it))) {
+        err = coaggregate_add(self, value);
+        Py_DECREF(value);
+        if (err) {
+            Py_DECREF(it);
+            return NULL;
+        }
+    }
+    Py_DECREF(it);
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    return coaggregate_value(self);
+}
+
+PyDoc_STRVAR(coaggregate_throw_doc,
+             "Raise an exception in the sink.\n"
+             "\n"
+             "The sink does not run any code between values so the\n"
+             "exception is raised immediately; the aggregate is left as it\n"
+             "is.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n");
+
+static PyObject *
+coaggregate_throw(coaggregate *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(coaggregate_throw, self, 0);
+    CTZ_STATS_INCR(self->ag_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(coaggregate_throw, self, 0, NULL);
+    return NULL;
+}
+
+PyObject *
+PyCoaggregate_Throw(PyObject *ag, PyObject *excinfo)
+{
+    if (!PyCoaggregate_Check(ag)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coaggregate_throw((coaggregate*) ag, excinfo);
+}
+
+PyDoc_STRVAR(coaggregate_close_doc,
+             "Close the sink."
+             "\n"
+             "The sink holds no resources so this does nothing; the\n"
+             "aggregate can still be read with ``value``.\n");
+
+static PyObject *
+coaggregate_close(coaggregate *self, PyObject *_)
+{
+    CTZ_PROBE_ENTRY(coaggregate_close, self, 0);
+    CTZ_STATS_INCR(self->ag_stats, closes);
+    CTZ_PROBE_RETURN(coaggregate_close, self, 0, Py_None);
+    Py_RETURN_NONE;
+}
+
+int
+PyCoaggregate_Close(PyObject *ag)
+{
+    PyObject *ret;
+
+    if (!PyCoaggregate_Check(ag)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = coaggregate_close((coaggregate*) ag, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCoaggregate_Stats(PyObject *ag, ctz_stats *out)
+{
+    if (!PyCoaggregate_Check(ag)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((coaggregate*) ag)->ag_stats), out);
+}
+
+PyDoc_STRVAR(coaggregate_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+coaggregate_stats(coaggregate *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->ag_stats));
+}
+
+static PyMethodDef coaggregate_methods[] = {
+    {"send", (PyCFunction) coaggregate_send, METH_O, coaggregate_send_doc},
+    {"send_many",
+     (PyCFunction) coaggregate_send_many,
+     METH_O,
+     coaggregate_send_many_doc},
+    {"throw",
+     (PyCFunction) coaggregate_throw,
+     METH_VARARGS,
+     coaggregate_throw_doc},
+    {"close",
+     (PyCFunction) coaggregate_close,
+     METH_NOARGS,
+     coaggregate_close_doc},
+    {"stats",
+     (PyCFunction) coaggregate_stats,
+     METH_NOARGS,
+     coaggregate_stats_doc},
+    {NULL},
+};
+
+static PyObject *
+coaggregate_get_value(coaggregate *self, void *_)
+{
+    return coaggregate_value(self);
+}
+
+static PyObject *
+coaggregate_get_count(coaggregate *self, void *_)
+{
+    return PyLong_FromUnsignedLongLong(self->ag_count);
+}
+
+static PyObject *
+coaggregate_children(coaggregate *self, void *_)
+{
+    return PyTuple_New(0);
+}
+
+static PyGetSetDef coaggregate_getsets[] = {
+    {"value", (getter) coaggregate_get_value, NULL,
+     "The current aggregate.", NULL},
+    {"count", (getter) coaggregate_get_count, NULL,
+     "The number of values aggregated.", NULL},
+    {"children", (getter) coaggregate_children, NULL,
+     "Sinks have no inner coroutines, this is always empty.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(coaggregate_doc,
+             "The base class of the aggregate sinks.\n"
+             "\n"
+             "Each sink aggregates the values sent into it and yields the\n"
+             "current aggregate. None is not aggregated, so ``next`` yields\n"
+             "the current aggregate and the sinks can be driven by a\n"
+             "``cozip`` to compute many aggregates in one pass.\n");
+
+PyTypeObject PyCoaggregate_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coaggregate.coaggregate",     /* tp_name */
+    sizeof(coaggregate),                    /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) coaggregate_dealloc,       /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    coaggregate_doc,                        /* tp_doc */
+    (traverseproc) coaggregate_traverse,    /* tp_traverse */
+    (inquiry) coaggregate_clear,            /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) coaggregate_next,        /* tp_iternext */
+    coaggregate_methods,                    /* tp_methods */
+    0,                                      /* tp_members */
+    coaggregate_getsets,                    /* tp_getset */
+};
+
+static PyObject *
+cosum_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"start", NULL};
+    PyObject *start = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|O:cosum",
+                                     keywords,
+                                     &start)) {
+        return NULL;
+    }
+    return inner_coaggregate_new(cls, COAGGREGATE_SUM, start);
+}
+
+static PyObject *
+comin_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, ":comin", keywords)) {
+        return NULL;
+    }
+    return inner_coaggregate_new(cls, COAGGREGATE_MIN, NULL);
+}
+
+static PyObject *
+comax_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, ":comax", keywords)) {
+        return NULL;
+    }
+    return inner_coaggregate_new(cls, COAGGREGATE_MAX, NULL);
+}
+
+static PyObject *
+cocount_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, ":cocount", keywords)) {
+        return NULL;
+    }
+    return inner_coaggregate_new(cls, COAGGREGATE_COUNT, NULL);
+}
+
+static PyObject *
+comean_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, ":comean", keywords)) {
+        return NULL;
+    }
+    return inner_coaggregate_new(cls, COAGGREGATE_MEAN, NULL);
+}
+
+static PyObject *
+covar_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"ddof", NULL};
+    PyObject *ddof = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|O:covar",
+                                     keywords,
+                                     &ddof)) {
+        return NULL;
+    }
+    return inner_coaggregate_new(cls, COAGGREGATE_VAR, ddof);
+}
+
+PyDoc_STRVAR(cosum_doc,
+             "A sink which yields the sum of the values sent into it.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "start : any, optional\n"
+             "    The value to start the sum at. Defaults to 0.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Exact ints are summed in a C long until the sum overflows and\n"
+             "floats are summed with Neumaier's compensated summation, like\n"
+             "``sum``. Other values are added with ``+``.\n");
+
+PyDoc_STRVAR(comin_doc,
+             "A sink which yields the smallest value sent into it.\n"
+             "\n"
+             "Yields None until the first value is sent. Like ``min``, the\n"
+             "first of equal values is kept.\n");
+
+PyDoc_STRVAR(comax_doc,
+             "A sink which yields the largest value sent into it.\n"
+             "\n"
+             "Yields None until the first value is sent. Like ``max``, the\n"
+             "first of equal values is kept.\n");
+
+PyDoc_STRVAR(cocount_doc,
+             "A sink which yields the number of values sent into it.\n");
+
+PyDoc_STRVAR(comean_doc,
+             "A sink which yields the mean of the values sent into it.\n"
+             "\n"
+             "The values are converted to floats and the mean is updated\n"
+             "with Welford's algorithm. Yields None until the first value is\n"
+             "sent.\n");
+
+PyDoc_STRVAR(covar_doc,
+             "A sink which yields the variance of the values sent into it.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "ddof : int, optional\n"
+             "    The delta degrees of freedom. The variance is the sum of\n"
+             "    squared deviations divided by ``count - ddof``. Defaults\n"
+             "    to 0, the population variance; use 1 for the sample\n"
+             "    variance.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "The values are converted to floats and the variance is updated\n"
+             "with Welford's algorithm. Yields None until more than ``ddof``\n"
+             "values have been sent.\n");
+
+#define COAGGREGATE_SUBTYPE(name, new, doc)                             \
+    {                                                                   \
+        PyVarObject_HEAD_INIT(&PyType_Type, 0)                          \
+        "cotoolz._coaggregate." name,           /* tp_name */           \
+        sizeof(coaggregate),                    /* tp_basicsize */      \
+        0,                                      /* tp_itemsize */       \
+        (destructor) coaggregate_dealloc,       /* tp_dealloc */        \
+        0,                                      /* tp_print */          \
+        0,                                      /* tp_getattr */        \
+        0,                                      /* tp_setattr */        \
+        0,                                      /* tp_reserved */       \
+        0,                                      /* tp_repr */           \
+        0,                                      /* tp_as_number */      \
+        0,                                      /* tp_as_sequence */    \
+        0,                                      /* tp_as_mapping */     \
+        0,                                      /* tp_hash */           \
+        0,                                      /* tp_call */           \
+        0,                                      /* tp_str */            \
+        0,                                      /* tp_getattro */       \
+        0,                                      /* tp_setattro */       \
+        0,                                      /* tp_as_buffer */      \
+        Py_TPFLAGS_DEFAULT |                                            \
+        Py_TPFLAGS_BASETYPE |                                           \
+        Py_TPFLAGS_HAVE_GC,                     /* tp_flags */          \
+        doc,                                    /* tp_doc */            \
+        (traverseproc) coaggregate_traverse,    /* tp_traverse */       \
+        (inquiry) coaggregate_clear,            /* tp_clear */          \
+        0,                                      /* tp_richcompare */    \
+        0,                                      /* tp_weaklistoffset */ \
+        0,                                      /* tp_iter */           \
+        0,                                      /* tp_iternext */       \
+        0,                                      /* tp_methods */        \
+        0,                                      /* tp_members */        \
+        0,                                      /* tp_getset */         \
+        &PyCoaggregate_Type,                    /* tp_base */           \
+        0,                                      /* tp_dict */           \
+        0,                                      /* tp_descr_get */      \
+        0,                                      /* tp_descr_set */      \
+        0,                                      /* tp_dictoffset */     \
+        0,                                      /* tp_init */           \
+        0,                                      /* tp_alloc */          \
+        new,                                    /* tp_new */            \
+    }
+
+PyTypeObject PyCosum_Type = COAGGREGATE_SUBTYPE("cosum", cosum_new, cosum_doc);
+PyTypeObject PyComin_Type = COAGGREGATE_SUBTYPE("comin", comin_new, comin_doc);
+PyTypeObject PyComax_Type = COAGGREGATE_SUBTYPE("comax", comax_new, comax_doc);
+PyTypeObject PyCocount_Type =
+    COAGGREGATE_SUBTYPE("cocount", cocount_new, cocount_doc);
+PyTypeObject PyComean_Type =
+    COAGGREGATE_SUBTYPE("comean", comean_new, comean_doc);
+PyTypeObject PyCovar_Type = COAGGREGATE_SUBTYPE("covar", covar_new, covar_doc);
+
+#undef COAGGREGATE_SUBTYPE
+
+PyDoc_STRVAR(module_doc,
+             "Streaming aggregate sinks.");
+
+static struct PyModuleDef _coaggregate_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._coaggregate",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCoaggregate_Exported exported_symbols = {
+    PyCoaggregate_New,
+    PyCoaggregate_Send,
+    PyCoaggregate_Throw,
+    PyCoaggregate_Close,
+    PyCoaggregate_Stats,
+    PyCoaggregate_SendDoubles,
+    PyCoaggregate_Value,
+};
+
+PyMODINIT_FUNC
+PyInit__coaggregate(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    PyTypeObject *tp;
+    size_t n;
+    int err;
+
+    if (PyType_Ready(&PyCoaggregate_Type)) {
+        return NULL;
+    }
+    for (n = 0;n < sizeof(coaggregate_types) / sizeof(*coaggregate_types);++n) {
+        if (PyType_Ready(coaggregate_types[n])) {
+            return NULL;
+        }
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._coaggregate._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_coaggregate_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "coaggregate",
+                               (PyObject*) &PyCoaggregate_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    for (n = 0;n < sizeof(coaggregate_types) / sizeof(*coaggregate_types);++n) {
+        tp = coaggregate_types[n];
+        if (PyObject_SetAttrString(m,
+                                   strrchr(tp->tp_name, '.') + 1,
+                                   (PyObject*) tp)) {
+            Py_DECREF(m);
+            return NULL;
+        }
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,591 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/cochain.h"
+#include "cotoolz/coiter.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+static PyObject *
+inner_cochain_new(PyTypeObject *cls, PyObject *crs, PyObject *source)
+{
+    cochain *self;
+
+    if (source && !(source = PyObject_GetIter(source))) {
+        return NULL;
+    }
+    if (!(self = (cochain*) cls->tp_alloc(cls, 0))) {
+        Py_XDECREF(source);
+        return NULL;
+    }
+    Py_XINCREF(crs);
+    self->ch_crs = crs;
+    self->ch_next = 0;
+    self->ch_source = source;
+    self->ch_active = NULL;
+    return (PyObject*) self;
+}
+
+PyObject *
+PyCochain_New(PyObject *crs)
+{
+    if (!PyTuple_Check(crs)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return inner_cochain_new(&PyCochain_Type, crs, NULL);
+}
+
+PyObject *
+PyCochain_FromIterable(PyObject *it)
+{
+    return inner_cochain_new(&PyCochain_Type, NULL, it);
+}
+
+static PyObject *
+cochain_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    if (kwargs && PyDict_Size(kwargs)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "cochain() does not accept keyword arguments");
+        return NULL;
+    }
+    return inner_cochain_new(cls, args, NULL);
+}
+
+PyDoc_STRVAR(cochain_from_iterable_doc,
+             "Chain together the coroutines of an iterable.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "it : iterable[coroutine]\n"
+             "    The coroutines to chain together. This is consumed lazily\n"
+             "    so it may be infinite.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "ch : cochain\n"
+             "    The chained coroutines.\n");
+
+static PyObject *
+cochain_from_iterable(PyTypeObject *cls, PyObject *it)
+{
+    return inner_cochain_new(cls, NULL, it);
+}
+
+static int
+cochain_traverse(cochain *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->ch_crs);
+    Py_VISIT(self->ch_source);
+    Py_VISIT(self->ch_active);
+    return 0;
+}
+
+static int
+cochain_clear(cochain *self)
+{
+    Py_CLEAR(self->ch_crs);
+    Py_CLEAR(self->ch_source);
+    Py_CLEAR(self->ch_active);
+    return 0;
+}
+
+static void
+cochain_dealloc(cochain *self)
+{
+    PyObject_GC_UnTrack(self);
+    cochain_clear(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Get the next child out of ``ch_crs`` or ``ch_source``.
+ *
+ * Returns
+ * -------
+ * child : any
+ *     A new reference to the next child. NULL with no exception set when
+ *     there are no more children.
+ */
+static PyObject *
+cochain_next_child(cochain *self)
+{
+    PyObject *child;
+
+    if (self->ch_crs) {
+        if (self->ch_next < PyTuple_GET_SIZE(self->ch_crs)) {
+            child = PyTuple_GET_ITEM(self->ch_crs, self->ch_next++);
+            Py_INCREF(child);
+            return child;
+        }
+        Py_CLEAR(self->ch_crs);
+        return NULL;
+    }
+    if (self->ch_source) {
+        if (!(child = PyIter_Next(self->ch_source)) && !PyErr_Occurred()) {
+            Py_CLEAR(self->ch_source);
+        }
+        return child;
+    }
+    return NULL;
+}
+
+/* Move on to the next child, wrapping it with coiter.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. StopIteration is raised when
+ *     there are no more children.
+ */
+static int
+cochain_advance(cochain *self)
+{
+    PyObject *child;
+
+    if (!(child = cochain_next_child(self))) {
+        if (!PyErr_Occurred()) {
+            PyErr_SetNone(PyExc_StopIteration);
+        }
+        return -1;
+    }
+    self->ch_active = PyCoiter_API->new(child);
+    Py_DECREF(child);
+    if (!self->ch_active) {
+        if (PyErr_ExceptionMatches(PyExc_TypeError))
+            PyErr_SetString(PyExc_TypeError,
+                            "cochain children must support iteration");
+        return -1;
+    }
+    return 0;
+}
+
+/* Send a value or throw an exception into the current child, moving on to
+ * the next child when the current child is exhausted. Each new child is
+ * started with None.
+ */
+static PyObject *
+cochain_step(cochain *self, PyObject *value, PyObject *excinfo)
+{
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
+
+    while (1) {
+        if (!self->ch_active) {
+            if (excinfo) {
+                _ctz_set_exc_from_tuple(excinfo);
+                return NULL;
+            }
+            if (cochain_advance(self)) {
+                CTZ_STATS_STOP(self->ch_stats, NULL);
+                return NULL;
+            }
+            value = Py_None;
+        }
+
+        CTZ_STATS_START(start);
+        if (excinfo) {
+            ret = PyCoiter_API->throw(self->ch_active, excinfo);
+        }
+        else {
+            ret = _ctz_coiter_send_fast(self->ch_active, value);
+        }
+        CTZ_STATS_ELAPSED(self->ch_stats, child, start);
+        if (ret || !PyErr_ExceptionMatches(PyExc_StopIteration)) {
+            return ret;
+        }
+        PyErr_Clear();
+        Py_CLEAR(self->ch_active);
+        excinfo = NULL;
+    }
+}
+
+PyDoc_STRVAR(cochain_send_doc,
+             "Send a value into the current coroutine.\n"
+             "\n"
+             "If the current coroutine is exhausted, the next coroutine is\n"
+             "started with None.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to send into the current coroutine.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The value yielded by the current coroutine.\n");
+
+static PyObject *
+cochain_send(cochain *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cochain_send, self, 1);
+    CTZ_STATS_INCR(self->ch_stats, sends);
+    ret = cochain_step(self, value, NULL);
+    CTZ_PROBE_RETURN(cochain_send, self, 1, ret);
+    return ret;
+}
+
+PyObject *
+PyCochain_Send(PyObject *ch, PyObject *value)
+{
+    if (!PyCochain_Check(ch)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cochain_send((cochain*) ch, value);
+}
+
+static PyObject *
+cochain_next(cochain *self)
+{
+    return cochain_send(self, Py_None);
+}
+
+PyDoc_STRVAR(cochain_throw_doc,
+             "Throw an exception into the current coroutine.\n"
+             "\n"
+             "If the current coroutine handles the exception and finishes,\n"
+             "the next coroutine is started with None. If no coroutine has\n"
+             "been started the exception is raised immediately.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The value yielded by the current coroutine.\n");
+
+static PyObject *
+cochain_throw(cochain *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cochain_throw, self, 1);
+    CTZ_STATS_INCR(self->ch_stats, throws);
+    ret = cochain_step(self, NULL, args);
+    CTZ_PROBE_RETURN(cochain_throw, self, 1, ret);
+    return ret;
+}
+
+PyObject *
+PyCochain_Throw(PyObject *ch, PyObject *excinfo)
+{
+    if (!PyCochain_Check(ch)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cochain_throw((cochain*) ch, excinfo);
+}
+
+/* Close a child which was never started. */
+static int
+cochain_close_child(PyObject *child)
+{
+    PyObject *cr;
+    int err;
+
+    if (!(cr = PyCoiter_API->new(child))) {
+        return -1;
+    }
+    err = PyCoiter_API->close(cr);
+    Py_DECREF(cr);
+    return err;
+}
+
+PyDoc_STRVAR(cochain_close_doc,
+             "Close the cochain."
+             "\n"
+             "This closes the current coroutine and every coroutine after\n"
+             "it. For ``cochain.from_iterable`` the remaining coroutines are\n"
+             "not drawn out of the iterable; the iterable itself is closed\n"
+             "if it has a ``close`` method.\n");
+
+static PyObject *
+inner_cochain_close(cochain *self, PyObject *_)
+{
+    PyObject *source;
+    PyObject *crs;
+    PyObject *ret;
+    Py_ssize_t n;
+    PyObject *type = NULL;
+    PyObject *exc = NULL;
+    PyObject *tb = NULL;
+
+    CTZ_STATS_INCR(self->ch_stats, closes);
+    if (self->ch_active) {
+        if (PyCoiter_API->close(self->ch_active)) {
+            PyErr_Fetch(&type, &exc, &tb);
+        }
+        Py_CLEAR(self->ch_active);
+    }
+
+    /* Close every remaining child even if one fails and raise the first
+       error. */
+    if ((crs = self->ch_crs)) {
+        self->ch_crs = NULL;
+        for (n = self->ch_next;n < PyTuple_GET_SIZE(crs);++n) {
+            if (cochain_close_child(PyTuple_GET_ITEM(crs, n))) {
+                if (type) {
+                    PyErr_Clear();
+                }
+                else {
+                    PyErr_Fetch(&type, &exc, &tb);
+                }
+            }
+        }
+        Py_DECREF(crs);
+    }
+    if ((source = self->ch_source)) {
+        self->ch_source = NULL;
+        if (PyObject_HasAttrString(source, "close")) {
+            if ((ret = PyObject_CallMethod(source, "close", NULL))) {
+                Py_DECREF(ret);
+            }
+            else if (type) {
+                PyErr_Clear();
+            }
+            else {
+                PyErr_Fetch(&type, &exc, &tb);
+            }
+        }
+        Py_DECREF(source);
+    }
+
+    if (type) {
+        PyErr_Restore(type, exc, tb);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+cochain_close(cochain *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cochain_close, self, 1);
+    ret = inner_cochain_close(self, _);
+    CTZ_PROBE_RETURN(cochain_close, self, 1, ret);
+    return ret;
+}
+
+int
+PyCochain_Close(PyObject *ch)
+{
+    PyObject *ret;
+
+    if (!PyCochain_Check(ch)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = cochain_close((cochain*) ch, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCochain_Stats(PyObject *ch, ctz_stats *out)
+{
+    if (!PyCochain_Check(ch)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((cochain*) ch)->ch_stats), out);
+}
+
+PyDoc_STRVAR(cochain_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+cochain_stats(cochain *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->ch_stats));
+}
+
+static PyMethodDef cochain_methods[] = {
+    {"send", (PyCFunction) cochain_send, METH_O, cochain_send_doc},
+    {"throw", (PyCFunction) cochain_throw, METH_VARARGS, cochain_throw_doc},
+    {"close", (PyCFunction) cochain_close, METH_NOARGS, cochain_close_doc},
+    {"stats", (PyCFunction) cochain_stats, METH_NOARGS, cochain_stats_doc},
+    {"from_iterable",
+     (PyCFunction) cochain_from_iterable,
+     METH_O | METH_CLASS,
+     cochain_from_iterable_doc},
+    {NULL},
+};
+
+static PyObject *
+cochain_children(cochain *self, void *_)
+{
+    if (!self->ch_active) {
+        return PyTuple_New(0);
+    }
+    return PyTuple_Pack(1, self->ch_active);
+}
+
+static PyGetSetDef cochain_getsets[] = {
+    {"children", (getter) cochain_children, NULL,
+     "The coiter wrapped current coroutine. The coroutines after it have\n"
+     "not been wrapped yet.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(cochain_doc,
+             "Chain coroutines together one after another.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "*crs : coroutine\n"
+             "    The coroutines to chain together.\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Sends a value into the current coroutine.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Throws an exception into the current coroutine.\n"
+             "close()\n"
+             "    Closes the current coroutine and the coroutines after it.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this cochain.\n"
+             "from_iterable(it)\n"
+             "    Chains the coroutines of a lazily consumed iterable.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "This is ``itertools.chain`` for the coroutine protocol. Each\n"
+             "coroutine is wrapped with ``coiter`` when it is reached and is\n"
+             "started with None, like ``yield from``.\n"
+    );
+
+PyTypeObject PyCochain_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._cochain.cochain",         /* tp_name */
+    sizeof(cochain),                    /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    (destructor) cochain_dealloc,       /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_reserved */
+    0,                                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    0,                                  /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    0,                                  /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
+    cochain_doc,                        /* tp_doc */
+    (traverseproc) cochain_traverse,    /* tp_traverse */
+    (inquiry) cochain_clear,            /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    PyObject_SelfIter,                  /* tp_iter */
+    (iternextfunc) cochain_next,        /* tp_iternext */
+    cochain_methods,                    /* tp_methods */
+    0,                                  /* tp_members */
+    cochain_getsets,                    /* tp_getset */
+    0,                                  /* tp_base */
+    0,                                  /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    0,                                  /* tp_init */
+    0,                                  /* tp_alloc */
+    cochain_new,                        /* tp_new */
+};
+
+PyDoc_STRVAR(module_doc,
+             "cochain chains coroutines together one after another.");
+
+static struct PyModuleDef _cochain_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._cochain",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCochain_Exported exported_symbols = {
+    PyCochain_New,
+    PyCochain_FromIterable,
+    PyCochain_Send,
+    PyCochain_Throw,
+    PyCochain_Close,
+    PyCochain_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__cochain(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCochain_Type)) {
+        return NULL;
+    }
+
+    /* ``cotoolz`` imports ``_cochain`` before ``_coiter`` so the capsule's
+       module needs to be imported explicitly. */
+    if (!(m = PyImport_ImportModule("cotoolz._coiter"))) {
+        return NULL;
+    }
+    Py_DECREF(m);
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._cochain._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_cochain_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m, "cochain", (PyObject*) &PyCochain_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
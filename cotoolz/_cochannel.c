@@ -0,0 +1,916 @@
+#include <Python.h>
+#include <sched.h>
+#include <structmember.h>
+
+#include "cotoolz/cochannel.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/futex.h"
+#include "cotoolz/probes.h"
+
+/* Before sleeping on the futex, a blocked end backs off for a few rounds in
+   case the other end is about to make progress. The other end cannot make
+   progress until we release the GIL, so release it and yield. */
+#define COCHANNEL_SPIN 8
+
+/* Back off once.
+ *
+ * Returns
+ * -------
+ * backed_off : int
+ *     non-zero if the caller should check the ring again, zero if the caller
+ *     has backed off enough and should sleep.
+ */
+static inline int
+cochannel_backoff(int *spin)
+{
+    if (*spin >= COCHANNEL_SPIN) {
+        return 0;
+    }
+    ++*spin;
+    Py_BEGIN_ALLOW_THREADS
+    sched_yield();
+    Py_END_ALLOW_THREADS
+    return 1;
+}
+
+/* Release one end's reference to the ring, dropping the values left in it
+   when both ends are gone. */
+static void
+cochannel_state_decref(cochannel_state *st)
+{
+    uint32_t head;
+    uint32_t tail;
+
+    if (atomic_fetch_sub(&st->cs_refcnt, 1) != 1) {
+        return;
+    }
+    tail = atomic_load(&st->cs_tail);
+    for (head = atomic_load(&st->cs_head);head != tail;++head) {
+        Py_DECREF(st->cs_slots[head & st->cs_mask]);
+    }
+    PyMem_Free(st->cs_slots);
+    PyMem_Free(st);
+}
+
+/* Wake up the other end after closing one end. */
+static void
+cochannel_wake_all(cochannel_state *st)
+{
+    _ctz_futex_wake(&st->cs_head, 0);
+    _ctz_futex_wake(&st->cs_tail, 0);
+}
+
+/* Visit the values in the ring. */
+static int
+cochannel_state_traverse(cochannel_state *st, visitproc visit, void *arg)
+{
+    uint32_t head;
+    uint32_t tail = atomic_load(&st->cs_tail);
+
+    for (head = atomic_load(&st->cs_head);head != tail;++head) {
+        Py_VISIT(st->cs_slots[head & st->cs_mask]);
+    }
+    return 0;
+}
+
+/* Drop the values in the ring. This must be called by the consumer, or by
+   the sink once the source is gone. */
+static void
+cochannel_state_drain(cochannel_state *st)
+{
+    uint32_t head = atomic_load(&st->cs_head);
+    PyObject *item;
+
+    while (head != atomic_load(&st->cs_tail)) {
+        item = st->cs_slots[head & st->cs_mask];
+        atomic_store(&st->cs_head, ++head);
+        Py_DECREF(item);
+    }
+    cochannel_wake_all(st);
+}
+
+/* Start using one end of the channel. ``busy`` is only touched with the GIL
+ * held.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero with an exception raised if another thread
+ *     is already using this end.
+ */
+static inline int
+cochannel_enter(int *busy, const char *end)
+{
+    if (*busy) {
+        PyErr_Format(PyExc_RuntimeError,
+                     "cochannel %s is already in use by another thread",
+                     end);
+        return -1;
+    }
+    *busy = 1;
+    return 0;
+}
+
+/* cochannel_sink ----------------------------------------------------------- */
+
+/* The values in the ring are visited by the source, or by the sink once the
+   source is gone, so that each value is only visited once. */
+static int
+cochannel_sink_traverse(cochannel_sink *self, visitproc visit, void *arg)
+{
+    if (self->sk_state && atomic_load(&self->sk_state->cs_refcnt) == 1) {
+        return cochannel_state_traverse(self->sk_state, visit, arg);
+    }
+    return 0;
+}
+
+static int
+cochannel_sink_clear(cochannel_sink *self)
+{
+    if (self->sk_state && atomic_load(&self->sk_state->cs_refcnt) == 1) {
+        atomic_store(&self->sk_state->cs_sink_closed, 1);
+        cochannel_state_drain(self->sk_state);
+    }
+    return 0;
+}
+
+static void
+cochannel_sink_dealloc(cochannel_sink *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->sk_state) {
+        atomic_store(&self->sk_state->cs_sink_closed, 1);
+        cochannel_wake_all(self->sk_state);
+        cochannel_state_decref(self->sk_state);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Push a value, waiting while the ring is full.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. StopIteration is raised when
+ *     either end has been closed.
+ */
+static int
+cochannel_push(cochannel_sink *self, PyObject *value)
+{
+    cochannel_state *st = self->sk_state;
+    uint32_t tail = atomic_load_explicit(&st->cs_tail, memory_order_relaxed);
+    uint32_t head;
+    int spin = 0;
+    CTZ_STATS_DECL(start);
+
+    while (1) {
+        if (atomic_load(&st->cs_sink_closed) ||
+            atomic_load(&st->cs_source_closed)) {
+            PyErr_SetNone(PyExc_StopIteration);
+            CTZ_STATS_STOP(self->sk_stats, NULL);
+            return -1;
+        }
+        head = atomic_load_explicit(&st->cs_head, memory_order_acquire);
+        if (tail - head <= st->cs_mask) {
+            break;
+        }
+        if (cochannel_backoff(&spin)) {
+            continue;
+        }
+
+        /* Announce that we are waiting and then check again so that the
+           consumer either sees the flag or we see its pop. */
+        CTZ_STATS_START(start);
+        atomic_store(&st->cs_producer_waiting, 1);
+        if (atomic_load(&st->cs_head) == head &&
+            !atomic_load(&st->cs_source_closed)) {
+            Py_BEGIN_ALLOW_THREADS
+            _ctz_futex_wait(&st->cs_head, head, 0);
+            Py_END_ALLOW_THREADS
+        }
+        atomic_store(&st->cs_producer_waiting, 0);
+        CTZ_STATS_ELAPSED(self->sk_stats, child, start);
+        if (PyErr_CheckSignals()) {
+            return -1;
+        }
+    }
+
+    Py_INCREF(value);
+    st->cs_slots[tail & st->cs_mask] = value;
+    atomic_store(&st->cs_tail, tail + 1);
+    if (atomic_load(&st->cs_consumer_waiting)) {
+        _ctz_futex_wake(&st->cs_tail, 0);
+    }
+    return 0;
+}
+
+PyDoc_STRVAR(cochannel_sink_send_doc,
+             "Push a value into the channel.\n"
+             "\n"
+             "This waits, without the GIL, while the channel is full.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to push.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "none : None\n"
+             "    Raises StopIteration once either end has been closed.\n");
+
+static PyObject *
+inner_cochannel_sink_send(cochannel_sink *self, PyObject *value)
+{
+    int err;
+
+    CTZ_STATS_INCR(self->sk_stats, sends);
+    if (cochannel_enter(&self->sk_busy, "sink")) {
+        return NULL;
+    }
+    err = cochannel_push(self, value);
+    self->sk_busy = 0;
+    if (err) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+cochannel_sink_send(cochannel_sink *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cochannel_send, self, 1);
+    ret = inner_cochannel_sink_send(self, value);
+    CTZ_PROBE_RETURN(cochannel_send, self, 1, ret);
+    return ret;
+}
+
+static PyObject *
+cochannel_sink_next(cochannel_sink *self)
+{
+    return cochannel_sink_send(self, Py_None);
+}
+
+PyDoc_STRVAR(cochannel_throw_doc,
+             "Raise an exception at this end of the channel.\n"
+             "\n"
+             "The exception is raised immediately; it is not passed to the\n"
+             "other end.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n");
+
+static PyObject *
+cochannel_sink_throw(cochannel_sink *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(cochannel_throw, self, 1);
+    CTZ_STATS_INCR(self->sk_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(cochannel_throw, self, 1, NULL);
+    return NULL;
+}
+
+PyDoc_STRVAR(cochannel_sink_close_doc,
+             "Close the sink end of the channel."
+             "\n"
+             "The source yields the values already in the channel and then\n"
+             "raises StopIteration.\n");
+
+static PyObject *
+cochannel_sink_close(cochannel_sink *self, PyObject *_)
+{
+    CTZ_PROBE_ENTRY(cochannel_close, self, 1);
+    CTZ_STATS_INCR(self->sk_stats, closes);
+    atomic_store(&self->sk_state->cs_sink_closed, 1);
+    cochannel_wake_all(self->sk_state);
+    CTZ_PROBE_RETURN(cochannel_close, self, 1, Py_None);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(cochannel_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+cochannel_sink_stats(cochannel_sink *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->sk_stats));
+}
+
+static PyMethodDef cochannel_sink_methods[] = {
+    {"send",
+     (PyCFunction) cochannel_sink_send,
+     METH_O,
+     cochannel_sink_send_doc},
+    {"throw",
+     (PyCFunction) cochannel_sink_throw,
+     METH_VARARGS,
+     cochannel_throw_doc},
+    {"close",
+     (PyCFunction) cochannel_sink_close,
+     METH_NOARGS,
+     cochannel_sink_close_doc},
+    {"stats",
+     (PyCFunction) cochannel_sink_stats,
+     METH_NOARGS,
+     cochannel_stats_doc},
+    {NULL},
+};
+
+static PyObject *
+cochannel_get_capacity(cochannel_state *st)
+{
+    return PyLong_FromUnsignedLong((unsigned long) st->cs_mask + 1);
+}
+
+static PyObject *
+cochannel_get_size(cochannel_state *st)
+{
+    return PyLong_FromUnsignedLong(
+        (unsigned long) (atomic_load(&st->cs_tail) -
+                         atomic_load(&st->cs_head)));
+}
+
+static PyObject *
+cochannel_sink_capacity(cochannel_sink *self, void *_)
+{
+    return cochannel_get_capacity(self->sk_state);
+}
+
+static PyObject *
+cochannel_sink_size(cochannel_sink *self, void *_)
+{
+    return cochannel_get_size(self->sk_state);
+}
+
+static PyGetSetDef cochannel_sink_getsets[] = {
+    {"capacity", (getter) cochannel_sink_capacity, NULL,
+     "The number of values the channel can hold.", NULL},
+    {"size", (getter) cochannel_sink_size, NULL,
+     "The number of values in the channel right now.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(cochannel_sink_doc,
+             "The sink end of a cochannel.\n"
+             "\n"
+             "Only one thread may send into a sink at a time, a send while\n"
+             "another thread is waiting on the sink raises RuntimeError.\n");
+
+PyTypeObject PyCochannelSink_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._cochannel.cochannel_sink",    /* tp_name */
+    sizeof(cochannel_sink),                 /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) cochannel_sink_dealloc,    /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, /* tp_flags */
+    cochannel_sink_doc,                     /* tp_doc */
+    (traverseproc) cochannel_sink_traverse, /* tp_traverse */
+    (inquiry) cochannel_sink_clear,         /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) cochannel_sink_next,     /* tp_iternext */
+    cochannel_sink_methods,                 /* tp_methods */
+    0,                                      /* tp_members */
+    cochannel_sink_getsets,                 /* tp_getset */
+};
+
+/* cochannel_source --------------------------------------------------------- */
+
+static int
+cochannel_source_traverse(cochannel_source *self, visitproc visit, void *arg)
+{
+    if (self->sr_state) {
+        return cochannel_state_traverse(self->sr_state, visit, arg);
+    }
+    return 0;
+}
+
+static int
+cochannel_source_clear(cochannel_source *self)
+{
+    if (self->sr_state) {
+        atomic_store(&self->sr_state->cs_source_closed, 1);
+        cochannel_state_drain(self->sr_state);
+    }
+    return 0;
+}
+
+static void
+cochannel_source_dealloc(cochannel_source *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->sr_state) {
+        atomic_store(&self->sr_state->cs_source_closed, 1);
+        cochannel_wake_all(self->sr_state);
+        cochannel_state_decref(self->sr_state);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Pop a value, waiting while the ring is empty.
+ *
+ * Returns
+ * -------
+ * value : any
+ *     A new reference to the oldest value. NULL with StopIteration raised
+ *     when the ring is empty and the sink has been closed.
+ */
+static PyObject *
+cochannel_pop(cochannel_source *self)
+{
+    cochannel_state *st = self->sr_state;
+    uint32_t head = atomic_load_explicit(&st->cs_head, memory_order_relaxed);
+    uint32_t tail;
+    PyObject *item;
+    int spin = 0;
+    CTZ_STATS_DECL(start);
+
+    if (atomic_load(&st->cs_source_closed)) {
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+    while ((tail = atomic_load_explicit(&st->cs_tail,
+                                        memory_order_acquire)) == head) {
+        if (atomic_load(&st->cs_sink_closed)) {
+            /* the sink may have pushed right before closing */
+            if (atomic_load(&st->cs_tail) != head) {
+                continue;
+            }
+            PyErr_SetNone(PyExc_StopIteration);
+            CTZ_STATS_STOP(self->sr_stats, NULL);
+            return NULL;
+        }
+        if (cochannel_backoff(&spin)) {
+            continue;
+        }
+
+        CTZ_STATS_START(start);
+        atomic_store(&st->cs_consumer_waiting, 1);
+        if (atomic_load(&st->cs_tail) == head &&
+            !atomic_load(&st->cs_sink_closed)) {
+            Py_BEGIN_ALLOW_THREADS
+            _ctz_futex_wait(&st->cs_tail, head, 0);
+            Py_END_ALLOW_THREADS
+        }
+        atomic_store(&st->cs_consumer_waiting, 0);
+        CTZ_STATS_ELAPSED(self->sr_stats, child, start);
+        if (PyErr_CheckSignals()) {
+            return NULL;
+        }
+    }
+
+    item = st->cs_slots[head & st->cs_mask];
+    atomic_store(&st->cs_head, head + 1);
+    if (atomic_load(&st->cs_producer_waiting)) {
+        _ctz_futex_wake(&st->cs_head, 0);
+    }
+    return item;
+}
+
+PyDoc_STRVAR(cochannel_source_send_doc,
+             "Pop the oldest value out of the channel.\n"
+             "\n"
+             "This waits, without the GIL, while the channel is empty.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    Ignored, like a ``coiter`` around a plain iterator.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The oldest value in the channel. Raises StopIteration once\n"
+             "    the sink has been closed and the channel is empty.\n");
+
+static PyObject *
+inner_cochannel_source_send(cochannel_source *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_STATS_INCR(self->sr_stats, sends);
+    if (cochannel_enter(&self->sr_busy, "source")) {
+        return NULL;
+    }
+    ret = cochannel_pop(self);
+    self->sr_busy = 0;
+    return ret;
+}
+
+static PyObject *
+cochannel_source_send(cochannel_source *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cochannel_source_send, self, 1);
+    ret = inner_cochannel_source_send(self, value);
+    CTZ_PROBE_RETURN(cochannel_source_send, self, 1, ret);
+    return ret;
+}
+
+static PyObject *
+cochannel_source_next(cochannel_source *self)
+{
+    return cochannel_source_send(self, Py_None);
+}
+
+static PyObject *
+cochannel_source_throw(cochannel_source *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(cochannel_source_throw, self, 1);
+    CTZ_STATS_INCR(self->sr_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(cochannel_source_throw, self, 1, NULL);
+    return NULL;
+}
+
+PyDoc_STRVAR(cochannel_source_close_doc,
+             "Close the source end of the channel."
+             "\n"
+             "Further sends into the sink raise StopIteration. The values\n"
+             "left in the channel are dropped once both ends are gone.\n");
+
+static PyObject *
+cochannel_source_close(cochannel_source *self, PyObject *_)
+{
+    CTZ_PROBE_ENTRY(cochannel_source_close, self, 1);
+    CTZ_STATS_INCR(self->sr_stats, closes);
+    atomic_store(&self->sr_state->cs_source_closed, 1);
+    cochannel_wake_all(self->sr_state);
+    CTZ_PROBE_RETURN(cochannel_source_close, self, 1, Py_None);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+cochannel_source_stats(cochannel_source *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->sr_stats));
+}
+
+static PyMethodDef cochannel_source_methods[] = {
+    {"send",
+     (PyCFunction) cochannel_source_send,
+     METH_O,
+     cochannel_source_send_doc},
+    {"throw",
+     (PyCFunction) cochannel_source_throw,
+     METH_VARARGS,
+     cochannel_throw_doc},
+    {"close",
+     (PyCFunction) cochannel_source_close,
+     METH_NOARGS,
+     cochannel_source_close_doc},
+    {"stats",
+     (PyCFunction) cochannel_source_stats,
+     METH_NOARGS,
+     cochannel_stats_doc},
+    {NULL},
+};
+
+static PyObject *
+cochannel_source_capacity(cochannel_source *self, void *_)
+{
+    return cochannel_get_capacity(self->sr_state);
+}
+
+static PyObject *
+cochannel_source_size(cochannel_source *self, void *_)
+{
+    return cochannel_get_size(self->sr_state);
+}
+
+static PyGetSetDef cochannel_source_getsets[] = {
+    {"capacity", (getter) cochannel_source_capacity, NULL,
+     "The number of values the channel can hold.", NULL},
+    {"size", (getter) cochannel_source_size, NULL,
+     "The number of values in the channel right now.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(cochannel_source_doc,
+             "The source end of a cochannel.\n"
+             "\n"
+             "Only one thread may pull from a source at a time, a pull while\n"
+             "another thread is waiting on the source raises RuntimeError.\n");
+
+PyTypeObject PyCochannelSource_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._cochannel.cochannel_source",  /* tp_name */
+    sizeof(cochannel_source),               /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) cochannel_source_dealloc,  /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, /* tp_flags */
+    cochannel_source_doc,                   /* tp_doc */
+    (traverseproc) cochannel_source_traverse, /* tp_traverse */
+    (inquiry) cochannel_source_clear,       /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) cochannel_source_next,   /* tp_iternext */
+    cochannel_source_methods,               /* tp_methods */
+    0,                                      /* tp_members */
+    cochannel_source_getsets,               /* tp_getset */
+};
+
+/* cochannel ---------------------------------------------------------------- */
+
+PyObject *
+PyCochannel_New(Py_ssize_t capacity)
+{
+    cochannel_state *st;
+    cochannel_sink *sink;
+    cochannel_source *source;
+    PyObject *ret;
+    Py_ssize_t size = 1;
+
+    if (capacity <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "cochannel() capacity must be positive");
+        return NULL;
+    }
+    if (capacity > (Py_ssize_t) 1 << 30) {
+        PyErr_SetString(PyExc_OverflowError,
+                        "cochannel() capacity is too large");
+        return NULL;
+    }
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    if (!(st = PyMem_Malloc(sizeof(cochannel_state)))) {
+        return PyErr_NoMemory();
+    }
+    if (!(st->cs_slots = PyMem_New(PyObject*, size))) {
+        PyMem_Free(st);
+        return PyErr_NoMemory();
+    }
+    atomic_init(&st->cs_head, 0);
+    atomic_init(&st->cs_tail, 0);
+    atomic_init(&st->cs_consumer_waiting, 0);
+    atomic_init(&st->cs_producer_waiting, 0);
+    atomic_init(&st->cs_sink_closed, 0);
+    atomic_init(&st->cs_source_closed, 0);
+    atomic_init(&st->cs_refcnt, 2);
+    st->cs_mask = (uint32_t) (size - 1);
+
+    sink = PyObject_GC_New(cochannel_sink, &PyCochannelSink_Type);
+    source = PyObject_GC_New(cochannel_source, &PyCochannelSource_Type);
+    if (!sink || !source) {
+        if (sink) {
+            sink->sk_state = NULL;
+            Py_DECREF(sink);
+        }
+        if (source) {
+            source->sr_state = NULL;
+            Py_DECREF(source);
+        }
+        PyMem_Free(st->cs_slots);
+        PyMem_Free(st);
+        return NULL;
+    }
+    sink->sk_state = st;
+    sink->sk_busy = 0;
+    CTZ_STATS_CLEAR(sink->sk_stats);
+    source->sr_state = st;
+    source->sr_busy = 0;
+    CTZ_STATS_CLEAR(source->sr_stats);
+    PyObject_GC_Track(sink);
+    PyObject_GC_Track(source);
+
+    ret = PyTuple_Pack(2, (PyObject*) sink, (PyObject*) source);
+    Py_DECREF(sink);
+    Py_DECREF(source);
+    return ret;
+}
+
+PyObject *
+PyCochannel_Send(PyObject *sink, PyObject *value)
+{
+    if (!PyCochannelSink_Check(sink)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cochannel_sink_send((cochannel_sink*) sink, value);
+}
+
+PyObject *
+PyCochannel_Recv(PyObject *source)
+{
+    if (!PyCochannelSource_Check(source)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cochannel_source_send((cochannel_source*) source, Py_None);
+}
+
+PyObject *
+PyCochannel_Throw(PyObject *end, PyObject *excinfo)
+{
+    if (PyCochannelSink_Check(end)) {
+        return cochannel_sink_throw((cochannel_sink*) end, excinfo);
+    }
+    if (PyCochannelSource_Check(end)) {
+        return cochannel_source_throw((cochannel_source*) end, excinfo);
+    }
+    PyErr_BadInternalCall();
+    return NULL;
+}
+
+int
+PyCochannel_Close(PyObject *end)
+{
+    PyObject *ret;
+
+    if (PyCochannelSink_Check(end)) {
+        ret = cochannel_sink_close((cochannel_sink*) end, NULL);
+    }
+    else if (PyCochannelSource_Check(end)) {
+        ret = cochannel_source_close((cochannel_source*) end, NULL);
+    }
+    else {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCochannel_Stats(PyObject *end, ctz_stats *out)
+{
+    if (PyCochannelSink_Check(end)) {
+        return _ctz_stats_copy(CTZ_STATS_PTR(((cochannel_sink*) end)->sk_stats), out);
+    }
+    if (PyCochannelSource_Check(end)) {
+        return _ctz_stats_copy(CTZ_STATS_PTR(((cochannel_source*) end)->sr_stats), out);
+    }
+    PyErr_BadInternalCall();
+    return 1;
+}
+
+PyDoc_STRVAR(cochannel_doc,
+             "cochannel(capacity=1024)\n"
+             "\n"
+             "Create a channel for passing values between two threads.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "capacity : int, optional\n"
+             "    The number of values the channel can hold. This is rounded\n"
+             "    up to a power of two.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "sink : cochannel_sink\n"
+             "    A coroutine which pushes the values sent into it.\n"
+             "source : cochannel_source\n"
+             "    An iterator over the values pushed into the sink.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "The channel is a lock-free single-producer/single-consumer\n"
+             "ring buffer. An end only sleeps, on a futex and without the\n"
+             "GIL, when the channel is full or empty. Closing either end\n"
+             "wakes the other: the source drains the values left in the\n"
+             "channel and then raises StopIteration, and sends into the\n"
+             "sink raise StopIteration.\n"
+             "\n"
+             "Pushing and popping hold the GIL, so the producer and the\n"
+             "consumer only run at the same time while one of them is\n"
+             "sleeping or doing work which releases the GIL. cochannel is\n"
+             "not marked as safe to run without the GIL, so this is also\n"
+             "true on a free-threaded build. The channel hands values\n"
+             "between threads, it does not make them run in parallel.\n");
+
+static PyObject *
+cochannel(PyObject *_, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"capacity", NULL};
+    Py_ssize_t capacity = 1024;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|n:cochannel",
+                                     keywords,
+                                     &capacity)) {
+        return NULL;
+    }
+    return PyCochannel_New(capacity);
+}
+
+static PyMethodDef module_methods[] = {
+    {"cochannel",
+     (PyCFunction) cochannel,
+     METH_VARARGS | METH_KEYWORDS,
+     cochannel_doc},
+    {NULL},
+};
+
+PyDoc_STRVAR(module_doc,
+             "cochannel passes values between threads.");
+
+static struct PyModuleDef _cochannel_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._cochannel",
+    module_doc,
+    -1,
+    module_methods,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCochannel_Exported exported_symbols = {
+    PyCochannel_New,
+    PyCochannel_Send,
+    PyCochannel_Recv,
+    PyCochannel_Throw,
+    PyCochannel_Close,
+    PyCochannel_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__cochannel(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCochannelSink_Type) ||
+        PyType_Ready(&PyCochannelSource_Type)) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._cochannel._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_cochannel_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "cochannel_sink",
+                               (PyObject*) &PyCochannelSink_Type) ||
+        PyObject_SetAttrString(m,
+                               "cochannel_source",
+                               (PyObject*) &PyCochannelSource_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,472 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/cointerleave.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+static PyObject *
+inner_cointerleave_new(PyTypeObject *cls, PyObject **crs, Py_ssize_t n)
+{
+    cointerleave *self;
+    PyObject *wrapped;
+    Py_ssize_t m;
+
+    if (!(wrapped = _ctz_coiter_wrap_all(PyCoiter_API, "cointerleave", crs, n))) {
+        return NULL;
+    }
+
+    if (!(self = (cointerleave*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(wrapped);
+        return NULL;
+    }
+    self->il_crs = wrapped;
+    if (!(self->il_active = PyMem_New(Py_ssize_t, n ? n : 1))) {
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    for (m = 0;m < n;++m) {
+        self->il_active[m] = m;
+    }
+    self->il_nactive = n;
+    self->il_pos = 0;
+    self->il_write = 0;
+    return (PyObject*) self;
+}
+
+PyObject *
+PyCointerleave_New(PyObject **crs, Py_ssize_t n)
+{
+    return inner_cointerleave_new(&PyCointerleave_Type, crs, n);
+}
+
+static PyObject *
+cointerleave_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    if (cls == &PyCointerleave_Type &&
+        !_PyArg_NoKeywords("cointerleave()", kwargs)) {
+        return NULL;
+    }
+    assert(PyTuple_Check(args));
+    return inner_cointerleave_new(cls,
+                                  &PyTuple_GET_ITEM(args, 0),
+                                  PyTuple_GET_SIZE(args));
+}
+
+static int
+cointerleave_traverse(cointerleave *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->il_crs);
+    return 0;
+}
+
+static int
+cointerleave_clear(cointerleave *self)
+{
+    Py_CLEAR(self->il_crs);
+    self->il_nactive = self->il_pos = self->il_write = 0;
+    return 0;
+}
+
+static void
+cointerleave_dealloc(cointerleave *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->il_crs);
+    PyMem_Free(self->il_active);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Advance the next coroutine in the rotation.
+ *
+ * Exhausted coroutines are dropped by not writing their index back into
+ * ``il_active``; the live indices are compacted towards the front of the
+ * array as the rotation passes over them, so each removal is O(1) and the
+ * rotation order is kept. Coroutines which raise anything are dropped.
+ *
+ * Paramaters
+ * ----------
+ * value : any
+ *     The value to send into the coroutine.
+ * excinfo : tuple or NULL
+ *     The arguments to ``throw``. If this is not NULL then it is thrown into
+ *     the coroutine instead of sending ``value``.
+ *
+ * Returns
+ * -------
+ * y : any
+ *     A new reference to the value yielded by the coroutine.
+ */
+static PyObject *
+cointerleave_step(cointerleave *self, PyObject *value, PyObject *excinfo)
+{
+    Py_ssize_t index;
+    PyObject *cr;
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
+
+    for (;;) {
+        if (self->il_pos == self->il_nactive) {
+            /* the end of a round, the exhausted coroutines are gone */
+            self->il_nactive = self->il_write;
+            self->il_pos = self->il_write = 0;
+            if (!self->il_nactive) {
+                PyErr_SetNone(PyExc_StopIteration);
+                return NULL;
+            }
+        }
+        index = self->il_active[self->il_pos++];
+        cr = PyTuple_GET_ITEM(self->il_crs, index);
+
+        CTZ_STATS_START(start);
+        if (excinfo) {
+            ret = PyCoiter_API->throw(cr, excinfo);
+        }
+        else {
+            ret = PyCoiter_API->send(cr, value);
+        }
+        CTZ_STATS_ELAPSED(self->il_stats, child, start);
+
+        if (ret) {
+            self->il_active[self->il_write++] = index;
+            return ret;
+        }
+        if (!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+            return NULL;
+        }
+        PyErr_Clear();
+    }
+}
+
+PyDoc_STRVAR(cointerleave_send_doc,
+             "Send a value into the next coroutine in the rotation.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to send in.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The value yielded by the coroutine.\n");
+
+static PyObject *
+cointerleave_send(cointerleave *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cointerleave_send, self, self->il_nactive);
+    CTZ_STATS_INCR(self->il_stats, sends);
+    ret = cointerleave_step(self, value, NULL);
+    CTZ_STATS_STOP(self->il_stats, ret);
+    CTZ_PROBE_RETURN(cointerleave_send, self, self->il_nactive, ret);
+    return ret;
+}
+
+PyObject *
+PyCointerleave_Send(PyObject *il, PyObject *value)
+{
+    if (!PyCointerleave_Check(il)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cointerleave_send((cointerleave*) il, value);
+}
+
+static PyObject *
+cointerleave_next(cointerleave *self)
+{
+    return cointerleave_send(self, Py_None);
+}
+
+PyDoc_STRVAR(cointerleave_throw_doc,
+             "Throw an exception into the next coroutine in the rotation.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The value yielded by the coroutine.\n");
+
+static PyObject *
+cointerleave_throw(cointerleave *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cointerleave_throw, self, self->il_nactive);
+    CTZ_STATS_INCR(self->il_stats, throws);
+    ret = cointerleave_step(self, NULL, args);
+    CTZ_STATS_STOP(self->il_stats, ret);
+    CTZ_PROBE_RETURN(cointerleave_throw, self, self->il_nactive, ret);
+    return ret;
+}
+
+PyObject *
+PyCointerleave_Throw(PyObject *il, PyObject *excinfo)
+{
+    if (!PyCointerleave_Check(il)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cointerleave_throw((cointerleave*) il, excinfo);
+}
+
+PyDoc_STRVAR(cointerleave_close_doc,
+             "Close the cointerleave."
+             "\n"
+             "This closes all of the inner coroutines.\n");
+
+static PyObject *
+inner_cointerleave_close(cointerleave *self, PyObject *_)
+{
+    Py_ssize_t n;
+    PyObject *type = NULL;
+    PyObject *exc = NULL;
+    PyObject *tb = NULL;
+
+    CTZ_STATS_INCR(self->il_stats, closes);
+    self->il_nactive = self->il_pos = self->il_write = 0;
+
+    /* Close every coroutine even if one fails and raise the first error. */
+    for (n = 0;n < PyTuple_GET_SIZE(self->il_crs);++n) {
+        if (PyCoiter_API->close(PyTuple_GET_ITEM(self->il_crs, n))) {
+            if (type) {
+                PyErr_Clear();
+            }
+            else {
+                PyErr_Fetch(&type, &exc, &tb);
+            }
+        }
+    }
+    if (type) {
+        PyErr_Restore(type, exc, tb);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+cointerleave_close(cointerleave *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cointerleave_close, self, self->il_nactive);
+    ret = inner_cointerleave_close(self, _);
+    CTZ_PROBE_RETURN(cointerleave_close, self, self->il_nactive, ret);
+    return ret;
+}
+
+int
+PyCointerleave_Close(PyObject *il)
+{
+    PyObject *ret;
+
+    if (!PyCointerleave_Check(il)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = cointerleave_close((cointerleave*) il, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCointerleave_Stats(PyObject *il, ctz_stats *out)
+{
+    if (!PyCointerleave_Check(il)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((cointerleave*) il)->il_stats), out);
+}
+
+PyDoc_STRVAR(cointerleave_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+cointerleave_stats(cointerleave *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->il_stats));
+}
+
+static PyMethodDef cointerleave_methods[] = {
+    {"send", (PyCFunction) cointerleave_send, METH_O, cointerleave_send_doc},
+    {"throw",
+     (PyCFunction) cointerleave_throw,
+     METH_VARARGS,
+     cointerleave_throw_doc},
+    {"close",
+     (PyCFunction) cointerleave_close,
+     METH_NOARGS,
+     cointerleave_close_doc},
+    {"stats",
+     (PyCFunction) cointerleave_stats,
+     METH_NOARGS,
+     cointerleave_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(cointerleave, a)
+
+static PyMemberDef cointerleave_members[] = {
+    {"children", T_OBJECT_EX, OFF(il_crs), READONLY,
+     "The coiter wrapped coroutines being interleaved."},
+    {NULL},
+};
+
+#undef OFF
+
+PyDoc_STRVAR(cointerleave_doc,
+             "Interleave coroutines by advancing them in round-robin order.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "*coroutines\n"
+             "    The coroutines to interleave.\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Sends a value into the next coroutine in the rotation.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Throws an exception into the next coroutine in the\n"
+             "    rotation.\n"
+             "close()\n"
+             "    Closes the cointerleave by closing all of the inner\n"
+             "    coroutines.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this cointerleave.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Each step advances exactly one coroutine. Exhausted coroutines\n"
+             "are dropped from the rotation and the next coroutine is\n"
+             "advanced in their place.\n"
+    );
+
+PyTypeObject PyCointerleave_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._cointerleave.cointerleave",   /* tp_name */
+    sizeof(cointerleave),                   /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) cointerleave_dealloc,      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    cointerleave_doc,                       /* tp_doc */
+    (traverseproc) cointerleave_traverse,   /* tp_traverse */
+    (inquiry) cointerleave_clear,           /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) cointerleave_next,       /* tp_iternext */
+    cointerleave_methods,                   /* tp_methods */
+    cointerleave_members,                   /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    cointerleave_new,                       /* tp_new */
+};
+
+PyDoc_STRVAR(module_doc,
+             "cointerleave is a round-robin of coroutines.");
+
+static struct PyModuleDef _cointerleave_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._cointerleave",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCointerleave_Exported exported_symbols = {
+    PyCointerleave_New,
+    PyCointerleave_Send,
+    PyCointerleave_Throw,
+    PyCointerleave_Close,
+    PyCointerleave_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__cointerleave(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCointerleave_Type)) {
+        return NULL;
+    }
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._cointerleave._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_cointerleave_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "cointerleave",
+                               (PyObject*) &PyCointerleave_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
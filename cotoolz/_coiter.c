@@ -3,6 +3,7 @@
 
 #include "cotoolz/coiter.h"
 #include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
 
 static PyObject *
 inner_coiter_new(PyTypeObject *cls, PyObject *it)
@@ -75,17 +76,28 @@ coiter_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
 PyObject *
 PyCoiter_Throw(PyObject *ci, PyObject *excinfo)
 {
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
+
     if (!PyCoiter_Check(ci)) {
         PyErr_BadInternalCall();
         return NULL;
     }
-    return PyObject_Call(((coiter*) ci)->ci_throw, excinfo, NULL);
+    CTZ_PROBE_ENTRY(coiter_throw, ci, 1);
+    CTZ_STATS_INCR(((coiter*) ci)->ci_stats, throws);
+    CTZ_STATS_START(start);
+    ret = PyObject_Call(((coiter*) ci)->ci_throw, excinfo, NULL);
+    CTZ_STATS_ELAPSED(((coiter*) ci)->ci_stats, child, start);
+    CTZ_STATS_STOP(((coiter*) ci)->ci_stats, ret);
+    CTZ_PROBE_RETURN(coiter_throw, ci, 1, ret);
+    return ret;
 }
 
 int
 PyCoiter_Close(PyObject *ci)
 {
     static PyObject *empty = NULL;
+    PyObject *ret;
 
     if (!PyCoiter_Check(ci)) {
         PyErr_BadInternalCall();
@@ -94,8 +106,12 @@ PyCoiter_Close(PyObject *ci)
     if (!empty && !(empty = PyTuple_New(0))) {
         return 1;
     }
-    Py_DECREF(PyObject_Call(((coiter*) ci)->ci_close, empty, NULL));
-    return 0;
+    CTZ_PROBE_ENTRY(coiter_close, ci, 1);
+    CTZ_STATS_INCR(((coiter*) ci)->ci_stats, closes);
+    ret = PyObject_Call(((coiter*) ci)->ci_close, empty, NULL);
+    CTZ_PROBE_RETURN(coiter_close, ci, 1, ret);
+    Py_XDECREF(ret);
+    return !ret;
 }
 
 static int
@@ -135,18 +151,26 @@ coiter_send(coiter *self, PyObject *value)
     static PyObject * volatile cached_args = NULL;
     PyObject *args;
     PyObject * ret;
+    CTZ_STATS_DECL(start);
 
+    CTZ_PROBE_ENTRY(coiter_send, self, 1);
+    CTZ_STATS_INCR(self->ci_stats, sends);
     args = cached_args;
     if (!args || Py_REFCNT(args) != 1) {
         Py_CLEAR(cached_args);
-        if (!(cached_args = args = PyTuple_New(1)))
+        if (!(cached_args = args = PyTuple_New(1))) {
+            CTZ_PROBE_RETURN(coiter_send, self, 1, NULL);
             return NULL;
+        }
     }
     Py_INCREF(args);
     assert (Py_REFCNT(args) == 2);
     Py_INCREF(value);
     PyTuple_SET_ITEM(args, 0, value);
+    CTZ_STATS_START(start);
     ret = PyObject_Call(((coiter*) self)->ci_send, args, NULL);
+    CTZ_STATS_ELAPSED(self->ci_stats, child, start);
+    CTZ_STATS_STOP(self->ci_stats, ret);
     if (args == cached_args) {
         if (Py_REFCNT(args) == 2) {
             value = PyTuple_GET_ITEM(args, 0);
@@ -158,6 +182,7 @@ coiter_send(coiter *self, PyObject *value)
         }
     }
     Py_DECREF(args);
+    CTZ_PROBE_RETURN(coiter_send, self, 1, ret);
     return ret;
 }
 
@@ -171,6 +196,26 @@ PyCoiter_Send(PyObject *ci, PyObject *value)
     return coiter_send((coiter*) ci, value);
 }
 
+Py_ssize_t
+PyCoiter_SendN(PyObject *ci,
+               PyObject **values,
+               Py_ssize_t n,
+               PyObject **out)
+{
+    Py_ssize_t m;
+
+    if (!PyCoiter_Check(ci)) {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+    for (m = 0;m < n;++m) {
+        if (!(out[m] = coiter_send((coiter*) ci, values[m]))) {
+            break;
+        }
+    }
+    return m;
+}
+
 static PyObject *
 coiter_iternext(coiter *self)
 {
@@ -261,6 +306,24 @@ coiter__close(coiter *self, PyObject *_)
     Py_RETURN_NONE;
 }
 
+int
+PyCoiter_Stats(PyObject *ci, ctz_stats *out)
+{
+    if (!PyCoiter_Check(ci)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((coiter*) ci)->ci_stats), out);
+}
+
+PyDoc_STRVAR(coiter_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+coiter_stats(coiter *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->ci_stats));
+}
+
 static PyObject *
 coiter___reduce__(coiter *self, PyObject *args)
 {
@@ -276,6 +339,7 @@ static PyMethodDef coiter_methods[] = {
     {"_send", (PyCFunction) coiter__send, METH_O, coiter__send_doc},
     {"_throw", (PyCFunction) coiter__throw, METH_VARARGS, coiter__throw_doc},
     {"_close", (PyCFunction) coiter__close, METH_NOARGS, coiter__close_doc},
+    {"stats", (PyCFunction) coiter_stats, METH_NOARGS, coiter_stats_doc},
     {"__reduce__", (PyCFunction) coiter___reduce__, METH_NOARGS, ""},
     {NULL},
 };
@@ -292,6 +356,18 @@ static PyMemberDef coiter_members[] = {
 
 #undef OFF
 
+static PyObject *
+coiter_children(coiter *self, void *_)
+{
+    return PyTuple_Pack(1, self->ci_it);
+}
+
+static PyGetSetDef coiter_getsets[] = {
+    {"children", (getter) coiter_children, NULL,
+     "A tuple holding the wrapped iterator.", NULL},
+    {NULL},
+};
+
 PyDoc_STRVAR(coiter_doc,
              "A wrapper around standard iterators that allows them to\n"
              "respond to the coroutine protocol.\n"
@@ -311,7 +387,10 @@ PyDoc_STRVAR(coiter_doc,
              "throw(exc) or throw(type, arg, traceback)\n"
              "    Emulates throwing an exception into the iterator.\n"
              "close()\n"
-             "    Emulates closing the iterator.\n");
+             "    Emulates closing the iterator.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this coiter. Only the\n"
+             "    calls made through iteration and the C API are counted.\n");
 
 PyTypeObject PyCoiter_Type = {
     PyVarObject_HEAD_INIT(&PyType_Type, 0)
@@ -345,7 +424,7 @@ PyTypeObject PyCoiter_Type = {
     (iternextfunc) coiter_iternext,             /* tp_iternext */
     coiter_methods,                             /* tp_methods */
     coiter_members,                             /* tp_members */
-    0,                                          /* tp_getset */
+    coiter_getsets,                             /* tp_getset */
     0,                                          /* tp_base */
     0,                                          /* tp_dict */
     0,                                          /* tp_descr_get */
@@ -380,6 +459,8 @@ static PyCoiter_Exported exported_symbols = {
     PyCoiter_Send,
     PyCoiter_Throw,
     PyCoiter_Close,
+    PyCoiter_Stats,
+    PyCoiter_SendN,
 };
 
 PyMODINIT_FUNC
@@ -419,5 +500,21 @@ PyInit__coiter(void)
         Py_DECREF(m);
         return NULL;
     }
+    if (PyObject_SetAttrString(m,
+                               "stats_enabled",
+                               CTZ_STATS_ENABLED ? Py_True : Py_False)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyObject_SetAttrString(m,
+                               "usdt_enabled",
+                               CTZ_USDT_ENABLED ? Py_True : Py_False)) {
+        Py_DECREF(m);
+        return NULL;
+    }
     return m;
 }
@@ -1,28 +1,141 @@
 #include <stdarg.h>
 
 #include <Python.h>
+#include <structmember.h>
 
 #include "cotoolz/coiter.h"
 #include "cotoolz/comap.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/fuse.h"
+#include "cotoolz/probes.h"
 
 PyCoiter_Exported *PyCoiter_API;
 
+#define COMAP_FINISHED(cm, n) ((cm)->cm_finished[(n) >> 3] & (1 << ((n) & 7)))
+#define COMAP_SET_FINISHED(cm, n) ((cm)->cm_finished[(n) >> 3] |= 1 << ((n) & 7))
+
+static unsigned char *
+comap_new_finished(Py_ssize_t n)
+{
+    unsigned char *finished;
+
+    if (!(finished = PyMem_Calloc((n + 7) / 8 + 1, 1))) {
+        PyErr_NoMemory();
+    }
+    return finished;
+}
+
+/* Mark the ``n``th coroutine as exhausted if it raised StopIteration. */
+static void
+comap_child_stopped(comap *cm, Py_ssize_t n)
+{
+    if (!PyErr_ExceptionMatches(PyExc_StopIteration) ||
+        COMAP_FINISHED(cm, n)) {
+        return;
+    }
+    COMAP_SET_FINISHED(cm, n);
+    ++cm->cm_nfinished;
+}
+
+/* Whether ``comap(func, child)`` can be built by fusing ``child`` into the new
+ * comap.
+ *
+ * Only unbatched, exact comaps are fused, and only when ``child`` is a
+ * temporary on the caller's stack, so that nothing else can observe that the
+ * inner node is no longer stepped.
+ */
+static int
+comap_can_fuse(PyObject *child)
+{
+    return (PyComap_CheckExact(child) &&
+            !((comap*) child)->cm_batch &&
+            _ctz_is_unique_temporary(child));
+}
+
+/* Build ``comap(func, inner)`` as a single node which steps ``inner``'s
+ * coroutines directly and then applies ``inner``'s functions and ``func`` in
+ * a C loop.
+ */
+static PyObject *
+comap_fuse(PyTypeObject *cls, PyObject *func, comap *inner)
+{
+    comap *cm;
+    PyObject *chain;
+    PyObject *f;
+    unsigned char *finished;
+    Py_ssize_t depth = inner->cm_chain ? PyTuple_GET_SIZE(inner->cm_chain) : 0;
+    Py_ssize_t n;
+
+    if (!(finished = comap_new_finished(PyTuple_GET_SIZE(inner->cm_crs)))) {
+        return NULL;
+    }
+    memcpy(finished,
+           inner->cm_finished,
+           (PyTuple_GET_SIZE(inner->cm_crs) + 7) / 8 + 1);
+    if (!(chain = PyTuple_New(depth + 1))) {
+        PyMem_Free(finished);
+        return NULL;
+    }
+    for (n = 0;n < depth;++n) {
+        f = PyTuple_GET_ITEM(inner->cm_chain, n);
+        Py_INCREF(f);
+        PyTuple_SET_ITEM(chain, n, f);
+    }
+    Py_INCREF(inner->cm_func);
+    PyTuple_SET_ITEM(chain, depth, inner->cm_func);
+
+    if (!(cm = (comap*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(chain);
+        PyMem_Free(finished);
+        return NULL;
+    }
+    Py_INCREF(inner->cm_crs);
+    cm->cm_crs = inner->cm_crs;
+    Py_INCREF(func);
+    cm->cm_func = func;
+    cm->cm_batch = 0;
+    cm->cm_flatten = 1;
+    cm->cm_pending = NULL;
+    cm->cm_chain = chain;
+    cm->cm_finished = finished;
+    cm->cm_nfinished = inner->cm_nfinished;
+    cm->cm_done = inner->cm_done;
+    cm->cm_closed = inner->cm_closed;
+    return (PyObject*) cm;
+}
+
 static PyObject *
-inner_comap_new(PyTypeObject *cls, Py_ssize_t n, PyObject *args)
+inner_comap_new(PyTypeObject *cls,
+                Py_ssize_t n,
+                PyObject *args,
+                Py_ssize_t batch,
+                int flatten)
 {
     PyObject *crs;
     PyObject *cr;
     comap *cm;
     PyObject *func;
+    unsigned char *finished;
 
     assert(PyTuple_Check(args));
+    if (batch < 0) {
+        PyErr_Format(PyExc_ValueError,
+                     "comap() batch must be non-negative, got %zd",
+                     batch);
+        return NULL;
+    }
+    if (!(finished = comap_new_finished(n))) {
+        return NULL;
+    }
     if (!(crs = PyTuple_New(n))) {
+        PyMem_Free(finished);
         return NULL;
     }
 
     for (;n > 0;--n) {
         if (!(cr = PyCoiter_API->new(PyTuple_GET_ITEM(args, n)))) {
             Py_DECREF(crs);
+            PyMem_Free(finished);
             return NULL;
         }
         PyTuple_SET_ITEM(crs, n - 1, cr);
@@ -30,23 +143,64 @@ inner_comap_new(PyTypeObject *cls, Py_ssize_t n, PyObject *args)
 
     if (!(cm = (comap*) cls->tp_alloc(cls, 0))) {
         Py_DECREF(crs);
+        PyMem_Free(finished);
         return NULL;
     }
     cm->cm_crs = crs;
     func = PyTuple_GET_ITEM(args, 0);
     Py_INCREF(func);
     cm->cm_func = func;
+    cm->cm_batch = batch;
+    cm->cm_flatten = flatten;
+    cm->cm_pending = NULL;
+    cm->cm_chain = NULL;
+    cm->cm_finished = finished;
+    cm->cm_nfinished = 0;
+    cm->cm_done = 0;
+    cm->cm_closed = 0;
 
     return (PyObject*) cm;
 }
 
 PyObject *
-PyComap_New(PyObject *func, Py_ssize_t n, ...)
+PyComap_FromArray(PyObject *func, PyObject **crs, Py_ssize_t n)
+{
+    PyObject *args;
+    PyObject *ret;
+    Py_ssize_t m;
+
+    if (n < 1) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+
+    if (!(args = PyTuple_New(n + 1))) {
+        return NULL;
+    }
+
+    Py_INCREF(func);
+    PyTuple_SET_ITEM(args, 0, func);
+
+    for (m = 0;m < n;++m) {
+        Py_INCREF(crs[m]);
+        PyTuple_SET_ITEM(args, m + 1, crs[m]);
+    }
+
+    ret = inner_comap_new(&PyComap_Type, n, args, 0, 1);
+    Py_DECREF(args);
+    return ret;
+}
+
+static PyObject *
+comap_from_va(PyObject *func,
+              Py_ssize_t batch,
+              int flatten,
+              Py_ssize_t n,
+              va_list vargs)
 {
     PyObject *args;
     PyObject *item;
     Py_ssize_t m;
-    va_list vargs;
 
     if (n < 1) {
         PyErr_BadInternalCall();
@@ -60,26 +214,66 @@ PyComap_New(PyObject *func, Py_ssize_t n, ...)
     Py_INCREF(func);
     PyTuple_SET_ITEM(args, 0, func);
 
-    va_start(vargs, n);
     for (m = 1;m <= n;++m) {
         item = va_arg(vargs, PyObject*);
         Py_INCREF(item);
         PyTuple_SET_ITEM(args, m, item);
     }
-    va_end(vargs);
 
-    item = inner_comap_new(&PyComap_Type, n, args);
+    item = inner_comap_new(&PyComap_Type, n, args, batch, flatten);
     Py_DECREF(args);
     return item;
 }
 
+PyObject *
+PyComap_New(PyObject *func, Py_ssize_t n, ...)
+{
+    PyObject *ret;
+    va_list vargs;
+
+    va_start(vargs, n);
+    ret = comap_from_va(func, 0, 1, n, vargs);
+    va_end(vargs);
+    return ret;
+}
+
+PyObject *
+PyComap_NewBatched(PyObject *func,
+                   Py_ssize_t batch,
+                   int flatten,
+                   Py_ssize_t n,
+                   ...)
+{
+    PyObject *ret;
+    va_list vargs;
+
+    va_start(vargs, n);
+    ret = comap_from_va(func, batch, flatten, n, vargs);
+    va_end(vargs);
+    return ret;
+}
+
 static PyObject *
 comap_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
 {
+    static char *keywords[] = {"batch", "flatten", NULL};
+    static PyObject *empty = NULL;
     Py_ssize_t n;
+    Py_ssize_t batch = 0;
+    int flatten = 1;
 
-    if (cls == &PyComap_Type && !_PyArg_NoKeywords("comap()", kwargs)) {
-        return NULL;
+    if (kwargs && cls == &PyComap_Type) {
+        if (!empty && !(empty = PyTuple_New(0))) {
+            return NULL;
+        }
+        if (!PyArg_ParseTupleAndKeywords(empty,
+                                         kwargs,
+                                         "|$np:comap",
+                                         keywords,
+                                         &batch,
+                                         &flatten)) {
+            return NULL;
+        }
     }
 
     assert(PyTuple_Check(args));
@@ -88,7 +282,278 @@ comap_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
                         "comap() must have at least two arguments.");
         return NULL;
     }
-    return inner_comap_new(cls, n - 1, args);
+    return inner_comap_new(cls, n - 1, args, batch, flatten);
+}
+
+/* Called for ``comap(...)`` from Python. This is the only place nested comaps
+ * are fused, see fuse.h.
+ */
+static PyObject *
+comap_vectorcall(PyTypeObject *cls,
+                 PyObject *const *args,
+                 size_t nargsf,
+                 PyObject *kwnames)
+{
+    if (!kwnames &&
+        PyVectorcall_NARGS(nargsf) == 2 &&
+        comap_can_fuse(args[1])) {
+        return comap_fuse(cls, args[0], (comap*) args[1]);
+    }
+    return _ctz_vectorcall_new(cls, args, nargsf, kwnames);
+}
+
+static int
+comap_traverse(comap *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->cm_crs);
+    Py_VISIT(self->cm_func);
+    Py_VISIT(self->cm_pending);
+    Py_VISIT(self->cm_chain);
+    return 0;
+}
+
+static int
+comap_clear(comap *self)
+{
+    Py_CLEAR(self->cm_crs);
+    Py_CLEAR(self->cm_func);
+    Py_CLEAR(self->cm_pending);
+    Py_CLEAR(self->cm_chain);
+    return 0;
+}
+
+static void
+comap_dealloc(comap *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->cm_crs);
+    Py_XDECREF(self->cm_func);
+    Py_XDECREF(self->cm_pending);
+    Py_XDECREF(self->cm_chain);
+    PyMem_Free(self->cm_finished);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Call the comap's function on the values of the inner coroutines.
+ *
+ * A fused comap first calls the innermost fused function with the values and
+ * then passes the result through the rest of the chain one call at a time.
+ * A StopIteration raised by the chain finishes the comap, as it would have
+ * finished the inner comaps before they were fused.
+ */
+static PyObject *
+comap_call(comap *self, PyObject *argtuple)
+{
+    PyObject *y;
+    PyObject *ret;
+    Py_ssize_t n;
+
+    if (!self->cm_chain) {
+        return PyObject_Call(self->cm_func, argtuple, NULL);
+    }
+    if (!(y = PyObject_Call(PyTuple_GET_ITEM(self->cm_chain, 0),
+                            argtuple,
+                            NULL))) {
+        goto chain_error;
+    }
+    for (n = 1;n < PyTuple_GET_SIZE(self->cm_chain);++n) {
+        ret = PyObject_CallOneArg(PyTuple_GET_ITEM(self->cm_chain, n), y);
+        Py_DECREF(y);
+        if (!ret) {
+            goto chain_error;
+        }
+        y = ret;
+    }
+    ret = PyObject_CallOneArg(self->cm_func, y);
+    Py_DECREF(y);
+    return ret;
+
+chain_error:
+    if (PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        self->cm_done = 1;
+    }
+    return NULL;
+}
+
+/* Pull up to ``cm_batch`` values out of each of the inner coroutines and call
+ * ``cm_func`` with one list of values per coroutine.
+ *
+ * The first step of the batch is produced by calling ``meth(values[n])`` on
+ * the ``n``th inner coroutine if ``values`` is given, otherwise
+ * ``meth(*args)`` on each of them. The remaining steps are produced with
+ * ``next``. If any
+ * coroutine is exhausted part way through the batch, the batch is truncated
+ * to the number of steps that every coroutine produced and the comap is
+ * done once the batch has been consumed.
+ */
+static PyObject *
+comap_call_batch(comap *self,
+                 PyObject *methstr,
+                 PyObject *args,
+                 PyObject **values)
+{
+    Py_ssize_t ncrs = PyTuple_GET_SIZE(self->cm_crs);
+    Py_ssize_t n;
+    Py_ssize_t m;
+    Py_ssize_t k;
+    PyObject *argtuple;
+    PyObject *batch;
+    PyObject *meth;
+    PyObject *y;
+    int err;
+    PyObject *ret = NULL;
+    CTZ_STATS_DECL(start);
+
+    if (self->cm_done) {
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+    if (!(argtuple = PyTuple_New(ncrs))) {
+        return NULL;
+    }
+    for (n = 0;n < ncrs;++n) {
+        if (!(batch = PyList_New(0))) {
+            goto error;
+        }
+        PyTuple_SET_ITEM(argtuple, n, batch);
+    }
+
+    CTZ_STATS_START(start);
+    for (n = 0;n < ncrs;++n) {
+        if (values) {
+            y = PyObject_CallMethodOneArg(PyTuple_GET_ITEM(self->cm_crs, n),
+                                          methstr,
+                                          values[n]);
+        }
+        else {
+            if (!(meth = PyObject_GetAttr(PyTuple_GET_ITEM(self->cm_crs, n),
+                                          methstr))) {
+                goto error;
+            }
+            y = PyObject_Call(meth, args, NULL);
+            Py_DECREF(meth);
+        }
+        if (!y) {
+            comap_child_stopped(self, n);
+            self->cm_done = self->cm_nfinished != 0;
+            goto error;
+        }
+        err = PyList_Append(PyTuple_GET_ITEM(argtuple, n), y);
+        Py_DECREF(y);
+        if (err) {
+            goto error;
+        }
+    }
+
+    for (m = 1;m < self->cm_batch;++m) {
+        for (n = 0;n < ncrs;++n) {
+            if (!(y = PyIter_Next(PyTuple_GET_ITEM(self->cm_crs, n)))) {
+                if (PyErr_Occurred()) {
+                    goto error;
+                }
+                COMAP_SET_FINISHED(self, n);
+                ++self->cm_nfinished;
+                self->cm_done = 1;
+                for (k = 0;k < n;++k) {
+                    if (PyList_SetSlice(PyTuple_GET_ITEM(argtuple, k),
+                                        m,
+                                        m + 1,
+                                        NULL)) {
+                        goto error;
+                    }
+                }
+                goto call;
+            }
+            err = PyList_Append(PyTuple_GET_ITEM(argtuple, n), y);
+            Py_DECREF(y);
+            if (err) {
+                goto error;
+            }
+        }
+    }
+
+call:
+    CTZ_STATS_ELAPSED(self->cm_stats, child, start);
+    CTZ_STATS_START(start);
+    ret = PyObject_Call(self->cm_func, argtuple, NULL);
+    CTZ_STATS_ELAPSED(self->cm_stats, func, start);
+    Py_DECREF(argtuple);
+    return ret;
+error:
+    CTZ_STATS_ELAPSED(self->cm_stats, child, start);
+    Py_DECREF(argtuple);
+    return NULL;
+}
+
+/* Step a batched comap.
+ *
+ * If the comap is flattened and there are still results left over from the
+ * last batch, the next one is returned and ``args`` and ``values`` are
+ * ignored. Otherwise a new batch is pulled with ``comap_call_batch``.
+ */
+static PyObject *
+comap_batched(comap *self,
+              PyObject *methstr,
+              PyObject *args,
+              PyObject **values)
+{
+    PyObject *res;
+    PyObject *it;
+    PyObject *y;
+    PyObject *sendstr = NULL;
+    PyObject *nonetuple = NULL;
+
+    if (!self->cm_flatten) {
+        return comap_call_batch(self, methstr, args, values);
+    }
+
+    if (self->cm_pending) {
+        if ((y = PyIter_Next(self->cm_pending))) {
+            return y;
+        }
+        Py_CLEAR(self->cm_pending);
+        if (PyErr_Occurred()) {
+            return NULL;
+        }
+    }
+
+    for (;;) {
+        if (!(res = comap_call_batch(self, methstr, args, values))) {
+            y = NULL;
+            break;
+        }
+        it = PyObject_GetIter(res);
+        Py_DECREF(res);
+        if (!it) {
+            y = NULL;
+            break;
+        }
+        if ((y = PyIter_Next(it))) {
+            self->cm_pending = it;
+            break;
+        }
+        Py_DECREF(it);
+        if (PyErr_Occurred()) {
+            break;
+        }
+
+        /* ``func`` returned an empty batch, pull the next one */
+        if (!sendstr) {
+            if (!(sendstr = PyUnicode_FromString("send"))) {
+                break;
+            }
+            if (!(nonetuple = PyTuple_Pack(1, Py_None))) {
+                break;
+            }
+            methstr = sendstr;
+            args = nonetuple;
+            values = NULL;
+        }
+    }
+
+    Py_XDECREF(sendstr);
+    Py_XDECREF(nonetuple);
+    return y;
 }
 
 PyDoc_STRVAR(comap_send_doc,
@@ -106,7 +571,7 @@ PyDoc_STRVAR(comap_send_doc,
              "    of sending the value into the inner coroutine(s).\n");
 
 static PyObject *
-comap_send(comap *self, PyObject *value)
+inner_comap_send(comap *self, PyObject *value)
 {
     Py_ssize_t n;
     PyObject *valuetuple = NULL;
@@ -115,6 +580,28 @@ comap_send(comap *self, PyObject *value)
     PyObject *sendstr = NULL;
     PyObject *send;
     PyObject *ret = NULL;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->cm_stats, sends);
+    if (self->cm_done && !self->cm_pending) {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_INCR(self->cm_stats, stops);
+        return NULL;
+    }
+    if (self->cm_batch) {
+        if (!(sendstr = PyUnicode_FromString("send"))) {
+            return NULL;
+        }
+        if (!(valuetuple = PyTuple_Pack(1, value))) {
+            Py_DECREF(sendstr);
+            return NULL;
+        }
+        ret = comap_batched(self, sendstr, valuetuple, NULL);
+        Py_DECREF(sendstr);
+        Py_DECREF(valuetuple);
+        CTZ_STATS_STOP(self->cm_stats, ret);
+        return ret;
+    }
 
     n = PyTuple_GET_SIZE(self->cm_crs);
     if (!(argtuple = PyTuple_New(n))) {
@@ -127,6 +614,7 @@ comap_send(comap *self, PyObject *value)
         goto error;
     }
 
+    CTZ_STATS_START(start);
     for (;n;--n) {
         if (!(send = PyObject_GetAttr(PyTuple_GET_ITEM(self->cm_crs, n - 1),
                                       sendstr))) {
@@ -135,12 +623,19 @@ comap_send(comap *self, PyObject *value)
         y = PyObject_Call(send, valuetuple, NULL);
         Py_DECREF(send);
         if (!y) {
+            comap_child_stopped(self, n - 1);
+            self->cm_done = self->cm_nfinished != 0;
+            CTZ_STATS_ELAPSED(self->cm_stats, child, start);
+            CTZ_STATS_STOP(self->cm_stats, y);
             goto error;
         }
         PyTuple_SET_ITEM(argtuple, n - 1, y);
     }
+    CTZ_STATS_ELAPSED(self->cm_stats, child, start);
 
-    ret = PyObject_Call(self->cm_func, argtuple, NULL);
+    CTZ_STATS_START(start);
+    ret = comap_call(self, argtuple);
+    CTZ_STATS_ELAPSED(self->cm_stats, func, start);
 error:
     Py_XDECREF(argtuple);
     Py_XDECREF(sendstr);
@@ -148,6 +643,17 @@ error:
     return ret;
 }
 
+static PyObject *
+comap_send(comap *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(comap_send, self, PyTuple_GET_SIZE(self->cm_crs));
+    ret = inner_comap_send(self, value);
+    CTZ_PROBE_RETURN(comap_send, self, PyTuple_GET_SIZE(self->cm_crs), ret);
+    return ret;
+}
+
 PyObject *
 PyComap_Send(PyObject *cm, PyObject *value)
 {
@@ -161,9 +667,122 @@ PyComap_Send(PyObject *cm, PyObject *value)
 static PyObject *
 comap_iternext(comap *self)
 {
+    if (self->cm_done && !self->cm_pending) {
+        return NULL;
+    }
     return comap_send(self, Py_None);
 }
 
+PyDoc_STRVAR(comap_send_each_doc,
+             "Send a different value into each of the inner coroutines.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "values : sequence\n"
+             "    One value for each inner coroutine, in the order the\n"
+             "    coroutines were passed.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The result of applying the comap's function over the results\n"
+             "    of sending the values into the inner coroutines.\n");
+
+static PyObject *
+inner_comap_send_each(comap *self, PyObject **values, Py_ssize_t n)
+{
+    PyObject *argtuple = NULL;
+    PyObject *y;
+    PyObject *sendstr;
+    PyObject *ret = NULL;
+    CTZ_STATS_DECL(start);
+
+    if (n != PyTuple_GET_SIZE(self->cm_crs)) {
+        PyErr_Format(PyExc_ValueError,
+                     "comap.send_each() expected %zd values, got %zd",
+                     PyTuple_GET_SIZE(self->cm_crs),
+                     n);
+        return NULL;
+    }
+    CTZ_STATS_INCR(self->cm_stats, sends);
+    if (self->cm_done && !self->cm_pending) {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_INCR(self->cm_stats, stops);
+        return NULL;
+    }
+    if (!(sendstr = PyUnicode_FromString("send"))) {
+        return NULL;
+    }
+    if (self->cm_batch) {
+        ret = comap_batched(self, sendstr, NULL, values);
+        CTZ_STATS_STOP(self->cm_stats, ret);
+        goto error;
+    }
+
+    if (!(argtuple = PyTuple_New(n))) {
+        goto error;
+    }
+    CTZ_STATS_START(start);
+    for (;n;--n) {
+        if (!(y = PyObject_CallMethodOneArg(
+                  PyTuple_GET_ITEM(self->cm_crs, n - 1),
+                  sendstr,
+                  values[n - 1]))) {
+            comap_child_stopped(self, n - 1);
+            self->cm_done = self->cm_nfinished != 0;
+            CTZ_STATS_ELAPSED(self->cm_stats, child, start);
+            CTZ_STATS_STOP(self->cm_stats, y);
+            goto error;
+        }
+        PyTuple_SET_ITEM(argtuple, n - 1, y);
+    }
+    CTZ_STATS_ELAPSED(self->cm_stats, child, start);
+
+    CTZ_STATS_START(start);
+    ret = comap_call(self, argtuple);
+    CTZ_STATS_ELAPSED(self->cm_stats, func, start);
+error:
+    Py_XDECREF(argtuple);
+    Py_DECREF(sendstr);
+    return ret;
+}
+
+PyObject *
+PyComap_SendEach(PyObject *cm, PyObject **values, Py_ssize_t n)
+{
+    PyObject *ret;
+
+    if (!PyComap_Check(cm)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    CTZ_PROBE_ENTRY(comap_send, cm, PyTuple_GET_SIZE(((comap*) cm)->cm_crs));
+    ret = inner_comap_send_each((comap*) cm, values, n);
+    CTZ_PROBE_RETURN(comap_send,
+                     cm,
+                     PyTuple_GET_SIZE(((comap*) cm)->cm_crs),
+                     ret);
+    return ret;
+}
+
+static PyObject *
+comap_send_each(comap *self, PyObject *values)
+{
+    PyObject *seq;
+    PyObject *ret;
+
+    if (!(seq = PySequence_Fast(values,
+                                "comap.send_each() argument must be a"
+                                " sequence"))) {
+        return NULL;
+    }
+    ret = PyComap_SendEach((PyObject*) self,
+                           PySequence_Fast_ITEMS(seq),
+                           PySequence_Fast_GET_SIZE(seq));
+    Py_DECREF(seq);
+    return ret;
+}
+
 PyDoc_STRVAR(comap_throw_doc,
              "Throw an exception into the comap.\n"
              "\n"
@@ -186,7 +805,7 @@ PyDoc_STRVAR(comap_throw_doc,
              "    of throwing the exception into the inner coroutine(s).\n");
 
 static PyObject *
-comap_throw(comap *self, PyObject *args)
+inner_comap_throw(comap *self, PyObject *args)
 {
     Py_ssize_t n;
     PyObject *argtuple;
@@ -194,6 +813,27 @@ comap_throw(comap *self, PyObject *args)
     PyObject *throwstr = NULL;
     PyObject *throw;
     PyObject *ret = NULL;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->cm_stats, throws);
+    if (self->cm_batch) {
+        /* throwing discards whatever is left of the current batch */
+        Py_CLEAR(self->cm_pending);
+    }
+    if (self->cm_done) {
+        /* like a finished generator, raise the exception right here */
+        _ctz_set_exc_from_tuple(args);
+        return NULL;
+    }
+    if (self->cm_batch) {
+        if (!(throwstr = PyUnicode_FromString("throw"))) {
+            return NULL;
+        }
+        ret = comap_batched(self, throwstr, args, NULL);
+        Py_DECREF(throwstr);
+        CTZ_STATS_STOP(self->cm_stats, ret);
+        return ret;
+    }
 
     n = PyTuple_GET_SIZE(self->cm_crs);
     if (!(argtuple = PyTuple_New(n))) {
@@ -203,6 +843,7 @@ comap_throw(comap *self, PyObject *args)
         goto error;
     }
 
+    CTZ_STATS_START(start);
     for (;n;--n) {
         if (!(throw = PyObject_GetAttr(PyTuple_GET_ITEM(self->cm_crs, n - 1),
                                        throwstr))) {
@@ -211,18 +852,36 @@ comap_throw(comap *self, PyObject *args)
         y = PyObject_Call(throw, args, NULL);
         Py_DECREF(throw);
         if (!y) {
+            comap_child_stopped(self, n - 1);
+            self->cm_done = self->cm_nfinished != 0;
+            CTZ_STATS_ELAPSED(self->cm_stats, child, start);
+            CTZ_STATS_STOP(self->cm_stats, y);
             goto error;
         }
         PyTuple_SET_ITEM(argtuple, n - 1, y);
     }
+    CTZ_STATS_ELAPSED(self->cm_stats, child, start);
 
-    ret = PyObject_Call(self->cm_func, argtuple, NULL);
+    CTZ_STATS_START(start);
+    ret = comap_call(self, argtuple);
+    CTZ_STATS_ELAPSED(self->cm_stats, func, start);
 error:
     Py_DECREF(argtuple);
     Py_XDECREF(throwstr);
     return ret;
 }
 
+static PyObject *
+comap_throw(comap *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(comap_throw, self, PyTuple_GET_SIZE(self->cm_crs));
+    ret = inner_comap_throw(self, args);
+    CTZ_PROBE_RETURN(comap_throw, self, PyTuple_GET_SIZE(self->cm_crs), ret);
+    return ret;
+}
+
 PyObject *
 PyComap_Throw(PyObject *cm, PyObject *excinfo)
 {
@@ -236,57 +895,144 @@ PyComap_Throw(PyObject *cm, PyObject *excinfo)
 PyDoc_STRVAR(comap_close_doc,
              "Close the comap."
              "\n"
-             "This closes all of the inner coroutines.\n");
+             "This closes all of the inner coroutines which are not already\n"
+             "exhausted. If closing a coroutine raises, the rest are still\n"
+             "closed and the first error is raised. Closing a closed comap\n"
+             "does nothing.\n");
 
 static PyObject *
-comap_close(comap *self, PyObject *_)
+inner_comap_close(comap *self, PyObject *_)
 {
-    Py_ssize_t n;
-    PyObject *argtuple;
-    PyObject *closestr = NULL;
-    PyObject *close;
-
-    n = PyTuple_GET_SIZE(self->cm_crs);
-    if (!(closestr = PyUnicode_FromString("close"))) {
-        return NULL;
+    CTZ_STATS_INCR(self->cm_stats, closes);
+    if (self->cm_closed) {
+        Py_RETURN_NONE;
     }
-    if (!(argtuple = PyTuple_New(0))) {
-        Py_DECREF(closestr);
+    self->cm_closed = 1;
+    self->cm_done = 1;
+    Py_CLEAR(self->cm_pending);
+    if (_ctz_coiter_close_all(PyCoiter_API,
+                              self->cm_crs,
+                              self->cm_finished)) {
         return NULL;
     }
+    Py_RETURN_NONE;
+}
 
-    for (;n;--n) {
-        if (!(close = PyObject_GetAttr(PyTuple_GET_ITEM(self->cm_crs, n - 1),
-                                       closestr))) {
-            Py_DECREF(closestr);
-            Py_DECREF(argtuple);
-            return NULL;
-        }
-        PyObject_Call(close, argtuple, NULL);
-    }
+static PyObject *
+comap_close(comap *self, PyObject *_)
+{
+    PyObject *ret;
 
-    Py_DECREF(argtuple);
-    Py_RETURN_NONE;
+    CTZ_PROBE_ENTRY(comap_close, self, PyTuple_GET_SIZE(self->cm_crs));
+    ret = inner_comap_close(self, _);
+    CTZ_PROBE_RETURN(comap_close, self, PyTuple_GET_SIZE(self->cm_crs), ret);
+    return ret;
 }
 
 int
 PyComap_Close(PyObject *cm)
 {
+    PyObject *ret;
+
     if (!PyComap_Check(cm)) {
         PyErr_BadInternalCall();
         return 1;
     }
-    Py_XDECREF(comap_close((comap*) cm, NULL));
+    if (!(ret = comap_close((comap*) cm, NULL))) {
+        return 1;
+    }
+    Py_DECREF(ret);
     return 0;
 }
 
+Py_ssize_t
+PyComap_SendN(PyObject *cm,
+              PyObject **values,
+              Py_ssize_t n,
+              PyObject **out)
+{
+    Py_ssize_t m;
+
+    if (!PyComap_Check(cm)) {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+    for (m = 0;m < n;++m) {
+        if (!(out[m] = comap_send((comap*) cm, values[m]))) {
+            break;
+        }
+    }
+    return m;
+}
+
+int
+PyComap_Stats(PyObject *cm, ctz_stats *out)
+{
+    if (!PyComap_Check(cm)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((comap*) cm)->cm_stats), out);
+}
+
+PyDoc_STRVAR(comap_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+comap_stats(comap *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->cm_stats));
+}
+
 static PyMethodDef comap_methods[] = {
     {"send", (PyCFunction) comap_send, METH_O, comap_send_doc},
+    {"send_each",
+     (PyCFunction) comap_send_each,
+     METH_O,
+     comap_send_each_doc},
     {"throw", (PyCFunction) comap_throw, METH_VARARGS, comap_throw_doc},
     {"close", (PyCFunction) comap_close, METH_NOARGS, comap_close_doc},
+    {"stats", (PyCFunction) comap_stats, METH_NOARGS, comap_stats_doc},
     {NULL},
 };
 
+static PyObject *
+comap_get_fused(comap *self, void *_)
+{
+    if (!self->cm_chain) {
+        return PyTuple_New(0);
+    }
+    Py_INCREF(self->cm_chain);
+    return self->cm_chain;
+}
+
+static PyObject *
+comap_get_finished(comap *self, void *_)
+{
+    return PyBool_FromLong(self->cm_done && !self->cm_pending);
+}
+
+static PyGetSetDef comap_getsets[] = {
+    {"finished", (getter) comap_get_finished, NULL,
+     "Whether the comap is exhausted or closed. Sending into a finished\n"
+     "comap raises StopIteration without stepping the coroutines.", NULL},
+    {"fused", (getter) comap_get_fused, NULL,
+     "The functions of the nested comaps fused into this one, innermost\n"
+     "first. These are applied before ``func``.", NULL},
+    {NULL},
+};
+
+#define OFF(a) offsetof(comap, a)
+
+static PyMemberDef comap_members[] = {
+    {"children", T_OBJECT_EX, OFF(cm_crs), READONLY,
+     "The coiter wrapped coroutines being mapped over."},
+    {"func", T_OBJECT_EX, OFF(cm_func), READONLY,
+     "The function being mapped over the coroutines."},
+    {NULL},
+};
+
+#undef OFF
+
 PyDoc_STRVAR(comap_doc,
              "map that acts on coroutines.\n"
              "\n"
@@ -297,24 +1043,48 @@ PyDoc_STRVAR(comap_doc,
              "    coroutines passed.\n"
              "*coroutines\n"
              "    The coroutines to map func over.\n"
+             "batch : int, optional, keyword only\n"
+             "    If given, pull up to ``batch`` values out of each coroutine\n"
+             "    at a time and call func once with one list of values per\n"
+             "    coroutine. Values sent in are forwarded to the coroutines\n"
+             "    for the first step of each batch.\n"
+             "flatten : bool, optional, keyword only\n"
+             "    When batching, yield the elements of func's result one at\n"
+             "    a time instead of the whole result. Defaults to True.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "``comap(f, comap(g, *coroutines))``, where the inner comap is a\n"
+             "temporary that is not referenced anywhere else, is built as a\n"
+             "single node which steps ``coroutines`` and calls\n"
+             "``f(g(*values))``. The inner comap's function is listed in\n"
+             "``fused`` and its coroutines become the ``children``. A\n"
+             "StopIteration raised by ``g`` finishes the comap. Batched\n"
+             "comaps, and comaps built through the C API, are never fused.\n"
              "\n"
              "Methods\n"
              "-------\n"
              "send(value)\n"
              "    Sends a value into the inner coroutines and calls func on\n"
              "    the results.\n"
+             "send_each(values)\n"
+             "    Sends ``values[n]`` into the nth inner coroutine and calls\n"
+             "    func on the results.\n"
              "throw(exc) or throw(type, arg, traceback)\n"
              "    Throws an exception into the inner coroutines and calls\n"
              "    func on the results.\n"
              "close()\n"
-             "    Closes the comap by closing all of the inner coroutines.\n");
+             "    Closes the comap by closing all of the inner coroutines.\n"
+             "    This is idempotent.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this comap.\n");
 
 PyTypeObject PyComap_Type = {
     PyVarObject_HEAD_INIT(&PyType_Type, 0)
     "cotoolz._comap.comap",             /* tp_name */
     sizeof(comap),                      /* tp_basicsize */
     0,                                  /* tp_itemsize */
-    0,                                  /* tp_dealloc */
+    (destructor) comap_dealloc,         /* tp_dealloc */
     0,                                  /* tp_print */
     0,                                  /* tp_getattr */
     0,                                  /* tp_setattr */
@@ -330,17 +1100,18 @@ PyTypeObject PyComap_Type = {
     0,                                  /* tp_setattro */
     0,                                  /* tp_as_buffer */
     Py_TPFLAGS_DEFAULT |
-    Py_TPFLAGS_BASETYPE,                /* tp_flags */
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
     comap_doc,                          /* tp_doc */
-    0,                                  /* tp_traverse */
-    0,                                  /* tp_clear */
+    (traverseproc) comap_traverse,      /* tp_traverse */
+    (inquiry) comap_clear,              /* tp_clear */
     0,                                  /* tp_richcompare */
     0,                                  /* tp_weaklistoffset */
     0,                                  /* tp_iter */
     (iternextfunc) comap_iternext,      /* tp_iternext */
     comap_methods,                      /* tp_methods */
-    0,                                  /* tp_members */
-    0,                                  /* tp_getset */
+    comap_members,                      /* tp_members */
+    comap_getsets,                      /* tp_getset */
     &PyMap_Type,                        /* tp_base */
     0,                                  /* tp_dict */
     0,                                  /* tp_descr_get */
@@ -349,6 +1120,17 @@ PyTypeObject PyComap_Type = {
     0,                                  /* tp_init */
     0,                                  /* tp_alloc */
     comap_new,                          /* tp_new */
+    0,                                  /* tp_free */
+    0,                                  /* tp_is_gc */
+    0,                                  /* tp_bases */
+    0,                                  /* tp_mro */
+    0,                                  /* tp_cache */
+    0,                                  /* tp_subclasses */
+    0,                                  /* tp_weaklist */
+    0,                                  /* tp_del */
+    0,                                  /* tp_version_tag */
+    0,                                  /* tp_finalize */
+    (vectorcallfunc) comap_vectorcall,  /* tp_vectorcall */
 };
 
 PyDoc_STRVAR(module_doc, "comap is a map that acts on coroutines.");
@@ -359,6 +1141,11 @@ static PyComap_Exported exported_symbols = {
   PyComap_Send,
   PyComap_Throw,
   PyComap_Close,
+  PyComap_NewBatched,
+  PyComap_Stats,
+  PyComap_FromArray,
+  PyComap_SendN,
+  PyComap_SendEach,
 };
 
 static struct PyModuleDef _comap_module = {
@@ -380,10 +1167,10 @@ PyInit__comap(void)
     PyObject *symbols;
     int err;
 
-    /* Assert that our custom comap struct definition is the same as
-     * the mapobject struct.
+    /* Assert that our custom comap struct definition starts with the
+     * mapobject struct.
      */
-    assert(sizeof(comap) == PyMap_Type.tp_basicsize);
+    assert(sizeof(comap) >= PyMap_Type.tp_basicsize);
 
     if (PyType_Ready(&PyComap_Type)) {
         return NULL;
@@ -416,5 +1203,9 @@ PyInit__comap(void)
         Py_DECREF(m);
         return NULL;
     }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
     return m;
 }
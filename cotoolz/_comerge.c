@@ -0,0 +1,804 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/comerge.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+static PyObject *
+inner_comerge_new(PyTypeObject *cls,
+                  PyObject *key,
+                  int reverse,
+                  PyObject **crs,
+                  Py_ssize_t n)
+{
+    comerge *self;
+    PyObject *wrapped;
+
+    if (key == Py_None) {
+        key = NULL;
+    }
+
+    if (!(wrapped = _ctz_coiter_wrap_all(PyCoiter_API, "comerge", crs, n))) {
+        return NULL;
+    }
+
+    if (!(self = (comerge*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(wrapped);
+        return NULL;
+    }
+    self->mg_crs = wrapped;
+    Py_XINCREF(key);
+    self->mg_key = key;
+    self->mg_reverse = reverse;
+    self->mg_pending = 0;
+    self->mg_nprimed = 0;
+    self->mg_size = 0;
+    if (!(self->mg_heap = PyMem_New(comerge_head, n ? n : 1))) {
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return (PyObject*) self;
+}
+
+PyObject *
+PyComerge_New(PyObject *key, int reverse, PyObject **crs, Py_ssize_t n)
+{
+    return inner_comerge_new(&PyComerge_Type, key, reverse, crs, n);
+}
+
+static PyObject *
+comerge_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"key", "reverse", NULL};
+    static PyObject *empty = NULL;
+    PyObject *key = Py_None;
+    int reverse = 0;
+
+    if (kwargs) {
+        if (!empty && !(empty = PyTuple_New(0))) {
+            return NULL;
+        }
+        if (!PyArg_ParseTupleAndKeywords(empty,
+                                         kwargs,
+                                         "|$Op:comerge",
+                                         keywords,
+                                         &key,
+                                         &reverse)) {
+            return NULL;
+        }
+    }
+    assert(PyTuple_Check(args));
+    return inner_comerge_new(cls,
+                             key,
+                             reverse,
+                             &PyTuple_GET_ITEM(args, 0),
+                             PyTuple_GET_SIZE(args));
+}
+
+static int
+comerge_traverse(comerge *self, visitproc visit, void *arg)
+{
+    Py_ssize_t n;
+
+    Py_VISIT(self->mg_crs);
+    Py_VISIT(self->mg_key);
+    for (n = 0;n < self->mg_size;++n) {
+        Py_VISIT(self->mg_heap[n].hd_value);
+        Py_VISIT(self->mg_heap[n].hd_key);
+    }
+    return 0;
+}
+
+static void
+comerge_clear_heap(comerge *self)
+{
+    Py_ssize_t size = self->mg_size;
+
+    /* Unlink the heads before releasing them in case a finalizer looks back
+     * at this comerge.
+     */
+    self->mg_size = 0;
+    self->mg_pending = 0;
+    while (size--) {
+        Py_DECREF(self->mg_heap[size].hd_value);
+        Py_DECREF(self->mg_heap[size].hd_key);
+    }
+}
+
+static int
+comerge_clear(comerge *self)
+{
+    Py_CLEAR(self->mg_crs);
+    Py_CLEAR(self->mg_key);
+    comerge_clear_heap(self);
+    return 0;
+}
+
+static void
+comerge_dealloc(comerge *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->mg_crs);
+    Py_XDECREF(self->mg_key);
+    if (self->mg_heap) {
+        comerge_clear_heap(self);
+        PyMem_Free(self->mg_heap);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Three way compare two keys.
+ *
+ * Keys of the same exact int, float, or str type are compared directly,
+ * anything else goes through ``<``. Keys where neither is less than the other
+ * compare equal.
+ *
+ * Returns
+ * -------
+ * cmp : int
+ *     -1, 0, or 1 if ``a`` is less than, equal to, or greater than ``b``.
+ *     -2 with an exception set on failure.
+ */
+static inline int
+comerge_compare(PyObject *a, PyObject *b)
+{
+    int lt;
+
+    if (Py_TYPE(a) == Py_TYPE(b)) {
+        if (PyLong_CheckExact(a)) {
+            int aoverflow;
+            int boverflow;
+            long along = PyLong_AsLongAndOverflow(a, &aoverflow);
+            long blong = PyLong_AsLongAndOverflow(b, &boverflow);
+
+            if (!(aoverflow || boverflow)) {
+                return (along > blong) - (along < blong);
+            }
+        }
+        else if (PyFloat_CheckExact(a)) {
+            double adouble = PyFloat_AS_DOUBLE(a);
+            double bdouble = PyFloat_AS_DOUBLE(b);
+
+            return (adouble > bdouble) - (adouble < bdouble);
+        }
+        else if (PyUnicode_CheckExact(a)) {
+            int cmp = PyUnicode_Compare(a, b);
+
+            return (cmp > 0) - (cmp < 0);
+        }
+    }
+
+    if ((lt = PyObject_RichCompareBool(a, b, Py_LT))) {
+        return lt < 0 ? -2 : -1;
+    }
+    if ((lt = PyObject_RichCompareBool(b, a, Py_LT)) < 0) {
+        return -2;
+    }
+    return lt;
+}
+
+/* Check if head ``a`` should be yielded before head ``b``. Ties go to the
+ * coroutine which was passed first, like ``heapq.merge``.
+ *
+ * Returns
+ * -------
+ * lt : int
+ *     1 if ``a`` comes first, 0 if ``b`` comes first, -1 on failure.
+ */
+static inline int
+comerge_less(comerge *self, comerge_head *a, comerge_head *b)
+{
+    int cmp = comerge_compare(a->hd_key, b->hd_key);
+
+    if (cmp == -2) {
+        return -1;
+    }
+    if (self->mg_reverse) {
+        cmp = -cmp;
+    }
+    if (!cmp) {
+        return a->hd_index < b->hd_index;
+    }
+    return cmp < 0;
+}
+
+/* Move the head at ``pos`` down the heap until it is not greater than its
+ * children.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure. The heads are all still in the heap
+ *     on failure but the heap may be out of order.
+ */
+static int
+comerge_sift_down(comerge *self, Py_ssize_t pos)
+{
+    comerge_head *heap = self->mg_heap;
+    Py_ssize_t size = self->mg_size;
+    comerge_head item = heap[pos];
+    Py_ssize_t child;
+    int lt;
+
+    while ((child = 2 * pos + 1) < size) {
+        if (child + 1 < size) {
+            if ((lt = comerge_less(self, &heap[child + 1], &heap[child])) < 0) {
+                goto error;
+            }
+            child += lt;
+        }
+        if ((lt = comerge_less(self, &heap[child], &item)) < 0) {
+            goto error;
+        }
+        if (!lt) {
+            break;
+        }
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = item;
+    return 0;
+
+error:
+    heap[pos] = item;
+    return -1;
+}
+
+/* Remove the head at the top of the heap.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static int
+comerge_pop(comerge *self)
+{
+    comerge_head top = self->mg_heap[0];
+    int err = 0;
+
+    if (--self->mg_size) {
+        self->mg_heap[0] = self->mg_heap[self->mg_size];
+        err = comerge_sift_down(self, 0);
+    }
+    Py_DECREF(top.hd_value);
+    Py_DECREF(top.hd_key);
+    return err;
+}
+
+/* Compute the key of a value.
+ *
+ * Returns
+ * -------
+ * key : any
+ *     A new reference to the key of ``value``.
+ */
+static inline PyObject *
+comerge_key(comerge *self, PyObject *value)
+{
+    PyObject *key;
+    CTZ_STATS_DECL(start);
+
+    if (!self->mg_key) {
+        Py_INCREF(value);
+        return value;
+    }
+    CTZ_STATS_START(start);
+    key = PyObject_CallFunctionObjArgs(self->mg_key, value, NULL);
+    CTZ_STATS_ELAPSED(self->mg_stats, func, start);
+    return key;
+}
+
+/* Start each of the inner coroutines and heapify their first values.
+ *
+ * If this fails part way through, the coroutine which failed is dropped and
+ * the next call picks up with the coroutine after it.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static int
+comerge_prime(comerge *self)
+{
+    Py_ssize_t n = PyTuple_GET_SIZE(self->mg_crs);
+    Py_ssize_t m;
+    PyObject *value;
+    PyObject *key;
+    CTZ_STATS_DECL(start);
+
+    while (self->mg_nprimed < n) {
+        m = self->mg_nprimed++;
+        CTZ_STATS_START(start);
+        value = PyCoiter_API->send(PyTuple_GET_ITEM(self->mg_crs, m),
+                                   Py_None);
+        CTZ_STATS_ELAPSED(self->mg_stats, child, start);
+        if (!value) {
+            if (!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+                return -1;
+            }
+            PyErr_Clear();
+            continue;
+        }
+        if (!(key = comerge_key(self, value))) {
+            Py_DECREF(value);
+            return -1;
+        }
+        self->mg_heap[self->mg_size].hd_value = value;
+        self->mg_heap[self->mg_size].hd_key = key;
+        self->mg_heap[self->mg_size].hd_index = m;
+        ++self->mg_size;
+    }
+
+    for (m = self->mg_size / 2 - 1;m >= 0;--m) {
+        if (comerge_sift_down(self, m)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Replace the head at the top of the heap with the next value out of its
+ * coroutine.
+ *
+ * Paramaters
+ * ----------
+ * value : any
+ *     A new reference to the next value out of the coroutine at the top of
+ *     the heap or NULL if it raised. The coroutine is dropped if it raised
+ *     anything.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static int
+comerge_advance(comerge *self, PyObject *value)
+{
+    comerge_head *top = &self->mg_heap[0];
+    PyObject *key;
+    PyObject *type;
+    PyObject *exc;
+    PyObject *tb;
+    int err;
+
+    if (!value || !(key = comerge_key(self, value))) {
+        Py_XDECREF(value);
+        if (PyErr_ExceptionMatches(PyExc_StopIteration)) {
+            PyErr_Clear();
+            return comerge_pop(self);
+        }
+        PyErr_Fetch(&type, &exc, &tb);
+        if ((err = comerge_pop(self))) {
+            Py_XDECREF(type);
+            Py_XDECREF(exc);
+            Py_XDECREF(tb);
+        }
+        else {
+            PyErr_Restore(type, exc, tb);
+        }
+        return -1;
+    }
+
+    Py_SETREF(top->hd_value, value);
+    Py_SETREF(top->hd_key, key);
+    return comerge_sift_down(self, 0);
+}
+
+/* Yield the head at the top of the heap. */
+static PyObject *
+comerge_yield(comerge *self)
+{
+    PyObject *value;
+
+    if (!self->mg_size) {
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+    value = self->mg_heap[0].hd_value;
+    Py_INCREF(value);
+    self->mg_pending = 1;
+    return value;
+}
+
+PyDoc_STRVAR(comerge_send_doc,
+             "Send a value into the comerge.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to send into the coroutine which yielded the\n"
+             "    last value out of the comerge.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The smallest head of the inner coroutines.\n");
+
+static PyObject *
+inner_comerge_send(comerge *self, PyObject *value)
+{
+    PyObject *cr;
+    PyObject *next;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->mg_stats, sends);
+    if (self->mg_pending) {
+        self->mg_pending = 0;
+        cr = PyTuple_GET_ITEM(self->mg_crs, self->mg_heap[0].hd_index);
+        CTZ_STATS_START(start);
+        next = PyCoiter_API->send(cr, value);
+        CTZ_STATS_ELAPSED(self->mg_stats, child, start);
+        if (comerge_advance(self, next)) {
+            return NULL;
+        }
+    }
+    else if (self->mg_nprimed < PyTuple_GET_SIZE(self->mg_crs)) {
+        if (value != Py_None) {
+            PyErr_SetString(PyExc_TypeError,
+                            "can't send non-None value to a just-started"
+                            " comerge");
+            return NULL;
+        }
+        if (comerge_prime(self)) {
+            return NULL;
+        }
+    }
+    next = comerge_yield(self);
+    CTZ_STATS_STOP(self->mg_stats, next);
+    return next;
+}
+
+static PyObject *
+comerge_send(comerge *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(comerge_send, self, PyTuple_GET_SIZE(self->mg_crs));
+    ret = inner_comerge_send(self, value);
+    CTZ_PROBE_RETURN(comerge_send,
+                     self,
+                     PyTuple_GET_SIZE(self->mg_crs),
+                     ret);
+    return ret;
+}
+
+PyObject *
+PyComerge_Send(PyObject *mg, PyObject *value)
+{
+    if (!PyComerge_Check(mg)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return comerge_send((comerge*) mg, value);
+}
+
+static PyObject *
+comerge_next(comerge *self)
+{
+    return comerge_send(self, Py_None);
+}
+
+PyDoc_STRVAR(comerge_throw_doc,
+             "Throw an exception into the comerge.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The smallest head of the inner coroutines after throwing\n"
+             "    the exception into the coroutine which yielded the last\n"
+             "    value out of the comerge.\n");
+
+static PyObject *
+inner_comerge_throw(comerge *self, PyObject *args)
+{
+    PyObject *cr;
+    PyObject *next;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->mg_stats, throws);
+    if (!self->mg_pending) {
+        /* there is no coroutine waiting on a value */
+        _ctz_set_exc_from_tuple(args);
+        return NULL;
+    }
+    self->mg_pending = 0;
+    cr = PyTuple_GET_ITEM(self->mg_crs, self->mg_heap[0].hd_index);
+    CTZ_STATS_START(start);
+    next = PyCoiter_API->throw(cr, args);
+    CTZ_STATS_ELAPSED(self->mg_stats, child, start);
+    if (comerge_advance(self, next)) {
+        return NULL;
+    }
+    next = comerge_yield(self);
+    CTZ_STATS_STOP(self->mg_stats, next);
+    return next;
+}
+
+static PyObject *
+comerge_throw(comerge *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(comerge_throw, self, PyTuple_GET_SIZE(self->mg_crs));
+    ret = inner_comerge_throw(self, args);
+    CTZ_PROBE_RETURN(comerge_throw,
+                     self,
+                     PyTuple_GET_SIZE(self->mg_crs),
+                     ret);
+    return ret;
+}
+
+PyObject *
+PyComerge_Throw(PyObject *mg, PyObject *excinfo)
+{
+    if (!PyComerge_Check(mg)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return comerge_throw((comerge*) mg, excinfo);
+}
+
+PyDoc_STRVAR(comerge_close_doc,
+             "Close the comerge."
+             "\n"
+             "This closes all of the inner coroutines.\n");
+
+static PyObject *
+inner_comerge_close(comerge *self, PyObject *_)
+{
+    Py_ssize_t n;
+    PyObject *type = NULL;
+    PyObject *exc = NULL;
+    PyObject *tb = NULL;
+
+    CTZ_STATS_INCR(self->mg_stats, closes);
+    comerge_clear_heap(self);
+    self->mg_nprimed = PyTuple_GET_SIZE(self->mg_crs);
+
+    /* Close every coroutine even if one fails and raise the first error. */
+    for (n = 0;n < PyTuple_GET_SIZE(self->mg_crs);++n) {
+        if (PyCoiter_API->close(PyTuple_GET_ITEM(self->mg_crs, n))) {
+            if (type) {
+                PyErr_Clear();
+            }
+            else {
+                PyErr_Fetch(&type, &exc, &tb);
+            }
+        }
+    }
+    if (type) {
+        PyErr_Restore(type, exc, tb);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+comerge_close(comerge *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(comerge_close, self, PyTuple_GET_SIZE(self->mg_crs));
+    ret = inner_comerge_close(self, _);
+    CTZ_PROBE_RETURN(comerge_close,
+                     self,
+                     PyTuple_GET_SIZE(self->mg_crs),
+                     ret);
+    return ret;
+}
+
+int
+PyComerge_Close(PyObject *mg)
+{
+    PyObject *ret;
+
+    if (!PyComerge_Check(mg)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = comerge_close((comerge*) mg, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyComerge_Stats(PyObject *mg, ctz_stats *out)
+{
+    if (!PyComerge_Check(mg)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((comerge*) mg)->mg_stats), out);
+}
+
+PyDoc_STRVAR(comerge_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+comerge_stats(comerge *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->mg_stats));
+}
+
+static PyMethodDef comerge_methods[] = {
+    {"send", (PyCFunction) comerge_send, METH_O, comerge_send_doc},
+    {"throw", (PyCFunction) comerge_throw, METH_VARARGS, comerge_throw_doc},
+    {"close", (PyCFunction) comerge_close, METH_NOARGS, comerge_close_doc},
+    {"stats", (PyCFunction) comerge_stats, METH_NOARGS, comerge_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(comerge, a)
+
+static PyMemberDef comerge_members[] = {
+    {"children", T_OBJECT_EX, OFF(mg_crs), READONLY,
+     "The coiter wrapped coroutines being merged."},
+    {"key", T_OBJECT, OFF(mg_key), READONLY,
+     "The function used to compute the sort key of each value."},
+    {NULL},
+};
+
+#undef OFF
+
+PyDoc_STRVAR(comerge_doc,
+             "Merge sorted coroutines into a single sorted coroutine, like\n"
+             "``heapq.merge``.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "*coroutines\n"
+             "    The sorted coroutines to merge.\n"
+             "key : callable, optional\n"
+             "    The function used to compute the sort key of each value.\n"
+             "reverse : bool, optional\n"
+             "    Are the coroutines sorted in descending order?\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Sends a value into the coroutine which yielded the last\n"
+             "    value and yields the next smallest value.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Throws an exception into the coroutine which yielded the\n"
+             "    last value and yields the next smallest value.\n"
+             "close()\n"
+             "    Closes the comerge by closing all of the inner coroutines.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this comerge.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Only the coroutine whose value was yielded is advanced on each\n"
+             "step. Keys of the same exact int, float, or str type are\n"
+             "compared without going through ``<``.\n"
+    );
+
+PyTypeObject PyComerge_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._comerge.comerge",         /* tp_name */
+    sizeof(comerge),                    /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    (destructor) comerge_dealloc,       /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_reserved */
+    0,                                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    0,                                  /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    0,                                  /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
+    comerge_doc,                        /* tp_doc */
+    (traverseproc) comerge_traverse,    /* tp_traverse */
+    (inquiry) comerge_clear,            /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    PyObject_SelfIter,                  /* tp_iter */
+    (iternextfunc) comerge_next,        /* tp_iternext */
+    comerge_methods,                    /* tp_methods */
+    comerge_members,                    /* tp_members */
+    0,                                  /* tp_getset */
+    0,                                  /* tp_base */
+    0,                                  /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    0,                                  /* tp_init */
+    0,                                  /* tp_alloc */
+    comerge_new,                        /* tp_new */
+};
+
+PyDoc_STRVAR(module_doc,
+             "comerge is a heapq.merge that acts on coroutines.");
+
+static struct PyModuleDef _comerge_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._comerge",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyComerge_Exported exported_symbols = {
+    PyComerge_New,
+    PyComerge_Send,
+    PyComerge_Throw,
+    PyComerge_Close,
+    PyComerge_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__comerge(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyComerge_Type)) {
+        return NULL;
+    }
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._comerge._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_comerge_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m, "comerge", (PyObject*) &PyComerge_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
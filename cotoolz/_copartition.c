@@ -0,0 +1,824 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/copartition.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+/* Resolve the ``send_many`` method of the sink stepped by the coiter ``cr``.
+ *
+ * The method is looked up on the object the coiter fast path steps, seeing
+ * through sinks which were already wrapped in a coiter.
+ *
+ * Returns
+ * -------
+ * send_many : callable or None
+ *     A new reference to the bound method, or to None if the sink does not
+ *     have one.
+ */
+static PyObject *
+copartition_resolve_send_many(PyObject *cr)
+{
+    PyObject *sink = ((coiter*) cr)->ci_it;
+    PyObject *meth;
+
+    while (Py_TYPE(sink) == Py_TYPE(cr)) {
+        sink = ((coiter*) sink)->ci_it;
+    }
+    if ((meth = PyObject_GetAttrString(sink, "send_many"))) {
+        return meth;
+    }
+    if (!PyErr_ExceptionMatches(PyExc_AttributeError)) {
+        return NULL;
+    }
+    PyErr_Clear();
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+inner_copartition_new(PyTypeObject *cls,
+                      PyObject *n_or_sinks,
+                      PyObject *key,
+                      Py_ssize_t batch)
+{
+    copartition *self;
+    PyObject *sinks = NULL;
+    PyObject *crs = NULL;
+    PyObject *send_many = NULL;
+    PyObject *meth;
+    Py_ssize_t n;
+    Py_ssize_t m;
+
+    if (key == Py_None) {
+        key = NULL;
+    }
+    if (batch <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "copartition() batch must be positive");
+        return NULL;
+    }
+
+    if (PyIndex_Check(n_or_sinks)) {
+        if ((n = PyNumber_AsSsize_t(n_or_sinks, PyExc_OverflowError)) == -1 &&
+            PyErr_Occurred()) {
+            return NULL;
+        }
+        if (!(crs = PyTuple_New(0)) || !(send_many = PyTuple_New(0))) {
+            goto error;
+        }
+    }
+    else {
+        if (!(sinks = PySequence_Fast(n_or_sinks,
+                                      "copartition() argument must be an"
+                                      " int or a sequence of sinks"))) {
+            return NULL;
+        }
+        n = PySequence_Fast_GET_SIZE(sinks);
+        if (!(crs = _ctz_coiter_wrap_all(PyCoiter_API,
+                                         "copartition",
+                                         PySequence_Fast_ITEMS(sinks),
+                                         n))) {
+            goto error;
+        }
+        if (!(send_many = PyTuple_New(n))) {
+            goto error;
+        }
+        for (m = 0;m < n;++m) {
+            if (!(meth = copartition_resolve_send_many(
+                      PyTuple_GET_ITEM(crs, m)))) {
+                goto error;
+            }
+            PyTuple_SET_ITEM(send_many, m, meth);
+        }
+        Py_CLEAR(sinks);
+    }
+    if (n <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "copartition() needs at least one partition");
+        goto error;
+    }
+
+    if (!(self = (copartition*) cls->tp_alloc(cls, 0))) {
+        goto error;
+    }
+    self->pt_n = n;
+    self->pt_crs = crs;
+    self->pt_send_many = send_many;
+    Py_XINCREF(key);
+    self->pt_key = key;
+    self->pt_batch = batch;
+    if (!(self->pt_buffers = PyMem_Calloc(n, sizeof(copartition_buffer)))) {
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    if (PyTuple_GET_SIZE(crs)) {
+        for (m = 0;m < n;++m) {
+            if (!(self->pt_buffers[m].pb_items = PyMem_New(PyObject*,
+                                                           batch))) {
+                Py_DECREF(self);
+                PyErr_NoMemory();
+                return NULL;
+            }
+        }
+    }
+    return (PyObject*) self;
+
+error:
+    Py_XDECREF(sinks);
+    Py_XDECREF(crs);
+    Py_XDECREF(send_many);
+    return NULL;
+}
+
+PyObject *
+PyCopartition_New(PyObject *n_or_sinks, PyObject *key, Py_ssize_t batch)
+{
+    return inner_copartition_new(&PyCopartition_Type, n_or_sinks, key, batch);
+}
+
+static PyObject *
+copartition_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"n_or_sinks", "key", "batch", NULL};
+    PyObject *n_or_sinks;
+    PyObject *key = Py_None;
+    Py_ssize_t batch = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "O|O$n:copartition",
+                                     keywords,
+                                     &n_or_sinks,
+                                     &key,
+                                     &batch)) {
+        return NULL;
+    }
+    return inner_copartition_new(cls, n_or_sinks, key, batch);
+}
+
+static int
+copartition_traverse(copartition *self, visitproc visit, void *arg)
+{
+    Py_ssize_t n;
+    Py_ssize_t m;
+    copartition_buffer *buffer;
+
+    Py_VISIT(self->pt_crs);
+    Py_VISIT(self->pt_send_many);
+    Py_VISIT(self->pt_key);
+    if (self->pt_buffers) {
+        for (n = 0;n < self->pt_n;++n) {
+            buffer = &self->pt_buffers[n];
+            for (m = 0;m < buffer->pb_size;++m) {
+                Py_VISIT(buffer->pb_items[m]);
+            }
+        }
+    }
+    return 0;
+}
+
+/* Drop the values buffered for a partition without sending them. */
+static void
+copartition_clear_buffer(copartition_buffer *buffer)
+{
+    Py_ssize_t size = buffer->pb_size;
+
+    buffer->pb_size = 0;
+    while (size--) {
+        Py_DECREF(buffer->pb_items[size]);
+    }
+}
+
+static int
+copartition_clear(copartition *self)
+{
+    Py_ssize_t n;
+
+    Py_CLEAR(self->pt_crs);
+    Py_CLEAR(self->pt_send_many);
+    Py_CLEAR(self->pt_key);
+    if (self->pt_buffers) {
+        for (n = 0;n < self->pt_n;++n) {
+            copartition_clear_buffer(&self->pt_buffers[n]);
+        }
+    }
+    return 0;
+}
+
+/* Send the values buffered for partition ``n`` into its sink.
+ *
+ * The values go through the sink's ``send_many`` as a single list if it has
+ * one, otherwise they are sent in one at a time. If the sink raises, the
+ * rest of the batch is dropped.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static int
+copartition_flush_one(copartition *self, Py_ssize_t n)
+{
+    copartition_buffer *buffer = &self->pt_buffers[n];
+    PyObject *send_many = PyTuple_GET_ITEM(self->pt_send_many, n);
+    PyObject *cr = PyTuple_GET_ITEM(self->pt_crs, n);
+    PyObject *batch;
+    PyObject *ret;
+    Py_ssize_t size = buffer->pb_size;
+    Py_ssize_t m;
+    CTZ_STATS_DECL(start);
+
+    if (!size) {
+        return 0;
+    }
+    buffer->pb_size = 0;
+
+    CTZ_STATS_START(start);
+    if (send_many != Py_None) {
+        if (!(batch = PyList_New(size))) {
+            buffer->pb_size = size;
+            return -1;
+        }
+        for (m = 0;m < size;++m) {
+            /* steal the buffer's references */
+            PyList_SET_ITEM(batch, m, buffer->pb_items[m]);
+        }
+        ret = PyObject_CallOneArg(send_many, batch);
+        Py_DECREF(batch);
+        CTZ_STATS_ELAPSED(self->pt_stats, child, start);
+        if (!ret) {
+            return -1;
+        }
+        Py_DECREF(ret);
+        return 0;
+    }
+
+    for (m = 0;m < size;++m) {
+        if (!(ret = _ctz_coiter_send_fast(cr, buffer->pb_items[m]))) {
+            break;
+        }
+        Py_DECREF(ret);
+        Py_DECREF(buffer->pb_items[m]);
+    }
+    CTZ_STATS_ELAPSED(self->pt_stats, child, start);
+    if (m < size) {
+        for (;m < size;++m) {
+            Py_DECREF(buffer->pb_items[m]);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/* Flush every partition, raising the first error.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static int
+copartition_flush_all(copartition *self)
+{
+    Py_ssize_t n;
+    PyObject *type = NULL;
+    PyObject *exc = NULL;
+    PyObject *tb = NULL;
+
+    if (!PyTuple_GET_SIZE(self->pt_crs)) {
+        return 0;
+    }
+    for (n = 0;n < self->pt_n;++n) {
+        if (copartition_flush_one(self, n)) {
+            if (type) {
+                PyErr_Clear();
+            }
+            else {
+                PyErr_Fetch(&type, &exc, &tb);
+            }
+        }
+    }
+    if (type) {
+        PyErr_Restore(type, exc, tb);
+        return -1;
+    }
+    return 0;
+}
+
+/* Send the values still buffered into their sinks before the copartition
+ * goes away. An error from a sink is reported as unraisable.
+ */
+static void
+copartition_finalize(copartition *self)
+{
+    PyObject *type;
+    PyObject *value;
+    PyObject *tb;
+
+    if (!self->pt_crs || !self->pt_buffers) {
+        return;
+    }
+    PyErr_Fetch(&type, &value, &tb);
+    if (copartition_flush_all(self)) {
+        PyErr_WriteUnraisable((PyObject*) self);
+    }
+    PyErr_Restore(type, value, tb);
+}
+
+static void
+copartition_dealloc(copartition *self)
+{
+    Py_ssize_t n;
+
+    if (PyObject_CallFinalizerFromDealloc((PyObject*) self)) {
+        /* resurrected by a sink */
+        return;
+    }
+    PyObject_GC_UnTrack(self);
+    copartition_clear(self);
+    if (self->pt_buffers) {
+        for (n = 0;n < self->pt_n;++n) {
+            PyMem_Free(self->pt_buffers[n].pb_items);
+        }
+        PyMem_Free(self->pt_buffers);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyDoc_STRVAR(copartition_send_doc,
+             "Send a value into the sink for its partition.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to partition.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "partition : int\n"
+             "    The index of the partition of ``value``.\n");
+
+static PyObject *
+inner_copartition_send(copartition *self, PyObject *value)
+{
+    PyObject *key = value;
+    Py_hash_t hash;
+    Py_ssize_t n;
+    copartition_buffer *buffer;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->pt_stats, sends);
+    if (self->pt_key) {
+        CTZ_STATS_START(start);
+        key = PyObject_CallOneArg(self->pt_key, value);
+        CTZ_STATS_ELAPSED(self->pt_stats, func, start);
+        if (!key) {
+            return NULL;
+        }
+    }
+    /* str and other types which cache their hash are not rehashed */
+    hash = PyObject_Hash(key);
+    if (key != value) {
+        Py_DECREF(key);
+    }
+    if (hash == -1) {
+        return NULL;
+    }
+    /* match ``hash(key) % n`` in Python */
+    if ((n = hash % self->pt_n) < 0) {
+        n += self->pt_n;
+    }
+
+    buffer = &self->pt_buffers[n];
+    ++buffer->pb_count;
+    if (PyTuple_GET_SIZE(self->pt_crs)) {
+        Py_INCREF(value);
+        buffer->pb_items[buffer->pb_size++] = value;
+        if (buffer->pb_size == self->pt_batch &&
+            copartition_flush_one(self, n)) {
+            return NULL;
+        }
+    }
+    return PyLong_FromSsize_t(n);
+}
+
+static PyObject *
+copartition_send(copartition *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(copartition_send, self, self->pt_n);
+    ret = inner_copartition_send(self, value);
+    CTZ_PROBE_RETURN(copartition_send, self, self->pt_n, ret);
+    return ret;
+}
+
+PyObject *
+PyCopartition_Send(PyObject *pt, PyObject *value)
+{
+    if (!PyCopartition_Check(pt)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return copartition_send((copartition*) pt, value);
+}
+
+static PyObject *
+copartition_next(copartition *self)
+{
+    return copartition_send(self, Py_None);
+}
+
+PyDoc_STRVAR(copartition_throw_doc,
+             "Raise an exception in the copartition.\n"
+             "\n"
+             "The copartition does not run any code between values so the\n"
+             "exception is raised immediately; the sinks are left as they\n"
+             "are.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n");
+
+static PyObject *
+copartition_throw(copartition *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(copartition_throw, self, self->pt_n);
+    CTZ_STATS_INCR(self->pt_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(copartition_throw, self, self->pt_n, NULL);
+    return NULL;
+}
+
+PyObject *
+PyCopartition_Throw(PyObject *pt, PyObject *excinfo)
+{
+    if (!PyCopartition_Check(pt)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return copartition_throw((copartition*) pt, excinfo);
+}
+
+PyDoc_STRVAR(copartition_flush_doc,
+             "Send all of the buffered values into their sinks.\n");
+
+static PyObject *
+copartition_flush(copartition *self, PyObject *_)
+{
+    if (copartition_flush_all(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+int
+PyCopartition_Flush(PyObject *pt)
+{
+    if (!PyCopartition_Check(pt)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return copartition_flush_all((copartition*) pt) ? 1 : 0;
+}
+
+PyDoc_STRVAR(copartition_close_doc,
+             "Close the copartition."
+             "\n"
+             "This flushes the buffered values and closes all of the sinks.\n");
+
+static PyObject *
+inner_copartition_close(copartition *self, PyObject *_)
+{
+    Py_ssize_t n;
+    PyObject *type = NULL;
+    PyObject *exc = NULL;
+    PyObject *tb = NULL;
+
+    CTZ_STATS_INCR(self->pt_stats, closes);
+    if (copartition_flush_all(self)) {
+        PyErr_Fetch(&type, &exc, &tb);
+    }
+
+    /* Close every sink even if one fails and raise the first error. */
+    for (n = 0;n < PyTuple_GET_SIZE(self->pt_crs);++n) {
+        if (PyCoiter_API->close(PyTuple_GET_ITEM(self->pt_crs, n))) {
+            if (type) {
+                PyErr_Clear();
+            }
+            else {
+                PyErr_Fetch(&type, &exc, &tb);
+            }
+        }
+    }
+    if (type) {
+        PyErr_Restore(type, exc, tb);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+copartition_close(copartition *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(copartition_close, self, self->pt_n);
+    ret = inner_copartition_close(self, _);
+    CTZ_PROBE_RETURN(copartition_close, self, self->pt_n, ret);
+    return ret;
+}
+
+int
+PyCopartition_Close(PyObject *pt)
+{
+    PyObject *ret;
+
+    if (!PyCopartition_Check(pt)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = copartition_close((copartition*) pt, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCopartition_Stats(PyObject *pt, ctz_stats *out)
+{
+    if (!PyCopartition_Check(pt)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((copartition*) pt)->pt_stats), out);
+}
+
+PyDoc_STRVAR(copartition_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+copartition_stats(copartition *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->pt_stats));
+}
+
+static PyMethodDef copartition_methods[] = {
+    {"send", (PyCFunction) copartition_send, METH_O, copartition_send_doc},
+    {"throw",
+     (PyCFunction) copartition_throw,
+     METH_VARARGS,
+     copartition_throw_doc},
+    {"close",
+     (PyCFunction) copartition_close,
+     METH_NOARGS,
+     copartition_close_doc},
+    {"flush",
+     (PyCFunction) copartition_flush,
+     METH_NOARGS,
+     copartition_flush_doc},
+    {"stats",
+     (PyCFunction) copartition_stats,
+     METH_NOARGS,
+     copartition_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(copartition, a)
+
+static PyMemberDef copartition_members[] = {
+    {"children", T_OBJECT_EX, OFF(pt_crs), READONLY,
+     "The coiter wrapped sinks."},
+    {"key", T_OBJECT, OFF(pt_key), READONLY,
+     "The function used to compute the key to hash."},
+    {"batch", T_PYSSIZET, OFF(pt_batch), READONLY,
+     "The number of values buffered per partition before flushing."},
+    {NULL},
+};
+
+#undef OFF
+
+static PyObject *
+copartition_counts(copartition *self, void *_)
+{
+    PyObject *counts;
+    PyObject *count;
+    Py_ssize_t n;
+
+    if (!(counts = PyTuple_New(self->pt_n))) {
+        return NULL;
+    }
+    for (n = 0;n < self->pt_n;++n) {
+        count = PyLong_FromUnsignedLongLong(
+            (unsigned long long) self->pt_buffers[n].pb_count);
+        if (!count) {
+            Py_DECREF(counts);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(counts, n, count);
+    }
+    return counts;
+}
+
+static PyObject *
+copartition_skew(copartition *self, void *_)
+{
+    uint64_t total = 0;
+    uint64_t max = 0;
+    uint64_t count;
+    Py_ssize_t n;
+
+    for (n = 0;n < self->pt_n;++n) {
+        count = self->pt_buffers[n].pb_count;
+        total += count;
+        if (count > max) {
+            max = count;
+        }
+    }
+    if (!total) {
+        return PyFloat_FromDouble(0.0);
+    }
+    return PyFloat_FromDouble((double) max * self->pt_n / total);
+}
+
+static PyGetSetDef copartition_getsets[] = {
+    {"counts", (getter) copartition_counts, NULL,
+     "The number of values sent to each partition.", NULL},
+    {"skew", (getter) copartition_skew, NULL,
+     "The size of the largest partition over the mean partition size.\n"
+     "1.0 is perfectly balanced, 0.0 if nothing has been sent.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(copartition_doc,
+             "Partition values by hash and send each partition into its own\n"
+             "sink.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "n_or_sinks : int or sequence of coroutines\n"
+             "    The sink for each partition. If this is an int then values\n"
+             "    are only counted and their partition is returned.\n"
+             "key : callable, optional\n"
+             "    The function used to compute the key to hash. By default\n"
+             "    the values themselves are hashed.\n"
+             "batch : int, optional\n"
+             "    The number of values to buffer per partition before\n"
+             "    sending them into the sink. Sinks with a ``send_many``\n"
+             "    method get the whole batch as a list, others get each\n"
+             "    value through ``send``. Values still buffered when the\n"
+             "    copartition is garbage collected are flushed then.\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Buffers the value for the sink of its partition.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Raises the exception.\n"
+             "flush()\n"
+             "    Sends all of the buffered values into their sinks.\n"
+             "close()\n"
+             "    Flushes and closes all of the sinks.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this copartition.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "The partition of a value is ``hash(key(value)) % n``. Like\n"
+             "``hash``, this is only stable across processes for types which\n"
+             "are not randomized by ``PYTHONHASHSEED``.\n"
+    );
+
+PyTypeObject PyCopartition_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._copartition.copartition",     /* tp_name */
+    sizeof(copartition),                    /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) copartition_dealloc,       /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    copartition_doc,                        /* tp_doc */
+    (traverseproc) copartition_traverse,    /* tp_traverse */
+    (inquiry) copartition_clear,            /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) copartition_next,        /* tp_iternext */
+    copartition_methods,                    /* tp_methods */
+    copartition_members,                    /* tp_members */
+    copartition_getsets,                    /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    copartition_new,                        /* tp_new */
+    0,                                      /* tp_free */
+    0,                                      /* tp_is_gc */
+    0,                                      /* tp_bases */
+    0,                                      /* tp_mro */
+    0,                                      /* tp_cache */
+    0,                                      /* tp_subclasses */
+    0,                                      /* tp_weaklist */
+    0,                                      /* tp_del */
+    0,                                      /* tp_version_tag */
+    (destructor) copartition_finalize,      /* tp_finalize */
+};
+
+PyDoc_STRVAR(module_doc,
+             "copartition fans values out to sinks by hash.");
+
+static struct PyModuleDef _copartition_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._copartition",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCopartition_Exported exported_symbols = {
+    PyCopartition_New,
+    PyCopartition_Send,
+    PyCopartition_Throw,
+    PyCopartition_Close,
+    PyCopartition_Stats,
+    PyCopartition_Flush,
+};
+
+PyMODINIT_FUNC
+PyInit__copartition(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCopartition_Type)) {
+        return NULL;
+    }
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._copartition._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_copartition_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "copartition",
+                               (PyObject*) &PyCopartition_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,1184 @@
+#include <Python.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <structmember.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/copool.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+/* How many steps the calling thread takes between checks for signals. */
+#define COPOOL_SIGNAL_INTERVAL 1024
+
+/* How long the calling thread waits for work before checking for signals,
+   in nanoseconds. */
+#define COPOOL_SIGNAL_INTERVAL_NS 50000000
+
+/* Keep the counters of neighbouring workers off each other's cache lines. */
+#define COPOOL_CACHE_LINE 64
+
+/* A worker of a running copool.
+ *
+ * The deque is only touched with ``wk_lock`` held. The owner takes tasks
+ * from the front and puts them back at the end, so its tasks are stepped
+ * round-robin; thieves take from the end, which is the task the owner would
+ * have gotten to last.
+ */
+typedef struct {
+    pthread_mutex_t wk_lock;
+    copool_task **wk_deque;     /* ring of tasks, owned references */
+    Py_ssize_t wk_head;         /* the index of the front of the deque */
+    Py_ssize_t wk_size;         /* the number of tasks in the deque */
+    Py_ssize_t wk_capacity;     /* the length of wk_deque, a power of two */
+    pthread_t wk_thread;
+    int wk_started;             /* wk_thread is running and must be joined */
+    copool_counters wk_counters;
+    char wk_pad[COPOOL_CACHE_LINE];
+} copool_worker;
+
+struct copool_run {
+    copool *rn_pool;
+    Py_ssize_t rn_nworkers;
+    copool_worker *rn_workers;
+    _Atomic Py_ssize_t rn_live;     /* tasks which are not done */
+    _Atomic Py_ssize_t rn_queued;   /* tasks sitting in a deque */
+    _Atomic int rn_waiters;         /* workers waiting on rn_ready */
+    _Atomic int rn_stop;            /* stop after the current batch */
+    pthread_mutex_t rn_lock;        /* guards rn_ready and the error */
+    pthread_cond_t rn_ready;
+    PyObject *rn_type;              /* the first error raised by a task */
+    PyObject *rn_value;
+    PyObject *rn_tb;
+};
+
+/* The run and the index of the worker running on this thread, so tasks
+   spawned by a task go to the deque of the worker stepping it. The run is
+   NULL on threads which are not stepping a task. */
+static _Thread_local struct copool_run *copool_current_run;
+static _Thread_local Py_ssize_t copool_current_worker;
+
+/* A worker thread and the run it belongs to. */
+typedef struct {
+    struct copool_run *ta_run;
+    Py_ssize_t ta_index;
+} copool_thread_arg;
+
+static inline uint64_t
+copool_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+/* deque -------------------------------------------------------------------- */
+
+/* Add a task to the end of a worker's deque, stealing a reference to it.
+ *
+ * This does not call into Python, so it may be called with or without the
+ * GIL.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero if the deque could not grow. The reference is
+ *     not released on failure.
+ */
+static int
+copool_worker_push(copool_worker *w, copool_task *task)
+{
+    copool_task **deque;
+    Py_ssize_t capacity;
+    Py_ssize_t n;
+    int err = 0;
+
+    pthread_mutex_lock(&w->wk_lock);
+    if (w->wk_size == w->wk_capacity) {
+        capacity = w->wk_capacity ? w->wk_capacity * 2 : 16;
+        if (!(deque = PyMem_RawMalloc(capacity * sizeof(copool_task*)))) {
+            err = -1;
+            goto done;
+        }
+        for (n = 0;n < w->wk_size;++n) {
+            deque[n] = w->wk_deque[(w->wk_head + n) & (w->wk_capacity - 1)];
+        }
+        PyMem_RawFree(w->wk_deque);
+        w->wk_deque = deque;
+        w->wk_capacity = capacity;
+        w->wk_head = 0;
+    }
+    w->wk_deque[(w->wk_head + w->wk_size++) & (w->wk_capacity - 1)] = task;
+done:
+    pthread_mutex_unlock(&w->wk_lock);
+    return err;
+}
+
+/* Take the task at the front of a worker's own deque.
+ *
+ * Returns
+ * -------
+ * task : copool_task*
+ *     The reference that was owned by the deque, or NULL if it is empty.
+ */
+static copool_task *
+copool_worker_pop(copool_worker *w)
+{
+    copool_task *task = NULL;
+
+    pthread_mutex_lock(&w->wk_lock);
+    if (w->wk_size) {
+        task = w->wk_deque[w->wk_head];
+        w->wk_head = (w->wk_head + 1) & (w->wk_capacity - 1);
+        --w->wk_size;
+    }
+    pthread_mutex_unlock(&w->wk_lock);
+    return task;
+}
+
+/* Take the task at the end of another worker's deque. */
+static copool_task *
+copool_worker_steal(copool_worker *w)
+{
+    copool_task *task = NULL;
+
+    pthread_mutex_lock(&w->wk_lock);
+    if (w->wk_size) {
+        --w->wk_size;
+        task = w->wk_deque[(w->wk_head + w->wk_size) & (w->wk_capacity - 1)];
+    }
+    pthread_mutex_unlock(&w->wk_lock);
+    return task;
+}
+
+/* run ---------------------------------------------------------------------- */
+
+/* Wake up the waiting workers. */
+static void
+copool_run_notify(struct copool_run *rn)
+{
+    if (atomic_load(&rn->rn_waiters)) {
+        pthread_mutex_lock(&rn->rn_lock);
+        pthread_cond_broadcast(&rn->rn_ready);
+        pthread_mutex_unlock(&rn->rn_lock);
+    }
+}
+
+/* Record the raised exception as the error of the run and stop the workers.
+ *
+ * This must be called with the GIL held. Only the first error is kept.
+ */
+static void
+copool_run_fail(struct copool_run *rn)
+{
+    PyObject *type;
+    PyObject *value;
+    PyObject *tb;
+
+    PyErr_Fetch(&type, &value, &tb);
+    pthread_mutex_lock(&rn->rn_lock);
+    if (!rn->rn_type) {
+        rn->rn_type = type;
+        rn->rn_value = value;
+        rn->rn_tb = tb;
+        type = value = tb = NULL;
+    }
+    atomic_store(&rn->rn_stop, 1);
+    pthread_cond_broadcast(&rn->rn_ready);
+    pthread_mutex_unlock(&rn->rn_lock);
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(tb);
+}
+
+/* Add a task to a deque of a running pool, stealing a reference to it.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero with an exception raised on failure. The
+ *     reference is released on failure.
+ */
+static int
+copool_run_push(struct copool_run *rn, Py_ssize_t index, copool_task *task)
+{
+    if (copool_worker_push(&rn->rn_workers[index], task)) {
+        Py_DECREF(task);
+        PyErr_NoMemory();
+        return -1;
+    }
+    atomic_fetch_add(&rn->rn_queued, 1);
+    copool_run_notify(rn);
+    return 0;
+}
+
+/* Find a task for a worker, first in its own deque and then in the other
+   workers' deques. */
+static copool_task *
+copool_run_take(struct copool_run *rn, Py_ssize_t index)
+{
+    copool_worker *self = &rn->rn_workers[index];
+    copool_task *task;
+    Py_ssize_t n;
+
+    if (!atomic_load(&rn->rn_queued)) {
+        return NULL;
+    }
+    if (!(task = copool_worker_pop(self))) {
+        for (n = 1;n < rn->rn_nworkers;++n) {
+            task = copool_worker_steal(
+                &rn->rn_workers[(index + n) % rn->rn_nworkers]);
+            if (task) {
+                ++self->wk_counters.wc_steals;
+                break;
+            }
+        }
+    }
+    if (task) {
+        atomic_fetch_sub(&rn->rn_queued, 1);
+    }
+    return task;
+}
+
+/* Wait, without the GIL, until there is a task in some deque, every task is
+ * done, or the run is stopped.
+ *
+ * The calling thread (index 0) wakes up periodically to run the signal
+ * handlers.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero if a signal handler raised.
+ */
+static int
+copool_run_wait(struct copool_run *rn, Py_ssize_t index)
+{
+    struct timespec deadline;
+    uint64_t start = copool_now();
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&rn->rn_lock);
+    atomic_fetch_add(&rn->rn_waiters, 1);
+    while (!atomic_load(&rn->rn_queued) &&
+           atomic_load(&rn->rn_live) &&
+           !atomic_load(&rn->rn_stop)) {
+        if (index) {
+            pthread_cond_wait(&rn->rn_ready, &rn->rn_lock);
+            continue;
+        }
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += COPOOL_SIGNAL_INTERVAL_NS;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_nsec -= 1000000000;
+            ++deadline.tv_sec;
+        }
+        if (pthread_cond_timedwait(&rn->rn_ready,
+                                   &rn->rn_lock,
+                                   &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    atomic_fetch_sub(&rn->rn_waiters, 1);
+    pthread_mutex_unlock(&rn->rn_lock);
+    Py_END_ALLOW_THREADS
+
+    rn->rn_workers[index].wk_counters.wc_idle_ns += copool_now() - start;
+    return index ? 0 : PyErr_CheckSignals();
+}
+
+/* Finish a task whose step returned NULL.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero if the coroutine returned, non-zero with the exception still
+ *     raised if it raised.
+ */
+static int
+copool_task_finish(copool_task *task)
+{
+    PyObject *type;
+    PyObject *value;
+    PyObject *tb;
+
+    task->pt_done = 1;
+    Py_CLEAR(task->pt_coroutine);
+    PyErr_Fetch(&type, &value, &tb);
+    PyErr_NormalizeException(&type, &value, &tb);
+    if (tb) {
+        PyException_SetTraceback(value, tb);
+    }
+    if (!PyErr_GivenExceptionMatches(type, PyExc_StopIteration)) {
+        Py_INCREF(value);
+        Py_XSETREF(task->pt_exception, value);
+        PyErr_Restore(type, value, tb);
+        return -1;
+    }
+    Py_XSETREF(task->pt_result, PyObject_GetAttrString(value, "value"));
+    Py_DECREF(type);
+    Py_DECREF(value);
+    Py_XDECREF(tb);
+    return task->pt_result ? 0 : -1;
+}
+
+/* The loop run by every worker, including the calling thread.
+ *
+ * A task is owned by exactly one worker from the time it is taken out of a
+ * deque until it is put back, so a coroutine is only ever stepped by one
+ * thread at a time. This must be called with the GIL held.
+ */
+static void
+copool_run_work(struct copool_run *rn, Py_ssize_t index)
+{
+    copool_counters *counters = &rn->rn_workers[index].wk_counters;
+    Py_ssize_t batch = rn->rn_pool->pl_batch;
+    Py_ssize_t next_check = COPOOL_SIGNAL_INTERVAL;
+    copool_task *task;
+    PyObject *ret;
+    Py_ssize_t n;
+    int err;
+    /* a task of another pool may be running this one */
+    struct copool_run *outer_run = copool_current_run;
+    Py_ssize_t outer_worker = copool_current_worker;
+
+    copool_current_run = rn;
+    copool_current_worker = index;
+    while (!atomic_load(&rn->rn_stop)) {
+        if (!(task = copool_run_take(rn, index))) {
+            if (!atomic_load(&rn->rn_live)) {
+                break;
+            }
+            if (copool_run_wait(rn, index)) {
+                copool_run_fail(rn);
+            }
+            continue;
+        }
+
+        ++counters->wc_batches;
+        err = 0;
+        for (n = 0;n < batch;++n) {
+            ret = _ctz_coiter_send_fast(task->pt_coroutine, Py_None);
+            ++task->pt_steps;
+            if (!ret) {
+                err = copool_task_finish(task);
+                ++n;
+                break;
+            }
+            Py_DECREF(ret);
+        }
+        counters->wc_steps += n;
+
+        if (task->pt_done) {
+            if (err) {
+                copool_run_fail(rn);
+            }
+            Py_DECREF(task);
+            if (atomic_fetch_sub(&rn->rn_live, 1) == 1) {
+                /* that was the last task, let the idle workers exit */
+                pthread_mutex_lock(&rn->rn_lock);
+                pthread_cond_broadcast(&rn->rn_ready);
+                pthread_mutex_unlock(&rn->rn_lock);
+            }
+        }
+        else if (copool_run_push(rn, index, task)) {
+            copool_run_fail(rn);
+        }
+
+        if (!index && counters->wc_steps >= (uint64_t) next_check) {
+            next_check = counters->wc_steps + COPOOL_SIGNAL_INTERVAL;
+            if (PyErr_CheckSignals()) {
+                copool_run_fail(rn);
+            }
+        }
+    }
+    copool_current_run = outer_run;
+    copool_current_worker = outer_worker;
+}
+
+static void *
+copool_thread(void *arg)
+{
+    copool_thread_arg *ta = arg;
+    PyGILState_STATE gil;
+
+    gil = PyGILState_Ensure();
+    copool_run_work(ta->ta_run, ta->ta_index);
+    PyGILState_Release(gil);
+    PyMem_RawFree(ta);
+    return NULL;
+}
+
+/* Start the worker threads of a run.
+ *
+ * A worker whose thread cannot be started still has its tasks dealt to it;
+ * the other workers steal them.
+ */
+static void
+copool_run_start(struct copool_run *rn)
+{
+    copool_thread_arg *ta;
+    Py_ssize_t n;
+
+    for (n = 1;n < rn->rn_nworkers;++n) {
+        if (!(ta = PyMem_RawMalloc(sizeof(copool_thread_arg)))) {
+            continue;
+        }
+        ta->ta_run = rn;
+        ta->ta_index = n;
+        if (pthread_create(&rn->rn_workers[n].wk_thread,
+                           NULL,
+                           copool_thread,
+                           ta)) {
+            PyMem_RawFree(ta);
+            continue;
+        }
+        rn->rn_workers[n].wk_started = 1;
+    }
+}
+
+/* Wait for the worker threads of a run and put the unfinished tasks back in
+   the pool's pending list. This must be called with the GIL held. */
+static int
+copool_run_finish(struct copool_run *rn)
+{
+    copool *pool = rn->rn_pool;
+    copool_worker *w;
+    copool_task *task;
+    Py_ssize_t n;
+    int err = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    for (n = 1;n < rn->rn_nworkers;++n) {
+        if (rn->rn_workers[n].wk_started) {
+            pthread_join(rn->rn_workers[n].wk_thread, NULL);
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    PyMem_Free(pool->pl_last);
+    pool->pl_last = PyMem_New(copool_counters, rn->rn_nworkers);
+    pool->pl_nlast = pool->pl_last ? rn->rn_nworkers : 0;
+    for (n = 0;n < rn->rn_nworkers;++n) {
+        w = &rn->rn_workers[n];
+        while ((task = copool_worker_pop(w))) {
+            if (!err && PyList_Append(pool->pl_pending, (PyObject*) task)) {
+                err = -1;
+            }
+            Py_DECREF(task);
+        }
+        PyMem_RawFree(w->wk_deque);
+        pthread_mutex_destroy(&w->wk_lock);
+
+        pool->pl_totals.wc_steps += w->wk_counters.wc_steps;
+        pool->pl_totals.wc_batches += w->wk_counters.wc_batches;
+        pool->pl_totals.wc_steals += w->wk_counters.wc_steals;
+        pool->pl_totals.wc_idle_ns += w->wk_counters.wc_idle_ns;
+        if (pool->pl_last) {
+            pool->pl_last[n] = w->wk_counters;
+        }
+    }
+    return err;
+}
+
+/* copool_task -------------------------------------------------------------- */
+
+static int
+copool_task_traverse(copool_task *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->pt_pool);
+    Py_VISIT(self->pt_coroutine);
+    Py_VISIT(self->pt_result);
+    Py_VISIT(self->pt_exception);
+    return 0;
+}
+
+static int
+copool_task_clear(copool_task *self)
+{
+    Py_CLEAR(self->pt_pool);
+    Py_CLEAR(self->pt_coroutine);
+    Py_CLEAR(self->pt_result);
+    Py_CLEAR(self->pt_exception);
+    return 0;
+}
+
+static void
+copool_task_dealloc(copool_task *self)
+{
+    PyObject_GC_UnTrack(self);
+    copool_task_clear(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyDoc_STRVAR(copool_task_close_doc,
+             "Close the task's coroutine and remove it from the pool.\n"
+             "\n"
+             "Raises\n"
+             "------\n"
+             "RuntimeError\n"
+             "    Raised when the pool is running.\n");
+
+static PyObject *
+copool_task_close(copool_task *self, PyObject *_)
+{
+    PyObject *cr;
+    int err;
+
+    if (self->pt_done) {
+        Py_RETURN_NONE;
+    }
+    if (((copool*) self->pt_pool)->pl_run) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cannot close a task while its pool is running");
+        return NULL;
+    }
+    /* the task is dropped from the pending list at the next run */
+    cr = self->pt_coroutine;
+    self->pt_coroutine = NULL;
+    self->pt_done = 1;
+    err = PyCoiter_API->close(cr);
+    Py_DECREF(cr);
+    if (err) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef copool_task_methods[] = {
+    {"close",
+     (PyCFunction) copool_task_close,
+     METH_NOARGS,
+     copool_task_close_doc},
+    {NULL},
+};
+
+static PyObject *
+copool_task_get_done(copool_task *self, void *_)
+{
+    return PyBool_FromLong(self->pt_done);
+}
+
+static PyObject *
+copool_task_get_steps(copool_task *self, void *_)
+{
+    return PyLong_FromUnsignedLongLong(self->pt_steps);
+}
+
+static PyObject *
+copool_task_get_result(copool_task *self, void *_)
+{
+    PyObject *ret = self->pt_result ? self->pt_result : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyObject *
+copool_task_get_exception(copool_task *self, void *_)
+{
+    PyObject *ret = self->pt_exception ? self->pt_exception : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyObject *
+copool_task_get_children(copool_task *self, void *_)
+{
+    if (!self->pt_coroutine) {
+        return PyTuple_New(0);
+    }
+    return PyTuple_Pack(1, self->pt_coroutine);
+}
+
+static PyGetSetDef copool_task_getsets[] = {
+    {"done", (getter) copool_task_get_done, NULL,
+     "Whether the task has finished, raised, or been closed.", NULL},
+    {"steps", (getter) copool_task_get_steps, NULL,
+     "The number of times the task has been stepped.", NULL},
+    {"result", (getter) copool_task_get_result, NULL,
+     "The value the coroutine returned, None until then.", NULL},
+    {"exception", (getter) copool_task_get_exception, NULL,
+     "The exception the coroutine raised, None if it did not.", NULL},
+    {"children", (getter) copool_task_get_children, NULL,
+     "The coroutine, empty once the task is done.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(copool_task_doc,
+             "A handle to a coroutine running on a copool.\n"
+             "\n"
+             "Tasks are created with ``copool.spawn``.\n");
+
+PyTypeObject PyCopoolTask_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._copool.task",                 /* tp_name */
+    sizeof(copool_task),                    /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) copool_task_dealloc,       /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    copool_task_doc,                        /* tp_doc */
+    (traverseproc) copool_task_traverse,    /* tp_traverse */
+    (inquiry) copool_task_clear,            /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    copool_task_methods,                    /* tp_methods */
+    0,                                      /* tp_members */
+    copool_task_getsets,                    /* tp_getset */
+};
+
+/* copool ------------------------------------------------------------------- */
+
+PyObject *
+PyCopool_New(Py_ssize_t workers, Py_ssize_t batch)
+{
+    copool *self;
+    PyObject *pending;
+
+    if (workers <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "copool() workers must be positive");
+        return NULL;
+    }
+    if (batch <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "copool() batch must be positive");
+        return NULL;
+    }
+    if (!(pending = PyList_New(0))) {
+        return NULL;
+    }
+    if (!(self = PyObject_GC_New(copool, &PyCopool_Type))) {
+        Py_DECREF(pending);
+        return NULL;
+    }
+    self->pl_pending = pending;
+    self->pl_run = NULL;
+    self->pl_workers = workers;
+    self->pl_batch = batch;
+    memset(&self->pl_totals, 0, sizeof(self->pl_totals));
+    self->pl_last = NULL;
+    self->pl_nlast = 0;
+    PyObject_GC_Track(self);
+    return (PyObject*) self;
+}
+
+static PyObject *
+copool_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"workers", "batch", NULL};
+    PyObject *workers_ob = Py_None;
+    Py_ssize_t workers;
+    Py_ssize_t batch = 64;
+    long ncpu;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|On:copool",
+                                     keywords,
+                                     &workers_ob,
+                                     &batch)) {
+        return NULL;
+    }
+    if (workers_ob == Py_None) {
+        ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = ncpu > 0 ? ncpu : 1;
+    }
+    else {
+        workers = PyNumber_AsSsize_t(workers_ob, PyExc_OverflowError);
+        if (workers == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+    }
+    return PyCopool_New(workers, batch);
+}
+
+static int
+copool_traverse(copool *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->pl_pending);
+    return 0;
+}
+
+static int
+copool_clear(copool *self)
+{
+    Py_CLEAR(self->pl_pending);
+    return 0;
+}
+
+static void
+copool_dealloc(copool *self)
+{
+    PyObject_GC_UnTrack(self);
+    copool_clear(self);
+    PyMem_Free(self->pl_last);
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyDoc_STRVAR(copool_spawn_doc,
+             "Add a coroutine to the pool.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "coroutine : iterable\n"
+             "    The coroutine or iterator to step. None is sent on every\n"
+             "    step and the yielded values are dropped.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "task : task\n"
+             "    The handle of the task.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "A task spawned by another task while the pool is running is\n"
+             "stepped in the same run.\n");
+
+PyObject *
+PyCopool_Spawn(PyObject *ob, PyObject *coroutine)
+{
+    copool *self;
+    copool_task *task;
+    struct copool_run *rn;
+    PyObject *cr;
+
+    if (!PyCopool_Check(ob)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    self = (copool*) ob;
+    if (!(cr = PyCoiter_API->new(coroutine))) {
+        return NULL;
+    }
+    if (!(task = PyObject_GC_New(copool_task, &PyCopoolTask_Type))) {
+        Py_DECREF(cr);
+        return NULL;
+    }
+    Py_INCREF(self);
+    task->pt_pool = (PyObject*) self;
+    task->pt_coroutine = cr;
+    task->pt_result = NULL;
+    task->pt_exception = NULL;
+    task->pt_steps = 0;
+    task->pt_done = 0;
+    PyObject_GC_Track(task);
+
+    if ((rn = self->pl_run)) {
+        /* the spawning task is live, so the workers are still running */
+        atomic_fetch_add(&rn->rn_live, 1);
+        Py_INCREF(task);
+        /* Spawns from outside of this pool's workers go to the calling
+           thread's deque, which the other workers steal from. */
+        if (copool_run_push(rn,
+                            copool_current_run == rn ?
+                            copool_current_worker :
+                            0,
+                            task)) {
+            atomic_fetch_sub(&rn->rn_live, 1);
+            Py_DECREF(task);
+            return NULL;
+        }
+    }
+    else if (PyList_Append(self->pl_pending, (PyObject*) task)) {
+        Py_DECREF(task);
+        return NULL;
+    }
+    return (PyObject*) task;
+}
+
+static PyObject *
+copool_spawn(copool *self, PyObject *coroutine)
+{
+    return PyCopool_Spawn((PyObject*) self, coroutine);
+}
+
+Py_ssize_t
+PyCopool_Run(PyObject *ob)
+{
+    copool *self;
+    struct copool_run rn;
+    copool_task *task;
+    PyObject *pending;
+    Py_ssize_t ntasks;
+    Py_ssize_t n;
+    uint64_t steps;
+    int err;
+
+    if (!PyCopool_Check(ob)) {
+        PyErr_BadInternalCall();
+        return -1;
+    }
+    self = (copool*) ob;
+    if (self->pl_run) {
+        PyErr_SetString(PyExc_RuntimeError, "copool is already running");
+        return -1;
+    }
+
+    /* take the pending list so tasks can be put back into a fresh one */
+    pending = self->pl_pending;
+    if (!(self->pl_pending = PyList_New(0))) {
+        self->pl_pending = pending;
+        return -1;
+    }
+    ntasks = 0;
+    for (n = 0;n < PyList_GET_SIZE(pending);++n) {
+        ntasks += !((copool_task*) PyList_GET_ITEM(pending, n))->pt_done;
+    }
+    if (!ntasks) {
+        Py_DECREF(pending);
+        return 0;
+    }
+
+    rn.rn_pool = self;
+    rn.rn_nworkers = self->pl_workers < ntasks ? self->pl_workers : ntasks;
+    if (!(rn.rn_workers = PyMem_RawCalloc(rn.rn_nworkers,
+                                          sizeof(copool_worker)))) {
+        Py_SETREF(self->pl_pending, pending);
+        PyErr_NoMemory();
+        return -1;
+    }
+    atomic_init(&rn.rn_live, ntasks);
+    atomic_init(&rn.rn_queued, 0);
+    atomic_init(&rn.rn_waiters, 0);
+    atomic_init(&rn.rn_stop, 0);
+    pthread_mutex_init(&rn.rn_lock, NULL);
+    pthread_cond_init(&rn.rn_ready, NULL);
+    rn.rn_type = rn.rn_value = rn.rn_tb = NULL;
+    for (n = 0;n < rn.rn_nworkers;++n) {
+        pthread_mutex_init(&rn.rn_workers[n].wk_lock, NULL);
+    }
+
+    /* deal the tasks round-robin */
+    err = 0;
+    ntasks = 0;
+    for (n = 0;n < PyList_GET_SIZE(pending);++n) {
+        task = (copool_task*) PyList_GET_ITEM(pending, n);
+        if (task->pt_done) {
+            continue;
+        }
+        Py_INCREF(task);
+        if (copool_run_push(&rn, ntasks++ % rn.rn_nworkers, task)) {
+            err = -1;
+            break;
+        }
+    }
+    Py_DECREF(pending);
+    if (err) {
+        atomic_store(&rn.rn_stop, 1);
+        copool_run_fail(&rn);
+    }
+
+    self->pl_run = &rn;
+    if (!err) {
+        copool_run_start(&rn);
+        copool_run_work(&rn, 0);
+    }
+    err = copool_run_finish(&rn);
+    self->pl_run = NULL;
+
+    steps = 0;
+    for (n = 0;n < rn.rn_nworkers;++n) {
+        steps += rn.rn_workers[n].wk_counters.wc_steps;
+    }
+    PyMem_RawFree(rn.rn_workers);
+    pthread_cond_destroy(&rn.rn_ready);
+    pthread_mutex_destroy(&rn.rn_lock);
+
+    if (rn.rn_type) {
+        PyErr_Restore(rn.rn_type, rn.rn_value, rn.rn_tb);
+        return -1;
+    }
+    if (err) {
+        return -1;
+    }
+    return steps;
+}
+
+PyDoc_STRVAR(copool_run_doc,
+             "Step every task until they are all done.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "steps : int\n"
+             "    The number of steps taken.\n"
+             "\n"
+             "Raises\n"
+             "------\n"
+             "If a task raises, the task is removed, the exception is stored\n"
+             "on the task, and the workers stop after their current batch.\n"
+             "The exception is re-raised from ``run`` once the workers have\n"
+             "stopped. Calling ``run`` again continues with the other tasks.\n");
+
+static PyObject *
+copool_run(copool *self, PyObject *_)
+{
+    Py_ssize_t steps;
+
+    if ((steps = PyCopool_Run((PyObject*) self)) < 0) {
+        return NULL;
+    }
+    return PyLong_FromSsize_t(steps);
+}
+
+static PyObject *
+copool_counters_as_dict(const copool_counters *counters)
+{
+    return Py_BuildValue("{sKsKsKsK}",
+                         "steps",
+                         (unsigned long long) counters->wc_steps,
+                         "batches",
+                         (unsigned long long) counters->wc_batches,
+                         "steals",
+                         (unsigned long long) counters->wc_steals,
+                         "idle_ns",
+                         (unsigned long long) counters->wc_idle_ns);
+}
+
+PyDoc_STRVAR(copool_stats_doc,
+             "Return the scheduling counters.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "stats : dict\n"
+             "    The number of ``steps``, the number of ``batches`` a task\n"
+             "    was picked up for, the number of tasks a worker took from\n"
+             "    another worker's deque (``steals``), and the nanoseconds the\n"
+             "    workers spent waiting for work (``idle_ns``), summed over\n"
+             "    every run. ``workers`` is a list of the same counters for\n"
+             "    each worker of the last run.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Unlike the ``stats`` of the coroutine nodes, these counters are\n"
+             "always kept; they are only updated once per batch.\n");
+
+static PyObject *
+copool_stats(copool *self, PyObject *_)
+{
+    PyObject *workers;
+    PyObject *item;
+    PyObject *ret;
+    Py_ssize_t n;
+
+    if (!(workers = PyList_New(self->pl_nlast))) {
+        return NULL;
+    }
+    for (n = 0;n < self->pl_nlast;++n) {
+        if (!(item = copool_counters_as_dict(&self->pl_last[n]))) {
+            Py_DECREF(workers);
+            return NULL;
+        }
+        PyList_SET_ITEM(workers, n, item);
+    }
+    if (!(ret = copool_counters_as_dict(&self->pl_totals))) {
+        Py_DECREF(workers);
+        return NULL;
+    }
+    if (PyDict_SetItemString(ret, "workers", workers)) {
+        Py_DECREF(ret);
+        ret = NULL;
+    }
+    Py_DECREF(workers);
+    return ret;
+}
+
+static PyMethodDef copool_methods[] = {
+    {"spawn",
+     (PyCFunction) copool_spawn,
+     METH_O,
+     copool_spawn_doc},
+    {"run",
+     (PyCFunction) copool_run,
+     METH_NOARGS,
+     copool_run_doc},
+    {"stats",
+     (PyCFunction) copool_stats,
+     METH_NOARGS,
+     copool_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(copool, a)
+
+static PyMemberDef copool_members[] = {
+    {"workers", T_PYSSIZET, OFF(pl_workers), READONLY,
+     "The most threads to step tasks on."},
+    {"batch", T_PYSSIZET, OFF(pl_batch), READONLY,
+     "The number of steps a task gets each time a worker picks it up."},
+    {NULL},
+};
+
+#undef OFF
+
+static PyObject *
+copool_get_pending(copool *self, void *_)
+{
+    return PyList_AsTuple(self->pl_pending);
+}
+
+static PyGetSetDef copool_getsets[] = {
+    {"pending", (getter) copool_get_pending, NULL,
+     "The tasks waiting for the next run.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(copool_doc,
+             "copool(workers=None, batch=64)\n"
+             "\n"
+             "A work-stealing pool of threads for stepping many independent\n"
+             "coroutines.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "workers : int, optional\n"
+             "    The most threads to step tasks on, including the thread\n"
+             "    which calls ``run``. Defaults to the number of CPUs.\n"
+             "batch : int, optional\n"
+             "    The number of steps a task gets each time a worker picks it\n"
+             "    up. Larger batches keep a pipeline on one core for longer.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "``run`` deals the tasks round-robin into a deque per worker.\n"
+             "Each worker steps the tasks from its own deque and, when that\n"
+             "is empty, steals from the others. A task is only ever stepped\n"
+             "by one thread at a time, so the coroutines do not need to be\n"
+             "thread-safe, but they must not be shared between tasks.\n"
+             "\n"
+             "The pool is concurrent but not parallel. Each worker holds the\n"
+             "GIL while it steps a task, so the workers take turns and only\n"
+             "overlap while a step releases the GIL, for example to block on\n"
+             "I/O or on a cochannel. This is also true on a free-threaded\n"
+             "build: copool and the rest of cotoolz are not marked as safe\n"
+             "to run without the GIL, so importing cotoolz turns the GIL back\n"
+             "on. Use a pool to overlap blocking steps, not to spread\n"
+             "CPU-bound steps over cores.\n");
+
+PyTypeObject PyCopool_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._copool.copool",               /* tp_name */
+    sizeof(copool),                         /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) copool_dealloc,            /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    copool_doc,                             /* tp_doc */
+    (traverseproc) copool_traverse,         /* tp_traverse */
+    (inquiry) copool_clear,                 /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    copool_methods,                         /* tp_methods */
+    copool_members,                         /* tp_members */
+    copool_getsets,                         /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    (newfunc) copool_new,                   /* tp_new */
+};
+
+static struct PyModuleDef _copool_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._copool",
+    "",
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCopool_Exported exported_symbols = {
+    PyCopool_New,
+    PyCopool_Spawn,
+    PyCopool_Run,
+};
+
+PyMODINIT_FUNC
+PyInit__copool(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCopoolTask_Type) || PyType_Ready(&PyCopool_Type)) {
+        return NULL;
+    }
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._copool._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_copool_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m, "copool", (PyObject*) &PyCopool_Type) ||
+        PyObject_SetAttrString(m, "task", (PyObject*) &PyCopoolTask_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,689 @@
+#include <Python.h>
+#include <errno.h>
+#include <structmember.h>
+#include <time.h>
+
+#include "cotoolz/coprefetch.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
+
+/* How long the consumer waits on the producer before checking for signals,
+   in nanoseconds. */
+#define COPREFETCH_SIGNAL_INTERVAL_NS 50000000
+
+/* Drop the values, iterator, and pending exception of a state.
+ *
+ * This must be called with the GIL held and while the producer thread is
+ * not running.
+ */
+static void
+coprefetch_state_drain(coprefetch_state *st)
+{
+    PyObject *item;
+
+    while (st->ps_count) {
+        item = st->ps_ring[st->ps_head];
+        st->ps_head = (st->ps_head + 1) % st->ps_depth;
+        --st->ps_count;
+        Py_DECREF(item);
+    }
+    st->ps_head = 0;
+    st->ps_done = 1;
+    Py_CLEAR(st->ps_it);
+    Py_CLEAR(st->ps_type);
+    Py_CLEAR(st->ps_value);
+    Py_CLEAR(st->ps_tb);
+}
+
+/* Release one owner of a state. This must be called with the GIL held. */
+static void
+coprefetch_state_decref(coprefetch_state *st)
+{
+    if (--st->ps_refcnt) {
+        return;
+    }
+    coprefetch_state_drain(st);
+    pthread_cond_destroy(&st->ps_not_full);
+    pthread_cond_destroy(&st->ps_not_empty);
+    pthread_mutex_destroy(&st->ps_lock);
+    PyMem_Free(st->ps_ring);
+    PyMem_Free(st);
+}
+
+/* The body of the producer thread.
+ *
+ * The producer pulls values out of the inner iterator until the ring is full
+ * and then waits, without the GIL, until the consumer has drained the ring
+ * to ``ps_lowwater`` values. Refilling in batches keeps the two threads from
+ * trading the GIL on every value.
+ */
+static void *
+coprefetch_produce(void *arg)
+{
+    coprefetch_state *st = arg;
+    PyGILState_STATE gil;
+    PyObject *item;
+    int more;
+
+    gil = PyGILState_Ensure();
+    while (1) {
+        Py_BEGIN_ALLOW_THREADS
+        pthread_mutex_lock(&st->ps_lock);
+        while (!st->ps_stop && st->ps_count > st->ps_lowwater) {
+            pthread_cond_wait(&st->ps_not_full, &st->ps_lock);
+        }
+        more = !st->ps_stop;
+        pthread_mutex_unlock(&st->ps_lock);
+        Py_END_ALLOW_THREADS
+        if (!more) {
+            break;
+        }
+
+        do {
+            if (!(item = PyIter_Next(st->ps_it)) && PyErr_Occurred()) {
+                PyErr_Fetch(&st->ps_type, &st->ps_value, &st->ps_tb);
+            }
+            pthread_mutex_lock(&st->ps_lock);
+            if (item) {
+                st->ps_ring[(st->ps_head + st->ps_count) % st->ps_depth] =
+                    item;
+                ++st->ps_count;
+            }
+            else {
+                st->ps_done = 1;
+            }
+            pthread_cond_signal(&st->ps_not_empty);
+            more = (item &&
+                    !st->ps_stop &&
+                    st->ps_count < st->ps_depth);
+            pthread_mutex_unlock(&st->ps_lock);
+        } while (more);
+        if (!item) {
+            break;
+        }
+    }
+    coprefetch_state_decref(st);
+    PyGILState_Release(gil);
+    return NULL;
+}
+
+static PyObject *
+inner_coprefetch_new(PyTypeObject *cls, PyObject *iterable, Py_ssize_t depth)
+{
+    coprefetch *self;
+    coprefetch_state *st;
+    PyObject *it;
+    int err;
+
+    if (depth <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "coprefetch() depth must be positive");
+        return NULL;
+    }
+    if (!(it = PyObject_GetIter(iterable))) {
+        return NULL;
+    }
+    if (!(st = PyMem_New(coprefetch_state, 1))) {
+        Py_DECREF(it);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    if (!(st->ps_ring = PyMem_New(PyObject*, depth))) {
+        PyMem_Free(st);
+        Py_DECREF(it);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    st->ps_it = it;
+    st->ps_depth = depth;
+    st->ps_lowwater = depth / 2;
+    st->ps_head = 0;
+    st->ps_count = 0;
+    st->ps_done = 0;
+    st->ps_stop = 0;
+    st->ps_refcnt = 1;
+    st->ps_type = NULL;
+    st->ps_value = NULL;
+    st->ps_tb = NULL;
+    pthread_mutex_init(&st->ps_lock, NULL);
+    pthread_cond_init(&st->ps_not_empty, NULL);
+    pthread_cond_init(&st->ps_not_full, NULL);
+
+    if (!(self = (coprefetch*) cls->tp_alloc(cls, 0))) {
+        coprefetch_state_decref(st);
+        return NULL;
+    }
+    self->pf_state = st;
+    self->pf_running = 0;
+
+    /* The producer thread owns a reference to the state. */
+    ++st->ps_refcnt;
+    if ((err = pthread_create(&self->pf_thread,
+                              NULL,
+                              coprefetch_produce,
+                              st))) {
+        --st->ps_refcnt;
+        Py_DECREF(self);
+        errno = err;
+        PyErr_SetFromErrno(PyExc_OSError);
+        return NULL;
+    }
+    self->pf_running = 1;
+    return (PyObject*) self;
+}
+
+PyObject *
+PyCoprefetch_New(PyObject *iterable, Py_ssize_t depth)
+{
+    return inner_coprefetch_new(&PyCoprefetch_Type, iterable, depth);
+}
+
+static PyObject *
+coprefetch_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"iterable", "depth", NULL};
+    PyObject *iterable;
+    Py_ssize_t depth = 64;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "O|n:coprefetch",
+                                     keywords,
+                                     &iterable,
+                                     &depth)) {
+        return NULL;
+    }
+    return inner_coprefetch_new(cls, iterable, depth);
+}
+
+/* Stop the producer thread and wait for it to exit.
+ *
+ * If this is called on the producer thread itself, for example when the
+ * garbage collector runs inside the inner iterator, the thread is detached
+ * instead and exits once it returns to the producer loop.
+ *
+ * Returns
+ * -------
+ * joined : int
+ *     zero when the producer is no longer using the state, non-zero when it
+ *     was detached and may still be running.
+ */
+static int
+coprefetch_join(coprefetch *self)
+{
+    coprefetch_state *st = self->pf_state;
+
+    if (!self->pf_running) {
+        return 0;
+    }
+    self->pf_running = 0;
+
+    pthread_mutex_lock(&st->ps_lock);
+    st->ps_stop = 1;
+    pthread_cond_broadcast(&st->ps_not_full);
+    pthread_mutex_unlock(&st->ps_lock);
+
+    if (pthread_equal(pthread_self(), self->pf_thread)) {
+        pthread_detach(self->pf_thread);
+        return 1;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(self->pf_thread, NULL);
+    Py_END_ALLOW_THREADS
+    return 0;
+}
+
+static int
+coprefetch_traverse(coprefetch *self, visitproc visit, void *arg)
+{
+    coprefetch_state *st = self->pf_state;
+    Py_ssize_t n;
+
+    /* Every write to the state happens with the GIL held. */
+    if (st) {
+        Py_VISIT(st->ps_it);
+        for (n = 0;n < st->ps_count;++n) {
+            Py_VISIT(st->ps_ring[(st->ps_head + n) % st->ps_depth]);
+        }
+    }
+    return 0;
+}
+
+static int
+coprefetch_clear(coprefetch *self)
+{
+    if (self->pf_state && !coprefetch_join(self)) {
+        coprefetch_state_drain(self->pf_state);
+    }
+    return 0;
+}
+
+static void
+coprefetch_dealloc(coprefetch *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->pf_state) {
+        coprefetch_join(self);
+        coprefetch_state_decref(self->pf_state);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Wait for the producer to make a value available.
+ *
+ * The GIL is released while waiting. The wait wakes up periodically to run
+ * the signal handlers so that a blocked consumer can be interrupted.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero if a signal handler raised. ``ps_lock`` is
+ *     held on success.
+ */
+static int
+coprefetch_wait(coprefetch_state *st)
+{
+    struct timespec deadline;
+
+    while (!st->ps_count && !st->ps_done) {
+        pthread_mutex_unlock(&st->ps_lock);
+        Py_BEGIN_ALLOW_THREADS
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += COPREFETCH_SIGNAL_INTERVAL_NS;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_nsec -= 1000000000;
+            ++deadline.tv_sec;
+        }
+        pthread_mutex_lock(&st->ps_lock);
+        if (!st->ps_count && !st->ps_done) {
+            pthread_cond_timedwait(&st->ps_not_empty, &st->ps_lock, &deadline);
+        }
+        pthread_mutex_unlock(&st->ps_lock);
+        Py_END_ALLOW_THREADS
+        if (PyErr_CheckSignals()) {
+            return -1;
+        }
+        pthread_mutex_lock(&st->ps_lock);
+    }
+    return 0;
+}
+
+static PyObject *
+coprefetch_pop(coprefetch *self)
+{
+    coprefetch_state *st = self->pf_state;
+    PyObject *item = NULL;
+    int err;
+    CTZ_STATS_DECL(start);
+
+    pthread_mutex_lock(&st->ps_lock);
+    if (!st->ps_count && !st->ps_done) {
+        CTZ_STATS_START(start);
+        err = coprefetch_wait(st);
+        CTZ_STATS_ELAPSED(self->pf_stats, child, start);
+        if (err) {
+            return NULL;
+        }
+    }
+    if (st->ps_count) {
+        item = st->ps_ring[st->ps_head];
+        st->ps_head = (st->ps_head + 1) % st->ps_depth;
+        if (--st->ps_count == st->ps_lowwater) {
+            pthread_cond_signal(&st->ps_not_full);
+        }
+    }
+    pthread_mutex_unlock(&st->ps_lock);
+    if (item) {
+        return item;
+    }
+
+    /* The producer is finished so reap it now rather than at close. */
+    coprefetch_join(self);
+    if (st->ps_type) {
+        PyErr_Restore(st->ps_type, st->ps_value, st->ps_tb);
+        st->ps_type = st->ps_value = st->ps_tb = NULL;
+    }
+    else {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_STOP(self->pf_stats, NULL);
+    }
+    return NULL;
+}
+
+PyDoc_STRVAR(coprefetch_send_doc,
+             "Get the next prefetched value.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    Ignored. The inner iterator runs ahead of the sends so, like\n"
+             "    a ``coiter`` around a plain iterator, the sent value is\n"
+             "    dropped.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The next value of the inner iterator.\n");
+
+static PyObject *
+coprefetch_send(coprefetch *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coprefetch_send, self, 1);
+    CTZ_STATS_INCR(self->pf_stats, sends);
+    ret = coprefetch_pop(self);
+    CTZ_PROBE_RETURN(coprefetch_send, self, 1, ret);
+    return ret;
+}
+
+PyObject *
+PyCoprefetch_Send(PyObject *pf, PyObject *value)
+{
+    if (!PyCoprefetch_Check(pf)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coprefetch_send((coprefetch*) pf, value);
+}
+
+static PyObject *
+coprefetch_next(coprefetch *self)
+{
+    return coprefetch_send(self, Py_None);
+}
+
+PyDoc_STRVAR(coprefetch_throw_doc,
+             "Raise an exception in the coprefetch.\n"
+             "\n"
+             "The inner iterator is running on another thread so the\n"
+             "exception is raised immediately; the producer keeps running.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n");
+
+static PyObject *
+coprefetch_throw(coprefetch *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(coprefetch_throw, self, 1);
+    CTZ_STATS_INCR(self->pf_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(coprefetch_throw, self, 1, NULL);
+    return NULL;
+}
+
+PyObject *
+PyCoprefetch_Throw(PyObject *pf, PyObject *excinfo)
+{
+    if (!PyCoprefetch_Check(pf)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coprefetch_throw((coprefetch*) pf, excinfo);
+}
+
+PyDoc_STRVAR(coprefetch_close_doc,
+             "Close the coprefetch."
+             "\n"
+             "This stops and joins the producer thread, drops the prefetched\n"
+             "values, and closes the inner iterator. If the producer is\n"
+             "blocked inside the inner iterator this waits for it to\n"
+             "return.\n");
+
+static PyObject *
+inner_coprefetch_close(coprefetch *self, PyObject *_)
+{
+    coprefetch_state *st = self->pf_state;
+    PyObject *it;
+    PyObject *ret;
+
+    CTZ_STATS_INCR(self->pf_stats, closes);
+    if (coprefetch_join(self)) {
+        /* closed from inside the inner iterator */
+        Py_RETURN_NONE;
+    }
+    it = st->ps_it;
+    st->ps_it = NULL;
+    coprefetch_state_drain(st);
+    if (!it) {
+        Py_RETURN_NONE;
+    }
+    if (!PyObject_HasAttrString(it, "close")) {
+        Py_DECREF(it);
+        Py_RETURN_NONE;
+    }
+    ret = PyObject_CallMethod(it, "close", NULL);
+    Py_DECREF(it);
+    return ret;
+}
+
+static PyObject *
+coprefetch_close(coprefetch *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coprefetch_close, self, 1);
+    ret = inner_coprefetch_close(self, _);
+    CTZ_PROBE_RETURN(coprefetch_close, self, 1, ret);
+    return ret;
+}
+
+int
+PyCoprefetch_Close(PyObject *pf)
+{
+    PyObject *ret;
+
+    if (!PyCoprefetch_Check(pf)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = coprefetch_close((coprefetch*) pf, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCoprefetch_Stats(PyObject *pf, ctz_stats *out)
+{
+    if (!PyCoprefetch_Check(pf)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((coprefetch*) pf)->pf_stats), out);
+}
+
+PyDoc_STRVAR(coprefetch_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+coprefetch_stats(coprefetch *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->pf_stats));
+}
+
+static PyMethodDef coprefetch_methods[] = {
+    {"send", (PyCFunction) coprefetch_send, METH_O, coprefetch_send_doc},
+    {"throw",
+     (PyCFunction) coprefetch_throw,
+     METH_VARARGS,
+     coprefetch_throw_doc},
+    {"close",
+     (PyCFunction) coprefetch_close,
+     METH_NOARGS,
+     coprefetch_close_doc},
+    {"stats",
+     (PyCFunction) coprefetch_stats,
+     METH_NOARGS,
+     coprefetch_stats_doc},
+    {NULL},
+};
+
+static PyObject *
+coprefetch_get_depth(coprefetch *self, void *_)
+{
+    return PyLong_FromSsize_t(self->pf_state->ps_depth);
+}
+
+static PyObject *
+coprefetch_get_buffered(coprefetch *self, void *_)
+{
+    return PyLong_FromSsize_t(self->pf_state->ps_count);
+}
+
+static PyGetSetDef coprefetch_getsets[] = {
+    {"depth", (getter) coprefetch_get_depth, NULL,
+     "The number of values to prefetch.", NULL},
+    {"buffered", (getter) coprefetch_get_buffered, NULL,
+     "The number of values which have been prefetched but not consumed.",
+     NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(coprefetch_doc,
+             "Prefetch the values of an iterable on a background thread.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "iterable : iterable\n"
+             "    The iterable to prefetch.\n"
+             "depth : int, optional\n"
+             "    The number of values to prefetch. Defaults to 64.\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Returns the next prefetched value, ``value`` is ignored.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Raises the exception.\n"
+             "close()\n"
+             "    Stops the producer thread and closes the inner iterator.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this coprefetch.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "The producer thread runs the inner iterator with the GIL held,\n"
+             "so this only helps when the inner iterator releases the GIL\n"
+             "itself, for example while reading from a file, pipe, or\n"
+             "socket. The producer refills the buffer in batches once it\n"
+             "has drained to half of ``depth``. An exception raised by the\n"
+             "inner iterator is raised by the coprefetch after the values\n"
+             "before it have been consumed. The child time in ``stats()``\n"
+             "is the time spent waiting on the producer.\n"
+    );
+
+PyTypeObject PyCoprefetch_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coprefetch.coprefetch",   /* tp_name */
+    sizeof(coprefetch),                 /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    (destructor) coprefetch_dealloc,    /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_reserved */
+    0,                                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    0,                                  /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    0,                                  /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
+    coprefetch_doc,                     /* tp_doc */
+    (traverseproc) coprefetch_traverse, /* tp_traverse */
+    (inquiry) coprefetch_clear,         /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    PyObject_SelfIter,                  /* tp_iter */
+    (iternextfunc) coprefetch_next,     /* tp_iternext */
+    coprefetch_methods,                 /* tp_methods */
+    0,                                  /* tp_members */
+    coprefetch_getsets,                 /* tp_getset */
+    0,                                  /* tp_base */
+    0,                                  /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    0,                                  /* tp_init */
+    0,                                  /* tp_alloc */
+    coprefetch_new,                     /* tp_new */
+};
+
+PyDoc_STRVAR(module_doc,
+             "coprefetch runs an iterator ahead on a background thread.");
+
+static struct PyModuleDef _coprefetch_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._coprefetch",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCoprefetch_Exported exported_symbols = {
+    PyCoprefetch_New,
+    PyCoprefetch_Send,
+    PyCoprefetch_Throw,
+    PyCoprefetch_Close,
+    PyCoprefetch_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__coprefetch(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCoprefetch_Type)) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._coprefetch._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_coprefetch_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "coprefetch",
+                               (PyObject*) &PyCoprefetch_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
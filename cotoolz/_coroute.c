@@ -0,0 +1,938 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/coroute.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+static PyObject *
+inner_coroute_new(PyTypeObject *cls,
+                  PyObject *keyfunc,
+                  PyObject *handlers,
+                  Py_ssize_t maxsize,
+                  int prime)
+{
+    coroute *self;
+    PyObject *routes;
+    PyObject *items = NULL;
+    PyObject *factory = NULL;
+    PyObject *item;
+    PyObject *cr;
+    Py_ssize_t n;
+    int err;
+
+    if (keyfunc == Py_None) {
+        keyfunc = NULL;
+    }
+    if (maxsize < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "coroute() maxsize must be positive");
+        return NULL;
+    }
+
+    if (!(routes = PyDict_New())) {
+        return NULL;
+    }
+    if (PyCallable_Check(handlers) && !PyDict_Check(handlers)) {
+        factory = handlers;
+    }
+    else {
+        if (maxsize) {
+            PyErr_SetString(PyExc_ValueError,
+                            "coroute() maxsize requires a handler factory");
+            goto error;
+        }
+        if (!PyMapping_Check(handlers)) {
+            PyErr_Format(PyExc_TypeError,
+                         "coroute() handlers must be a mapping or callable,"
+                         " got %R",
+                         handlers);
+            goto error;
+        }
+        if (!(items = PyMapping_Items(handlers))) {
+            goto error;
+        }
+        for (n = 0;n < PyList_GET_SIZE(items);++n) {
+            item = PyList_GET_ITEM(items, n);
+            if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != 2) {
+                PyErr_SetString(PyExc_TypeError,
+                                "coroute() handlers.items() must be pairs");
+                goto error;
+            }
+            if (!(cr = PyCoiter_API->new(PyTuple_GET_ITEM(item, 1)))) {
+                goto error;
+            }
+            err = PyDict_SetItem(routes, PyTuple_GET_ITEM(item, 0), cr);
+            Py_DECREF(cr);
+            if (err) {
+                goto error;
+            }
+        }
+        Py_CLEAR(items);
+    }
+
+    if (!(self = (coroute*) cls->tp_alloc(cls, 0))) {
+        goto error;
+    }
+    Py_XINCREF(keyfunc);
+    self->rt_keyfunc = keyfunc;
+    Py_XINCREF(factory);
+    self->rt_factory = factory;
+    self->rt_routes = routes;
+    self->rt_last = NULL;
+    self->rt_lastkey = NULL;
+    self->rt_prime = prime;
+    self->rt_maxsize = maxsize;
+    self->rt_slots = NULL;
+    self->rt_nslots = 0;
+    self->rt_capacity = 0;
+    self->rt_head = -1;
+    self->rt_tail = -1;
+    return (PyObject*) self;
+
+error:
+    Py_DECREF(routes);
+    Py_XDECREF(items);
+    return NULL;
+}
+
+PyObject *
+PyCoroute_New(PyObject *keyfunc, PyObject *handlers, Py_ssize_t maxsize)
+{
+    return inner_coroute_new(&PyCoroute_Type, keyfunc, handlers, maxsize, 0);
+}
+
+static PyObject *
+coroute_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"keyfunc", "handlers", "maxsize", "prime", NULL};
+    PyObject *keyfunc;
+    PyObject *handlers;
+    PyObject *maxsize_ob = Py_None;
+    Py_ssize_t maxsize = 0;
+    int prime = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "OO|$Op:coroute",
+                                     keywords,
+                                     &keyfunc,
+                                     &handlers,
+                                     &maxsize_ob,
+                                     &prime)) {
+        return NULL;
+    }
+    if (maxsize_ob != Py_None) {
+        if ((maxsize = PyLong_AsSsize_t(maxsize_ob)) == -1 &&
+            PyErr_Occurred()) {
+            return NULL;
+        }
+        if (maxsize <= 0) {
+            PyErr_SetString(PyExc_ValueError,
+                            "coroute() maxsize must be positive");
+            return NULL;
+        }
+    }
+    return inner_coroute_new(cls, keyfunc, handlers, maxsize, prime);
+}
+
+static int
+coroute_traverse(coroute *self, visitproc visit, void *arg)
+{
+    Py_ssize_t n;
+
+    Py_VISIT(self->rt_keyfunc);
+    Py_VISIT(self->rt_factory);
+    Py_VISIT(self->rt_routes);
+    Py_VISIT(self->rt_last);
+    Py_VISIT(self->rt_lastkey);
+    for (n = 0;n < self->rt_nslots;++n) {
+        Py_VISIT(self->rt_slots[n].rs_key);
+        Py_VISIT(self->rt_slots[n].rs_handler);
+    }
+    return 0;
+}
+
+static void
+coroute_clear_slots(coroute *self)
+{
+    Py_ssize_t nslots = self->rt_nslots;
+    coroute_slot *slot;
+
+    self->rt_nslots = 0;
+    self->rt_head = self->rt_tail = -1;
+    while (nslots--) {
+        slot = &self->rt_slots[nslots];
+        Py_CLEAR(slot->rs_key);
+        Py_CLEAR(slot->rs_index);
+        Py_CLEAR(slot->rs_handler);
+    }
+}
+
+static int
+coroute_clear(coroute *self)
+{
+    Py_CLEAR(self->rt_keyfunc);
+    Py_CLEAR(self->rt_factory);
+    Py_CLEAR(self->rt_routes);
+    Py_CLEAR(self->rt_last);
+    Py_CLEAR(self->rt_lastkey);
+    coroute_clear_slots(self);
+    return 0;
+}
+
+static void
+coroute_dealloc(coroute *self)
+{
+    PyObject_GC_UnTrack(self);
+    coroute_clear(self);
+    PyMem_Free(self->rt_slots);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* The least recently used list --------------------------------------------- */
+
+static void
+coroute_unlink(coroute *self, Py_ssize_t n)
+{
+    coroute_slot *slot = &self->rt_slots[n];
+
+    if (slot->rs_prev < 0) {
+        self->rt_head = slot->rs_next;
+    }
+    else {
+        self->rt_slots[slot->rs_prev].rs_next = slot->rs_next;
+    }
+    if (slot->rs_next < 0) {
+        self->rt_tail = slot->rs_prev;
+    }
+    else {
+        self->rt_slots[slot->rs_next].rs_prev = slot->rs_prev;
+    }
+}
+
+static void
+coroute_push_front(coroute *self, Py_ssize_t n)
+{
+    coroute_slot *slot = &self->rt_slots[n];
+
+    slot->rs_prev = -1;
+    slot->rs_next = self->rt_head;
+    if (self->rt_head < 0) {
+        self->rt_tail = n;
+    }
+    else {
+        self->rt_slots[self->rt_head].rs_prev = n;
+    }
+    self->rt_head = n;
+}
+
+static void
+coroute_push_back(coroute *self, Py_ssize_t n)
+{
+    coroute_slot *slot = &self->rt_slots[n];
+
+    slot->rs_next = -1;
+    slot->rs_prev = self->rt_tail;
+    if (self->rt_tail < 0) {
+        self->rt_head = n;
+    }
+    else {
+        self->rt_slots[self->rt_tail].rs_next = n;
+    }
+    self->rt_tail = n;
+}
+
+/* Get a free slot, evicting the least recently used handler if there are
+ * ``rt_maxsize`` handlers.
+ *
+ * Returns
+ * -------
+ * n : Py_ssize_t
+ *     The index of the free slot, -1 on failure.
+ */
+static Py_ssize_t
+coroute_free_slot(coroute *self)
+{
+    Py_ssize_t n;
+    Py_ssize_t capacity;
+    coroute_slot *slots;
+    coroute_slot *slot;
+
+    if (self->rt_nslots < self->rt_maxsize &&
+        (self->rt_tail < 0 || self->rt_slots[self->rt_tail].rs_key)) {
+        if (self->rt_nslots == self->rt_capacity) {
+            capacity = self->rt_capacity ? self->rt_capacity * 2 : 8;
+            if (capacity > self->rt_maxsize) {
+                capacity = self->rt_maxsize;
+            }
+            if (!(slots = PyMem_Realloc(self->rt_slots,
+                                        capacity * sizeof(coroute_slot)))) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            self->rt_slots = slots;
+            self->rt_capacity = capacity;
+        }
+        n = self->rt_nslots;
+        slot = &self->rt_slots[n];
+        if (!(slot->rs_index = PyLong_FromSsize_t(n))) {
+            return -1;
+        }
+        slot->rs_key = NULL;
+        slot->rs_handler = NULL;
+        ++self->rt_nslots;
+        coroute_push_back(self, n);
+        return n;
+    }
+
+    n = self->rt_tail;
+    slot = &self->rt_slots[n];
+    if (slot->rs_key) {
+        if (PyCoiter_API->close(slot->rs_handler) ||
+            PyDict_DelItem(self->rt_routes, slot->rs_key)) {
+            return -1;
+        }
+        Py_CLEAR(slot->rs_key);
+        Py_CLEAR(slot->rs_handler);
+    }
+    return n;
+}
+
+/* Routing ------------------------------------------------------------------ */
+
+/* Create the handler for a new key.
+ *
+ * Returns
+ * -------
+ * handler : coiter
+ *     A borrowed reference to the new handler.
+ */
+static PyObject *
+coroute_add(coroute *self, PyObject *key)
+{
+    PyObject *ob;
+    PyObject *handler;
+    PyObject *ret;
+    Py_ssize_t n;
+    coroute_slot *slot;
+    int err;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_START(start);
+    ob = PyObject_CallOneArg(self->rt_factory, key);
+    CTZ_STATS_ELAPSED(self->rt_stats, func, start);
+    if (!ob) {
+        return NULL;
+    }
+    handler = PyCoiter_API->new(ob);
+    Py_DECREF(ob);
+    if (!handler) {
+        return NULL;
+    }
+    if (self->rt_prime) {
+        CTZ_STATS_START(start);
+        ret = _ctz_coiter_send_fast(handler, Py_None);
+        CTZ_STATS_ELAPSED(self->rt_stats, child, start);
+        if (!ret) {
+            Py_DECREF(handler);
+            return NULL;
+        }
+        Py_DECREF(ret);
+    }
+
+    if (!self->rt_maxsize) {
+        err = PyDict_SetItem(self->rt_routes, key, handler);
+        Py_DECREF(handler);
+        return err ? NULL : handler;
+    }
+
+    if ((n = coroute_free_slot(self)) < 0) {
+        Py_DECREF(handler);
+        return NULL;
+    }
+    slot = &self->rt_slots[n];
+    if (PyDict_SetItem(self->rt_routes, key, slot->rs_index)) {
+        Py_DECREF(handler);
+        return NULL;
+    }
+    Py_INCREF(key);
+    slot->rs_key = key;
+    slot->rs_handler = handler;
+    coroute_unlink(self, n);
+    coroute_push_front(self, n);
+    return handler;
+}
+
+/* Find or create the handler for a key.
+ *
+ * Returns
+ * -------
+ * handler : coiter
+ *     A borrowed reference to the handler.
+ */
+static inline PyObject *
+coroute_handler(coroute *self, PyObject *key)
+{
+    PyObject *found;
+    Py_ssize_t n;
+
+    if ((found = PyDict_GetItemWithError(self->rt_routes, key))) {
+        if (!self->rt_maxsize) {
+            return found;
+        }
+        n = PyLong_AsSsize_t(found);
+        if (n != self->rt_head) {
+            coroute_unlink(self, n);
+            coroute_push_front(self, n);
+        }
+        return self->rt_slots[n].rs_handler;
+    }
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    if (!self->rt_factory) {
+        if ((found = PyTuple_Pack(1, key))) {
+            PyErr_SetObject(PyExc_KeyError, found);
+            Py_DECREF(found);
+        }
+        return NULL;
+    }
+    return coroute_add(self, key);
+}
+
+/* Forget the handler for a key so that the factory is called again the next
+ * time the key is seen. Handlers from a fixed mapping are kept.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure.
+ */
+static int
+coroute_drop(coroute *self, PyObject *key)
+{
+    PyObject *found;
+    coroute_slot *slot;
+    Py_ssize_t n;
+
+    if (!self->rt_factory) {
+        return 0;
+    }
+    if (!self->rt_maxsize) {
+        if (PyDict_DelItem(self->rt_routes, key)) {
+            if (!PyErr_ExceptionMatches(PyExc_KeyError)) {
+                return -1;
+            }
+            PyErr_Clear();
+        }
+        return 0;
+    }
+    if (!(found = PyDict_GetItemWithError(self->rt_routes, key))) {
+        return PyErr_Occurred() ? -1 : 0;
+    }
+    n = PyLong_AsSsize_t(found);
+    if (PyDict_DelItem(self->rt_routes, key)) {
+        return -1;
+    }
+    slot = &self->rt_slots[n];
+    Py_CLEAR(slot->rs_key);
+    Py_CLEAR(slot->rs_handler);
+    coroute_unlink(self, n);
+    coroute_push_back(self, n);
+    return 0;
+}
+
+/* Handle the result of sending or throwing into the handler for ``key``.
+ *
+ * Paramaters
+ * ----------
+ * handler : coiter
+ *     A new reference to the handler.
+ * key : any
+ *     A new reference to the key of the handler.
+ * ret : any
+ *     A new reference to the result of the handler or NULL if it raised.
+ *
+ * Returns
+ * -------
+ * ret : any
+ *     ``ret``.
+ */
+static PyObject *
+coroute_finish(coroute *self, PyObject *handler, PyObject *key, PyObject *ret)
+{
+    PyObject *type;
+    PyObject *exc;
+    PyObject *tb;
+
+    if (ret) {
+        Py_XSETREF(self->rt_last, handler);
+        Py_XSETREF(self->rt_lastkey, key);
+        return ret;
+    }
+
+    Py_CLEAR(self->rt_last);
+    Py_CLEAR(self->rt_lastkey);
+    if (PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        PyErr_Fetch(&type, &exc, &tb);
+        if (coroute_drop(self, key)) {
+            Py_XDECREF(type);
+            Py_XDECREF(exc);
+            Py_XDECREF(tb);
+        }
+        else {
+            PyErr_Restore(type, exc, tb);
+        }
+    }
+    Py_DECREF(handler);
+    Py_DECREF(key);
+    return NULL;
+}
+
+PyDoc_STRVAR(coroute_send_doc,
+             "Send a value into the handler for its key.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to route.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The value yielded by the handler.\n");
+
+static PyObject *
+inner_coroute_send(coroute *self, PyObject *value)
+{
+    PyObject *key;
+    PyObject *handler;
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->rt_stats, sends);
+    if (!self->rt_keyfunc) {
+        key = value;
+        Py_INCREF(key);
+    }
+    else {
+        CTZ_STATS_START(start);
+        key = PyObject_CallOneArg(self->rt_keyfunc, value);
+        CTZ_STATS_ELAPSED(self->rt_stats, func, start);
+        if (!key) {
+            return NULL;
+        }
+    }
+    if (!(handler = coroute_handler(self, key))) {
+        Py_DECREF(key);
+        return NULL;
+    }
+    /* The handler may be evicted while it is running. */
+    Py_INCREF(handler);
+    CTZ_STATS_START(start);
+    ret = _ctz_coiter_send_fast(handler, value);
+    CTZ_STATS_ELAPSED(self->rt_stats, child, start);
+    CTZ_STATS_STOP(self->rt_stats, ret);
+    return coroute_finish(self, handler, key, ret);
+}
+
+static PyObject *
+coroute_send(coroute *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coroute_send, self, PyDict_GET_SIZE(self->rt_routes));
+    ret = inner_coroute_send(self, value);
+    CTZ_PROBE_RETURN(coroute_send,
+                     self,
+                     PyDict_GET_SIZE(self->rt_routes),
+                     ret);
+    return ret;
+}
+
+PyObject *
+PyCoroute_Send(PyObject *rt, PyObject *value)
+{
+    if (!PyCoroute_Check(rt)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coroute_send((coroute*) rt, value);
+}
+
+static PyObject *
+coroute_next(coroute *self)
+{
+    return coroute_send(self, Py_None);
+}
+
+PyDoc_STRVAR(coroute_throw_doc,
+             "Throw an exception into the handler which yielded the last\n"
+             "value.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : any\n"
+             "    The value yielded by the handler.\n");
+
+static PyObject *
+inner_coroute_throw(coroute *self, PyObject *args)
+{
+    PyObject *handler;
+    PyObject *key;
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
+
+    CTZ_STATS_INCR(self->rt_stats, throws);
+    if (!self->rt_last) {
+        /* there is no handler waiting on a value */
+        _ctz_set_exc_from_tuple(args);
+        return NULL;
+    }
+    handler = self->rt_last;
+    key = self->rt_lastkey;
+    Py_INCREF(handler);
+    Py_INCREF(key);
+    CTZ_STATS_START(start);
+    ret = PyCoiter_API->throw(handler, args);
+    CTZ_STATS_ELAPSED(self->rt_stats, child, start);
+    CTZ_STATS_STOP(self->rt_stats, ret);
+    return coroute_finish(self, handler, key, ret);
+}
+
+static PyObject *
+coroute_throw(coroute *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coroute_throw, self, PyDict_GET_SIZE(self->rt_routes));
+    ret = inner_coroute_throw(self, args);
+    CTZ_PROBE_RETURN(coroute_throw,
+                     self,
+                     PyDict_GET_SIZE(self->rt_routes),
+                     ret);
+    return ret;
+}
+
+PyObject *
+PyCoroute_Throw(PyObject *rt, PyObject *excinfo)
+{
+    if (!PyCoroute_Check(rt)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coroute_throw((coroute*) rt, excinfo);
+}
+
+/* Build a tuple of all of the handlers. */
+static PyObject *
+coroute_handlers(coroute *self)
+{
+    PyObject *handlers;
+    PyObject *handler;
+    Py_ssize_t n;
+    Py_ssize_t m = 0;
+
+    if (!self->rt_maxsize) {
+        if (!(handlers = PyDict_Values(self->rt_routes))) {
+            return NULL;
+        }
+        Py_SETREF(handlers, PyList_AsTuple(handlers));
+        return handlers;
+    }
+    if (!(handlers = PyTuple_New(PyDict_GET_SIZE(self->rt_routes)))) {
+        return NULL;
+    }
+    for (n = 0;n < self->rt_nslots;++n) {
+        if ((handler = self->rt_slots[n].rs_handler)) {
+            Py_INCREF(handler);
+            PyTuple_SET_ITEM(handlers, m++, handler);
+        }
+    }
+    return handlers;
+}
+
+PyDoc_STRVAR(coroute_close_doc,
+             "Close the coroute."
+             "\n"
+             "This closes all of the handlers. Handlers which were created\n"
+             "by a factory are forgotten.\n");
+
+static PyObject *
+inner_coroute_close(coroute *self, PyObject *_)
+{
+    PyObject *handlers;
+    Py_ssize_t n;
+    PyObject *type = NULL;
+    PyObject *exc = NULL;
+    PyObject *tb = NULL;
+
+    CTZ_STATS_INCR(self->rt_stats, closes);
+    if (!(handlers = coroute_handlers(self))) {
+        return NULL;
+    }
+    Py_CLEAR(self->rt_last);
+    Py_CLEAR(self->rt_lastkey);
+    if (self->rt_factory) {
+        PyDict_Clear(self->rt_routes);
+        coroute_clear_slots(self);
+    }
+
+    /* Close every handler even if one fails and raise the first error. */
+    for (n = 0;n < PyTuple_GET_SIZE(handlers);++n) {
+        if (PyCoiter_API->close(PyTuple_GET_ITEM(handlers, n))) {
+            if (type) {
+                PyErr_Clear();
+            }
+            else {
+                PyErr_Fetch(&type, &exc, &tb);
+            }
+        }
+    }
+    Py_DECREF(handlers);
+    if (type) {
+        PyErr_Restore(type, exc, tb);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+coroute_close(coroute *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coroute_close, self, PyDict_GET_SIZE(self->rt_routes));
+    ret = inner_coroute_close(self, _);
+    CTZ_PROBE_RETURN(coroute_close,
+                     self,
+                     PyDict_GET_SIZE(self->rt_routes),
+                     ret);
+    return ret;
+}
+
+int
+PyCoroute_Close(PyObject *rt)
+{
+    PyObject *ret;
+
+    if (!PyCoroute_Check(rt)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = coroute_close((coroute*) rt, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCoroute_Stats(PyObject *rt, ctz_stats *out)
+{
+    if (!PyCoroute_Check(rt)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((coroute*) rt)->rt_stats), out);
+}
+
+PyDoc_STRVAR(coroute_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+coroute_stats(coroute *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->rt_stats));
+}
+
+static PyMethodDef coroute_methods[] = {
+    {"send", (PyCFunction) coroute_send, METH_O, coroute_send_doc},
+    {"throw", (PyCFunction) coroute_throw, METH_VARARGS, coroute_throw_doc},
+    {"close", (PyCFunction) coroute_close, METH_NOARGS, coroute_close_doc},
+    {"stats", (PyCFunction) coroute_stats, METH_NOARGS, coroute_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(coroute, a)
+
+static PyMemberDef coroute_members[] = {
+    {"keyfunc", T_OBJECT, OFF(rt_keyfunc), READONLY,
+     "The function used to compute the key of each value."},
+    {NULL},
+};
+
+#undef OFF
+
+static PyObject *
+coroute_children(coroute *self, void *_)
+{
+    return coroute_handlers(self);
+}
+
+static PyGetSetDef coroute_getsets[] = {
+    {"children", (getter) coroute_children, NULL,
+     "The coiter wrapped handlers.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(coroute_doc,
+             "Route each value to a handler coroutine based on its key.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "keyfunc : callable or None\n"
+             "    The function used to compute the key of each value. If this\n"
+             "    is None then the values are used as their own keys.\n"
+             "handlers : mapping or callable\n"
+             "    Either a mapping from key to handler coroutine or a factory\n"
+             "    which is called with a new key to create its handler.\n"
+             "maxsize : int, optional\n"
+             "    The maximum number of handlers to keep when ``handlers`` is\n"
+             "    a factory. The least recently used handler is closed to\n"
+             "    make room for a new one.\n"
+             "prime : bool, optional\n"
+             "    Advance handlers created by the factory once before sending\n"
+             "    them their first value.\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Sends a value into the handler for its key.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Throws an exception into the handler which yielded the\n"
+             "    last value.\n"
+             "close()\n"
+             "    Closes the coroute by closing all of the handlers.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this coroute.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "A handler created by the factory which is exhausted is\n"
+             "forgotten, the next value with its key creates a new handler.\n"
+    );
+
+PyTypeObject PyCoroute_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coroute.coroute",         /* tp_name */
+    sizeof(coroute),                    /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    (destructor) coroute_dealloc,       /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_reserved */
+    0,                                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    0,                                  /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    0,                                  /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
+    coroute_doc,                        /* tp_doc */
+    (traverseproc) coroute_traverse,    /* tp_traverse */
+    (inquiry) coroute_clear,            /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    PyObject_SelfIter,                  /* tp_iter */
+    (iternextfunc) coroute_next,        /* tp_iternext */
+    coroute_methods,                    /* tp_methods */
+    coroute_members,                    /* tp_members */
+    coroute_getsets,                    /* tp_getset */
+    0,                                  /* tp_base */
+    0,                                  /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    0,                                  /* tp_init */
+    0,                                  /* tp_alloc */
+    coroute_new,                        /* tp_new */
+};
+
+PyDoc_STRVAR(module_doc,
+             "coroute routes values to handler coroutines by key.");
+
+static struct PyModuleDef _coroute_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._coroute",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCoroute_Exported exported_symbols = {
+    PyCoroute_New,
+    PyCoroute_Send,
+    PyCoroute_Throw,
+    PyCoroute_Close,
+    PyCoroute_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__coroute(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCoroute_Type)) {
+        return NULL;
+    }
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._coroute._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_coroute_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m, "coroute", (PyObject*) &PyCoroute_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,942 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/coscheduler.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+/* How many steps ``run`` takes between checks for signals. */
+#define COSCHEDULER_SIGNAL_INTERVAL 1024
+
+/* park --------------------------------------------------------------------- */
+
+static PyObject *
+coscheduler_park_repr(PyObject *self)
+{
+    return PyUnicode_FromString("coscheduler.park");
+}
+
+PyDoc_STRVAR(coscheduler_park_doc,
+             "The sentinel a coroutine yields to park itself.");
+
+static PyTypeObject coscheduler_park_type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coscheduler.park_type",       /* tp_name */
+    sizeof(PyObject),                       /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    0,                                      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    coscheduler_park_repr,                  /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    coscheduler_park_doc,                   /* tp_doc */
+};
+
+static struct {
+    PyObject_HEAD
+} coscheduler_park = {
+    PyObject_HEAD_INIT(&coscheduler_park_type)
+};
+
+#define COSCHEDULER_PARK ((PyObject*) &coscheduler_park)
+
+/* run queue ---------------------------------------------------------------- */
+
+/* Add a task to the back of the run queue, stealing a reference to it.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. The reference is released on
+ *     failure.
+ */
+static int
+coscheduler_push(coscheduler *self, cotask *task)
+{
+    cotask **queue;
+    Py_ssize_t capacity;
+    Py_ssize_t n;
+
+    if (self->sc_size == self->sc_capacity) {
+        capacity = self->sc_capacity ? self->sc_capacity * 2 : 16;
+        if (!(queue = PyMem_New(cotask*, capacity))) {
+            Py_DECREF(task);
+            PyErr_NoMemory();
+            return -1;
+        }
+        for (n = 0;n < self->sc_size;++n) {
+            queue[n] = self->sc_queue[(self->sc_head + n) &
+                                      (self->sc_capacity - 1)];
+        }
+        PyMem_Free(self->sc_queue);
+        self->sc_queue = queue;
+        self->sc_capacity = capacity;
+        self->sc_head = 0;
+    }
+    self->sc_queue[(self->sc_head + self->sc_size++) &
+                   (self->sc_capacity - 1)] = task;
+    return 0;
+}
+
+/* Take the task at the front of the run queue.
+ *
+ * Returns
+ * -------
+ * task : cotask*
+ *     The reference that was owned by the queue.
+ */
+static cotask *
+coscheduler_pop(coscheduler *self)
+{
+    cotask *task = self->sc_queue[self->sc_head];
+
+    self->sc_head = (self->sc_head + 1) & (self->sc_capacity - 1);
+    --self->sc_size;
+    return task;
+}
+
+/* cotask ------------------------------------------------------------------- */
+
+static int
+cotask_traverse(cotask *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->tk_scheduler);
+    Py_VISIT(self->tk_coroutine);
+    Py_VISIT(self->tk_value);
+    Py_VISIT(self->tk_result);
+    Py_VISIT(self->tk_exception);
+    return 0;
+}
+
+static int
+cotask_clear(cotask *self)
+{
+    Py_CLEAR(self->tk_scheduler);
+    Py_CLEAR(self->tk_coroutine);
+    Py_CLEAR(self->tk_value);
+    Py_CLEAR(self->tk_result);
+    Py_CLEAR(self->tk_exception);
+    return 0;
+}
+
+/* Mark a task done and drop its coroutine. */
+static void
+cotask_done(cotask *self)
+{
+    coscheduler *sc = (coscheduler*) self->tk_scheduler;
+
+    if (self->tk_state == COTASK_DONE) {
+        return;
+    }
+    if (sc) {
+        if (self->tk_state == COTASK_PARKED) {
+            --sc->sc_parked;
+        }
+        --sc->sc_live;
+    }
+    self->tk_state = COTASK_DONE;
+    Py_CLEAR(self->tk_coroutine);
+    Py_CLEAR(self->tk_value);
+}
+
+static void
+cotask_dealloc(cotask *self)
+{
+    PyObject_GC_UnTrack(self);
+    cotask_done(self);
+    cotask_clear(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Finish a task whose step returned NULL.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero if the coroutine returned, non-zero with the exception still
+ *     raised if it raised.
+ */
+static int
+cotask_finish(cotask *self)
+{
+    PyObject *type;
+    PyObject *value;
+    PyObject *tb;
+
+    CTZ_STATS_INCR(((coscheduler*) self->tk_scheduler)->sc_stats, stops);
+    cotask_done(self);
+    PyErr_Fetch(&type, &value, &tb);
+    PyErr_NormalizeException(&type, &value, &tb);
+    if (tb) {
+        PyException_SetTraceback(value, tb);
+    }
+    if (!PyErr_GivenExceptionMatches(type, PyExc_StopIteration)) {
+        Py_INCREF(value);
+        Py_XSETREF(self->tk_exception, value);
+        PyErr_Restore(type, value, tb);
+        return -1;
+    }
+    Py_XSETREF(self->tk_result,
+               PyObject_GetAttrString(value, "value"));
+    Py_DECREF(type);
+    Py_DECREF(value);
+    Py_XDECREF(tb);
+    return self->tk_result ? 0 : -1;
+}
+
+PyDoc_STRVAR(cotask_wake_doc,
+             "Wake a parked task.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any, optional\n"
+             "    The value to send into the coroutine on its next step.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "woken : bool\n"
+             "    False if the task is done, True otherwise. Waking a task\n"
+             "    which is not parked makes its next ``yield park`` return\n"
+             "    immediately.\n");
+
+int
+PyCotask_Wake(PyObject *ob, PyObject *value)
+{
+    cotask *self;
+    coscheduler *sc;
+
+    if (!PyCotask_Check(ob)) {
+        PyErr_BadInternalCall();
+        return -1;
+    }
+    self = (cotask*) ob;
+    if (self->tk_state == COTASK_DONE) {
+        return 0;
+    }
+    Py_INCREF(value);
+    Py_XSETREF(self->tk_value, value);
+    if (self->tk_state != COTASK_PARKED) {
+        self->tk_woken = 1;
+        return 0;
+    }
+    sc = (coscheduler*) self->tk_scheduler;
+    self->tk_state = COTASK_RUNNABLE;
+    --sc->sc_parked;
+    Py_INCREF(self);
+    if (coscheduler_push(sc, self)) {
+        /* leave the task parked so it may be woken again */
+        self->tk_state = COTASK_PARKED;
+        ++sc->sc_parked;
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+cotask_wake(cotask *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"value", NULL};
+    PyObject *value = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|O:wake",
+                                     keywords,
+                                     &value)) {
+        return NULL;
+    }
+    if (self->tk_state == COTASK_DONE) {
+        Py_RETURN_FALSE;
+    }
+    if (PyCotask_Wake((PyObject*) self, value)) {
+        return NULL;
+    }
+    Py_RETURN_TRUE;
+}
+
+PyDoc_STRVAR(cotask_close_doc,
+             "Close the task's coroutine and remove it from the scheduler.");
+
+static PyObject *
+cotask_close(cotask *self, PyObject *_)
+{
+    PyObject *cr;
+    int err;
+
+    if (self->tk_state == COTASK_RUNNING) {
+        PyErr_SetString(PyExc_RuntimeError, "cannot close a running task");
+        return NULL;
+    }
+    if (self->tk_state == COTASK_DONE) {
+        Py_RETURN_NONE;
+    }
+    cr = self->tk_coroutine;
+    Py_INCREF(cr);
+    CTZ_PROBE_ENTRY(cotask_close, self, 1);
+    /* runnable tasks are dropped when they reach the front of the queue */
+    cotask_done(self);
+    err = PyCoiter_API->close(cr);
+    Py_DECREF(cr);
+    CTZ_PROBE_RETURN(cotask_close, self, 1, err ? NULL : Py_None);
+    if (err) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef cotask_methods[] = {
+    {"wake",
+     (PyCFunction) cotask_wake,
+     METH_VARARGS | METH_KEYWORDS,
+     cotask_wake_doc},
+    {"close",
+     (PyCFunction) cotask_close,
+     METH_NOARGS,
+     cotask_close_doc},
+    {NULL},
+};
+
+static PyObject *
+cotask_get_state(cotask *self, void *_)
+{
+    static const char *names[] = {"runnable", "running", "parked", "done"};
+
+    return PyUnicode_FromString(names[self->tk_state]);
+}
+
+static PyObject *
+cotask_get_done(cotask *self, void *_)
+{
+    return PyBool_FromLong(self->tk_state == COTASK_DONE);
+}
+
+static PyObject *
+cotask_get_steps(cotask *self, void *_)
+{
+    return PyLong_FromUnsignedLongLong(self->tk_steps);
+}
+
+static PyObject *
+cotask_get_result(cotask *self, void *_)
+{
+    PyObject *ret = self->tk_result ? self->tk_result : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyObject *
+cotask_get_exception(cotask *self, void *_)
+{
+    PyObject *ret = self->tk_exception ? self->tk_exception : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyObject *
+cotask_get_children(cotask *self, void *_)
+{
+    if (!self->tk_coroutine) {
+        return PyTuple_New(0);
+    }
+    return PyTuple_Pack(1, self->tk_coroutine);
+}
+
+static PyGetSetDef cotask_getsets[] = {
+    {"state", (getter) cotask_get_state, NULL,
+     "One of 'runnable', 'running', 'parked', or 'done'.", NULL},
+    {"done", (getter) cotask_get_done, NULL,
+     "Whether the task has finished, raised, or been closed.", NULL},
+    {"steps", (getter) cotask_get_steps, NULL,
+     "The number of times the task has been stepped.", NULL},
+    {"result", (getter) cotask_get_result, NULL,
+     "The value the coroutine returned, None until then.", NULL},
+    {"exception", (getter) cotask_get_exception, NULL,
+     "The exception the coroutine raised, None if it did not.", NULL},
+    {"children", (getter) cotask_get_children, NULL,
+     "The coroutine, empty once the task is done.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(cotask_doc,
+             "A handle to a coroutine running on a coscheduler.\n"
+             "\n"
+             "Tasks are created with ``coscheduler.spawn``.\n");
+
+PyTypeObject PyCotask_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coscheduler.cotask",          /* tp_name */
+    sizeof(cotask),                         /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) cotask_dealloc,            /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    cotask_doc,                             /* tp_doc */
+    (traverseproc) cotask_traverse,         /* tp_traverse */
+    (inquiry) cotask_clear,                 /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    cotask_methods,                         /* tp_methods */
+    0,                                      /* tp_members */
+    cotask_getsets,                         /* tp_getset */
+};
+
+/* coscheduler -------------------------------------------------------------- */
+
+PyObject *
+PyCoscheduler_New(Py_ssize_t batch)
+{
+    coscheduler *self;
+
+    if (batch <= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "coscheduler() batch must be positive");
+        return NULL;
+    }
+    if (!(self = PyObject_GC_New(coscheduler, &PyCoscheduler_Type))) {
+        return NULL;
+    }
+    self->sc_queue = NULL;
+    self->sc_head = 0;
+    self->sc_size = 0;
+    self->sc_capacity = 0;
+    self->sc_batch = batch;
+    self->sc_live = 0;
+    self->sc_parked = 0;
+    self->sc_steps = 0;
+    self->sc_running = 0;
+    CTZ_STATS_CLEAR(self->sc_stats);
+    PyObject_GC_Track(self);
+    return (PyObject*) self;
+}
+
+static PyObject *
+coscheduler_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"batch", NULL};
+    Py_ssize_t batch = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|n:coscheduler",
+                                     keywords,
+                                     &batch)) {
+        return NULL;
+    }
+    return PyCoscheduler_New(batch);
+}
+
+static int
+coscheduler_traverse(coscheduler *self, visitproc visit, void *arg)
+{
+    Py_ssize_t n;
+
+    for (n = 0;n < self->sc_size;++n) {
+        Py_VISIT(self->sc_queue[(self->sc_head + n) &
+                                (self->sc_capacity - 1)]);
+    }
+    return 0;
+}
+
+static int
+coscheduler_clear(coscheduler *self)
+{
+    while (self->sc_size) {
+        Py_DECREF(coscheduler_pop(self));
+    }
+    return 0;
+}
+
+static void
+coscheduler_dealloc(coscheduler *self)
+{
+    PyObject_GC_UnTrack(self);
+    coscheduler_clear(self);
+    PyMem_Free(self->sc_queue);
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyDoc_STRVAR(coscheduler_spawn_doc,
+             "Add a coroutine to the run queue.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "coroutine : iterable\n"
+             "    The coroutine or iterator to step. The first step sends\n"
+             "    None.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "task : cotask\n"
+             "    The handle of the task.\n");
+
+PyObject *
+PyCoscheduler_Spawn(PyObject *ob, PyObject *coroutine)
+{
+    coscheduler *self;
+    cotask *task;
+    PyObject *cr;
+
+    if (!PyCoscheduler_Check(ob)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    self = (coscheduler*) ob;
+    if (!(cr = PyCoiter_API->new(coroutine))) {
+        return NULL;
+    }
+    if (!(task = PyObject_GC_New(cotask, &PyCotask_Type))) {
+        Py_DECREF(cr);
+        return NULL;
+    }
+    Py_INCREF(self);
+    task->tk_scheduler = (PyObject*) self;
+    task->tk_coroutine = cr;
+    task->tk_value = NULL;
+    task->tk_result = NULL;
+    task->tk_exception = NULL;
+    task->tk_steps = 0;
+    task->tk_state = COTASK_RUNNABLE;
+    task->tk_woken = 0;
+    ++self->sc_live;
+    PyObject_GC_Track(task);
+
+    Py_INCREF(task);
+    if (coscheduler_push(self, task)) {
+        cotask_done(task);
+        Py_DECREF(task);
+        return NULL;
+    }
+    return (PyObject*) task;
+}
+
+/* Step a task up to ``limit`` times.
+ *
+ * Returns
+ * -------
+ * steps : Py_ssize_t
+ *     The number of steps taken, -1 with the exception raised if the task
+ *     raised.
+ */
+static Py_ssize_t
+coscheduler_step_task(coscheduler *self, cotask *task, Py_ssize_t limit)
+{
+    PyObject *value;
+    PyObject *ret;
+    Py_ssize_t steps = 0;
+    int parked;
+
+    task->tk_state = COTASK_RUNNING;
+    while (steps < limit) {
+        value = task->tk_value;
+        task->tk_value = NULL;
+        CTZ_PROBE_ENTRY(cotask_send, task, 1);
+        ret = _ctz_coiter_send_fast(task->tk_coroutine,
+                                    value ? value : Py_None);
+        CTZ_PROBE_RETURN(cotask_send, task, 1, ret);
+        Py_XDECREF(value);
+        ++task->tk_steps;
+        ++steps;
+        if (!ret) {
+            if (cotask_finish(task)) {
+                return -1;
+            }
+            return steps;
+        }
+        parked = ret == COSCHEDULER_PARK;
+        Py_DECREF(ret);
+        if (parked && task->tk_woken) {
+            /* a wake which came in since the last park lets this one
+             * return immediately
+             */
+            task->tk_woken = 0;
+            parked = 0;
+        }
+        if (parked) {
+            task->tk_state = COTASK_PARKED;
+            ++self->sc_parked;
+            return steps;
+        }
+    }
+    task->tk_state = COTASK_RUNNABLE;
+    return steps;
+}
+
+Py_ssize_t
+PyCoscheduler_Run(PyObject *ob, Py_ssize_t max_steps)
+{
+    coscheduler *self;
+    cotask *task;
+    Py_ssize_t steps = 0;
+    Py_ssize_t next_check = COSCHEDULER_SIGNAL_INTERVAL;
+    Py_ssize_t limit;
+    Py_ssize_t n;
+    CTZ_STATS_DECL(start);
+
+    if (!PyCoscheduler_Check(ob)) {
+        PyErr_BadInternalCall();
+        return -1;
+    }
+    self = (coscheduler*) ob;
+    if (self->sc_running) {
+        PyErr_SetString(PyExc_RuntimeError, "coscheduler is already running");
+        return -1;
+    }
+    self->sc_running = 1;
+    CTZ_STATS_START(start);
+
+    while (self->sc_size && (max_steps < 0 || steps < max_steps)) {
+        task = coscheduler_pop(self);
+        if (task->tk_state == COTASK_DONE) {
+            /* closed while it was waiting to run */
+            Py_DECREF(task);
+            continue;
+        }
+        limit = self->sc_batch;
+        if (max_steps >= 0 && max_steps - steps < limit) {
+            limit = max_steps - steps;
+        }
+        n = coscheduler_step_task(self, task, limit);
+        if (n < 0) {
+            Py_DECREF(task);
+            steps = -1;
+            break;
+        }
+        steps += n;
+        if (task->tk_state == COTASK_RUNNABLE) {
+            if (coscheduler_push(self, task)) {
+                steps = -1;
+                break;
+            }
+        }
+        else {
+            Py_DECREF(task);
+        }
+        if (steps >= next_check) {
+            next_check = steps + COSCHEDULER_SIGNAL_INTERVAL;
+            if (PyErr_CheckSignals()) {
+                steps = -1;
+                break;
+            }
+        }
+    }
+
+    CTZ_STATS_ELAPSED(self->sc_stats, child, start);
+    self->sc_running = 0;
+    if (steps > 0) {
+        self->sc_steps += steps;
+#if CTZ_STATS_ENABLED
+        CTZ_STATS_ADD(self->sc_stats, sends, steps);
+#endif
+    }
+    return steps;
+}
+
+PyDoc_STRVAR(coscheduler_run_doc,
+             "Step the runnable tasks round-robin.\n"
+             "\n"
+             "Each task is stepped ``batch`` times before moving on to the\n"
+             "next one. Tasks which finish are removed and tasks which yield\n"
+             "``coscheduler.park`` are parked until they are woken.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "max_steps : int, optional\n"
+             "    The most steps to take. By default this runs until no task\n"
+             "    is runnable.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "steps : int\n"
+             "    The number of steps taken.\n"
+             "\n"
+             "Raises\n"
+             "------\n"
+             "If a task raises, the task is removed, the exception is stored\n"
+             "on the task, and it is re-raised from ``run``. Calling ``run``\n"
+             "again continues with the other tasks.\n");
+
+static PyObject *
+coscheduler_run(coscheduler *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"max_steps", NULL};
+    PyObject *max_steps_ob = Py_None;
+    Py_ssize_t max_steps = -1;
+    Py_ssize_t steps;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "|O:run",
+                                     keywords,
+                                     &max_steps_ob)) {
+        return NULL;
+    }
+    if (max_steps_ob != Py_None) {
+        max_steps = PyNumber_AsSsize_t(max_steps_ob, PyExc_OverflowError);
+        if (max_steps == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (max_steps < 0) {
+            PyErr_SetString(PyExc_ValueError,
+                            "run() max_steps must be non-negative");
+            return NULL;
+        }
+    }
+    if ((steps = PyCoscheduler_Run((PyObject*) self, max_steps)) < 0) {
+        return NULL;
+    }
+    return PyLong_FromSsize_t(steps);
+}
+
+static PyObject *
+coscheduler_spawn(coscheduler *self, PyObject *coroutine)
+{
+    return PyCoscheduler_Spawn((PyObject*) self, coroutine);
+}
+
+PyDoc_STRVAR(coscheduler_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+coscheduler_stats(coscheduler *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->sc_stats));
+}
+
+static PyMethodDef coscheduler_methods[] = {
+    {"spawn",
+     (PyCFunction) coscheduler_spawn,
+     METH_O,
+     coscheduler_spawn_doc},
+    {"run",
+     (PyCFunction) coscheduler_run,
+     METH_VARARGS | METH_KEYWORDS,
+     coscheduler_run_doc},
+    {"stats",
+     (PyCFunction) coscheduler_stats,
+     METH_NOARGS,
+     coscheduler_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(coscheduler, a)
+
+static PyMemberDef coscheduler_members[] = {
+    {"batch", T_PYSSIZET, OFF(sc_batch), READONLY,
+     "The number of steps each task gets before moving on."},
+    {"parked", T_PYSSIZET, OFF(sc_parked), READONLY,
+     "The number of parked tasks."},
+    {"steps", T_ULONGLONG, OFF(sc_steps), READONLY,
+     "The number of steps ever taken."},
+    {NULL},
+};
+
+#undef OFF
+
+static PyObject *
+coscheduler_get_runnable(coscheduler *self, void *_)
+{
+    return PyLong_FromSsize_t(self->sc_live - self->sc_parked);
+}
+
+static PyGetSetDef coscheduler_getsets[] = {
+    {"runnable", (getter) coscheduler_get_runnable, NULL,
+     "The number of tasks waiting to be stepped.", NULL},
+    {NULL},
+};
+
+static Py_ssize_t
+coscheduler_len(coscheduler *self)
+{
+    return self->sc_live;
+}
+
+static PySequenceMethods coscheduler_as_sequence = {
+    (lenfunc) coscheduler_len,              /* sq_length */
+};
+
+PyDoc_STRVAR(coscheduler_doc,
+             "coscheduler(batch=1)\n"
+             "\n"
+             "A cooperative scheduler for driving many coroutines.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "batch : int, optional\n"
+             "    The number of steps each task gets before moving on to the\n"
+             "    next one. Larger batches keep a coroutine's state in cache.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "A coroutine parks itself by yielding ``coscheduler.park``; any\n"
+             "other yielded value is ignored. A parked task is run again\n"
+             "once its handle's ``wake`` is called, and the value passed to\n"
+             "``wake`` is sent in. ``len(scheduler)`` is the number of tasks\n"
+             "which are not done.\n");
+
+PyTypeObject PyCoscheduler_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coscheduler.coscheduler",     /* tp_name */
+    sizeof(coscheduler),                    /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) coscheduler_dealloc,       /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    &coscheduler_as_sequence,               /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    coscheduler_doc,                        /* tp_doc */
+    (traverseproc) coscheduler_traverse,    /* tp_traverse */
+    (inquiry) coscheduler_clear,            /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    coscheduler_methods,                    /* tp_methods */
+    coscheduler_members,                    /* tp_members */
+    coscheduler_getsets,                    /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    (newfunc) coscheduler_new,              /* tp_new */
+};
+
+static PyObject *
+PyCoscheduler_Park(void)
+{
+    return COSCHEDULER_PARK;
+}
+
+int
+PyCoscheduler_Stats(PyObject *sc, ctz_stats *out)
+{
+    if (!PyCoscheduler_Check(sc)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((coscheduler*) sc)->sc_stats), out);
+}
+
+PyDoc_STRVAR(module_doc,
+             "coscheduler steps many coroutines cooperatively.");
+
+static struct PyModuleDef _coscheduler_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._coscheduler",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCoscheduler_Exported exported_symbols = {
+    PyCoscheduler_New,
+    PyCoscheduler_Spawn,
+    PyCoscheduler_Run,
+    PyCotask_Wake,
+    PyCoscheduler_Park,
+    PyCoscheduler_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__coscheduler(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&coscheduler_park_type) ||
+        PyType_Ready(&PyCotask_Type) ||
+        PyType_Ready(&PyCoscheduler_Type)) {
+        return NULL;
+    }
+    if (PyDict_SetItemString(PyCoscheduler_Type.tp_dict,
+                             "park",
+                             COSCHEDULER_PARK)) {
+        return NULL;
+    }
+    PyType_Modified(&PyCoscheduler_Type);
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._coscheduler._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_coscheduler_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "coscheduler",
+                               (PyObject*) &PyCoscheduler_Type) ||
+        PyObject_SetAttrString(m, "cotask", (PyObject*) &PyCotask_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,363 @@
+from collections import deque
+from itertools import islice
+import multiprocessing
+import os
+import pickle
+import queue
+import signal
+import traceback
+
+
+class RemoteTraceback(Exception):
+    """The formatted traceback of an exception raised in a coshard worker.
+
+    This is set as the ``__cause__`` of the exception re-raised by the
+    coshard so the original traceback shows up in the error report.
+    """
+    def __init__(self, tb):
+        super().__init__(tb)
+        self.tb = tb
+
+    def __str__(self):
+        return '\n"""\n%s"""' % self.tb
+
+
+def _dumps(index, results, exc, tb):
+    try:
+        return pickle.dumps((index, results, exc, tb), pickle.HIGHEST_PROTOCOL)
+    except Exception as e:
+        # either the results or the exception could not be pickled; report
+        # that instead
+        return pickle.dumps(
+            (
+                index,
+                [],
+                RuntimeError(
+                    'failed to send the results of a coshard chunk back: %r'
+                    % e,
+                ),
+                tb or _format(e),
+            ),
+            pickle.HIGHEST_PROTOCOL,
+        )
+
+
+def _format(e):
+    return ''.join(traceback.format_exception(type(e), e, e.__traceback__))
+
+
+def _worker(func, tasks, results):
+    # the parent handles ctrl-c and tears the workers down
+    signal.signal(signal.SIGINT, signal.SIG_IGN)
+    while True:
+        task = tasks.get()
+        if task is None:
+            return
+        index, chunk = task
+        out = []
+        try:
+            for value in chunk:
+                out.append(func(value))
+        except BaseException as e:
+            results.put(_dumps(index, out, e, _format(e)))
+        else:
+            results.put(_dumps(index, out, None, None))
+
+
+class coshard:
+    """coshard(func, source, workers=None, chunksize=64, *, ordered=True,
+    window=None)
+
+    Map a function over an iterable in worker processes.
+
+    Parameters
+    ----------
+    func : callable
+        The function to apply to each value of ``source``. This runs in the
+        worker processes so it should not depend on state in this process.
+    source : iterable
+        The values to map ``func`` over. This is read in this process and
+        sent to the workers in chunks.
+    workers : int, optional
+        The number of worker processes. Defaults to ``os.cpu_count()``.
+    chunksize : int, optional
+        The number of values sent to a worker at a time.
+    ordered : bool, optional
+        Yield the results in the order of ``source``. When False, the results
+        of each chunk are yielded as soon as the chunk is done.
+    window : int, optional
+        The most chunks which may be read from ``source`` but not yet yielded.
+        This bounds the memory used when ``source`` is faster than ``func``.
+        Defaults to twice ``workers``.
+
+    Notes
+    -----
+    The workers are forked the first time a value is pulled, so ``func`` does
+    not need to be picklable; the values of ``source`` and the results do.
+
+    Values sent into a coshard are ignored, like a ``coiter`` around a plain
+    iterator. ``throw`` raises the exception immediately.
+
+    When ``func`` raises, the results for the values before the failing one
+    are yielded and then the exception is re-raised with the worker's
+    traceback attached as a ``RemoteTraceback`` in ``__cause__``. The coshard
+    is closed after raising.
+
+    ``close`` terminates the workers and closes ``source``.
+    """
+    def __init__(self,
+                 func,
+                 source,
+                 workers=None,
+                 chunksize=64,
+                 *,
+                 ordered=True,
+                 window=None):
+        if workers is None:
+            workers = os.cpu_count() or 1
+        if window is None:
+            window = 2 * workers
+        if workers < 1:
+            raise ValueError('coshard() workers must be positive')
+        if chunksize < 1:
+            raise ValueError('coshard() chunksize must be positive')
+        if window < 1:
+            raise ValueError('coshard() window must be positive')
+
+        self._func = func
+        self._source = source
+        self._it = iter(source)
+        self._workers = workers
+        self._chunksize = chunksize
+        self._ordered = ordered
+        self._window = window
+
+        self._procs = None
+        self._tasks = None
+        self._results = None
+        self._next_submit = 0       # the index of the next chunk to send
+        self._next_yield = 0        # the index of the next chunk to yield
+        self._inflight = 0          # chunks read but not yet yielded
+        self._done = {}             # index -> (results, exc, tb)
+        self._ready = deque()       # results of the chunk being yielded
+        self._exc = None            # the error to raise once _ready drains
+        self._exhausted = False     # source has been fully read
+        self._finished = False
+
+    @property
+    def func(self):
+        """The function mapped over the source.
+        """
+        return self._func
+
+    @property
+    def children(self):
+        """The source feeding this coshard.
+        """
+        return (self._source,)
+
+    @property
+    def workers(self):
+        """The number of worker processes.
+        """
+        return self._workers
+
+    @property
+    def chunksize(self):
+        """The number of values sent to a worker at a time.
+        """
+        return self._chunksize
+
+    @property
+    def ordered(self):
+        """Whether the results are yielded in the order of the source.
+        """
+        return self._ordered
+
+    @property
+    def window(self):
+        """The most chunks which may be in flight at once.
+        """
+        return self._window
+
+    def _start(self):
+        ctx = multiprocessing.get_context('fork')
+        self._tasks = ctx.Queue()
+        self._results = ctx.Queue()
+        self._procs = [
+            ctx.Process(
+                target=_worker,
+                args=(self._func, self._tasks, self._results),
+                daemon=True,
+            )
+            for _ in range(self._workers)
+        ]
+        for proc in self._procs:
+            proc.start()
+
+    def _submit(self):
+        while not self._exhausted and self._inflight < self._window:
+            chunk = []
+            try:
+                chunk.extend(islice(self._it, self._chunksize))
+            except BaseException as e:
+                # raise the error once the values before it are yielded
+                self._exhausted = True
+                if chunk:
+                    self._put(chunk)
+                self._done[self._next_submit] = ([], e, None)
+                self._next_submit += 1
+                self._inflight += 1
+                return
+            if not chunk:
+                self._exhausted = True
+                return
+            self._put(chunk)
+
+    def _put(self, chunk):
+        self._tasks.put((self._next_submit, chunk))
+        self._next_submit += 1
+        self._inflight += 1
+
+    def _receive(self):
+        while True:
+            try:
+                payload = self._results.get(timeout=0.1)
+            except queue.Empty:
+                for proc in self._procs:
+                    if proc.exitcode is not None:
+                        code = proc.exitcode
+                        self.close()
+                        raise RuntimeError(
+                            'a coshard worker died with exit code %d' % code,
+                        )
+                continue
+            index, results, exc, tb = pickle.loads(payload)
+            self._done[index] = (results, exc, tb)
+            return
+
+    def _take(self):
+        """Get the results of the next chunk to yield.
+
+        Returns
+        -------
+        entry : tuple or None
+            The results, exception, and remote traceback of the chunk, or None
+            once every chunk has been yielded.
+        """
+        while True:
+            self._submit()
+            if self._ordered:
+                entry = self._done.pop(self._next_yield, None)
+                if entry is not None:
+                    self._next_yield += 1
+            elif self._done:
+                entry = self._done.pop(next(iter(self._done)))
+            else:
+                entry = None
+            if entry is not None:
+                self._inflight -= 1
+                return entry
+            if not self._inflight:
+                return None
+            self._receive()
+
+    def send(self, value):
+        """Get the next result.
+
+        Parameters
+        ----------
+        value : any
+            Ignored, the source is read ahead of the sends.
+
+        Returns
+        -------
+        y : any
+            The next result of ``func``.
+        """
+        while not self._ready:
+            if self._exc is not None:
+                exc, tb = self._exc
+                self._exc = None
+                self.close()
+                if tb is not None:
+                    raise exc from RemoteTraceback(tb)
+                raise exc
+            if self._finished:
+                raise StopIteration
+            if self._procs is None:
+                self._start()
+            entry = self._take()
+            if entry is None:
+                self._shutdown()
+                raise StopIteration
+            results, exc, tb = entry
+            self._ready.extend(results)
+            if exc is not None:
+                self._exc = exc, tb
+        return self._ready.popleft()
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        return self.send(None)
+
+    def throw(self, type, value=None, tb=None):
+        """Raise an exception at this point in the pipeline.
+
+        The exception is raised immediately; it is not passed to the workers.
+        """
+        if isinstance(type, BaseException):
+            if value is not None:
+                raise TypeError(
+                    'throw either takes an exception instance or type,'
+                    ' value, tb',
+                )
+            raise type
+        if value is None:
+            value = type()
+        elif not isinstance(value, BaseException):
+            value = type(value)
+        raise value.with_traceback(tb)
+
+    def _shutdown(self):
+        """Stop the workers once every chunk has been yielded.
+        """
+        self._finished = True
+        if self._procs is None:
+            return
+        for _ in self._procs:
+            self._tasks.put(None)
+        for proc in self._procs:
+            proc.join()
+        self._tasks.close()
+        self._results.close()
+        self._procs = None
+
+    def close(self):
+        """Terminate the workers and close the source.
+        """
+        self._finished = True
+        self._ready.clear()
+        self._done.clear()
+        self._exc = None
+        if self._procs is not None:
+            for proc in self._procs:
+                proc.terminate()
+            for proc in self._procs:
+                proc.join()
+            for q in self._tasks, self._results:
+                q.cancel_join_thread()
+                q.close()
+            self._procs = None
+        close = getattr(self._source, 'close', None)
+        if close is not None:
+            close()
+
+    def __del__(self):
+        if getattr(self, '_procs', None) is not None:
+            try:
+                self.close()
+            except Exception:
+                pass
@@ -0,0 +1,1142 @@
+#include <Python.h>
+#include <sched.h>
+#include <string.h>
+
+#include "cotoolz/coshm.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/futex.h"
+#include "cotoolz/probes.h"
+
+/* The other end is in another process and may be running right now, so a
+   blocked end spins and then yields for a few rounds before sleeping on the
+   futex. */
+#define COSHM_SPIN 32
+#define COSHM_YIELD 64
+
+/* Payloads at least this large are copied into the ring without the GIL. */
+#define COSHM_NOGIL_COPY 65536
+
+#define COSHM_RECORD_SIZE(length)                                       \
+    ((uint32_t) (8 + (((length) + 7) & ~(uint32_t) 7)))
+
+/* The largest payload a ring of ``capacity`` bytes accepts. Keeping records
+   to a quarter of the ring means a record always fits while the source is
+   holding on to another one, even after wrapping. */
+#define COSHM_MAX_PAYLOAD(capacity) ((capacity) / 4 - 8)
+
+/* Back off once.
+ *
+ * Returns
+ * -------
+ * backed_off : int
+ *     non-zero if the caller should check the ring again, zero if the caller
+ *     has backed off enough and should sleep.
+ */
+static inline int
+coshm_backoff(int *spin)
+{
+    if (*spin >= COSHM_YIELD) {
+        return 0;
+    }
+    if (++*spin > COSHM_SPIN) {
+        sched_yield();
+    }
+    return 1;
+}
+
+/* Get a writable view of ``buffer`` and find the header and ring in it.
+ *
+ * Paramaters
+ * ----------
+ * buffer : any
+ *     The buffer to attach to.
+ * view : Py_buffer*
+ *     The view to fill in.
+ * header : coshm_header**
+ *     The header of the ring.
+ * ring : char**
+ *     The start of the ring.
+ * init : int
+ *     Lay out the buffer as an empty ring instead of attaching to an
+ *     existing one.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure.
+ */
+static int
+coshm_attach(PyObject *buffer,
+             Py_buffer *view,
+             coshm_header **header,
+             char **ring,
+             int init)
+{
+    coshm_header *h;
+    Py_ssize_t available;
+    uint32_t capacity;
+
+    if (PyObject_GetBuffer(buffer, view, PyBUF_WRITABLE)) {
+        return -1;
+    }
+    available = view->len - COSHM_HEADER_SIZE;
+    if (available < 64) {
+        PyErr_Format(PyExc_ValueError,
+                     "coshm buffers must be at least %d bytes",
+                     COSHM_HEADER_SIZE + 64);
+        goto error;
+    }
+    if ((uintptr_t) view->buf % 64) {
+        PyErr_SetString(PyExc_ValueError,
+                        "coshm buffers must be aligned to 64 bytes");
+        goto error;
+    }
+    h = view->buf;
+
+    if (init) {
+        for (capacity = 64;
+             capacity <= available / 2 && capacity < ((uint32_t) 1 << 31);
+             capacity <<= 1);
+        memset(h, 0, COSHM_HEADER_SIZE);
+        h->sh_capacity = capacity;
+        atomic_init(&h->sh_head, 0);
+        atomic_init(&h->sh_tail, 0);
+        atomic_init(&h->sh_consumer_waiting, 0);
+        atomic_init(&h->sh_producer_waiting, 0);
+        atomic_init(&h->sh_sink_closed, 0);
+        atomic_init(&h->sh_source_closed, 0);
+        atomic_thread_fence(memory_order_seq_cst);
+        h->sh_magic = COSHM_MAGIC;
+    }
+    else if (h->sh_magic != COSHM_MAGIC) {
+        PyErr_SetString(PyExc_ValueError,
+                        "buffer has not been laid out with coshm()");
+        goto error;
+    }
+    else if (h->sh_capacity > available ||
+             h->sh_capacity & (h->sh_capacity - 1)) {
+        PyErr_SetString(PyExc_ValueError, "buffer has a corrupt coshm header");
+        goto error;
+    }
+
+    *header = h;
+    *ring = (char*) view->buf + COSHM_HEADER_SIZE;
+    return 0;
+
+error:
+    PyBuffer_Release(view);
+    return -1;
+}
+
+/* Wake up the other end after closing one end. */
+static void
+coshm_wake_all(coshm_header *h)
+{
+    _ctz_futex_wake(&h->sh_head, 1);
+    _ctz_futex_wake(&h->sh_tail, 1);
+}
+
+/* coshm_sink --------------------------------------------------------------- */
+
+static PyObject *
+coshm_sink_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"buffer", NULL};
+    PyObject *buffer;
+    coshm_sink *self;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "O:coshm_sink",
+                                     keywords,
+                                     &buffer)) {
+        return NULL;
+    }
+    if (!(self = (coshm_sink*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    if (coshm_attach(buffer,
+                     &self->sk_buf,
+                     &self->sk_header,
+                     &self->sk_ring,
+                     0)) {
+        self->sk_header = NULL;
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject*) self;
+}
+
+/* Mark the sink closed and let go of the buffer. */
+static void
+coshm_sink_detach(coshm_sink *self)
+{
+    if (!self->sk_header) {
+        return;
+    }
+    atomic_store(&self->sk_header->sh_sink_closed, 1);
+    coshm_wake_all(self->sk_header);
+    self->sk_header = NULL;
+    self->sk_ring = NULL;
+    PyBuffer_Release(&self->sk_buf);
+}
+
+static void
+coshm_sink_dealloc(coshm_sink *self)
+{
+    coshm_sink_detach(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Copy a payload into the ring, waiting while the ring is full.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. StopIteration is raised when
+ *     either end has been closed.
+ */
+static int
+coshm_push(coshm_sink *self, Py_buffer *payload)
+{
+    coshm_header *h = self->sk_header;
+    uint32_t capacity = h->sh_capacity;
+    uint32_t length = (uint32_t) payload->len;
+    uint32_t size = COSHM_RECORD_SIZE(length);
+    uint32_t tail = atomic_load_explicit(&h->sh_tail, memory_order_relaxed);
+    uint32_t offset = tail & (capacity - 1);
+    uint32_t skip = (capacity - offset < size) ? capacity - offset : 0;
+    uint32_t head;
+    char *ring = self->sk_ring;
+    int spin = 0;
+    CTZ_STATS_DECL(start);
+
+    if (payload->len > COSHM_MAX_PAYLOAD(capacity)) {
+        PyErr_Format(PyExc_ValueError,
+                     "a payload of %zd bytes is larger than the %u byte limit"
+                     " of a coshm ring of %u bytes",
+                     payload->len,
+                     COSHM_MAX_PAYLOAD(capacity),
+                     capacity);
+        return -1;
+    }
+
+    while (1) {
+        if (atomic_load(&h->sh_sink_closed) ||
+            atomic_load(&h->sh_source_closed)) {
+            PyErr_SetNone(PyExc_StopIteration);
+            CTZ_STATS_STOP(self->sk_stats, NULL);
+            return -1;
+        }
+        head = atomic_load_explicit(&h->sh_head, memory_order_acquire);
+        if (capacity - (tail - head) >= skip + size) {
+            break;
+        }
+        if (coshm_backoff(&spin)) {
+            continue;
+        }
+
+        CTZ_STATS_START(start);
+        atomic_store(&h->sh_producer_waiting, 1);
+        if (atomic_load(&h->sh_head) == head &&
+            !atomic_load(&h->sh_source_closed)) {
+            Py_BEGIN_ALLOW_THREADS
+            _ctz_futex_wait(&h->sh_head, head, 1);
+            Py_END_ALLOW_THREADS
+        }
+        atomic_store(&h->sh_producer_waiting, 0);
+        CTZ_STATS_ELAPSED(self->sk_stats, child, start);
+        if (PyErr_CheckSignals()) {
+            return -1;
+        }
+    }
+
+    if (skip) {
+        *(uint32_t*) (ring + offset) = COSHM_WRAP;
+        tail += skip;
+        offset = 0;
+    }
+    *(uint32_t*) (ring + offset) = length;
+    if (length >= COSHM_NOGIL_COPY) {
+        Py_BEGIN_ALLOW_THREADS
+        memcpy(ring + offset + 8, payload->buf, length);
+        Py_END_ALLOW_THREADS
+    }
+    else {
+        memcpy(ring + offset + 8, payload->buf, length);
+    }
+    atomic_store(&h->sh_tail, tail + size);
+    if (atomic_load(&h->sh_consumer_waiting)) {
+        _ctz_futex_wake(&h->sh_tail, 1);
+    }
+    return 0;
+}
+
+PyDoc_STRVAR(coshm_sink_send_doc,
+             "Copy a payload into the ring.\n"
+             "\n"
+             "This waits, without the GIL, while the ring is full.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : bytes-like or None\n"
+             "    The payload to copy. This may be any contiguous buffer.\n"
+             "    None is ignored so the sink may be primed like any other\n"
+             "    coroutine. Payloads larger than ``capacity // 4 - 8`` bytes\n"
+             "    raise a ValueError.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "none : None\n"
+             "    Raises StopIteration once either end has been closed.\n");
+
+static PyObject *
+inner_coshm_sink_send(coshm_sink *self, PyObject *value)
+{
+    Py_buffer payload;
+    int err;
+
+    CTZ_STATS_INCR(self->sk_stats, sends);
+    if (!self->sk_header) {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_STOP(self->sk_stats, NULL);
+        return NULL;
+    }
+    if (value == Py_None) {
+        Py_RETURN_NONE;
+    }
+    if (PyObject_GetBuffer(value, &payload, PyBUF_SIMPLE)) {
+        return NULL;
+    }
+    err = coshm_push(self, &payload);
+    PyBuffer_Release(&payload);
+    if (err) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+coshm_sink_send(coshm_sink *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coshm_send, self, 1);
+    ret = inner_coshm_sink_send(self, value);
+    CTZ_PROBE_RETURN(coshm_send, self, 1, ret);
+    return ret;
+}
+
+static PyObject *
+coshm_sink_next(coshm_sink *self)
+{
+    return coshm_sink_send(self, Py_None);
+}
+
+PyDoc_STRVAR(coshm_throw_doc,
+             "Raise an exception at this end of the ring.\n"
+             "\n"
+             "The exception is raised immediately; it is not passed to the\n"
+             "other end.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n");
+
+static PyObject *
+coshm_sink_throw(coshm_sink *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(coshm_throw, self, 1);
+    CTZ_STATS_INCR(self->sk_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(coshm_throw, self, 1, NULL);
+    return NULL;
+}
+
+PyDoc_STRVAR(coshm_sink_close_doc,
+             "Close the sink end of the ring.\n"
+             "\n"
+             "The source yields the payloads already in the ring and then\n"
+             "raises StopIteration. This lets go of the buffer so the shared\n"
+             "memory may be closed.\n");
+
+static PyObject *
+coshm_sink_close(coshm_sink *self, PyObject *_)
+{
+    CTZ_PROBE_ENTRY(coshm_close, self, 1);
+    CTZ_STATS_INCR(self->sk_stats, closes);
+    coshm_sink_detach(self);
+    CTZ_PROBE_RETURN(coshm_close, self, 1, Py_None);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(coshm_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+coshm_sink_stats(coshm_sink *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->sk_stats));
+}
+
+static PyMethodDef coshm_sink_methods[] = {
+    {"send",
+     (PyCFunction) coshm_sink_send,
+     METH_O,
+     coshm_sink_send_doc},
+    {"throw",
+     (PyCFunction) coshm_sink_throw,
+     METH_VARARGS,
+     coshm_throw_doc},
+    {"close",
+     (PyCFunction) coshm_sink_close,
+     METH_NOARGS,
+     coshm_sink_close_doc},
+    {"stats",
+     (PyCFunction) coshm_sink_stats,
+     METH_NOARGS,
+     coshm_stats_doc},
+    {NULL},
+};
+
+static PyObject *
+coshm_get_capacity(coshm_header *h)
+{
+    if (!h) {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLong(h->sh_capacity);
+}
+
+static PyObject *
+coshm_get_size(coshm_header *h)
+{
+    if (!h) {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLong(
+        (unsigned long) (atomic_load(&h->sh_tail) -
+                         atomic_load(&h->sh_head)));
+}
+
+static PyObject *
+coshm_sink_capacity(coshm_sink *self, void *_)
+{
+    return coshm_get_capacity(self->sk_header);
+}
+
+static PyObject *
+coshm_sink_size(coshm_sink *self, void *_)
+{
+    return coshm_get_size(self->sk_header);
+}
+
+static PyGetSetDef coshm_sink_getsets[] = {
+    {"capacity", (getter) coshm_sink_capacity, NULL,
+     "The size of the ring in bytes, None once closed.", NULL},
+    {"size", (getter) coshm_sink_size, NULL,
+     "The number of bytes in use right now, None once closed.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(coshm_sink_doc,
+             "coshm_sink(buffer)\n"
+             "\n"
+             "Attach a sink to a buffer laid out with ``coshm``.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "buffer : buffer\n"
+             "    The writable buffer holding the ring, usually the ``buf``\n"
+             "    of a ``multiprocessing.shared_memory.SharedMemory``.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Only one sink may send into a ring at a time.\n");
+
+PyTypeObject PyCoshmSink_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coshm.coshm_sink",            /* tp_name */
+    sizeof(coshm_sink),                     /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) coshm_sink_dealloc,        /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    coshm_sink_doc,                         /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) coshm_sink_next,         /* tp_iternext */
+    coshm_sink_methods,                     /* tp_methods */
+    0,                                      /* tp_members */
+    coshm_sink_getsets,                     /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    (newfunc) coshm_sink_new,               /* tp_new */
+};
+
+/* coshm_source ------------------------------------------------------------- */
+
+static PyObject *
+coshm_source_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"buffer", NULL};
+    PyObject *buffer;
+    coshm_source *self;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "O:coshm_source",
+                                     keywords,
+                                     &buffer)) {
+        return NULL;
+    }
+    if (!(self = (coshm_source*) cls->tp_alloc(cls, 0))) {
+        return NULL;
+    }
+    if (coshm_attach(buffer,
+                     &self->sr_buf,
+                     &self->sr_header,
+                     &self->sr_ring,
+                     0)) {
+        self->sr_header = NULL;
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject*) self;
+}
+
+/* Release the view of the last record and give its space back to the sink.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. This fails with a BufferError
+ *     when something is still using the view.
+ */
+static int
+coshm_source_ack(coshm_source *self)
+{
+    coshm_header *h = self->sr_header;
+    PyObject *ret;
+
+    if (self->sr_view) {
+        if (!(ret = PyObject_CallMethod(self->sr_view, "release", NULL))) {
+            return -1;
+        }
+        Py_DECREF(ret);
+        Py_CLEAR(self->sr_view);
+    }
+    if (self->sr_exports) {
+        /* slices of the view are still alive */
+        PyErr_SetString(PyExc_BufferError,
+                        "a view of the last coshm payload is still in use,"
+                        " copy the payloads that need to outlive the next"
+                        " read");
+        return -1;
+    }
+    if (self->sr_pending) {
+        atomic_store(&h->sh_head, atomic_load(&h->sh_head) + self->sr_pending);
+        self->sr_pending = 0;
+        if (atomic_load(&h->sh_producer_waiting)) {
+            _ctz_futex_wake(&h->sh_head, 1);
+        }
+    }
+    return 0;
+}
+
+/* Mark the source closed and let go of the buffer. */
+static void
+coshm_source_detach(coshm_source *self)
+{
+    if (!self->sr_header) {
+        return;
+    }
+    atomic_store(&self->sr_header->sh_source_closed, 1);
+    coshm_wake_all(self->sr_header);
+    self->sr_header = NULL;
+    self->sr_ring = NULL;
+    PyBuffer_Release(&self->sr_buf);
+}
+
+static int
+coshm_source_traverse(coshm_source *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->sr_view);
+    return 0;
+}
+
+static int
+coshm_source_clear(coshm_source *self)
+{
+    Py_CLEAR(self->sr_view);
+    return 0;
+}
+
+static void
+coshm_source_dealloc(coshm_source *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_CLEAR(self->sr_view);
+    coshm_source_detach(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Wait for the next record.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. StopIteration is raised when
+ *     the ring is empty and the sink has been closed.
+ */
+static int
+coshm_pop(coshm_source *self)
+{
+    coshm_header *h = self->sr_header;
+    uint32_t capacity = h->sh_capacity;
+    uint32_t head = atomic_load_explicit(&h->sh_head, memory_order_relaxed);
+    uint32_t offset;
+    uint32_t length;
+    int spin = 0;
+    CTZ_STATS_DECL(start);
+
+    while (1) {
+        if (atomic_load_explicit(&h->sh_tail, memory_order_acquire) == head) {
+            if (atomic_load(&h->sh_sink_closed)) {
+                /* the sink may have written right before closing */
+                if (atomic_load(&h->sh_tail) != head) {
+                    continue;
+                }
+                PyErr_SetNone(PyExc_StopIteration);
+                CTZ_STATS_STOP(self->sr_stats, NULL);
+                return -1;
+            }
+            if (coshm_backoff(&spin)) {
+                continue;
+            }
+
+            CTZ_STATS_START(start);
+            atomic_store(&h->sh_consumer_waiting, 1);
+            if (atomic_load(&h->sh_tail) == head &&
+                !atomic_load(&h->sh_sink_closed)) {
+                Py_BEGIN_ALLOW_THREADS
+                _ctz_futex_wait(&h->sh_tail, head, 1);
+                Py_END_ALLOW_THREADS
+            }
+            atomic_store(&h->sh_consumer_waiting, 0);
+            CTZ_STATS_ELAPSED(self->sr_stats, child, start);
+            if (PyErr_CheckSignals()) {
+                return -1;
+            }
+            continue;
+        }
+
+        offset = head & (capacity - 1);
+        length = *(uint32_t*) (self->sr_ring + offset);
+        if (length != COSHM_WRAP) {
+            break;
+        }
+        head += capacity - offset;
+        atomic_store(&h->sh_head, head);
+    }
+
+    if (length > COSHM_MAX_PAYLOAD(capacity)) {
+        PyErr_SetString(PyExc_RuntimeError, "coshm ring is corrupt");
+        return -1;
+    }
+    self->sr_record = self->sr_ring + offset + 8;
+    self->sr_length = length;
+    self->sr_pending = COSHM_RECORD_SIZE(length);
+    return 0;
+}
+
+PyDoc_STRVAR(coshm_source_send_doc,
+             "Read the next payload out of the ring.\n"
+             "\n"
+             "This acknowledges the last payload and then waits, without the\n"
+             "GIL, while the ring is empty.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    Ignored, like a ``coiter`` around a plain iterator.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "view : memoryview\n"
+             "    A read only view of the payload in the ring. The view is\n"
+             "    released when the next payload is read, copy it with\n"
+             "    ``bytes(view)`` to keep it. Raises StopIteration once the\n"
+             "    sink has been closed and the ring is empty.\n");
+
+static PyObject *
+inner_coshm_source_send(coshm_source *self, PyObject *value)
+{
+    PyObject *view;
+
+    CTZ_STATS_INCR(self->sr_stats, sends);
+    if (!self->sr_header) {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_STOP(self->sr_stats, NULL);
+        return NULL;
+    }
+    if (coshm_source_ack(self) || coshm_pop(self)) {
+        return NULL;
+    }
+    self->sr_exporting = 1;
+    view = PyMemoryView_FromObject((PyObject*) self);
+    self->sr_exporting = 0;
+    if (!view) {
+        return NULL;
+    }
+    Py_INCREF(view);
+    self->sr_view = view;
+    return view;
+}
+
+static PyObject *
+coshm_source_send(coshm_source *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coshm_source_send, self, 1);
+    ret = inner_coshm_source_send(self, value);
+    CTZ_PROBE_RETURN(coshm_source_send, self, 1, ret);
+    return ret;
+}
+
+static PyObject *
+coshm_source_next(coshm_source *self)
+{
+    return coshm_source_send(self, Py_None);
+}
+
+static PyObject *
+coshm_source_throw(coshm_source *self, PyObject *args)
+{
+    CTZ_PROBE_ENTRY(coshm_source_throw, self, 1);
+    CTZ_STATS_INCR(self->sr_stats, throws);
+    _ctz_set_exc_from_tuple(args);
+    CTZ_PROBE_RETURN(coshm_source_throw, self, 1, NULL);
+    return NULL;
+}
+
+PyDoc_STRVAR(coshm_source_close_doc,
+             "Close the source end of the ring.\n"
+             "\n"
+             "This releases the view of the last payload. Further sends\n"
+             "into the sink raise StopIteration. This lets go of the buffer\n"
+             "so the shared memory may be closed.\n");
+
+static PyObject *
+inner_coshm_source_close(coshm_source *self)
+{
+    CTZ_STATS_INCR(self->sr_stats, closes);
+    if (!self->sr_header) {
+        Py_RETURN_NONE;
+    }
+    if (coshm_source_ack(self)) {
+        return NULL;
+    }
+    coshm_source_detach(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+coshm_source_close(coshm_source *self, PyObject *_)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(coshm_source_close, self, 1);
+    ret = inner_coshm_source_close(self);
+    CTZ_PROBE_RETURN(coshm_source_close, self, 1, ret);
+    return ret;
+}
+
+static PyObject *
+coshm_source_stats(coshm_source *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->sr_stats));
+}
+
+static PyMethodDef coshm_source_methods[] = {
+    {"send",
+     (PyCFunction) coshm_source_send,
+     METH_O,
+     coshm_source_send_doc},
+    {"throw",
+     (PyCFunction) coshm_source_throw,
+     METH_VARARGS,
+     coshm_throw_doc},
+    {"close",
+     (PyCFunction) coshm_source_close,
+     METH_NOARGS,
+     coshm_source_close_doc},
+    {"stats",
+     (PyCFunction) coshm_source_stats,
+     METH_NOARGS,
+     coshm_stats_doc},
+    {NULL},
+};
+
+static PyObject *
+coshm_source_capacity(coshm_source *self, void *_)
+{
+    return coshm_get_capacity(self->sr_header);
+}
+
+static PyObject *
+coshm_source_size(coshm_source *self, void *_)
+{
+    return coshm_get_size(self->sr_header);
+}
+
+static PyGetSetDef coshm_source_getsets[] = {
+    {"capacity", (getter) coshm_source_capacity, NULL,
+     "The size of the ring in bytes, None once closed.", NULL},
+    {"size", (getter) coshm_source_size, NULL,
+     "The number of bytes in use right now, None once closed.", NULL},
+    {NULL},
+};
+
+/* The memoryviews yielded by the source are views of the source itself so
+   that they keep the buffer mapped for as long as they are alive. */
+static int
+coshm_source_getbuffer(coshm_source *self, Py_buffer *view, int flags)
+{
+    if (!self->sr_exporting) {
+        PyErr_SetString(PyExc_BufferError,
+                        "coshm_source only exports the payloads it yields");
+        view->obj = NULL;
+        return -1;
+    }
+    if (PyBuffer_FillInfo(view,
+                          (PyObject*) self,
+                          self->sr_record,
+                          self->sr_length,
+                          1,
+                          flags)) {
+        return -1;
+    }
+    ++self->sr_exports;
+    return 0;
+}
+
+static void
+coshm_source_releasebuffer(coshm_source *self, Py_buffer *view)
+{
+    --self->sr_exports;
+}
+
+static PyBufferProcs coshm_source_as_buffer = {
+    (getbufferproc) coshm_source_getbuffer,
+    (releasebufferproc) coshm_source_releasebuffer,
+};
+
+PyDoc_STRVAR(coshm_source_doc,
+             "coshm_source(buffer)\n"
+             "\n"
+             "Attach a source to a buffer laid out with ``coshm``.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "buffer : buffer\n"
+             "    The writable buffer holding the ring, usually the ``buf``\n"
+             "    of a ``multiprocessing.shared_memory.SharedMemory``.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Only one source may read from a ring at a time.\n");
+
+PyTypeObject PyCoshmSource_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._coshm.coshm_source",          /* tp_name */
+    sizeof(coshm_source),                   /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) coshm_source_dealloc,      /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    &coshm_source_as_buffer,                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_HAVE_GC,                     /* tp_flags */
+    coshm_source_doc,                       /* tp_doc */
+    (traverseproc) coshm_source_traverse,   /* tp_traverse */
+    (inquiry) coshm_source_clear,           /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    PyObject_SelfIter,                      /* tp_iter */
+    (iternextfunc) coshm_source_next,       /* tp_iternext */
+    coshm_source_methods,                   /* tp_methods */
+    0,                                      /* tp_members */
+    coshm_source_getsets,                   /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    (newfunc) coshm_source_new,             /* tp_new */
+};
+
+/* coshm -------------------------------------------------------------------- */
+
+PyObject *
+PyCoshm_New(PyObject *buffer)
+{
+    coshm_sink *sink;
+    coshm_source *source;
+    PyObject *ret;
+
+    if (!(sink = PyObject_New(coshm_sink, &PyCoshmSink_Type))) {
+        return NULL;
+    }
+    CTZ_STATS_CLEAR(sink->sk_stats);
+    if (coshm_attach(buffer,
+                     &sink->sk_buf,
+                     &sink->sk_header,
+                     &sink->sk_ring,
+                     1)) {
+        sink->sk_header = NULL;
+        Py_DECREF(sink);
+        return NULL;
+    }
+    ret = PyObject_CallFunctionObjArgs((PyObject*) &PyCoshmSource_Type,
+                                       buffer,
+                                       NULL);
+    if (!(source = (coshm_source*) ret)) {
+        Py_DECREF(sink);
+        return NULL;
+    }
+    ret = PyTuple_Pack(2, (PyObject*) sink, (PyObject*) source);
+    Py_DECREF(sink);
+    Py_DECREF(source);
+    return ret;
+}
+
+PyObject *
+PyCoshm_Send(PyObject *sink, PyObject *value)
+{
+    if (!PyCoshmSink_Check(sink)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coshm_sink_send((coshm_sink*) sink, value);
+}
+
+PyObject *
+PyCoshm_Recv(PyObject *source)
+{
+    if (!PyCoshmSource_Check(source)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return coshm_source_send((coshm_source*) source, Py_None);
+}
+
+PyObject *
+PyCoshm_Throw(PyObject *end, PyObject *excinfo)
+{
+    if (PyCoshmSink_Check(end)) {
+        return coshm_sink_throw((coshm_sink*) end, excinfo);
+    }
+    if (PyCoshmSource_Check(end)) {
+        return coshm_source_throw((coshm_source*) end, excinfo);
+    }
+    PyErr_BadInternalCall();
+    return NULL;
+}
+
+int
+PyCoshm_Close(PyObject *end)
+{
+    PyObject *ret;
+
+    if (PyCoshmSink_Check(end)) {
+        ret = coshm_sink_close((coshm_sink*) end, NULL);
+    }
+    else if (PyCoshmSource_Check(end)) {
+        ret = coshm_source_close((coshm_source*) end, NULL);
+    }
+    else {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCoshm_Stats(PyObject *end, ctz_stats *out)
+{
+    if (PyCoshmSink_Check(end)) {
+        return _ctz_stats_copy(CTZ_STATS_PTR(((coshm_sink*) end)->sk_stats), out);
+    }
+    if (PyCoshmSource_Check(end)) {
+        return _ctz_stats_copy(CTZ_STATS_PTR(((coshm_source*) end)->sr_stats), out);
+    }
+    PyErr_BadInternalCall();
+    return 1;
+}
+
+PyDoc_STRVAR(coshm_doc,
+             "coshm(buffer)\n"
+             "\n"
+             "Lay out a shared buffer as a ring for passing bytes between\n"
+             "processes.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "buffer : buffer\n"
+             "    The writable buffer to hold the ring, usually the ``buf``\n"
+             "    of a ``multiprocessing.shared_memory.SharedMemory`` or an\n"
+             "    ``mmap``. The first 256 bytes hold the header and the ring\n"
+             "    is the largest power of two that fits in the rest. Each\n"
+             "    payload may be at most a quarter of the ring.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "sink : coshm_sink\n"
+             "    A coroutine which copies the payloads sent into it into the\n"
+             "    ring.\n"
+             "source : coshm_source\n"
+             "    An iterator of memoryviews of the payloads in the ring.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "Other processes attach to the ring with\n"
+             "``coshm_sink(buffer)`` or ``coshm_source(buffer)``. Payloads\n"
+             "are copied into the ring once and are never pickled. Each\n"
+             "memoryview yielded by the source points into the ring and is\n"
+             "released when the next payload is read, which gives the space\n"
+             "back to the sink.\n"
+             "\n"
+             "The ring is a lock-free single-producer/single-consumer ring\n"
+             "buffer. An end only sleeps, on a process shared futex and\n"
+             "without the GIL, when the ring is full or empty.\n");
+
+static PyObject *
+coshm(PyObject *_, PyObject *buffer)
+{
+    return PyCoshm_New(buffer);
+}
+
+static PyMethodDef module_methods[] = {
+    {"coshm",
+     (PyCFunction) coshm,
+     METH_O,
+     coshm_doc},
+    {NULL},
+};
+
+PyDoc_STRVAR(module_doc,
+             "coshm passes bytes between processes through shared memory.");
+
+static struct PyModuleDef _coshm_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._coshm",
+    module_doc,
+    -1,
+    module_methods,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCoshm_Exported exported_symbols = {
+    PyCoshm_New,
+    PyCoshm_Send,
+    PyCoshm_Recv,
+    PyCoshm_Throw,
+    PyCoshm_Close,
+    PyCoshm_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__coshm(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCoshmSink_Type) ||
+        PyType_Ready(&PyCoshmSource_Type)) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._coshm._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_coshm_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+#ifdef Py_GIL_DISABLED
+    PyUnstable_Module_SetGIL(m, Py_MOD_GIL_NOT_USED);
+#endif
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m,
+                               "coshm_sink",
+                               (PyObject*) &PyCoshmSink_Type) ||
+        PyObject_SetAttrString(m,
+                               "coshm_source",
+                               (PyObject*) &PyCoshmSource_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
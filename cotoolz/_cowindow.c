@@ -0,0 +1,709 @@
+#include <Python.h>
+#include <structmember.h>
+
+#include "cotoolz/coiter.h"
+#include "cotoolz/cowindow.h"
+#include "cotoolz/probes.h"
+
+PyCoiter_Exported *PyCoiter_API;
+
+/* cowindow_view ------------------------------------------------------------ */
+
+static PyObject *
+cowindow_view_new(cowindow *window)
+{
+    cowindow_view *self;
+
+    if (!(self = PyObject_GC_New(cowindow_view, &PyCowindowView_Type))) {
+        return NULL;
+    }
+    Py_INCREF(window);
+    self->wv_window = window;
+    self->wv_generation = window->wd_generation;
+    PyObject_GC_Track(self);
+    return (PyObject*) self;
+}
+
+static int
+cowindow_view_traverse(cowindow_view *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->wv_window);
+    return 0;
+}
+
+static int
+cowindow_view_clear(cowindow_view *self)
+{
+    Py_CLEAR(self->wv_window);
+    return 0;
+}
+
+static void
+cowindow_view_dealloc(cowindow_view *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->wv_window);
+    PyObject_GC_Del(self);
+}
+
+/* Get the window of a view, raising if it has moved on.
+ *
+ * Returns
+ * -------
+ * window : cowindow
+ *     A borrowed reference to the window or NULL if the view is stale.
+ */
+static cowindow *
+cowindow_view_window(cowindow_view *self)
+{
+    cowindow *window = self->wv_window;
+
+    if (!window || window->wd_generation != self->wv_generation) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cowindow view is no longer valid, the cowindow has"
+                        " moved on; copy the view with tuple() to keep it");
+        return NULL;
+    }
+    return window;
+}
+
+static Py_ssize_t
+cowindow_view_length(cowindow_view *self)
+{
+    cowindow *window;
+
+    if (!(window = cowindow_view_window(self))) {
+        return -1;
+    }
+    return window->wd_count;
+}
+
+static PyObject *
+cowindow_view_item(cowindow_view *self, Py_ssize_t n)
+{
+    cowindow *window;
+    PyObject *item;
+
+    if (!(window = cowindow_view_window(self))) {
+        return NULL;
+    }
+    if (n < 0 || n >= window->wd_count) {
+        PyErr_SetString(PyExc_IndexError, "cowindow view index out of range");
+        return NULL;
+    }
+    item = window->wd_ring[(window->wd_start + n) % window->wd_size];
+    Py_INCREF(item);
+    return item;
+}
+
+static PySequenceMethods cowindow_view_as_sequence = {
+    (lenfunc) cowindow_view_length,     /* sq_length */
+    0,                                  /* sq_concat */
+    0,                                  /* sq_repeat */
+    (ssizeargfunc) cowindow_view_item,  /* sq_item */
+};
+
+PyDoc_STRVAR(cowindow_view_doc,
+             "A read-only view of the current window of a cowindow.\n"
+             "\n"
+             "The view does not copy the values out of the window. It is\n"
+             "only valid until the cowindow takes its next step, use\n"
+             "``tuple(view)`` to keep the values.\n");
+
+PyTypeObject PyCowindowView_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._cowindow.cowindow_view",      /* tp_name */
+    sizeof(cowindow_view),                  /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor) cowindow_view_dealloc,     /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_reserved */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    &cowindow_view_as_sequence,             /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_HAVE_GC |
+    Py_TPFLAGS_SEQUENCE,                    /* tp_flags */
+    cowindow_view_doc,                      /* tp_doc */
+    (traverseproc) cowindow_view_traverse,  /* tp_traverse */
+    (inquiry) cowindow_view_clear,          /* tp_clear */
+};
+
+/* cowindow ----------------------------------------------------------------- */
+
+static PyObject *
+inner_cowindow_new(PyTypeObject *cls,
+                   PyObject *cr,
+                   Py_ssize_t size,
+                   Py_ssize_t step,
+                   int view)
+{
+    cowindow *self;
+
+    if (size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "cowindow() size must be positive");
+        return NULL;
+    }
+    if (step <= 0) {
+        PyErr_SetString(PyExc_ValueError, "cowindow() step must be positive");
+        return NULL;
+    }
+    if (!(cr = PyCoiter_API->new(cr))) {
+        if (PyErr_ExceptionMatches(PyExc_TypeError))
+            PyErr_SetString(PyExc_TypeError,
+                            "cowindow argument #1 must support iteration");
+        return NULL;
+    }
+
+    if (!(self = (cowindow*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(cr);
+        return NULL;
+    }
+    self->wd_cr = cr;
+    self->wd_size = size;
+    self->wd_step = step;
+    self->wd_start = 0;
+    self->wd_count = 0;
+    self->wd_view = view;
+    self->wd_res = NULL;
+    self->wd_generation = 0;
+    if (!(self->wd_ring = PyMem_New(PyObject*, size))) {
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return (PyObject*) self;
+}
+
+PyObject *
+PyCowindow_New(PyObject *cr, Py_ssize_t size, Py_ssize_t step)
+{
+    return inner_cowindow_new(&PyCowindow_Type, cr, size, step, 0);
+}
+
+static PyObject *
+cowindow_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"coroutine", "size", "step", "view", NULL};
+    PyObject *cr;
+    Py_ssize_t size;
+    Py_ssize_t step = 1;
+    int view = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args,
+                                     kwargs,
+                                     "On|n$p:cowindow",
+                                     keywords,
+                                     &cr,
+                                     &size,
+                                     &step,
+                                     &view)) {
+        return NULL;
+    }
+    return inner_cowindow_new(cls, cr, size, step, view);
+}
+
+static int
+cowindow_traverse(cowindow *self, visitproc visit, void *arg)
+{
+    Py_ssize_t n;
+
+    Py_VISIT(self->wd_cr);
+    Py_VISIT(self->wd_res);
+    for (n = 0;n < self->wd_count;++n) {
+        Py_VISIT(self->wd_ring[(self->wd_start + n) % self->wd_size]);
+    }
+    return 0;
+}
+
+static void
+cowindow_clear_ring(cowindow *self)
+{
+    Py_ssize_t count = self->wd_count;
+
+    self->wd_count = 0;
+    ++self->wd_generation;
+    while (count--) {
+        Py_DECREF(self->wd_ring[(self->wd_start + count) % self->wd_size]);
+    }
+    self->wd_start = 0;
+}
+
+static int
+cowindow_clear(cowindow *self)
+{
+    Py_CLEAR(self->wd_cr);
+    Py_CLEAR(self->wd_res);
+    if (self->wd_ring) {
+        cowindow_clear_ring(self);
+    }
+    return 0;
+}
+
+static void
+cowindow_dealloc(cowindow *self)
+{
+    PyObject_GC_UnTrack(self);
+    cowindow_clear(self);
+    PyMem_Free(self->wd_ring);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Add a value to the ring, dropping the oldest value if the ring is full.
+ *
+ * Paramaters
+ * ----------
+ * item : any
+ *     A new reference to the value, this is stolen.
+ */
+static inline void
+cowindow_push(cowindow *self, PyObject *item)
+{
+    PyObject *old;
+
+    if (self->wd_count < self->wd_size) {
+        self->wd_ring[(self->wd_start + self->wd_count) % self->wd_size] = item;
+        ++self->wd_count;
+        return;
+    }
+    old = self->wd_ring[self->wd_start];
+    self->wd_ring[self->wd_start] = item;
+    if (++self->wd_start == self->wd_size) {
+        self->wd_start = 0;
+    }
+    Py_DECREF(old);
+}
+
+/* Build the result for the current window.
+ *
+ * The last result is reused if nothing else holds a reference to it, like
+ * ``cozip`` does with ``cz_res``.
+ *
+ * Returns
+ * -------
+ * window : tuple or cowindow_view
+ *     A new reference to the window.
+ */
+static PyObject *
+cowindow_result(cowindow *self)
+{
+    PyObject *res = self->wd_res;
+    PyObject *item;
+    PyObject *old;
+    Py_ssize_t size = self->wd_size;
+    Py_ssize_t start = self->wd_start;
+    Py_ssize_t n;
+
+    if (self->wd_view) {
+        if (res && Py_REFCNT(res) == 1) {
+            ((cowindow_view*) res)->wv_generation = self->wd_generation;
+        }
+        else if ((res = cowindow_view_new(self))) {
+            Py_XSETREF(self->wd_res, res);
+        }
+        else {
+            return NULL;
+        }
+        Py_INCREF(res);
+        return res;
+    }
+
+    if (res && Py_REFCNT(res) == 1) {
+        for (n = 0;n < size;++n) {
+            item = self->wd_ring[(start + n) % size];
+            Py_INCREF(item);
+            old = PyTuple_GET_ITEM(res, n);
+            PyTuple_SET_ITEM(res, n, item);
+            Py_DECREF(old);
+        }
+    }
+    else {
+        if (!(res = PyTuple_New(size))) {
+            return NULL;
+        }
+        for (n = 0;n < size;++n) {
+            item = self->wd_ring[(start + n) % size];
+            Py_INCREF(item);
+            PyTuple_SET_ITEM(res, n, item);
+        }
+        Py_XSETREF(self->wd_res, res);
+    }
+    Py_INCREF(res);
+    return res;
+}
+
+/* Pull enough values out of the inner coroutine to produce the next window.
+ *
+ * The first pull sends ``value`` or throws ``excinfo``, the rest of the
+ * pulls in the step send None.
+ */
+static PyObject *
+cowindow_step(cowindow *self, PyObject *value, PyObject *excinfo)
+{
+    Py_ssize_t pulls;
+    PyObject *item;
+    CTZ_STATS_DECL(start);
+
+    if (self->wd_count < self->wd_size) {
+        pulls = self->wd_size - self->wd_count;
+    }
+    else {
+        pulls = self->wd_step;
+    }
+
+    CTZ_STATS_START(start);
+    while (pulls--) {
+        if (excinfo) {
+            item = PyCoiter_API->throw(self->wd_cr, excinfo);
+            excinfo = NULL;
+        }
+        else {
+            item = PyCoiter_API->send(self->wd_cr, value);
+        }
+        value = Py_None;
+        if (!item) {
+            CTZ_STATS_ELAPSED(self->wd_stats, child, start);
+            CTZ_STATS_STOP(self->wd_stats, item);
+            return NULL;
+        }
+        /* the ring is about to change, so views of it are stale even if a
+         * later pull raises
+         */
+        ++self->wd_generation;
+        cowindow_push(self, item);
+    }
+    CTZ_STATS_ELAPSED(self->wd_stats, child, start);
+    return cowindow_result(self);
+}
+
+PyDoc_STRVAR(cowindow_send_doc,
+             "Send a value into the inner coroutine and yield the next\n"
+             "window.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "value : any\n"
+             "    The value to send into the inner coroutine. If more than\n"
+             "    one value is needed for the next window the rest of the\n"
+             "    values are pulled with None.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "window : tuple or cowindow_view\n"
+             "    The next window.\n");
+
+static PyObject *
+cowindow_send(cowindow *self, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cowindow_send, self, 1);
+    CTZ_STATS_INCR(self->wd_stats, sends);
+    ret = cowindow_step(self, value, NULL);
+    CTZ_PROBE_RETURN(cowindow_send, self, 1, ret);
+    return ret;
+}
+
+PyObject *
+PyCowindow_Send(PyObject *wd, PyObject *value)
+{
+    if (!PyCowindow_Check(wd)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cowindow_send((cowindow*) wd, value);
+}
+
+static PyObject *
+cowindow_next(cowindow *self)
+{
+    return cowindow_send(self, Py_None);
+}
+
+PyDoc_STRVAR(cowindow_throw_doc,
+             "Throw an exception into the inner coroutine and yield the next\n"
+             "window.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "exc : Exception\n"
+             "    The exception to raise.\n"
+             "-OR-\n"
+             "type : Exception class\n"
+             "    The type of exception to raise.\n"
+             "arg : any\n"
+             "    The argument to ``type``.\n"
+             "tb : traceback\n"
+             "    The traceback to raise the exception with.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "window : tuple or cowindow_view\n"
+             "    The next window.\n");
+
+static PyObject *
+cowindow_throw(cowindow *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cowindow_throw, self, 1);
+    CTZ_STATS_INCR(self->wd_stats, throws);
+    ret = cowindow_step(self, NULL, args);
+    CTZ_PROBE_RETURN(cowindow_throw, self, 1, ret);
+    return ret;
+}
+
+PyObject *
+PyCowindow_Throw(PyObject *wd, PyObject *excinfo)
+{
+    if (!PyCowindow_Check(wd)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    return cowindow_throw((cowindow*) wd, excinfo);
+}
+
+PyDoc_STRVAR(cowindow_close_doc,
+             "Close the cowindow."
+             "\n"
+             "This closes the inner coroutine and drops the window.\n");
+
+static PyObject *
+cowindow_close(cowindow *self, PyObject *_)
+{
+    PyObject *ret = NULL;
+
+    CTZ_PROBE_ENTRY(cowindow_close, self, 1);
+    CTZ_STATS_INCR(self->wd_stats, closes);
+    cowindow_clear_ring(self);
+    if (!PyCoiter_API->close(self->wd_cr)) {
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+    CTZ_PROBE_RETURN(cowindow_close, self, 1, ret);
+    return ret;
+}
+
+int
+PyCowindow_Close(PyObject *wd)
+{
+    PyObject *ret;
+
+    if (!PyCowindow_Check(wd)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    ret = cowindow_close((cowindow*) wd, NULL);
+    Py_XDECREF(ret);
+    return !ret;
+}
+
+int
+PyCowindow_Stats(PyObject *wd, ctz_stats *out)
+{
+    if (!PyCowindow_Check(wd)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((cowindow*) wd)->wd_stats), out);
+}
+
+PyDoc_STRVAR(cowindow_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+cowindow_stats(cowindow *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->wd_stats));
+}
+
+static PyMethodDef cowindow_methods[] = {
+    {"send", (PyCFunction) cowindow_send, METH_O, cowindow_send_doc},
+    {"throw", (PyCFunction) cowindow_throw, METH_VARARGS, cowindow_throw_doc},
+    {"close", (PyCFunction) cowindow_close, METH_NOARGS, cowindow_close_doc},
+    {"stats", (PyCFunction) cowindow_stats, METH_NOARGS, cowindow_stats_doc},
+    {NULL},
+};
+
+#define OFF(a) offsetof(cowindow, a)
+
+static PyMemberDef cowindow_members[] = {
+    {"size", T_PYSSIZET, OFF(wd_size), READONLY,
+     "The number of values in each window."},
+    {"step", T_PYSSIZET, OFF(wd_step), READONLY,
+     "The number of values to advance between windows."},
+    {NULL},
+};
+
+#undef OFF
+
+static PyObject *
+cowindow_children(cowindow *self, void *_)
+{
+    return PyTuple_Pack(1, self->wd_cr);
+}
+
+static PyGetSetDef cowindow_getsets[] = {
+    {"children", (getter) cowindow_children, NULL,
+     "The coiter wrapped inner coroutine.", NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(cowindow_doc,
+             "Sliding windows over a coroutine.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "coroutine : coroutine\n"
+             "    The coroutine to window.\n"
+             "size : int\n"
+             "    The number of values in each window.\n"
+             "step : int, optional\n"
+             "    The number of values to advance between windows.\n"
+             "view : bool, optional\n"
+             "    Yield a read-only view of the ring buffer instead of a\n"
+             "    tuple. The view does not copy the values but is only valid\n"
+             "    until the next step.\n"
+             "\n"
+             "Methods\n"
+             "-------\n"
+             "send(value)\n"
+             "    Sends a value into the inner coroutine and yields the next\n"
+             "    window.\n"
+             "throw(exc) or throw(type, arg, traceback)\n"
+             "    Throws an exception into the inner coroutine and yields\n"
+             "    the next window.\n"
+             "close()\n"
+             "    Closes the inner coroutine.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this cowindow.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "The first window is yielded once ``size`` values have been\n"
+             "pulled. Values which do not fill a complete step at the end of\n"
+             "the inner coroutine are dropped. The yielded tuple is reused\n"
+             "for the next window if the caller has dropped it.\n"
+    );
+
+PyTypeObject PyCowindow_Type = {
+    PyVarObject_HEAD_INIT(&PyType_Type, 0)
+    "cotoolz._cowindow.cowindow",       /* tp_name */
+    sizeof(cowindow),                   /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    (destructor) cowindow_dealloc,      /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_reserved */
+    0,                                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    0,                                  /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    0,                                  /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
+    cowindow_doc,                       /* tp_doc */
+    (traverseproc) cowindow_traverse,   /* tp_traverse */
+    (inquiry) cowindow_clear,           /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    PyObject_SelfIter,                  /* tp_iter */
+    (iternextfunc) cowindow_next,       /* tp_iternext */
+    cowindow_methods,                   /* tp_methods */
+    cowindow_members,                   /* tp_members */
+    cowindow_getsets,                   /* tp_getset */
+    0,                                  /* tp_base */
+    0,                                  /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    0,                                  /* tp_init */
+    0,                                  /* tp_alloc */
+    cowindow_new,                       /* tp_new */
+};
+
+PyDoc_STRVAR(module_doc,
+             "cowindow yields sliding windows over a coroutine.");
+
+static struct PyModuleDef _cowindow_module = {
+    PyModuleDef_HEAD_INIT,
+    "cotoolz._cowindow",
+    module_doc,
+    -1,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static PyCowindow_Exported exported_symbols = {
+    PyCowindow_New,
+    PyCowindow_Send,
+    PyCowindow_Throw,
+    PyCowindow_Close,
+    PyCowindow_Stats,
+};
+
+PyMODINIT_FUNC
+PyInit__cowindow(void)
+{
+    PyObject *m;
+    PyObject *symbols;
+    int err;
+
+    if (PyType_Ready(&PyCowindow_Type) || PyType_Ready(&PyCowindowView_Type)) {
+        return NULL;
+    }
+
+    if (!(PyCoiter_API =
+          PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
+        return NULL;
+    }
+
+    if (!(symbols = PyCapsule_New(&exported_symbols,
+                                  "cotoolz._cowindow._exported_symbols",
+                                  NULL))) {
+        return NULL;
+    }
+
+    if (!(m = PyModule_Create(&_cowindow_module))) {
+        Py_DECREF(symbols);
+        return NULL;
+    }
+
+    err = PyObject_SetAttrString(m, "_exported_symbols", symbols);
+    Py_DECREF(symbols);
+    if (err) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (PyObject_SetAttrString(m, "cowindow", (PyObject*) &PyCowindow_Type) ||
+        PyObject_SetAttrString(m,
+                               "cowindow_view",
+                               (PyObject*) &PyCowindowView_Type)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -1,53 +1,369 @@
 #include <stdarg.h>
 
 #include <Python.h>
+#include <structmember.h>
 
 #include "cotoolz/coiter.h"
 #include "cotoolz/cozip.h"
+#include "cotoolz/emptycoroutine.h"
+#include "cotoolz/fuse.h"
+#include "cotoolz/probes.h"
 
 PyCoiter_Exported *PyCoiter_API;
 
+/* The struct sequence types built for ``names``, keyed by the tuple of field
+ * names.
+ */
+static PyObject *record_types = NULL;
+
+/* Weak references to every live record type. The field names of a struct
+ * sequence type point into the strings of its names, so the callback of each
+ * reference owns the tuple of names and drops it when the type dies.
+ */
+static PyObject *record_names = NULL;
+
+/* The most record types kept in ``record_types``. The oldest is dropped to
+ * make room for a new one.
+ */
+#define COZIP_RECORD_TYPES_MAX 256
+
+#define COZIP_FINISHED(cz, n) ((cz)->cz_finished[(n) >> 3] & (1 << ((n) & 7)))
+#define COZIP_SET_FINISHED(cz, n) ((cz)->cz_finished[(n) >> 3] |= 1 << ((n) & 7))
+#define COZIP_FINISHED_SIZE(tuplesize) (((tuplesize) + 7) / 8 + 1)
+
+/* Mark the ``n``th coroutine as exhausted if it raised StopIteration. In
+ * 'shortest' mode this finishes the whole cozip.
+ */
+static void
+cozip_child_stopped(cozip *cz, Py_ssize_t n)
+{
+    if (!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        return;
+    }
+    if (!COZIP_FINISHED(cz, n)) {
+        COZIP_SET_FINISHED(cz, n);
+        ++cz->cz_nfinished;
+    }
+    cz->cz_done = 1;
+}
+
+/* Whether ``cozip(child)`` can be built by fusing ``child`` into the new
+ * cozip.
+ *
+ * With a single coroutine every mode behaves the same, so only the inner
+ * cozip's mode matters. Only exact, non-empty cozips in 'shortest' mode are
+ * fused, and only when ``child`` is a temporary on the caller's stack.
+ * Cozips which build records are never fused.
+ */
+static int
+cozip_can_fuse(PyObject *child)
+{
+    return (PyCozip_CheckExact(child) &&
+            ((cozip*) child)->cz_mode == COZIP_SHORTEST &&
+            !((cozip*) child)->cz_type &&
+            ((cozip*) child)->cz_tuplesize &&
+            _ctz_is_unique_temporary(child));
+}
+
+/* Allocate a result filled with None, a struct sequence of ``type`` if it is
+ * not NULL, otherwise a tuple.
+ */
 static PyObject *
-inner_cozip_new(PyTypeObject *cls, Py_ssize_t tuplesize, PyObject *args)
+cozip_new_res(PyTypeObject *type, Py_ssize_t tuplesize)
 {
-    cozip *cz;
+    PyObject *res;
     Py_ssize_t n;
-    PyObject *crs;
+
+    if (!(res = type ? PyStructSequence_New(type) : PyTuple_New(tuplesize))) {
+        return NULL;
+    }
+    for (n = 0;n < tuplesize;++n) {
+        Py_INCREF(Py_None);
+        PyTuple_SET_ITEM(res, n, Py_None);
+    }
+    /* PyStructSequence_New leaves the row untracked for the caller to fill
+       in, which would hide cycles through the rows from the GC. */
+    if (type && !PyObject_GC_IsTracked(res)) {
+        PyObject_GC_Track(res);
+    }
+    return res;
+}
+
+/* Allocate an empty result. The items of a tuple are left NULL, a struct
+ * sequence is filled with None so it can be tracked by the GC.
+ */
+static inline PyObject *
+cozip_alloc_res(PyTypeObject *type, Py_ssize_t tuplesize)
+{
+    return type ? cozip_new_res(type, tuplesize) : PyTuple_New(tuplesize);
+}
+
+/* Build ``cozip(inner)`` as a single node which zips ``inner``'s coroutines
+ * directly and wraps the result in a 1-tuple.
+ */
+static PyObject *
+cozip_fuse(PyTypeObject *cls, cozip *inner)
+{
+    cozip *cz;
     PyObject *res;
-    PyObject *cr;
+    unsigned char *finished;
+
+    if (!(finished = PyMem_Malloc(COZIP_FINISHED_SIZE(inner->cz_tuplesize)))) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memcpy(finished,
+           inner->cz_finished,
+           COZIP_FINISHED_SIZE(inner->cz_tuplesize));
+    if (!(res = cozip_new_res(NULL, inner->cz_tuplesize))) {
+        PyMem_Free(finished);
+        return NULL;
+    }
+    if (!(cz = (cozip*) cls->tp_alloc(cls, 0))) {
+        Py_DECREF(res);
+        PyMem_Free(finished);
+        return NULL;
+    }
+    Py_INCREF(inner->cz_crs);
+    cz->cz_crs = inner->cz_crs;
+    cz->cz_tuplesize = inner->cz_tuplesize;
+    cz->cz_res = res;
+    cz->cz_mode = COZIP_SHORTEST;
+    Py_INCREF(inner->cz_fillvalue);
+    cz->cz_fillvalue = inner->cz_fillvalue;
+    cz->cz_finished = finished;
+    cz->cz_nfinished = inner->cz_nfinished;
+    cz->cz_nest = inner->cz_nest + 1;
+    cz->cz_wrap = NULL;
+    cz->cz_done = inner->cz_done;
+    cz->cz_closed = inner->cz_closed;
+    cz->cz_type = NULL;
+    return (PyObject*) cz;
+}
 
-    if (!(crs = PyTuple_New(tuplesize))) {
+PyDoc_STRVAR(record_doc,
+             "A row of a cozip which was given ``names``.");
+
+/* Drop the oldest record type from ``record_types`` if it is full.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure.
+ */
+static int
+cozip_record_types_evict(void)
+{
+    Py_ssize_t pos = 0;
+    PyObject *oldest;
+    PyObject *type;
+    int err;
+
+    if (PyDict_GET_SIZE(record_types) < COZIP_RECORD_TYPES_MAX ||
+        !PyDict_Next(record_types, &pos, &oldest, &type)) {
+        return 0;
+    }
+    Py_INCREF(oldest);
+    err = PyDict_DelItem(record_types, oldest);
+    Py_DECREF(oldest);
+    return err;
+}
+
+/* The weakref callback of a record type, ``self`` is the tuple of names. */
+static PyObject *
+cozip_record_type_dead(PyObject *self, PyObject *ref)
+{
+    if (PySet_Discard(record_names, ref) < 0) {
         return NULL;
     }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef record_type_dead_def = {
+    "record_type_dead",
+    (PyCFunction) cozip_record_type_dead,
+    METH_O,
+    NULL,
+};
+
+/* Keep ``key`` alive for as long as ``type`` is.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure.
+ */
+static int
+cozip_record_type_keep(PyTypeObject *type, PyObject *key)
+{
+    PyObject *callback;
+    PyObject *ref;
+    int err;
+
+    if (!(callback = PyCFunction_New(&record_type_dead_def, key))) {
+        return -1;
+    }
+    ref = PyWeakref_NewRef((PyObject*) type, callback);
+    Py_DECREF(callback);
+    if (!ref) {
+        return -1;
+    }
+    err = PySet_Add(record_names, ref);
+    Py_DECREF(ref);
+    return err;
+}
+
+/* Get the struct sequence type with one field for each of ``names``,
+ * building it the first time these names are used.
+ */
+static PyTypeObject *
+cozip_record_type(PyObject *names, Py_ssize_t tuplesize)
+{
+    PyObject *key;
+    PyObject *unique = NULL;
+    PyObject *name;
+    PyTypeObject *type = NULL;
+    PyStructSequence_Field *fields = NULL;
+    PyStructSequence_Desc desc;
+    Py_ssize_t n;
+
+    if (!(key = PySequence_Tuple(names))) {
+        return NULL;
+    }
+    if (PyTuple_GET_SIZE(key) != tuplesize) {
+        PyErr_Format(PyExc_ValueError,
+                     "cozip() got %zd names for %zd coroutines",
+                     PyTuple_GET_SIZE(key),
+                     tuplesize);
+        goto done;
+    }
+    if ((type = (PyTypeObject*) PyDict_GetItemWithError(record_types, key))) {
+        Py_INCREF(type);
+        goto done;
+    }
+    if (PyErr_Occurred()) {
+        goto done;
+    }
+
     for (n = 0;n < tuplesize;++n) {
-        if (!(cr = PyCoiter_API->new(PyTuple_GET_ITEM(args, n)))) {
-            if (PyErr_ExceptionMatches(PyExc_TypeError))
-                PyErr_Format(PyExc_TypeError,
-                             "cozip argument #%zd must support iteration",
-                             n + 1);
-            Py_DECREF(crs);
-            return NULL;
+        name = PyTuple_GET_ITEM(key, n);
+        if (!PyUnicode_Check(name) || !PyUnicode_IsIdentifier(name)) {
+            PyErr_Format(PyExc_ValueError,
+                         "cozip() names must be identifiers, got %R",
+                         name);
+            goto done;
         }
-        PyTuple_SET_ITEM(crs, n, cr);
+        if (PyUnicode_READ_CHAR(name, 0) == '_') {
+            PyErr_Format(PyExc_ValueError,
+                         "cozip() names cannot start with an underscore,"
+                         " got %R",
+                         name);
+            goto done;
+        }
+        if (!PyUnicode_CompareWithASCIIString(name, "n_fields") ||
+            !PyUnicode_CompareWithASCIIString(name, "n_sequence_fields") ||
+            !PyUnicode_CompareWithASCIIString(name, "n_unnamed_fields")) {
+            PyErr_Format(PyExc_ValueError,
+                         "cozip() name %R is reserved by struct sequences",
+                         name);
+            goto done;
+        }
+    }
+    if (!(unique = PySet_New(key))) {
+        goto done;
+    }
+    if (PySet_GET_SIZE(unique) != tuplesize) {
+        PyErr_Format(PyExc_ValueError,
+                     "cozip() names must be unique, got %R",
+                     key);
+        goto done;
     }
 
-    if (!(res = PyTuple_New(tuplesize))) {
+    if (!(fields = PyMem_New(PyStructSequence_Field, tuplesize + 1))) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (n = 0;n < tuplesize;++n) {
+        if (!(fields[n].name = PyUnicode_AsUTF8(PyTuple_GET_ITEM(key, n)))) {
+            goto done;
+        }
+        fields[n].doc = NULL;
+    }
+    fields[tuplesize].name = NULL;
+    fields[tuplesize].doc = NULL;
+    desc.name = "cotoolz._cozip.record";
+    desc.doc = record_doc;
+    desc.fields = fields;
+    desc.n_in_sequence = (int) tuplesize;
+
+    if (!(type = PyStructSequence_NewType(&desc))) {
+        goto done;
+    }
+    if (cozip_record_type_keep(type, key) ||
+        PyObject_SetAttrString((PyObject*) type, "_fields", key) ||
+        cozip_record_types_evict() ||
+        PyDict_SetItem(record_types, key, (PyObject*) type)) {
+        Py_CLEAR(type);
+    }
+done:
+    PyMem_Free(fields);
+    Py_XDECREF(unique);
+    Py_DECREF(key);
+    return type;
+}
+
+static PyObject *
+inner_cozip_new(PyTypeObject *cls,
+                Py_ssize_t tuplesize,
+                PyObject *args,
+                cozip_mode mode,
+                PyObject *fillvalue,
+                PyTypeObject *type)
+{
+    cozip *cz;
+    PyObject *crs;
+    PyObject *res;
+    unsigned char *finished;
+
+    if (!(crs = _ctz_coiter_wrap_all(PyCoiter_API,
+                                     "cozip",
+                                     &PyTuple_GET_ITEM(args, 0),
+                                     tuplesize))) {
+        return NULL;
+    }
+
+    if (!(res = cozip_new_res(type, tuplesize))) {
         Py_DECREF(crs);
         return NULL;
     }
-    for (n = 0;n < tuplesize;++n) {
-        Py_INCREF(Py_None);
-        PyTuple_SET_ITEM(res, n, Py_None);
+
+    if (!(finished = PyMem_Calloc(COZIP_FINISHED_SIZE(tuplesize), 1))) {
+        Py_DECREF(crs);
+        Py_DECREF(res);
+        PyErr_NoMemory();
+        return NULL;
     }
 
     if (!(cz = (cozip*) cls->tp_alloc(cls, 0))) {
         Py_DECREF(crs);
         Py_DECREF(res);
+        PyMem_Free(finished);
         return NULL;
     }
     cz->cz_crs = crs;
     cz->cz_tuplesize = tuplesize;
     cz->cz_res = res;
+    cz->cz_mode = mode;
+    Py_INCREF(fillvalue);
+    cz->cz_fillvalue = fillvalue;
+    cz->cz_finished = finished;
+    cz->cz_nfinished = 0;
+    cz->cz_nest = 0;
+    cz->cz_wrap = NULL;
+    cz->cz_done = !tuplesize;
+    cz->cz_closed = 0;
+    Py_XINCREF(type);
+    cz->cz_type = type;
 
     return (PyObject*) cz;
 }
@@ -72,19 +388,388 @@ PyCozip_New(Py_ssize_t n, ...)
     }
     va_end(vcrs);
 
-    item = inner_cozip_new(&PyCozip_Type, n, crs);
+    item = inner_cozip_new(&PyCozip_Type,
+                           n,
+                           crs,
+                           COZIP_SHORTEST,
+                           Py_None,
+                           NULL);
     Py_DECREF(crs);
     return item;
 }
 
+PyObject *
+PyCozip_FromArray(PyObject **crs, Py_ssize_t n)
+{
+    PyObject *args;
+    PyObject *ret;
+    Py_ssize_t m;
+
+    if (!(args = PyTuple_New(n))) {
+        return NULL;
+    }
+    for (m = 0;m < n;++m) {
+        Py_INCREF(crs[m]);
+        PyTuple_SET_ITEM(args, m, crs[m]);
+    }
+
+    ret = inner_cozip_new(&PyCozip_Type,
+                          n,
+                          args,
+                          COZIP_SHORTEST,
+                          Py_None,
+                          NULL);
+    Py_DECREF(args);
+    return ret;
+}
+
 static PyObject *
 cozip_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
 {
-    if (cls == &PyCozip_Type && !_PyArg_NoKeywords("cozip()", kwargs)) {
-        return NULL;
+    static char *keywords[] = {"mode", "fillvalue", "names", NULL};
+    static PyObject *empty = NULL;
+    PyObject *modestr = NULL;
+    PyObject *fillvalue = Py_None;
+    PyObject *names = Py_None;
+    PyTypeObject *type = NULL;
+    PyObject *ret;
+    cozip_mode mode = COZIP_SHORTEST;
+
+    if (kwargs && cls == &PyCozip_Type) {
+        if (!empty && !(empty = PyTuple_New(0))) {
+            return NULL;
+        }
+        if (!PyArg_ParseTupleAndKeywords(empty,
+                                         kwargs,
+                                         "|$UOO:cozip",
+                                         keywords,
+                                         &modestr,
+                                         &fillvalue,
+                                         &names)) {
+            return NULL;
+        }
+    }
+    if (modestr) {
+        if (!PyUnicode_CompareWithASCIIString(modestr, "shortest")) {
+            mode = COZIP_SHORTEST;
+        }
+        else if (!PyUnicode_CompareWithASCIIString(modestr, "longest")) {
+            mode = COZIP_LONGEST;
+        }
+        else if (!PyUnicode_CompareWithASCIIString(modestr, "strict")) {
+            mode = COZIP_STRICT;
+        }
+        else {
+            PyErr_Format(PyExc_ValueError,
+                         "cozip() mode must be one of 'shortest', 'longest',"
+                         " or 'strict', got %R",
+                         modestr);
+            return NULL;
+        }
     }
     assert(PyTuple_Check(args));
-    return inner_cozip_new(cls, PyTuple_GET_SIZE(args), args);
+    if (names != Py_None &&
+        !(type = cozip_record_type(names, PyTuple_GET_SIZE(args)))) {
+        return NULL;
+    }
+    ret = inner_cozip_new(cls,
+                          PyTuple_GET_SIZE(args),
+                          args,
+                          mode,
+                          fillvalue,
+                          type);
+    Py_XDECREF(type);
+    return ret;
+}
+
+/* Called for ``cozip(...)`` from Python. This is the only place nested cozips
+ * are fused, see fuse.h.
+ */
+static PyObject *
+cozip_vectorcall(PyTypeObject *cls,
+                 PyObject *const *args,
+                 size_t nargsf,
+                 PyObject *kwnames)
+{
+    if (!kwnames &&
+        PyVectorcall_NARGS(nargsf) == 1 &&
+        cozip_can_fuse(args[0])) {
+        return cozip_fuse(cls, (cozip*) args[0]);
+    }
+    return _ctz_vectorcall_new(cls, args, nargsf, kwnames);
+}
+
+static int
+cozip_traverse(cozip *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->cz_crs);
+    Py_VISIT(self->cz_res);
+    Py_VISIT(self->cz_wrap);
+    Py_VISIT(self->cz_fillvalue);
+    Py_VISIT(self->cz_type);
+    return 0;
+}
+
+static int
+cozip_clear(cozip *self)
+{
+    Py_CLEAR(self->cz_crs);
+    Py_CLEAR(self->cz_res);
+    Py_CLEAR(self->cz_wrap);
+    Py_CLEAR(self->cz_fillvalue);
+    Py_CLEAR(self->cz_type);
+    return 0;
+}
+
+static void
+cozip_dealloc(cozip *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->cz_crs);
+    Py_XDECREF(self->cz_res);
+    Py_XDECREF(self->cz_wrap);
+    Py_XDECREF(self->cz_fillvalue);
+    Py_XDECREF(self->cz_type);
+    PyMem_Free(self->cz_finished);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* Step the ``n``th coroutine of a cozip with ``meth(values[n])`` if
+ * ``values`` is given, otherwise with ``meth(*args)``.
+ */
+static PyObject *
+cozip_step_child(cozip *cz,
+                 Py_ssize_t n,
+                 PyObject *methstr,
+                 PyObject *args,
+                 PyObject **values)
+{
+    PyObject *cr = PyTuple_GET_ITEM(cz->cz_crs, n);
+    PyObject *meth;
+    PyObject *item;
+
+    if (values) {
+        return PyObject_CallMethodOneArg(cr, methstr, values[n]);
+    }
+    if (!(meth = PyObject_GetAttr(cr, methstr))) {
+        return NULL;
+    }
+    item = PyObject_Call(meth, args, NULL);
+    Py_DECREF(meth);
+    return item;
+}
+
+/* Set the ValueError for a strict cozip whose ``n``th coroutine raised a
+ * StopIteration. If ``n`` is 0 the rest of the coroutines are stepped as in
+ * ``cozip_step_child`` to see if they are also exhausted, in which case
+ * StopIteration is raised instead.
+ */
+static void
+cozip_strict_error(cozip *cz,
+                   Py_ssize_t n,
+                   PyObject *methstr,
+                   PyObject *args,
+                   PyObject **values)
+{
+    Py_ssize_t m;
+    PyObject *item;
+
+    if (n) {
+        PyErr_Format(PyExc_ValueError,
+                     "cozip() argument %zd is shorter than argument%s%zd",
+                     n + 1,
+                     n == 1 ? " " : "s 1-",
+                     n);
+        return;
+    }
+
+    for (m = 1;m < cz->cz_tuplesize;++m) {
+        if ((item = cozip_step_child(cz, m, methstr, args, values))) {
+            Py_DECREF(item);
+            PyErr_Format(PyExc_ValueError,
+                         "cozip() argument %zd is longer than argument%s%zd",
+                         m + 1,
+                         m == 1 ? " " : "s 1-",
+                         m);
+            return;
+        }
+        if (!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+            return;
+        }
+        PyErr_Clear();
+    }
+    PyErr_SetNone(PyExc_StopIteration);
+}
+
+/* Step a cozip in longest or strict mode by stepping each of the coroutines
+ * which are not yet exhausted as in ``cozip_step_child``.
+ */
+static PyObject *
+cozip_step_mode(cozip *cz,
+                PyObject *methstr,
+                PyObject *args,
+                PyObject **values)
+{
+    Py_ssize_t n;
+    Py_ssize_t tuplesize = cz->cz_tuplesize;
+    PyObject *res = cz->cz_res;
+    PyObject *item;
+    PyObject *old;
+
+    if (Py_REFCNT(res) == 1) {
+        Py_INCREF(res);
+    }
+    else if (!(res = cozip_alloc_res(cz->cz_type, tuplesize))) {
+        return NULL;
+    }
+
+    for (n = 0;n < tuplesize;++n) {
+        if (cz->cz_mode == COZIP_LONGEST && COZIP_FINISHED(cz, n)) {
+            Py_INCREF(cz->cz_fillvalue);
+            item = cz->cz_fillvalue;
+        }
+        else {
+            if (!(item = cozip_step_child(cz, n, methstr, args, values))) {
+                if (!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+                    goto error;
+                }
+                if (cz->cz_mode == COZIP_STRICT) {
+                    cozip_child_stopped(cz, n);
+                    PyErr_Clear();
+                    cozip_strict_error(cz, n, methstr, args, values);
+                    goto error;
+                }
+                PyErr_Clear();
+                COZIP_SET_FINISHED(cz, n);
+                ++cz->cz_nfinished;
+                Py_INCREF(cz->cz_fillvalue);
+                item = cz->cz_fillvalue;
+            }
+        }
+        old = PyTuple_GET_ITEM(res, n);
+        PyTuple_SET_ITEM(res, n, item);
+        Py_XDECREF(old);
+    }
+
+    if (cz->cz_nfinished == tuplesize) {
+        cz->cz_done = 1;
+        PyErr_SetNone(PyExc_StopIteration);
+        goto error;
+    }
+    return res;
+
+error:
+    Py_DECREF(res);
+    return NULL;
+}
+
+/* The innermost 1-tuple of the last result of a fused cozip, or NULL if
+ * anything other than the cozip refers to any of the 1-tuples.
+ */
+static PyObject *
+cozip_unique_wrap(cozip *cz)
+{
+    PyObject *wrapped = cz->cz_wrap;
+    Py_ssize_t n;
+
+    if (!wrapped) {
+        return NULL;
+    }
+    for (n = 1;;++n) {
+        if (Py_REFCNT(wrapped) != 1) {
+            return NULL;
+        }
+        if (n == cz->cz_nest) {
+            return wrapped;
+        }
+        wrapped = PyTuple_GET_ITEM(wrapped, 0);
+    }
+}
+
+/* Let go of the zipped values held by the last result of a fused cozip if
+ * that result is no longer used, so ``cz_res`` can be reused as well.
+ */
+static void
+cozip_release_wrap(cozip *cz)
+{
+    PyObject *inner;
+    PyObject *old;
+
+    if ((inner = cozip_unique_wrap(cz))) {
+        old = PyTuple_GET_ITEM(inner, 0);
+        Py_INCREF(Py_None);
+        PyTuple_SET_ITEM(inner, 0, Py_None);
+        Py_DECREF(old);
+    }
+}
+
+/* Wrap the zipped values of a fused cozip in one 1-tuple for each cozip fused
+ * around it. The 1-tuples of the last result are reused when nothing else
+ * refers to them. This steals the reference to ``res``.
+ */
+static PyObject *
+cozip_nest(cozip *cz, PyObject *res)
+{
+    PyObject *wrapped;
+    PyObject *old;
+    Py_ssize_t n;
+
+    if ((wrapped = cozip_unique_wrap(cz))) {
+        old = PyTuple_GET_ITEM(wrapped, 0);
+        PyTuple_SET_ITEM(wrapped, 0, res);
+        Py_DECREF(old);
+        Py_INCREF(cz->cz_wrap);
+        return cz->cz_wrap;
+    }
+    for (n = 0;n < cz->cz_nest;++n) {
+        if (!(wrapped = PyTuple_New(1))) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(wrapped, 0, res);
+        res = wrapped;
+    }
+    Py_INCREF(res);
+    Py_XSETREF(cz->cz_wrap, res);
+    return res;
+}
+
+/* Step a cozip in shortest mode by stepping each of the coroutines as in
+ * ``cozip_step_child``. The result tuple is reused when nothing else refers to
+ * it.
+ */
+static PyObject *
+cozip_step_shortest(cozip *cz,
+                    PyObject *methstr,
+                    PyObject *args,
+                    PyObject **values)
+{
+    Py_ssize_t n;
+    PyObject *res;
+    PyObject *item;
+    PyObject *old;
+
+    if (cz->cz_nest) {
+        cozip_release_wrap(cz);
+    }
+    if (Py_REFCNT(cz->cz_res) == 1) {
+        res = cz->cz_res;
+        Py_INCREF(res);
+    }
+    else if (!(res = cozip_alloc_res(cz->cz_type, cz->cz_tuplesize))) {
+        return NULL;
+    }
+    for (n = 0;n < cz->cz_tuplesize;++n) {
+        if (!(item = cozip_step_child(cz, n, methstr, args, values))) {
+            cozip_child_stopped(cz, n);
+            Py_DECREF(res);
+            return NULL;
+        }
+        old = PyTuple_GET_ITEM(res, n);
+        PyTuple_SET_ITEM(res, n, item);
+        Py_XDECREF(old);
+    }
+    return cz->cz_nest ? cozip_nest(cz, res) : res;
 }
 
 PyDoc_STRVAR(cozip_send_doc,
@@ -102,21 +787,42 @@ PyDoc_STRVAR(cozip_send_doc,
              "    coroutine(s).\n");
 
 static PyObject *
-cozip_send(cozip *cz, PyObject *value)
+inner_cozip_send(cozip *cz, PyObject *value)
 {
     PyObject *sendstr;
     PyObject *send;
     Py_ssize_t n;
     PyObject *item;
+    PyObject *old;
     Py_ssize_t tuplesize = cz->cz_tuplesize;
     PyObject *crs = cz->cz_crs;
-    PyObject *res = cz->cz_res;
+    PyObject *res = NULL;
     PyObject *argtuple;
     PyObject *ret = NULL;
+    CTZ_STATS_DECL(start);
 
-    if (!tuplesize) {
+    CTZ_STATS_INCR(cz->cz_stats, sends);
+    if (cz->cz_done) {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_INCR(cz->cz_stats, stops);
         return NULL;
     }
+    if (cz->cz_mode != COZIP_SHORTEST) {
+        if (!(sendstr = PyUnicode_FromString("send"))) {
+            return NULL;
+        }
+        if (!(argtuple = PyTuple_Pack(1, value))) {
+            Py_DECREF(sendstr);
+            return NULL;
+        }
+        CTZ_STATS_START(start);
+        ret = cozip_step_mode(cz, sendstr, argtuple, NULL);
+        CTZ_STATS_ELAPSED(cz->cz_stats, child, start);
+        CTZ_STATS_STOP(cz->cz_stats, ret);
+        Py_DECREF(sendstr);
+        Py_DECREF(argtuple);
+        return ret;
+    }
     if (!(sendstr = PyUnicode_FromString("send"))) {
         return NULL;
     }
@@ -125,48 +831,58 @@ cozip_send(cozip *cz, PyObject *value)
         return NULL;
     }
 
-    if (Py_REFCNT(res) == 1) {
+    CTZ_STATS_START(start);
+    if (cz->cz_nest) {
+        cozip_release_wrap(cz);
+    }
+    if (Py_REFCNT(cz->cz_res) == 1) {
+        res = cz->cz_res;
         Py_INCREF(res);
-        for (n = 0;n < cz->cz_tuplesize;++n) {
-            if (!(send = PyObject_GetAttr(PyTuple_GET_ITEM(crs, n), sendstr))) {
-                goto error;
-            }
-            if (Py_REFCNT(argtuple) != 1) {
-                Py_DECREF(argtuple);
-                if (!(argtuple = PyTuple_Pack(1, value))) {
-                    goto error;
-                }
-            }
-            if (!(item = PyObject_Call(send, argtuple, NULL))) {
-                goto error;
-            }
-            Py_DECREF(PyTuple_GET_ITEM(res, n));
-            PyTuple_SET_ITEM(res, n, item);
-        }
     }
-    else {
-        res = PyTuple_New(tuplesize);
-        for (n = 0;n < cz->cz_tuplesize;++n) {
-            if (!(send = PyObject_GetAttr(PyTuple_GET_ITEM(crs, n), sendstr))) {
-                goto error;
-            }
-            if (Py_REFCNT(argtuple) != 1) {
-                Py_DECREF(argtuple);
-                if (!(argtuple = PyTuple_Pack(1, value))) {
-                    goto error;
-                }
-            }
-            if (!(item = PyObject_Call(send, argtuple, NULL))) {
+    else if (!(res = cozip_alloc_res(cz->cz_type, tuplesize))) {
+        goto error;
+    }
+    for (n = 0;n < tuplesize;++n) {
+        if (!(send = PyObject_GetAttr(PyTuple_GET_ITEM(crs, n), sendstr))) {
+            goto error;
+        }
+        if (Py_REFCNT(argtuple) != 1) {
+            Py_DECREF(argtuple);
+            if (!(argtuple = PyTuple_Pack(1, value))) {
+                Py_DECREF(send);
                 goto error;
             }
-            PyTuple_SET_ITEM(res, n, item);
         }
+        item = PyObject_Call(send, argtuple, NULL);
+        Py_DECREF(send);
+        if (!item) {
+            cozip_child_stopped(cz, n);
+            goto error;
+        }
+        old = PyTuple_GET_ITEM(res, n);
+        PyTuple_SET_ITEM(res, n, item);
+        Py_XDECREF(old);
     }
 
-    ret = res;
+    ret = cz->cz_nest ? cozip_nest(cz, res) : res;
+    res = NULL;
 error:
+    CTZ_STATS_ELAPSED(cz->cz_stats, child, start);
+    CTZ_STATS_STOP(cz->cz_stats, ret);
+    Py_XDECREF(res);
     Py_DECREF(sendstr);
-    Py_DECREF(argtuple);
+    Py_XDECREF(argtuple);
+    return ret;
+}
+
+static PyObject *
+cozip_send(cozip *cz, PyObject *value)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cozip_send, cz, cz->cz_tuplesize);
+    ret = inner_cozip_send(cz, value);
+    CTZ_PROBE_RETURN(cozip_send, cz, cz->cz_tuplesize, ret);
     return ret;
 }
 
@@ -183,9 +899,96 @@ PyCozip_Send(PyObject *cz, PyObject *value)
 static PyObject *
 cozip_next(cozip *cz)
 {
+    if (cz->cz_done) {
+        return NULL;
+    }
     return cozip_send(cz, Py_None);
 }
 
+PyDoc_STRVAR(cozip_send_each_doc,
+             "Send a different value into each of the inner coroutines.\n"
+             "\n"
+             "Paramaters\n"
+             "----------\n"
+             "values : sequence\n"
+             "    One value for each inner coroutine, in the order the\n"
+             "    coroutines were passed.\n"
+             "\n"
+             "Returns\n"
+             "-------\n"
+             "y : tuple\n"
+             "    The zipped results of sending the values into the inner\n"
+             "    coroutines.\n");
+
+static PyObject *
+inner_cozip_send_each(cozip *cz, PyObject **values, Py_ssize_t n)
+{
+    PyObject *sendstr;
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
+
+    if (n != cz->cz_tuplesize) {
+        PyErr_Format(PyExc_ValueError,
+                     "cozip.send_each() expected %zd values, got %zd",
+                     cz->cz_tuplesize,
+                     n);
+        return NULL;
+    }
+    CTZ_STATS_INCR(cz->cz_stats, sends);
+    if (cz->cz_done) {
+        PyErr_SetNone(PyExc_StopIteration);
+        CTZ_STATS_INCR(cz->cz_stats, stops);
+        return NULL;
+    }
+    if (!(sendstr = PyUnicode_FromString("send"))) {
+        return NULL;
+    }
+    CTZ_STATS_START(start);
+    if (cz->cz_mode != COZIP_SHORTEST) {
+        ret = cozip_step_mode(cz, sendstr, NULL, values);
+    }
+    else {
+        ret = cozip_step_shortest(cz, sendstr, NULL, values);
+    }
+    CTZ_STATS_ELAPSED(cz->cz_stats, child, start);
+    CTZ_STATS_STOP(cz->cz_stats, ret);
+    Py_DECREF(sendstr);
+    return ret;
+}
+
+PyObject *
+PyCozip_SendEach(PyObject *cz, PyObject **values, Py_ssize_t n)
+{
+    PyObject *ret;
+
+    if (!PyCozip_Check(cz)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    CTZ_PROBE_ENTRY(cozip_send, cz, ((cozip*) cz)->cz_tuplesize);
+    ret = inner_cozip_send_each((cozip*) cz, values, n);
+    CTZ_PROBE_RETURN(cozip_send, cz, ((cozip*) cz)->cz_tuplesize, ret);
+    return ret;
+}
+
+static PyObject *
+cozip_send_each(cozip *cz, PyObject *values)
+{
+    PyObject *seq;
+    PyObject *ret;
+
+    if (!(seq = PySequence_Fast(values,
+                                "cozip.send_each() argument must be a"
+                                " sequence"))) {
+        return NULL;
+    }
+    ret = PyCozip_SendEach((PyObject*) cz,
+                           PySequence_Fast_ITEMS(seq),
+                           PySequence_Fast_GET_SIZE(seq));
+    Py_DECREF(seq);
+    return ret;
+}
+
 PyDoc_STRVAR(cozip_throw_doc,
              "Throw an exception into the cozip.\n"
              "\n"
@@ -208,57 +1011,45 @@ PyDoc_STRVAR(cozip_throw_doc,
              "    inner coroutine(s).\n");
 
 static PyObject *
-cozip_throw(cozip *self, PyObject *args)
+inner_cozip_throw(cozip *self, PyObject *args)
 {
     PyObject *throwstr;
-    PyObject *throw;
-    Py_ssize_t n;
-    PyObject *item;
-    Py_ssize_t tuplesize = self->cz_tuplesize;
-    PyObject *crs = self->cz_crs;
-    PyObject *res = self->cz_res;
-    PyObject *ret = NULL;
+    PyObject *ret;
+    CTZ_STATS_DECL(start);
 
-    if (!tuplesize) {
+    CTZ_STATS_INCR(self->cz_stats, throws);
+    if (self->cz_done) {
+        /* like a finished generator, raise the exception right here */
+        _ctz_set_exc_from_tuple(args);
         return NULL;
     }
     if (!(throwstr = PyUnicode_FromString("throw"))) {
         return NULL;
     }
-    if (Py_REFCNT(res) == 1) {
-        Py_INCREF(res);
-        for (n = 0;n < self->cz_tuplesize;++n) {
-            if (!(throw = PyObject_GetAttr(PyTuple_GET_ITEM(crs, n),
-                                           throwstr))) {
-                goto error;
-            }
-            if (!(item = PyObject_Call(throw, args, NULL))) {
-                goto error;
-            }
-            Py_DECREF(PyTuple_GET_ITEM(res, n));
-            PyTuple_SET_ITEM(res, n, item);
-        }
+    CTZ_STATS_START(start);
+    if (self->cz_mode != COZIP_SHORTEST) {
+        ret = cozip_step_mode(self, throwstr, args, NULL);
     }
     else {
-        res = PyTuple_New(tuplesize);
-        for (n = 0;n < self->cz_tuplesize;++n) {
-            if (!(throw = PyObject_GetAttr(PyTuple_GET_ITEM(crs, n),
-                                           throwstr))) {
-                goto error;
-            }
-            if (!(item = PyObject_Call(throw, args, NULL))) {
-                goto error;
-            }
-            PyTuple_SET_ITEM(res, n, item);
-        }
+        ret = cozip_step_shortest(self, throwstr, args, NULL);
     }
-
-    ret = res;
-error:
+    CTZ_STATS_ELAPSED(self->cz_stats, child, start);
+    CTZ_STATS_STOP(self->cz_stats, ret);
     Py_DECREF(throwstr);
     return ret;
 }
 
+static PyObject *
+cozip_throw(cozip *self, PyObject *args)
+{
+    PyObject *ret;
+
+    CTZ_PROBE_ENTRY(cozip_throw, self, self->cz_tuplesize);
+    ret = inner_cozip_throw(self, args);
+    CTZ_PROBE_RETURN(cozip_throw, self, self->cz_tuplesize, ret);
+    return ret;
+}
+
 PyObject *
 PyCozip_Throw(PyObject *cz, PyObject *excinfo)
 {
@@ -272,57 +1063,133 @@ PyCozip_Throw(PyObject *cz, PyObject *excinfo)
 PyDoc_STRVAR(cozip_close_doc,
              "Close the cozip."
              "\n"
-             "This closes all of the inner coroutines.\n");
+             "This closes all of the inner coroutines which are not already\n"
+             "exhausted. If closing a coroutine raises, the rest are still\n"
+             "closed and the first error is raised. Closing a closed cozip\n"
+             "does nothing.\n");
 
 static PyObject *
-cozip_close(cozip *self, PyObject *_)
+inner_cozip_close(cozip *self, PyObject *_)
 {
-    Py_ssize_t n;
-    PyObject *argtuple;
-    PyObject *closestr = NULL;
-    PyObject *close;
-
-    n = PyTuple_GET_SIZE(self->cz_crs);
-    if (!(closestr = PyUnicode_FromString("close"))) {
-        return NULL;
+    CTZ_STATS_INCR(self->cz_stats, closes);
+    if (self->cz_closed) {
+        Py_RETURN_NONE;
     }
-    if (!(argtuple = PyTuple_New(0))) {
-        Py_DECREF(closestr);
+    self->cz_closed = 1;
+    self->cz_done = 1;
+    if (_ctz_coiter_close_all(PyCoiter_API,
+                              self->cz_crs,
+                              self->cz_finished)) {
         return NULL;
     }
+    Py_RETURN_NONE;
+}
 
-    for (;n;--n) {
-        if (!(close = PyObject_GetAttr(PyTuple_GET_ITEM(self->cz_crs, n - 1),
-                                       closestr))) {
-            Py_DECREF(closestr);
-            Py_DECREF(argtuple);
-            return NULL;
-        }
-        PyObject_Call(close, argtuple, NULL);
-    }
+static PyObject *
+cozip_close(cozip *self, PyObject *_)
+{
+    PyObject *ret;
 
-    Py_DECREF(argtuple);
-    Py_RETURN_NONE;
+    CTZ_PROBE_ENTRY(cozip_close, self, self->cz_tuplesize);
+    ret = inner_cozip_close(self, _);
+    CTZ_PROBE_RETURN(cozip_close, self, self->cz_tuplesize, ret);
+    return ret;
 }
 
 int
 PyCozip_Close(PyObject *cz)
 {
+    PyObject *ret;
+
     if (!PyCozip_Check(cz)) {
         PyErr_BadInternalCall();
         return 1;
     }
-    Py_XDECREF(cozip_close((cozip*) cz, NULL));
+    if (!(ret = cozip_close((cozip*) cz, NULL))) {
+        return 1;
+    }
+    Py_DECREF(ret);
     return 0;
 }
 
+Py_ssize_t
+PyCozip_SendN(PyObject *cz,
+              PyObject **values,
+              Py_ssize_t n,
+              PyObject **out)
+{
+    Py_ssize_t m;
+
+    if (!PyCozip_Check(cz)) {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+    for (m = 0;m < n;++m) {
+        if (!(out[m] = cozip_send((cozip*) cz, values[m]))) {
+            break;
+        }
+    }
+    return m;
+}
+
+int
+PyCozip_Stats(PyObject *cz, ctz_stats *out)
+{
+    if (!PyCozip_Check(cz)) {
+        PyErr_BadInternalCall();
+        return 1;
+    }
+    return _ctz_stats_copy(CTZ_STATS_PTR(((cozip*) cz)->cz_stats), out);
+}
+
+PyDoc_STRVAR(cozip_stats_doc, CTZ_STATS_DOC);
+
+static PyObject *
+cozip_stats(cozip *self, PyObject *_)
+{
+    return _ctz_stats_as_dict(CTZ_STATS_PTR(self->cz_stats));
+}
+
 static PyMethodDef cozip_methods[] = {
     {"send", (PyCFunction) cozip_send, METH_O, cozip_send_doc},
+    {"send_each",
+     (PyCFunction) cozip_send_each,
+     METH_O,
+     cozip_send_each_doc},
     {"throw", (PyCFunction) cozip_throw, METH_VARARGS, cozip_throw_doc},
     {"close", (PyCFunction) cozip_close, METH_NOARGS, cozip_close_doc},
+    {"stats", (PyCFunction) cozip_stats, METH_NOARGS, cozip_stats_doc},
     {NULL},
 };
 
+static PyObject *
+cozip_get_finished(cozip *self, void *_)
+{
+    return PyBool_FromLong(self->cz_done);
+}
+
+static PyGetSetDef cozip_getsets[] = {
+    {"finished", (getter) cozip_get_finished, NULL,
+     "Whether the cozip is exhausted or closed. Sending into a finished\n"
+     "cozip raises StopIteration without stepping the coroutines.", NULL},
+    {NULL},
+};
+
+#define OFF(a) offsetof(cozip, a)
+
+static PyMemberDef cozip_members[] = {
+    {"children", T_OBJECT_EX, OFF(cz_crs), READONLY,
+     "The coiter wrapped coroutines being zipped together."},
+    {"fused", T_PYSSIZET, OFF(cz_nest), READONLY,
+     "The number of single-child cozips fused around the children."},
+    {"record_type", T_OBJECT, OFF(cz_type), READONLY,
+     "The struct sequence type of the results, or None if the results\n"
+     "are tuples."},
+    {NULL},
+};
+
+#undef OFF
+
 PyDoc_STRVAR(cozip_doc,
              "zip that acts on coroutines.\n"
              "\n"
@@ -330,16 +1197,47 @@ PyDoc_STRVAR(cozip_doc,
              "----------\n"
              "*coroutines\n"
              "    The coroutines to zip together.\n"
+             "mode : {'shortest', 'longest', 'strict'}, optional\n"
+             "    How to handle coroutines of different lengths. 'shortest'\n"
+             "    stops at the first exhausted coroutine like ``zip``,\n"
+             "    'longest' fills in exhausted coroutines with ``fillvalue``\n"
+             "    like ``itertools.zip_longest``, and 'strict' raises a\n"
+             "    ValueError if the coroutines are not all exhausted together.\n"
+             "fillvalue : any, optional\n"
+             "    The value used for exhausted coroutines in 'longest' mode.\n"
+             "names : sequence[str], optional\n"
+             "    One field name for each coroutine. When given, the results\n"
+             "    are struct sequences with these fields instead of tuples.\n"
+             "    The names must be identifiers which do not start with an\n"
+             "    underscore, other than ``n_fields``, ``n_sequence_fields``,\n"
+             "    and ``n_unnamed_fields``. The type is shared by cozips with\n"
+             "    the same names; the types of the 256 most recently added sets\n"
+             "    of names are cached.\n"
+             "\n"
+             "Notes\n"
+             "-----\n"
+             "``cozip(cozip(*coroutines))``, where the inner cozip is a\n"
+             "temporary that is not referenced anywhere else and is in\n"
+             "'shortest' mode, is built as a single node which zips\n"
+             "``coroutines`` and wraps each result in a 1-tuple. ``fused``\n"
+             "counts the cozips flattened this way. Cozips built through the\n"
+             "C API are never fused.\n"
              "\n"
              "Methods\n"
              "-------\n"
              "send(value)\n"
              "    Sends a value into the inner coroutines and zips the results\n"
+             "send_each(values)\n"
+             "    Sends ``values[n]`` into the nth inner coroutine and zips\n"
+             "    the results.\n"
              "throw(exc) or throw(type, arg, traceback)\n"
              "    Throws an exception into the inner coroutines and zips\n"
              "    the results.\n"
              "close()\n"
              "    Closes the cozip by closing all of the inner coroutines.\n"
+             "    This is idempotent.\n"
+             "stats()\n"
+             "    Returns the runtime counters for this cozip.\n"
     );
 
 PyTypeObject PyCozip_Type = {
@@ -347,7 +1245,7 @@ PyTypeObject PyCozip_Type = {
     "cotoolz._cozip.cozip",             /* tp_name */
     sizeof(cozip),                      /* tp_basicsize */
     0,                                  /* tp_itemsize */
-    0,                                  /* tp_dealloc */
+    (destructor) cozip_dealloc,         /* tp_dealloc */
     0,                                  /* tp_print */
     0,                                  /* tp_getattr */
     0,                                  /* tp_setattr */
@@ -363,17 +1261,18 @@ PyTypeObject PyCozip_Type = {
     0,                                  /* tp_setattro */
     0,                                  /* tp_as_buffer */
     Py_TPFLAGS_DEFAULT |
-    Py_TPFLAGS_BASETYPE,                /* tp_flags */
+    Py_TPFLAGS_BASETYPE |
+    Py_TPFLAGS_HAVE_GC,                 /* tp_flags */
     cozip_doc,                          /* tp_doc */
-    0,                                  /* tp_traverse */
-    0,                                  /* tp_clear */
+    (traverseproc) cozip_traverse,      /* tp_traverse */
+    (inquiry) cozip_clear,              /* tp_clear */
     0,                                  /* tp_richcompare */
     0,                                  /* tp_weaklistoffset */
     0,                                  /* tp_iter */
     (iternextfunc) cozip_next,          /* tp_iternext */
     cozip_methods,                      /* tp_methods */
-    0,                                  /* tp_members */
-    0,                                  /* tp_getset */
+    cozip_members,                      /* tp_members */
+    cozip_getsets,                      /* tp_getset */
     &PyZip_Type,                        /* tp_base */
     0,                                  /* tp_dict */
     0,                                  /* tp_descr_get */
@@ -382,6 +1281,17 @@ PyTypeObject PyCozip_Type = {
     0,                                  /* tp_init */
     0,                                  /* tp_alloc */
     cozip_new,                          /* tp_new */
+    0,                                  /* tp_free */
+    0,                                  /* tp_is_gc */
+    0,                                  /* tp_bases */
+    0,                                  /* tp_mro */
+    0,                                  /* tp_cache */
+    0,                                  /* tp_subclasses */
+    0,                                  /* tp_weaklist */
+    0,                                  /* tp_del */
+    0,                                  /* tp_version_tag */
+    0,                                  /* tp_finalize */
+    (vectorcallfunc) cozip_vectorcall,  /* tp_vectorcall */
 };
 
 PyDoc_STRVAR(module_doc, "cozip is a zip that acts on coroutines.");
@@ -403,6 +1313,10 @@ static PyCozip_Exported exported_symbols = {
     PyCozip_Send,
     PyCozip_Throw,
     PyCozip_Close,
+    PyCozip_Stats,
+    PyCozip_FromArray,
+    PyCozip_SendN,
+    PyCozip_SendEach,
 };
 
 PyMODINIT_FUNC
@@ -412,15 +1326,22 @@ PyInit__cozip(void)
     PyObject *symbols;
     int err;
 
-    /* Assert that our custom cozip struct definition is the same as
-     * the zipobject struct.
+    /* Assert that our custom cozip struct definition starts with the
+     * zipobject struct.
      */
-    assert(sizeof(cozip) == PyZip_Type.tp_basicsize);
+    assert(sizeof(cozip) >= PyZip_Type.tp_basicsize);
 
     if (PyType_Ready(&PyCozip_Type)) {
         return NULL;
     }
 
+    if (!record_types && !(record_types = PyDict_New())) {
+        return NULL;
+    }
+    if (!record_names && !(record_names = PySet_New(NULL))) {
+        return NULL;
+    }
+
     if (!(PyCoiter_API =
           PyCapsule_Import("cotoolz._coiter._exported_symbols", 0))) {
         return NULL;
@@ -448,5 +1369,9 @@ PyInit__cozip(void)
         Py_DECREF(m);
         return NULL;
     }
+    if (PyModule_AddIntConstant(m, "_api_version", COTOOLZ_API_VERSION)) {
+        Py_DECREF(m);
+        return NULL;
+    }
     return m;
 }
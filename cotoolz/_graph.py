@@ -0,0 +1,274 @@
+from collections import namedtuple
+from itertools import islice
+from time import perf_counter
+
+from ._cochain import cochain
+from ._coiter import coiter, stats_enabled
+from ._cointerleave import cointerleave
+from ._comap import comap
+from ._comerge import comerge
+from ._copartition import copartition
+from ._coprefetch import coprefetch
+from ._coroute import coroute
+from ._coshard import coshard
+from ._cowindow import cowindow
+from ._cozip import cozip
+
+
+_kinds = (
+    (comap, 'comap'),
+    (cozip, 'cozip'),
+    (comerge, 'comerge'),
+    (cointerleave, 'cointerleave'),
+    (coroute, 'coroute'),
+    (copartition, 'copartition'),
+    (cowindow, 'cowindow'),
+    (cochain, 'cochain'),
+    (coprefetch, 'coprefetch'),
+    (coshard, 'coshard'),
+    (coiter, 'coiter'),
+)
+
+
+def _kind(ob):
+    for tp, name in _kinds:
+        if isinstance(ob, tp):
+            return name
+    return type(ob).__name__
+
+
+def _label(ob):
+    func = getattr(ob, 'func', None)
+    kind = _kind(ob)
+    if func is None:
+        return kind
+    return '%s(%s)' % (kind, getattr(func, '__name__', repr(func)))
+
+
+class Node(namedtuple('Node', 'obj kind func children')):
+    """A node in a coroutine pipeline.
+
+    Parameters
+    ----------
+    obj : any
+        The object at this point in the pipeline.
+    kind : str
+        The name of the type of ``obj``, for example ``'comap'``.
+    func : callable or None
+        The function mapped by ``obj`` if it is a ``comap``.
+    children : tuple[Node]
+        The nodes feeding into ``obj``.
+    """
+    __slots__ = ()
+
+    def walk(self):
+        """Iterate over the nodes of this tree in pre-order.
+        """
+        yield self
+        for child in self.children:
+            yield from child.walk()
+
+    def to_dot(self):
+        """Render this tree in the graphviz dot format.
+
+        Returns
+        -------
+        dot : str
+            The dot source for this tree.
+        """
+        return _to_dot(self, _label)
+
+
+def graph(pipeline):
+    """Walk the ``children`` of a coroutine pipeline.
+
+    Parameters
+    ----------
+    pipeline : any
+        The root of the pipeline, usually a ``comap``, ``cozip``, or
+        ``coiter``.
+
+    Returns
+    -------
+    root : Node
+        The tree of nodes in the pipeline. Objects which do not expose
+        ``children`` are leaves.
+    """
+    return Node(
+        pipeline,
+        _kind(pipeline),
+        getattr(pipeline, 'func', None),
+        tuple(map(graph, getattr(pipeline, 'children', ()))),
+    )
+
+
+def _to_dot(root, label):
+    lines = ['digraph pipeline {']
+    ids = {}
+    for node in root.walk():
+        ids[id(node)] = 'n%d' % len(ids)
+        lines.append(
+            '    %s [label="%s"];' % (
+                ids[id(node)],
+                label(node.obj).replace('"', '\\"'),
+            ),
+        )
+    for node in root.walk():
+        for child in node.children:
+            lines.append('    %s -> %s;' % (ids[id(child)], ids[id(node)]))
+    lines.append('}')
+    return '\n'.join(lines)
+
+
+class NodeProfile(namedtuple('NodeProfile', 'node calls total_ns self_ns')):
+    """The profile of a single node in a pipeline.
+
+    Parameters
+    ----------
+    node : Node
+        The node that was profiled.
+    calls : int
+        The number of sends and throws into the node.
+    total_ns : int
+        The nanoseconds spent in the node, including its children.
+    self_ns : int
+        The nanoseconds spent in the node, excluding the time attributed to
+        its instrumented children. Time spent in plain iterators is
+        attributed to the node that consumes them.
+    """
+    __slots__ = ()
+
+
+class Profile(namedtuple('Profile', 'root nodes steps seconds')):
+    """The result of ``profile``.
+
+    Parameters
+    ----------
+    root : Node
+        The pipeline that was profiled.
+    nodes : list[NodeProfile]
+        The profile of each instrumented node, in pre-order.
+    steps : int
+        The number of values pulled out of the pipeline.
+    seconds : float
+        The wall time spent driving the pipeline.
+    """
+    __slots__ = ()
+
+    def throughput(self, node_profile):
+        """The calls per second into a node while profiling.
+        """
+        if not self.seconds:
+            return 0.0
+        return node_profile.calls / self.seconds
+
+    def __str__(self):
+        lines = ['%-32s %10s %12s %12s %12s' % (
+            'node', 'calls', 'calls/s', 'total ms', 'self ms',
+        )]
+        for p in self.nodes:
+            lines.append('%-32s %10d %12.0f %12.3f %12.3f' % (
+                _label(p.node.obj)[:32],
+                p.calls,
+                self.throughput(p),
+                p.total_ns / 1e6,
+                p.self_ns / 1e6,
+            ))
+        return '\n'.join(lines)
+
+    def to_dot(self):
+        """Render the profiled pipeline in the graphviz dot format, labeling
+        each node with its throughput and self-time.
+
+        Returns
+        -------
+        dot : str
+            The dot source for this profile.
+        """
+        by_obj = {id(p.node.obj): p for p in self.nodes}
+
+        def label(ob):
+            p = by_obj.get(id(ob))
+            if p is None:
+                return _label(ob)
+            return '%s\\n%.0f calls/s\\nself %.3f ms' % (
+                _label(ob),
+                self.throughput(p),
+                p.self_ns / 1e6,
+            )
+
+        return _to_dot(self.root, label)
+
+
+def _snapshot(root):
+    snap = {}
+    for node in root.walk():
+        stats = getattr(node.obj, 'stats', None)
+        if stats is not None:
+            snap[id(node.obj)] = stats()
+    return snap
+
+
+def profile(pipeline, n):
+    """Drive a pipeline and report the throughput and self-time of each node.
+
+    Parameters
+    ----------
+    pipeline : any
+        The root of the pipeline to profile.
+    n : int
+        The maximum number of values to pull out of the pipeline.
+
+    Returns
+    -------
+    profile : Profile
+        The per-node profile.
+
+    Raises
+    ------
+    RuntimeError
+        Raised when cotoolz was compiled without ``COTOOLZ_STATS``.
+    """
+    if not stats_enabled:
+        raise RuntimeError(
+            'profile requires cotoolz to be compiled with COTOOLZ_STATS=1',
+        )
+
+    root = graph(pipeline)
+    before = _snapshot(root)
+    steps = 0
+    start = perf_counter()
+    for steps, _ in enumerate(islice(pipeline, n), 1):
+        pass
+    seconds = perf_counter() - start
+    after = _snapshot(root)
+
+    def delta(obj):
+        a = after.get(id(obj))
+        if a is None:
+            return None
+        b = before[id(obj)]
+        return {k: a[k] - b[k] for k in a}
+
+    deltas = {id(node.obj): delta(node.obj) for node in root.walk()}
+
+    def total(node):
+        d = deltas[id(node.obj)]
+        if d is None or not (d['sends'] or d['throws']):
+            # an uninstrumented or pass-through node, look through it
+            return sum(map(total, node.children))
+        return d['child_ns'] + d['func_ns']
+
+    nodes = []
+    for node in root.walk():
+        d = deltas[id(node.obj)]
+        if d is None or not (d['sends'] or d['throws']):
+            continue
+        node_total = total(node)
+        nodes.append(NodeProfile(
+            node,
+            d['sends'] + d['throws'],
+            node_total,
+            max(node_total - sum(map(total, node.children)), 0),
+        ))
+    return Profile(root, nodes, steps, seconds)
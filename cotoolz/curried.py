@@ -1,25 +1,74 @@
 from toolz.functoolz import curry
 from toolz._signatures import module_info, create_signature_registry
 
+from ._coaggregate import (
+    cocount,
+    comax,
+    comean,
+    comin,
+    cosum,
+    covar,
+)
+from ._cochain import cochain
+from ._cochannel import cochannel
 from ._coiter import coiter
+from ._cointerleave import cointerleave
 from ._comap import comap
+from ._comerge import comerge
+from ._copartition import copartition
+from ._copool import copool
+from ._coprefetch import coprefetch
+from ._coroute import coroute
+from ._coscheduler import coscheduler
+from ._coshard import coshard
+from ._coshm import coshm, coshm_sink, coshm_source
+from ._cowindow import cowindow
 from ._cozip import cozip
 from ._emptycoroutine import emptycoroutine
 from .include import get_include
 
 
 __all__ = [
+    'cochain',
+    'cochannel',
+    'cocount',
     'coiter',
+    'cointerleave',
     'comap',
+    'comax',
+    'comean',
+    'comerge',
+    'comin',
+    'copartition',
+    'copool',
+    'coprefetch',
+    'coroute',
+    'coscheduler',
+    'coshard',
+    'coshm',
+    'coshm_sink',
+    'coshm_source',
+    'cosum',
+    'covar',
+    'cowindow',
     'cozip',
     'emptycoroutine',
     'get_include',
 ]
 
 module_info['cotoolz._comap'] = {
-    'comap': [lambda func, coroutine, *coroutines: None],
+    'comap': [
+        lambda func, coroutine, *coroutines, batch=0, flatten=True: None,
+    ],
+}
+module_info['cotoolz._coroute'] = {
+    'coroute': [
+        lambda keyfunc, handlers, *, maxsize=None, prime=False: None,
+    ],
 }
 create_signature_registry()
 
 comap = curry(comap)
+coroute = curry(coroute)
+coshard = curry(coshard)
 del curry, module_info, create_signature_registry
@@ -19,5 +19,9 @@ def get_include():
             include_dirs=[ctz.get_include()],
         )
         ...
+
+    This directory also holds the ``.pxd`` declarations for Cython. Pass it
+    as the ``include_path`` to ``cythonize`` to ``cimport`` them, for
+    example: ``from cotoolz.cotoolz cimport cotoolz_import, cotoolz_send``.
     """
     return os.path.dirname(__file__)
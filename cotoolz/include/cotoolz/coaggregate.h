@@ -0,0 +1,178 @@
+#ifndef COTOOLZ_COAGGREGATE_H
+#define COTOOLZ_COAGGREGATE_H
+
+#include "stats.h"
+#include "version.h"
+
+/* The aggregate computed by a coaggregate. */
+typedef enum {
+    COAGGREGATE_SUM,
+    COAGGREGATE_MIN,
+    COAGGREGATE_MAX,
+    COAGGREGATE_COUNT,
+    COAGGREGATE_MEAN,
+    COAGGREGATE_VAR,
+} coaggregate_kind;
+
+/* How a cosum is holding its total. A cosum starts out in the narrowest
+   mode which can hold ``start`` and widens as needed. */
+typedef enum {
+    COAGGREGATE_SUM_INT,        /* the total fits in ``ag_int`` */
+    COAGGREGATE_SUM_FLOAT,      /* the total is ``ag_sum + ag_comp`` */
+    COAGGREGATE_SUM_OBJECT,     /* the total is ``ag_obj`` */
+} coaggregate_sum_mode;
+
+typedef struct {
+    PyObject_HEAD
+    coaggregate_kind ag_kind;
+    coaggregate_sum_mode ag_mode;
+    long ag_int;                /* the exact int total of a cosum */
+    double ag_sum;              /* the float total of a cosum or the running
+                                   mean of a comean or covar */
+    double ag_comp;             /* the Neumaier compensation of a cosum or
+                                   the sum of squared deviations of a
+                                   covar */
+    PyObject *ag_obj;           /* the object total of a cosum or the best
+                                   value of a comin or comax, NULL before the
+                                   first value */
+    uint64_t ag_count;          /* the number of values aggregated */
+    Py_ssize_t ag_ddof;         /* the delta degrees of freedom of a covar */
+    CTZ_STATS_FIELD(ag_stats)
+} coaggregate;
+
+extern PyTypeObject PyCoaggregate_Type;
+extern PyTypeObject PyCosum_Type;
+extern PyTypeObject PyComin_Type;
+extern PyTypeObject PyComax_Type;
+extern PyTypeObject PyCocount_Type;
+extern PyTypeObject PyComean_Type;
+extern PyTypeObject PyCovar_Type;
+
+#define PyCoaggregate_Check(obj)                                \
+    PyObject_IsInstance(obj, (PyObject*) &PyCoaggregate_Type)
+
+typedef struct{
+
+    /* Construct a new aggregate sink.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * kind : coaggregate_kind
+     *     The aggregate to compute.
+     * arg : any or NULL
+     *     The ``start`` of a cosum or the ``ddof`` of a covar, NULL for the
+     *     default. This is ignored for the other kinds.
+     *
+     * Returns
+     * -------
+     * ag : coaggregate
+     *     A new reference to a coaggregate.
+     */
+    PyObject *(*CTZ_NEW)(coaggregate_kind kind, PyObject *arg);
+
+    /* Send a value into an aggregate sink.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ag : coaggregate
+     *     The coaggregate to send the value into.
+     * value : any
+     *     The value to aggregate. None is not aggregated.
+     *
+     * Returns
+     * -------
+     * aggregate : any
+     *     A new reference to the current aggregate.
+     */
+    PyObject *(*send)(PyObject *ag, PyObject *value);
+
+    /* Throw an exception into an aggregate sink.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ag : coaggregate
+     *     The coaggregate to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     Always NULL, the exception is raised.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *ag, PyObject *excinfo);
+
+    /* Close an aggregate sink.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *ag);
+
+    /* Read the runtime counters of an aggregate sink.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ag : coaggregate
+     *     The coaggregate to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *ag, ctz_stats *out);
+
+    /* Aggregate a C array of doubles.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ag : coaggregate
+     *     The coaggregate to send the values into.
+     * values : const double*
+     *     The values to aggregate.
+     * n : Py_ssize_t
+     *     The number of values.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*send_doubles)(PyObject *ag, const double *values, Py_ssize_t n);
+
+    /* Get the current aggregate.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ag : coaggregate
+     *     The coaggregate to read.
+     *
+     * Returns
+     * -------
+     * aggregate : any
+     *     A new reference to the current aggregate.
+     */
+    PyObject *(*value)(PyObject *ag);
+}PyCoaggregate_Exported;
+
+#endif
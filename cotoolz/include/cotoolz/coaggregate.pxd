@@ -0,0 +1,22 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/coaggregate.h":
+    ctypedef enum coaggregate_kind:
+        COAGGREGATE_SUM
+        COAGGREGATE_MIN
+        COAGGREGATE_MAX
+        COAGGREGATE_COUNT
+        COAGGREGATE_MEAN
+        COAGGREGATE_VAR
+
+    ctypedef struct PyCoaggregate_Exported:
+        PyObject *(*new "new")(coaggregate_kind kind, PyObject *arg)
+        PyObject *(*send)(PyObject *ag, PyObject *value)
+        PyObject *(*throw)(PyObject *ag, PyObject *excinfo)
+        int (*close)(PyObject *ag)
+        int (*stats)(PyObject *ag, ctz_stats *out)
+        int (*send_doubles)(PyObject *ag, const double *values, Py_ssize_t n)
+        PyObject *(*value)(PyObject *ag)
@@ -0,0 +1,127 @@
+#ifndef COTOOLZ_COCHAIN_H
+#define COTOOLZ_COCHAIN_H
+
+#include "stats.h"
+#include "version.h"
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *ch_crs;           /* the children passed to cochain(*crs), NULL
+                                   for cochain.from_iterable */
+    Py_ssize_t ch_next;         /* the index of the next child in ch_crs */
+    PyObject *ch_source;        /* the iterator of children for
+                                   cochain.from_iterable, NULL otherwise */
+    PyObject *ch_active;        /* the coiter wrapped current child, NULL
+                                   before the first send and once exhausted */
+    CTZ_STATS_FIELD(ch_stats)
+} cochain;
+
+extern PyTypeObject PyCochain_Type;
+
+#define PyCochain_Check(obj)                                    \
+    PyObject_IsInstance(obj, (PyObject*) &PyCochain_Type)
+#define PyCochain_CheckExact(obj) (Py_TYPE(obj) == &PyCochain_Type)
+
+typedef struct{
+
+    /* Construct a new cochain.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * crs : tuple
+     *     The coroutines to chain together.
+     *
+     * Returns
+     * -------
+     * ch : cochain
+     *     A new reference to a cochain.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *crs);
+
+    /* Construct a new cochain from an iterable of coroutines.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * it : iterable
+     *     The coroutines to chain together. This is consumed lazily.
+     *
+     * Returns
+     * -------
+     * ch : cochain
+     *     A new reference to a cochain.
+     */
+    PyObject *(*from_iterable)(PyObject *it);
+
+    /* Send a value into the current child of a cochain.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ch : cochain
+     *     The cochain to send the value into.
+     * value : any
+     *     The value to send into the current child.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the value yielded by the current child.
+     */
+    PyObject *(*send)(PyObject *ch, PyObject *value);
+
+    /* Throw an exception into the current child of a cochain.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ch : cochain
+     *     The cochain to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the value yielded by the current child.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *ch, PyObject *excinfo);
+
+    /* Close a cochain.
+     * This closes the current child and the children after it.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *ch);
+
+    /* Read the runtime counters of a cochain.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * ch : cochain
+     *     The cochain to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *ch, ctz_stats *out);
+}PyCochain_Exported;
+
+#endif
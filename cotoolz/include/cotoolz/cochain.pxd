@@ -0,0 +1,13 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/cochain.h":
+    ctypedef struct PyCochain_Exported:
+        PyObject *(*new "new")(PyObject *crs)
+        PyObject *(*from_iterable)(PyObject *it)
+        PyObject *(*send)(PyObject *ch, PyObject *value)
+        PyObject *(*throw)(PyObject *ch, PyObject *excinfo)
+        int (*close)(PyObject *ch)
+        int (*stats)(PyObject *ch, ctz_stats *out)
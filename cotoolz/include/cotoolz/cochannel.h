@@ -0,0 +1,171 @@
+#ifndef COTOOLZ_COCHANNEL_H
+#define COTOOLZ_COCHANNEL_H
+
+#include <stdint.h>
+
+#include "stats.h"
+#include "version.h"
+
+/* Keep the producer's and consumer's indices on separate cache lines. */
+#define COCHANNEL_CACHE_LINE 64
+
+/* The single-producer/single-consumer ring shared by the two ends of a
+ * cochannel.
+ *
+ * ``cs_head`` is only written by the consumer and ``cs_tail`` is only written
+ * by the producer. Both are free running 32 bit counters so they can be used
+ * directly as futex words; ``cs_tail - cs_head`` is the number of values in
+ * the ring.
+ *
+ * The layout uses C11 atomics so it is opaque to C++.
+ */
+#ifdef __cplusplus
+typedef struct cochannel_state cochannel_state;
+#else
+#include <stdatomic.h>
+
+typedef struct cochannel_state {
+    _Atomic uint32_t cs_head;               /* the next slot to pop */
+    char cs_pad0[COCHANNEL_CACHE_LINE - sizeof(uint32_t)];
+    _Atomic uint32_t cs_tail;               /* the next slot to push */
+    char cs_pad1[COCHANNEL_CACHE_LINE - sizeof(uint32_t)];
+    _Atomic int cs_consumer_waiting;        /* the consumer is, or is about to
+                                               be, waiting on cs_tail */
+    _Atomic int cs_producer_waiting;        /* the producer is, or is about to
+                                               be, waiting on cs_head */
+    _Atomic int cs_sink_closed;
+    _Atomic int cs_source_closed;
+    _Atomic Py_ssize_t cs_refcnt;           /* the number of ends alive */
+    uint32_t cs_mask;                       /* the capacity minus one */
+    PyObject **cs_slots;
+} cochannel_state;
+#endif
+
+typedef struct {
+    PyObject_HEAD
+    cochannel_state *sk_state;
+    int sk_busy;                            /* a thread is pushing */
+    CTZ_STATS_FIELD(sk_stats)
+} cochannel_sink;
+
+typedef struct {
+    PyObject_HEAD
+    cochannel_state *sr_state;
+    int sr_busy;                            /* a thread is popping */
+    CTZ_STATS_FIELD(sr_stats)
+} cochannel_source;
+
+extern PyTypeObject PyCochannelSink_Type;
+extern PyTypeObject PyCochannelSource_Type;
+
+#define PyCochannelSink_Check(obj)                                      \
+    PyObject_IsInstance(obj, (PyObject*) &PyCochannelSink_Type)
+#define PyCochannelSource_Check(obj)                                    \
+    PyObject_IsInstance(obj, (PyObject*) &PyCochannelSource_Type)
+
+typedef struct{
+
+    /* Construct a new channel.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * capacity : Py_ssize_t
+     *     The number of values the channel can hold. This is rounded up to a
+     *     power of two.
+     *
+     * Returns
+     * -------
+     * ends : tuple[cochannel_sink, cochannel_source]
+     *     A new reference to the two ends of the channel.
+     */
+    PyObject *(*CTZ_NEW)(Py_ssize_t capacity);
+
+    /* Push a value into a channel, waiting while the channel is full.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * sink : cochannel_sink
+     *     The sink end of the channel.
+     * value : any
+     *     The value to push.
+     *
+     * Returns
+     * -------
+     * none : None
+     *     A new reference to None, NULL with StopIteration raised if the
+     *     source end has been closed.
+     */
+    PyObject *(*send)(PyObject *sink, PyObject *value);
+
+    /* Pop a value out of a channel, waiting while the channel is empty.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * source : cochannel_source
+     *     The source end of the channel.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the oldest value in the channel, NULL with
+     *     StopIteration raised once the sink end has been closed and the
+     *     channel is empty.
+     */
+    PyObject *(*recv)(PyObject *source);
+
+    /* Throw an exception into either end of a channel.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * end : cochannel_sink or cochannel_source
+     *     The end of the channel to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     Always NULL, the exception is raised.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *end, PyObject *excinfo);
+
+    /* Close either end of a channel.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *end);
+
+    /* Read the runtime counters of either end of a channel.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * end : cochannel_sink or cochannel_source
+     *     The end of the channel to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *end, ctz_stats *out);
+}PyCochannel_Exported;
+
+#endif
@@ -0,0 +1,13 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/cochannel.h":
+    ctypedef struct PyCochannel_Exported:
+        PyObject *(*new "new")(Py_ssize_t capacity)
+        PyObject *(*send)(PyObject *sink, PyObject *value)
+        PyObject *(*recv)(PyObject *source)
+        PyObject *(*throw)(PyObject *end, PyObject *excinfo)
+        int (*close)(PyObject *end)
+        int (*stats)(PyObject *end, ctz_stats *out)
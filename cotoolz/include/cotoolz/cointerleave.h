@@ -0,0 +1,113 @@
+#ifndef COTOOLZ_COINTERLEAVE_H
+#define COTOOLZ_COINTERLEAVE_H
+
+#include "stats.h"
+#include "version.h"
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *il_crs;         /* the coiter wrapped coroutines */
+    Py_ssize_t *il_active;    /* the indices into il_crs of the coroutines
+                                 which are not exhausted, in rotation order */
+    Py_ssize_t il_nactive;    /* the number of indices in il_active */
+    Py_ssize_t il_pos;        /* the index in il_active to advance next */
+    Py_ssize_t il_write;      /* where to write back the index of the next
+                                 coroutine which is not exhausted */
+    CTZ_STATS_FIELD(il_stats)
+} cointerleave;
+
+extern PyTypeObject PyCointerleave_Type;
+
+#define PyCointerleave_Check(obj)                                       \
+    PyObject_IsInstance(obj, (PyObject*) &PyCointerleave_Type)
+#define PyCointerleave_CheckExact(obj) (Py_TYPE(obj) == &PyCointerleave_Type)
+
+typedef struct{
+
+    /* Construct a new cointerleave from an array of coroutines.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * crs : PyObject**
+     *     The coroutines to interleave.
+     * n : Py_ssize_t
+     *     The number of coroutines.
+     *
+     * Returns
+     * -------
+     * il : cointerleave
+     *     A new reference to a cointerleave.
+     */
+    PyObject *(*CTZ_NEW)(PyObject **crs, Py_ssize_t n);
+
+    /* Send a value into the next coroutine in the rotation.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * il : cointerleave
+     *     The cointerleave to send the value into.
+     * value : any
+     *     The value to send in.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the value yielded by the coroutine.
+     */
+    PyObject *(*send)(PyObject *il, PyObject *value);
+
+    /* Throw an exception into the next coroutine in the rotation.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * il : cointerleave
+     *     The cointerleave to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the value yielded by the coroutine.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *il, PyObject *excinfo);
+
+    /* Close a cointerleave.
+     * This closes all of the inner coroutines.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *il);
+
+    /* Read the runtime counters of a cointerleave.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * il : cointerleave
+     *     The cointerleave to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *il, ctz_stats *out);
+}PyCointerleave_Exported;
+
+#endif
@@ -0,0 +1,12 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/cointerleave.h":
+    ctypedef struct PyCointerleave_Exported:
+        PyObject *(*new "new")(PyObject **crs, Py_ssize_t n)
+        PyObject *(*send)(PyObject *il, PyObject *value)
+        PyObject *(*throw)(PyObject *il, PyObject *excinfo)
+        int (*close)(PyObject *il)
+        int (*stats)(PyObject *il, ctz_stats *out)
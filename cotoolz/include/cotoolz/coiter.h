@@ -1,12 +1,16 @@
 #ifndef COTOOLZ_COITER_H
 #define COTOOLZ_COITER_H
 
+#include "stats.h"
+#include "version.h"
+
 typedef struct {
     PyObject_HEAD
     PyObject *ci_it;
     PyObject *ci_send;
     PyObject *ci_throw;
     PyObject *ci_close;
+    CTZ_STATS_FIELD(ci_stats)
 } coiter;
 
 extern PyTypeObject PyCoiter_Type;
@@ -28,7 +32,7 @@ typedef struct{
      * ci : coiter
      *    A new reference to a coiter.
      */
-    PyObject *(*new)(PyObject *it);
+    PyObject *(*CTZ_NEW)(PyObject *it);
 
     /* Send a value into a coiter.
      *
@@ -70,7 +74,7 @@ typedef struct{
      *     The exception that was passed in if not caught.
      * PyObject *PyCoiter_Throw(PyObject *ci, PyObject *excinfo);
      */
-    PyObject *(*throw)(PyObject *ci, PyObject *excinfo);
+    PyObject *(*CTZ_THROW)(PyObject *ci, PyObject *excinfo);
 
     /* Close a coiter.
      * This closes the inner data.
@@ -82,6 +86,53 @@ typedef struct{
      */
     int (*close)(PyObject *ci);
 
+    /* Read the runtime counters of a coiter.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * ci : coiter
+     *     The coiter to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *ci, ctz_stats *out);
+
+    /* Send an array of values into a coiter one at a time.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * ci : coiter
+     *     The coiter to send the values into.
+     * values : PyObject**
+     *     The values to send in, in order.
+     * n : Py_ssize_t
+     *     The number of values to send.
+     * out : PyObject**
+     *     An array of at least ``n`` elements to write the new references to
+     *     the yielded values into.
+     *
+     * Returns
+     * -------
+     * count : Py_ssize_t
+     *     The number of values written into ``out``. If this is less than
+     *     ``n`` then an exception is set, for example StopIteration when the
+     *     coiter is exhausted.
+     */
+    Py_ssize_t (*send_n)(PyObject *ci,
+                         PyObject **values,
+                         Py_ssize_t n,
+                         PyObject **out);
+
 }PyCoiter_Exported;
 
 /* Internal use ------------------------------------------------------------- */
@@ -95,4 +146,148 @@ typedef struct{
  */
 void _ctz_set_exc_from_tuple(PyObject *args);
 
+/* Wrap each of an array of iterables or coroutines in a coiter.
+ *
+ * Paramaters
+ * ----------
+ * api : PyCoiter_Exported*
+ *     The imported coiter API.
+ * name : const char*
+ *     The name of the type being constructed, used in error messages.
+ * crs : PyObject**
+ *     The objects to wrap.
+ * n : Py_ssize_t
+ *     The number of objects.
+ *
+ * Returns
+ * -------
+ * wrapped : tuple[coiter]
+ *     A new reference to a tuple of the wrapped objects.
+ */
+static inline PyObject *
+_ctz_coiter_wrap_all(PyCoiter_Exported *api,
+                     const char *name,
+                     PyObject **crs,
+                     Py_ssize_t n)
+{
+    PyObject *wrapped;
+    PyObject *cr;
+    Py_ssize_t m;
+
+    if (!(wrapped = PyTuple_New(n))) {
+        return NULL;
+    }
+    for (m = 0;m < n;++m) {
+        if (!(cr = api->CTZ_NEW(crs[m]))) {
+            if (PyErr_ExceptionMatches(PyExc_TypeError))
+                PyErr_Format(PyExc_TypeError,
+                             "%s argument #%zd must support iteration",
+                             name,
+                             m + 1);
+            Py_DECREF(wrapped);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(wrapped, m, cr);
+    }
+    return wrapped;
+}
+
+/* Close every coiter in a tuple which is not marked as exhausted, last to
+ * first.
+ *
+ * A failing close does not stop the rest from being closed. The first error
+ * is left set and any later ones are reported with
+ * ``PyErr_WriteUnraisable``.
+ *
+ * Paramaters
+ * ----------
+ * api : PyCoiter_Exported*
+ *     The imported coiter API.
+ * crs : tuple[coiter]
+ *     The coiters to close.
+ * finished : const unsigned char*
+ *     A bitmap with a bit set for each coiter which is already exhausted.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero if any close failed.
+ */
+static inline int
+_ctz_coiter_close_all(PyCoiter_Exported *api,
+                      PyObject *crs,
+                      const unsigned char *finished)
+{
+    PyObject *type = NULL;
+    PyObject *value = NULL;
+    PyObject *tb = NULL;
+    PyObject *cr;
+    Py_ssize_t n;
+
+    for (n = PyTuple_GET_SIZE(crs) - 1;n >= 0;--n) {
+        if (finished[n >> 3] & (1 << (n & 7))) {
+            continue;
+        }
+        cr = PyTuple_GET_ITEM(crs, n);
+        if (!api->close(cr)) {
+            continue;
+        }
+        if (type) {
+            PyErr_WriteUnraisable(cr);
+        }
+        else {
+            PyErr_Fetch(&type, &value, &tb);
+        }
+    }
+    if (!type) {
+        return 0;
+    }
+    PyErr_Restore(type, value, tb);
+    return 1;
+}
+
+/* Send a value into a coiter without going through its counters or probes.
+ *
+ * On Python 3.10 and newer, generators and native coroutines are resumed
+ * directly with ``PyIter_Send``. Anything else, and everything on older
+ * versions, calls the pre-resolved ``send`` method with vectorcall. This is
+ * for types which step many coiters and account for the time themselves.
+ *
+ * Returns
+ * -------
+ * y : any
+ *     A new reference to the next yielded value.
+ */
+static inline PyObject *
+_ctz_coiter_send_fast(PyObject *ci, PyObject *value)
+{
+#if PY_VERSION_HEX >= 0x030A0000
+    PyObject *it = ((coiter*) ci)->ci_it;
+    PyObject *ret;
+    PyObject *stop;
+
+    if (!(PyGen_CheckExact(it) || PyCoro_CheckExact(it))) {
+        return PyObject_CallOneArg(((coiter*) ci)->ci_send, value);
+    }
+    switch (PyIter_Send(it, value, &ret)) {
+    case PYGEN_NEXT:
+        return ret;
+    case PYGEN_RETURN:
+        if (ret == Py_None) {
+            PyErr_SetNone(PyExc_StopIteration);
+        }
+        else if ((stop = PyObject_CallOneArg(PyExc_StopIteration, ret))) {
+            PyErr_SetObject(PyExc_StopIteration, stop);
+            Py_DECREF(stop);
+        }
+        Py_DECREF(ret);
+        return NULL;
+    default:
+        return NULL;
+    }
+#else
+    return PyObject_CallOneArg(((coiter*) ci)->ci_send, value);
+#endif
+}
+
 #endif
@@ -0,0 +1,16 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/coiter.h":
+    ctypedef struct PyCoiter_Exported:
+        PyObject *(*new "new")(PyObject *it)
+        PyObject *(*send)(PyObject *ci, PyObject *value)
+        PyObject *(*throw)(PyObject *ci, PyObject *excinfo)
+        int (*close)(PyObject *ci)
+        int (*stats)(PyObject *ci, ctz_stats *out)
+        Py_ssize_t (*send_n)(PyObject *ci,
+                             PyObject **values,
+                             Py_ssize_t n,
+                             PyObject **out)
@@ -1,10 +1,25 @@
 #ifndef COTOOLZ_COMAP_H
 #define COTOOLZ_COMAP_H
 
+#include "stats.h"
+#include "version.h"
+
 typedef struct {
     PyObject_HEAD
     PyObject *cm_crs;
     PyObject *cm_func;
+    Py_ssize_t cm_batch;    /* number of values to pull per call, 0 if unbatched */
+    int cm_flatten;         /* yield the batch results one at a time */
+    PyObject *cm_pending;   /* iterator over the current flattened batch */
+    PyObject *cm_chain;     /* functions fused from nested comaps, applied
+                               innermost first before cm_func, NULL if not
+                               fused */
+    unsigned char *cm_finished; /* bitmap of the exhausted coroutines */
+    Py_ssize_t cm_nfinished;    /* the number of bits set in cm_finished */
+    int cm_done;                /* no more batches will be pulled, set when a
+                                   coroutine is exhausted or on close */
+    int cm_closed;              /* close has been called */
+    CTZ_STATS_FIELD(cm_stats)
 } comap;
 
 extern PyTypeObject PyComap_Type;
@@ -79,7 +94,8 @@ typedef struct{
     PyObject *(*PyComap_Throw)(PyObject *cm, PyObject *excinfo);
 
     /* Close a comap.
-     * This closes all of the inner coroutines.
+     * This closes all of the inner coroutines which are not already
+     * exhausted. Closing a comap a second time does nothing.
      *
      * Returns
      * -------
@@ -87,6 +103,134 @@ typedef struct{
      *     zero on success, non-zero on failure.
      */
     int (*PyComap_Close)(PyObject *cm);
+
+    /* Construct a new batched comap object from a function and a variable
+     * amount of coroutines.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * func : callable
+     *     The function to map over the batches. This is called with one list
+     *     of up to ``batch`` values per coroutine.
+     * batch : Py_ssize_t
+     *     The number of values to pull from each coroutine per call to
+     *     ``func``.
+     * flatten : int
+     *     If non-zero, the result of ``func`` is iterated and yielded one
+     *     element at a time, otherwise the whole result is yielded.
+     * n : Py_ssize_t
+     *     The number of coroutines.
+     * crs : var * any
+     *     The coroutines to be mapped over.
+     *
+     * Returns
+     * -------
+     * cm : comap
+     *     A new reference to a comap.
+     */
+    PyObject *(*PyComap_NewBatched)(PyObject *func,
+                                    Py_ssize_t batch,
+                                    int flatten,
+                                    Py_ssize_t n,
+                                    ...);
+
+    /* Read the runtime counters of a comap.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * cm : comap
+     *     The comap to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*PyComap_Stats)(PyObject *cm, ctz_stats *out);
+
+    /* Construct a new comap object from a function and an array of
+     * coroutines.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * func : callable
+     *     The function to map over the coroutines.
+     * crs : PyObject**
+     *     The coroutines to be mapped over.
+     * n : Py_ssize_t
+     *     The number of coroutines.
+     *
+     * Returns
+     * -------
+     * cm : comap
+     *     A new reference to a comap.
+     */
+    PyObject *(*PyComap_FromArray)(PyObject *func,
+                                   PyObject **crs,
+                                   Py_ssize_t n);
+
+    /* Send an array of values into a comap one at a time.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * cm : comap
+     *     The comap to send the values into.
+     * values : PyObject**
+     *     The values to send in, in order.
+     * n : Py_ssize_t
+     *     The number of values to send.
+     * out : PyObject**
+     *     An array of at least ``n`` elements to write the new references to
+     *     the yielded values into.
+     *
+     * Returns
+     * -------
+     * count : Py_ssize_t
+     *     The number of values written into ``out``. If this is less than
+     *     ``n`` then an exception is set, for example StopIteration when the
+     *     comap is exhausted.
+     */
+    Py_ssize_t (*PyComap_SendN)(PyObject *cm,
+                                PyObject **values,
+                                Py_ssize_t n,
+                                PyObject **out);
+
+    /* Send a different value into each of the coroutines of a comap.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * cm : comap
+     *     The comap to send the values into.
+     * values : PyObject**
+     *     One value for each coroutine, ``values[n]`` is sent into the
+     *     ``n``th coroutine. A batched comap only sends these in for the
+     *     first step of a new batch.
+     * n : Py_ssize_t
+     *     The number of values. This must be the number of coroutines.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     The result of applying the comap's function over the results of
+     *     sending the values into the inner coroutines. In python:
+     *     cm.cm_func(*map(lambda cr, v: cr.send(v), cm.cm_crs, values))
+     */
+    PyObject *(*PyComap_SendEach)(PyObject *cm,
+                                  PyObject **values,
+                                  Py_ssize_t n);
 }PyComap_Exported;
 
 #endif
@@ -0,0 +1,27 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/comap.h":
+    ctypedef struct PyComap_Exported:
+        PyObject *(*PyComap_New)(PyObject *func, Py_ssize_t n, ...)
+        PyObject *(*PyComap_Send)(PyObject *cm, PyObject *value)
+        PyObject *(*PyComap_Throw)(PyObject *cm, PyObject *excinfo)
+        int (*PyComap_Close)(PyObject *cm)
+        PyObject *(*PyComap_NewBatched)(PyObject *func,
+                                        Py_ssize_t batch,
+                                        int flatten,
+                                        Py_ssize_t n,
+                                        ...)
+        int (*PyComap_Stats)(PyObject *cm, ctz_stats *out)
+        PyObject *(*PyComap_FromArray)(PyObject *func,
+                                       PyObject **crs,
+                                       Py_ssize_t n)
+        Py_ssize_t (*PyComap_SendN)(PyObject *cm,
+                                    PyObject **values,
+                                    Py_ssize_t n,
+                                    PyObject **out)
+        PyObject *(*PyComap_SendEach)(PyObject *cm,
+                                      PyObject **values,
+                                      Py_ssize_t n)
@@ -0,0 +1,136 @@
+#ifndef COTOOLZ_COMERGE_H
+#define COTOOLZ_COMERGE_H
+
+#include "stats.h"
+#include "version.h"
+
+/* The current head of one of the coroutines being merged. */
+typedef struct {
+    PyObject *hd_value;   /* the last value yielded by the coroutine */
+    PyObject *hd_key;     /* key(hd_value), or hd_value when there is no key */
+    Py_ssize_t hd_index;  /* the index of the coroutine in mg_crs */
+} comerge_head;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *mg_crs;         /* the coiter wrapped coroutines */
+    PyObject *mg_key;         /* the key function, NULL for the identity */
+    int mg_reverse;           /* merge in descending order */
+    int mg_pending;           /* the value at the top of the heap was yielded
+                                 and its coroutine is waiting for a send */
+    Py_ssize_t mg_nprimed;    /* the number of coroutines which have been
+                                 started */
+    Py_ssize_t mg_size;       /* the number of heads in mg_heap */
+    comerge_head *mg_heap;    /* binary heap of the live heads */
+    CTZ_STATS_FIELD(mg_stats)
+} comerge;
+
+extern PyTypeObject PyComerge_Type;
+
+#define PyComerge_Check(obj)                                    \
+    PyObject_IsInstance(obj, (PyObject*) &PyComerge_Type)
+#define PyComerge_CheckExact(obj) (Py_TYPE(obj) == &PyComerge_Type)
+
+typedef struct{
+
+    /* Construct a new comerge from an array of coroutines.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * key : callable or NULL
+     *     The function used to compute the sort key of each value. NULL
+     *     compares the values themselves.
+     * reverse : int
+     *     Non-zero if the coroutines are sorted in descending order.
+     * crs : PyObject**
+     *     The sorted coroutines to merge.
+     * n : Py_ssize_t
+     *     The number of coroutines.
+     *
+     * Returns
+     * -------
+     * mg : comerge
+     *     A new reference to a comerge.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *key,
+                     int reverse,
+                     PyObject **crs,
+                     Py_ssize_t n);
+
+    /* Send a value into a comerge.
+     *
+     * The value is sent into the coroutine which yielded the last value
+     * out of the comerge.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * mg : comerge
+     *     The comerge to send the value into.
+     * value : any
+     *     The value to send in.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the smallest head of the inner coroutines.
+     */
+    PyObject *(*send)(PyObject *mg, PyObject *value);
+
+    /* Throw an exception into a comerge.
+     *
+     * The exception is thrown into the coroutine which yielded the last
+     * value out of the comerge.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * mg : comerge
+     *     The comerge to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the smallest head of the inner coroutines.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *mg, PyObject *excinfo);
+
+    /* Close a comerge.
+     * This closes all of the inner coroutines.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *mg);
+
+    /* Read the runtime counters of a comerge.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * mg : comerge
+     *     The comerge to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *mg, ctz_stats *out);
+}PyComerge_Exported;
+
+#endif
@@ -0,0 +1,15 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/comerge.h":
+    ctypedef struct PyComerge_Exported:
+        PyObject *(*new "new")(PyObject *key,
+                               int reverse,
+                               PyObject **crs,
+                               Py_ssize_t n)
+        PyObject *(*send)(PyObject *mg, PyObject *value)
+        PyObject *(*throw)(PyObject *mg, PyObject *excinfo)
+        int (*close)(PyObject *mg)
+        int (*stats)(PyObject *mg, ctz_stats *out)
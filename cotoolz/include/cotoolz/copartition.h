@@ -0,0 +1,137 @@
+#ifndef COTOOLZ_COPARTITION_H
+#define COTOOLZ_COPARTITION_H
+
+#include "stats.h"
+#include "version.h"
+
+/* The values waiting to be sent into a single sink. */
+typedef struct {
+    PyObject **pb_items;    /* the buffered values, ``pt_batch`` long */
+    Py_ssize_t pb_size;     /* the number of buffered values */
+    uint64_t pb_count;      /* the number of values sent to this partition */
+} copartition_buffer;
+
+typedef struct {
+    PyObject_HEAD
+    Py_ssize_t pt_n;               /* the number of partitions */
+    PyObject *pt_crs;              /* the coiter wrapped sinks, empty when
+                                      partitioning without sinks */
+    PyObject *pt_send_many;        /* the ``send_many`` method of each sink,
+                                      or None */
+    PyObject *pt_key;              /* the key function, NULL to hash the
+                                      values themselves */
+    Py_ssize_t pt_batch;           /* the number of values to buffer per
+                                      partition before flushing */
+    copartition_buffer *pt_buffers;
+    CTZ_STATS_FIELD(pt_stats)
+} copartition;
+
+extern PyTypeObject PyCopartition_Type;
+
+#define PyCopartition_Check(obj)                                        \
+    PyObject_IsInstance(obj, (PyObject*) &PyCopartition_Type)
+#define PyCopartition_CheckExact(obj) (Py_TYPE(obj) == &PyCopartition_Type)
+
+typedef struct{
+
+    /* Construct a new copartition.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * n_or_sinks : int or sequence of coroutines
+     *     The number of partitions or the sink for each partition.
+     * key : callable or NULL
+     *     The function used to compute the key to hash. NULL hashes the
+     *     values themselves.
+     * batch : Py_ssize_t
+     *     The number of values to buffer per partition before flushing.
+     *
+     * Returns
+     * -------
+     * pt : copartition
+     *     A new reference to a copartition.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *n_or_sinks, PyObject *key, Py_ssize_t batch);
+
+    /* Send a value into the sink for its partition.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pt : copartition
+     *     The copartition to send the value into.
+     * value : any
+     *     The value to partition.
+     *
+     * Returns
+     * -------
+     * partition : int
+     *     A new reference to the index of the partition of ``value``.
+     */
+    PyObject *(*send)(PyObject *pt, PyObject *value);
+
+    /* Throw an exception into a copartition.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pt : copartition
+     *     The copartition to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     Always NULL, the exception is raised.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *pt, PyObject *excinfo);
+
+    /* Close a copartition.
+     * This flushes the buffered values and closes all of the sinks.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *pt);
+
+    /* Read the runtime counters of a copartition.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pt : copartition
+     *     The copartition to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *pt, ctz_stats *out);
+
+    /* Send all of the buffered values into their sinks.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*flush)(PyObject *pt);
+}PyCopartition_Exported;
+
+#endif
@@ -0,0 +1,15 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/copartition.h":
+    ctypedef struct PyCopartition_Exported:
+        PyObject *(*new "new")(PyObject *n_or_sinks,
+                               PyObject *key,
+                               Py_ssize_t batch)
+        PyObject *(*send)(PyObject *pt, PyObject *value)
+        PyObject *(*throw)(PyObject *pt, PyObject *excinfo)
+        int (*close)(PyObject *pt)
+        int (*stats)(PyObject *pt, ctz_stats *out)
+        int (*flush)(PyObject *pt)
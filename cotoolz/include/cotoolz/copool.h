@@ -0,0 +1,109 @@
+#ifndef COTOOLZ_COPOOL_H
+#define COTOOLZ_COPOOL_H
+
+#include <stdint.h>
+
+#include "version.h"
+
+/* The counters kept by each worker of a copool run. */
+typedef struct {
+    uint64_t wc_steps;          /* the number of sends */
+    uint64_t wc_batches;        /* the number of times a task was picked up */
+    uint64_t wc_steals;         /* tasks taken from another worker's deque */
+    uint64_t wc_idle_ns;        /* nanoseconds spent waiting for work */
+} copool_counters;
+
+/* The state shared by the worker threads while a copool is running. This is
+   private to _copool.c. */
+struct copool_run;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *pl_pending;       /* list of the tasks waiting for ``run`` */
+    struct copool_run *pl_run;  /* the running state, NULL when not running */
+    Py_ssize_t pl_workers;      /* the most threads to step tasks on */
+    Py_ssize_t pl_batch;        /* steps per task before going back to the
+                                   deque */
+    copool_counters pl_totals;  /* the sum of every run's counters */
+    copool_counters *pl_last;   /* the per-worker counters of the last run */
+    Py_ssize_t pl_nlast;        /* the length of pl_last */
+} copool;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *pt_pool;          /* the copool that spawned this task */
+    PyObject *pt_coroutine;     /* the coiter wrapped coroutine, NULL once
+                                   done */
+    PyObject *pt_result;        /* the value the coroutine returned */
+    PyObject *pt_exception;     /* the exception the coroutine raised */
+    uint64_t pt_steps;          /* the number of times this task has been
+                                   stepped */
+    int pt_done;
+} copool_task;
+
+extern PyTypeObject PyCopool_Type;
+extern PyTypeObject PyCopoolTask_Type;
+
+#define PyCopool_Check(obj)                                     \
+    PyObject_IsInstance(obj, (PyObject*) &PyCopool_Type)
+#define PyCopoolTask_Check(obj)                                 \
+    PyObject_IsInstance(obj, (PyObject*) &PyCopoolTask_Type)
+
+typedef struct{
+
+    /* Construct a new copool.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * workers : Py_ssize_t
+     *     The most threads to step tasks on, including the thread which
+     *     calls ``run``.
+     * batch : Py_ssize_t
+     *     The number of steps to give a task each time a worker picks it up.
+     *
+     * Returns
+     * -------
+     * pool : copool
+     *     A new reference to a copool.
+     */
+    PyObject *(*CTZ_NEW)(Py_ssize_t workers, Py_ssize_t batch);
+
+    /* Add a coroutine to the pool.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pool : copool
+     *     The pool to run the coroutine on.
+     * coroutine : iterable
+     *     The coroutine or iterator to step.
+     *
+     * Returns
+     * -------
+     * task : copool_task
+     *     A new reference to the handle of the task.
+     */
+    PyObject *(*spawn)(PyObject *pool, PyObject *coroutine);
+
+    /* Step every task until they are all done.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pool : copool
+     *     The pool to run.
+     *
+     * Returns
+     * -------
+     * steps : Py_ssize_t
+     *     The number of steps taken, -1 with an exception raised if a task
+     *     raised.
+     */
+    Py_ssize_t (*run)(PyObject *pool);
+}PyCopool_Exported;
+
+#endif
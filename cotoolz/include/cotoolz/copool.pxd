@@ -0,0 +1,8 @@
+from cpython.object cimport PyObject
+
+
+cdef extern from "cotoolz/copool.h":
+    ctypedef struct PyCopool_Exported:
+        PyObject *(*new "new")(Py_ssize_t workers, Py_ssize_t batch)
+        PyObject *(*spawn)(PyObject *pool, PyObject *coroutine)
+        Py_ssize_t (*run)(PyObject *pool)
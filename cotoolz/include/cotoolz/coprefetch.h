@@ -0,0 +1,139 @@
+#ifndef COTOOLZ_COPREFETCH_H
+#define COTOOLZ_COPREFETCH_H
+
+#include <pthread.h>
+
+#include "stats.h"
+#include "version.h"
+
+/* The state shared between a coprefetch and its producer thread.
+ *
+ * The state is owned by both the coprefetch and the producer thread so that
+ * either may go away first. ``ps_refcnt`` and the Python objects are only
+ * touched with the GIL held; the ring indices and flags are protected by
+ * ``ps_lock``. Nothing waits for the GIL while holding ``ps_lock``.
+ */
+typedef struct {
+    PyObject *ps_it;            /* the inner iterator */
+    PyObject **ps_ring;         /* the prefetched values */
+    Py_ssize_t ps_depth;        /* the capacity of ps_ring */
+    Py_ssize_t ps_lowwater;     /* the producer refills ps_ring once it has
+                                   drained to this many values */
+    Py_ssize_t ps_head;         /* the index of the oldest value */
+    Py_ssize_t ps_count;        /* the number of values in ps_ring */
+    int ps_done;                /* the inner iterator is exhausted or
+                                   raised */
+    int ps_stop;                /* the producer has been asked to stop */
+    int ps_refcnt;              /* the number of owners of this state */
+    PyObject *ps_type;          /* the exception raised by the inner */
+    PyObject *ps_value;         /* iterator, raised once ps_ring is */
+    PyObject *ps_tb;            /* drained */
+    pthread_mutex_t ps_lock;
+    pthread_cond_t ps_not_empty;
+    pthread_cond_t ps_not_full;
+} coprefetch_state;
+
+typedef struct {
+    PyObject_HEAD
+    coprefetch_state *pf_state;
+    pthread_t pf_thread;
+    int pf_running;             /* pf_thread has not been joined */
+    CTZ_STATS_FIELD(pf_stats)
+} coprefetch;
+
+extern PyTypeObject PyCoprefetch_Type;
+
+#define PyCoprefetch_Check(obj)                                 \
+    PyObject_IsInstance(obj, (PyObject*) &PyCoprefetch_Type)
+#define PyCoprefetch_CheckExact(obj) (Py_TYPE(obj) == &PyCoprefetch_Type)
+
+typedef struct{
+
+    /* Construct a new coprefetch. This starts the producer thread.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * iterable : iterable
+     *     The iterable to prefetch.
+     * depth : Py_ssize_t
+     *     The number of values to prefetch.
+     *
+     * Returns
+     * -------
+     * pf : coprefetch
+     *     A new reference to a coprefetch.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *iterable, Py_ssize_t depth);
+
+    /* Get the next prefetched value.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pf : coprefetch
+     *     The coprefetch to pull from.
+     * value : any
+     *     Ignored, the inner iterator runs ahead of the sends.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the next value of the inner iterator.
+     */
+    PyObject *(*send)(PyObject *pf, PyObject *value);
+
+    /* Throw an exception into a coprefetch.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pf : coprefetch
+     *     The coprefetch to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     Always NULL, the exception is raised.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *pf, PyObject *excinfo);
+
+    /* Close a coprefetch.
+     * This stops and joins the producer thread and closes the inner
+     * iterator.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *pf);
+
+    /* Read the runtime counters of a coprefetch.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * pf : coprefetch
+     *     The coprefetch to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *pf, ctz_stats *out);
+}PyCoprefetch_Exported;
+
+#endif
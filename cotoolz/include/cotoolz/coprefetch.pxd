@@ -0,0 +1,12 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/coprefetch.h":
+    ctypedef struct PyCoprefetch_Exported:
+        PyObject *(*new "new")(PyObject *iterable, Py_ssize_t depth)
+        PyObject *(*send)(PyObject *pf, PyObject *value)
+        PyObject *(*throw)(PyObject *pf, PyObject *excinfo)
+        int (*close)(PyObject *pf)
+        int (*stats)(PyObject *pf, ctz_stats *out)
@@ -0,0 +1,142 @@
+#ifndef COTOOLZ_COROUTE_H
+#define COTOOLZ_COROUTE_H
+
+#include "stats.h"
+#include "version.h"
+
+/* A handler in a coroute with a maxsize.
+ *
+ * The slots form a doubly linked list from the most recently used to the
+ * least recently used. Free slots are kept at the least recently used end.
+ */
+typedef struct {
+    PyObject *rs_key;       /* the key routed to this slot, NULL if free */
+    PyObject *rs_index;     /* the index of this slot as a Python int */
+    PyObject *rs_handler;   /* the coiter wrapped handler, NULL if free */
+    Py_ssize_t rs_prev;     /* the next more recently used slot or -1 */
+    Py_ssize_t rs_next;     /* the next less recently used slot or -1 */
+} coroute_slot;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *rt_keyfunc;   /* the key function, NULL when the value is the
+                               key */
+    PyObject *rt_factory;   /* the handler factory, NULL for a fixed set of
+                               handlers */
+    PyObject *rt_routes;    /* dict of key -> coiter wrapped handler, or
+                               key -> slot index when rt_maxsize is set */
+    PyObject *rt_last;      /* the handler which yielded the last value */
+    PyObject *rt_lastkey;   /* the key of rt_last */
+    int rt_prime;           /* advance new handlers once before sending */
+    Py_ssize_t rt_maxsize;  /* the maximum number of handlers, 0 for no
+                               limit */
+    coroute_slot *rt_slots;
+    Py_ssize_t rt_nslots;   /* the number of slots which have been used */
+    Py_ssize_t rt_capacity; /* the number of slots allocated */
+    Py_ssize_t rt_head;     /* the most recently used slot or -1 */
+    Py_ssize_t rt_tail;     /* the least recently used slot or -1 */
+    CTZ_STATS_FIELD(rt_stats)
+} coroute;
+
+extern PyTypeObject PyCoroute_Type;
+
+#define PyCoroute_Check(obj)                                    \
+    PyObject_IsInstance(obj, (PyObject*) &PyCoroute_Type)
+#define PyCoroute_CheckExact(obj) (Py_TYPE(obj) == &PyCoroute_Type)
+
+typedef struct{
+
+    /* Construct a new coroute.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * keyfunc : callable or NULL
+     *     The function used to compute the key of each value. NULL routes
+     *     on the values themselves.
+     * handlers : mapping or callable
+     *     Either a mapping from key to handler coroutine or a factory called
+     *     with a new key to create its handler.
+     * maxsize : Py_ssize_t
+     *     The maximum number of handlers to keep when ``handlers`` is a
+     *     factory, 0 for no limit.
+     *
+     * Returns
+     * -------
+     * rt : coroute
+     *     A new reference to a coroute.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *keyfunc,
+                     PyObject *handlers,
+                     Py_ssize_t maxsize);
+
+    /* Send a value into the handler for its key.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * rt : coroute
+     *     The coroute to send the value into.
+     * value : any
+     *     The value to route.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the value yielded by the handler.
+     */
+    PyObject *(*send)(PyObject *rt, PyObject *value);
+
+    /* Throw an exception into the handler which yielded the last value.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * rt : coroute
+     *     The coroute to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     A new reference to the value yielded by the handler.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *rt, PyObject *excinfo);
+
+    /* Close a coroute.
+     * This closes all of the handlers.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *rt);
+
+    /* Read the runtime counters of a coroute.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * rt : coroute
+     *     The coroute to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *rt, ctz_stats *out);
+}PyCoroute_Exported;
+
+#endif
@@ -0,0 +1,14 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/coroute.h":
+    ctypedef struct PyCoroute_Exported:
+        PyObject *(*new "new")(PyObject *keyfunc,
+                               PyObject *handlers,
+                               Py_ssize_t maxsize)
+        PyObject *(*send)(PyObject *rt, PyObject *value)
+        PyObject *(*throw)(PyObject *rt, PyObject *excinfo)
+        int (*close)(PyObject *rt)
+        int (*stats)(PyObject *rt, ctz_stats *out)
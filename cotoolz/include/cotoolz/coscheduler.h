@@ -0,0 +1,160 @@
+#ifndef COTOOLZ_COSCHEDULER_H
+#define COTOOLZ_COSCHEDULER_H
+
+#include <stdint.h>
+
+#include "stats.h"
+#include "version.h"
+
+/* The states of a cotask. */
+typedef enum {
+    COTASK_RUNNABLE = 0,        /* in the run queue */
+    COTASK_RUNNING,             /* being stepped */
+    COTASK_PARKED,              /* waiting for ``wake`` */
+    COTASK_DONE,                /* finished, raised, or closed */
+} cotask_state;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *tk_scheduler;     /* the coscheduler that spawned this task */
+    PyObject *tk_coroutine;     /* the coiter wrapped coroutine, NULL once
+                                   done */
+    PyObject *tk_value;         /* the value to send on the next step, NULL
+                                   for None */
+    PyObject *tk_result;        /* the value the coroutine returned */
+    PyObject *tk_exception;     /* the exception the coroutine raised */
+    uint64_t tk_steps;          /* the number of times this task has been
+                                   stepped */
+    cotask_state tk_state;
+    int tk_woken;               /* woken while running, so yielding park
+                                   does not park */
+} cotask;
+
+typedef struct {
+    PyObject_HEAD
+    cotask **sc_queue;          /* ring of runnable tasks, owned references */
+    Py_ssize_t sc_head;         /* the index of the next task to step */
+    Py_ssize_t sc_size;         /* the number of tasks in sc_queue */
+    Py_ssize_t sc_capacity;     /* the length of sc_queue, a power of two */
+    Py_ssize_t sc_batch;        /* steps per task before moving on */
+    Py_ssize_t sc_live;         /* tasks which are not done */
+    Py_ssize_t sc_parked;       /* tasks which are parked */
+    uint64_t sc_steps;          /* the number of steps ever taken */
+    int sc_running;             /* ``run`` is on the stack */
+    CTZ_STATS_FIELD(sc_stats)
+} coscheduler;
+
+extern PyTypeObject PyCotask_Type;
+extern PyTypeObject PyCoscheduler_Type;
+
+#define PyCotask_Check(obj)                                     \
+    PyObject_IsInstance(obj, (PyObject*) &PyCotask_Type)
+#define PyCoscheduler_Check(obj)                                \
+    PyObject_IsInstance(obj, (PyObject*) &PyCoscheduler_Type)
+
+typedef struct{
+
+    /* Construct a new coscheduler.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * batch : Py_ssize_t
+     *     The number of steps to give each task before moving on to the
+     *     next one.
+     *
+     * Returns
+     * -------
+     * sc : coscheduler
+     *     A new reference to a coscheduler.
+     */
+    PyObject *(*CTZ_NEW)(Py_ssize_t batch);
+
+    /* Add a coroutine to the run queue.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * sc : coscheduler
+     *     The scheduler to run the coroutine on.
+     * coroutine : iterable
+     *     The coroutine or iterator to step.
+     *
+     * Returns
+     * -------
+     * task : cotask
+     *     A new reference to the handle of the task.
+     */
+    PyObject *(*spawn)(PyObject *sc, PyObject *coroutine);
+
+    /* Step the runnable tasks.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * sc : coscheduler
+     *     The scheduler to run.
+     * max_steps : Py_ssize_t
+     *     The most steps to take, or -1 to run until no task is runnable.
+     *
+     * Returns
+     * -------
+     * steps : Py_ssize_t
+     *     The number of steps taken, -1 with an exception raised if a task
+     *     raised.
+     */
+    Py_ssize_t (*run)(PyObject *sc, Py_ssize_t max_steps);
+
+    /* Wake a parked task.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * task : cotask
+     *     The task to wake.
+     * value : any
+     *     The value to send into the task on its next step.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*wake)(PyObject *task, PyObject *value);
+
+    /* The sentinel a coroutine yields to park itself.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * park : any
+     *     A borrowed reference to the sentinel.
+     */
+    PyObject *(*park)(void);
+
+    /* Read the runtime counters of a coscheduler.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * sc : coscheduler
+     *     The scheduler to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *sc, ctz_stats *out);
+}PyCoscheduler_Exported;
+
+#endif
@@ -0,0 +1,13 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/coscheduler.h":
+    ctypedef struct PyCoscheduler_Exported:
+        PyObject *(*new "new")(Py_ssize_t batch)
+        PyObject *(*spawn)(PyObject *sc, PyObject *coroutine)
+        Py_ssize_t (*run)(PyObject *sc, Py_ssize_t max_steps)
+        int (*wake)(PyObject *task, PyObject *value)
+        PyObject *(*park)()
+        int (*stats)(PyObject *sc, ctz_stats *out)
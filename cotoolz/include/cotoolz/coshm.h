@@ -0,0 +1,191 @@
+#ifndef COTOOLZ_COSHM_H
+#define COTOOLZ_COSHM_H
+
+#include <stdint.h>
+
+#include "stats.h"
+#include "version.h"
+
+/* Identifies a buffer which has been laid out as a coshm ring. */
+#define COSHM_MAGIC 0x6d68736f636f7463ULL
+
+/* The number of bytes at the start of the buffer used by the header. */
+#define COSHM_HEADER_SIZE 256
+
+/* The length written in place of a record when the next record does not fit
+   before the end of the ring and starts again at offset 0. */
+#define COSHM_WRAP UINT32_MAX
+
+/* The layout of the start of a coshm buffer, shared by the processes.
+ *
+ * The ring follows the header. Each record is a 32 bit length followed by
+ * the payload starting at the next 8 byte boundary, padded out to a multiple
+ * of 8 bytes so the payloads are always contiguous and aligned.
+ *
+ * ``sh_head`` is only written by the source and ``sh_tail`` is only written
+ * by the sink. Both are free running byte offsets into the ring, so
+ * ``sh_tail - sh_head`` is the number of bytes in use. They are also used as
+ * process shared futex words.
+ *
+ * The layout uses C11 atomics so it is opaque to C++.
+ */
+#ifdef __cplusplus
+typedef struct coshm_header coshm_header;
+#else
+#include <stdatomic.h>
+
+typedef struct coshm_header {
+    uint64_t sh_magic;
+    uint32_t sh_capacity;                   /* the size of the ring in bytes,
+                                               a power of two */
+    char sh_pad0[64 - sizeof(uint64_t) - sizeof(uint32_t)];
+    _Atomic uint32_t sh_head;               /* the next byte to read */
+    char sh_pad1[64 - sizeof(uint32_t)];
+    _Atomic uint32_t sh_tail;               /* the next byte to write */
+    char sh_pad2[64 - sizeof(uint32_t)];
+    _Atomic uint32_t sh_consumer_waiting;
+    _Atomic uint32_t sh_producer_waiting;
+    _Atomic uint32_t sh_sink_closed;
+    _Atomic uint32_t sh_source_closed;
+    char sh_pad3[64 - 4 * sizeof(uint32_t)];
+} coshm_header;
+#endif
+
+typedef struct {
+    PyObject_HEAD
+    Py_buffer sk_buf;           /* the shared buffer */
+    coshm_header *sk_header;
+    char *sk_ring;
+    CTZ_STATS_FIELD(sk_stats)
+} coshm_sink;
+
+typedef struct {
+    PyObject_HEAD
+    Py_buffer sr_buf;           /* the shared buffer */
+    coshm_header *sr_header;
+    char *sr_ring;
+    PyObject *sr_view;          /* the memoryview of the record that has not
+                                   been acknowledged */
+    uint32_t sr_pending;        /* the size of that record in the ring */
+    char *sr_record;            /* the payload of that record */
+    uint32_t sr_length;         /* the length of that payload */
+    int sr_exporting;           /* sr_record may be exported */
+    Py_ssize_t sr_exports;      /* the number of live exports of sr_record */
+    CTZ_STATS_FIELD(sr_stats)
+} coshm_source;
+
+extern PyTypeObject PyCoshmSink_Type;
+extern PyTypeObject PyCoshmSource_Type;
+
+#define PyCoshmSink_Check(obj)                                  \
+    PyObject_IsInstance(obj, (PyObject*) &PyCoshmSink_Type)
+#define PyCoshmSource_Check(obj)                                \
+    PyObject_IsInstance(obj, (PyObject*) &PyCoshmSource_Type)
+
+typedef struct{
+
+    /* Lay out a buffer as an empty ring and attach both ends to it.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * buffer : any
+     *     A writable buffer, usually the ``buf`` of a
+     *     ``multiprocessing.shared_memory.SharedMemory``.
+     *
+     * Returns
+     * -------
+     * ends : tuple[coshm_sink, coshm_source]
+     *     A new reference to the two ends of the ring.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *buffer);
+
+    /* Write a payload into the ring, waiting while the ring is full.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * sink : coshm_sink
+     *     The sink end of the ring.
+     * value : any
+     *     A contiguous buffer to copy into the ring, or None to do nothing.
+     *
+     * Returns
+     * -------
+     * none : None
+     *     A new reference to None, NULL with StopIteration raised if either
+     *     end has been closed.
+     */
+    PyObject *(*send)(PyObject *sink, PyObject *value);
+
+    /* Acknowledge the last record and read the next one, waiting while the
+     * ring is empty.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * source : coshm_source
+     *     The source end of the ring.
+     *
+     * Returns
+     * -------
+     * view : memoryview
+     *     A new reference to a read only view of the payload in the ring,
+     *     NULL with StopIteration raised once the sink has been closed and
+     *     the ring is empty.
+     */
+    PyObject *(*recv)(PyObject *source);
+
+    /* Throw an exception into either end of a ring.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * end : coshm_sink or coshm_source
+     *     The end of the ring to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * y : any
+     *     Always NULL, the exception is raised.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *end, PyObject *excinfo);
+
+    /* Close either end of a ring.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *end);
+
+    /* Read the runtime counters of either end of a ring.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * end : coshm_sink or coshm_source
+     *     The end of the ring to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *end, ctz_stats *out);
+}PyCoshm_Exported;
+
+#endif
@@ -1,9 +1,308 @@
 #ifndef COTOOLZ_H
 #define COTOOLZ_H
 
+#include "coaggregate.h"
+#include "cochain.h"
+#include "cochannel.h"
 #include "coiter.h"
+#include "cointerleave.h"
 #include "comap.h"
+#include "comerge.h"
+#include "copartition.h"
+#include "copool.h"
+#include "coprefetch.h"
+#include "coroute.h"
+#include "coscheduler.h"
+#include "coshm.h"
+#include "cowindow.h"
 #include "cozip.h"
 #include "emptycoroutine.h"
+#include "stats.h"
+#include "version.h"
+
+/* Client side access to cotoolz ------------------------------------------- */
+
+/* The exported symbols and types of each cotoolz module.
+ * These are filled in by ``cotoolz_import``. Only coiter, comap, and cozip
+ * have their types imported, they are the ones ``cotoolz_send``,
+ * ``cotoolz_throw``, and ``cotoolz_close`` dispatch on.
+ */
+static PyCoiter_Exported *cotoolz_coiter_api = NULL;
+static PyComap_Exported *cotoolz_comap_api = NULL;
+static PyCozip_Exported *cotoolz_cozip_api = NULL;
+static PyCoaggregate_Exported *cotoolz_coaggregate_api = NULL;
+static PyCochain_Exported *cotoolz_cochain_api = NULL;
+static PyCochannel_Exported *cotoolz_cochannel_api = NULL;
+static PyCointerleave_Exported *cotoolz_cointerleave_api = NULL;
+static PyComerge_Exported *cotoolz_comerge_api = NULL;
+static PyCopartition_Exported *cotoolz_copartition_api = NULL;
+static PyCopool_Exported *cotoolz_copool_api = NULL;
+static PyCoprefetch_Exported *cotoolz_coprefetch_api = NULL;
+static PyCoroute_Exported *cotoolz_coroute_api = NULL;
+static PyCoscheduler_Exported *cotoolz_coscheduler_api = NULL;
+static PyCoshm_Exported *cotoolz_coshm_api = NULL;
+static PyCowindow_Exported *cotoolz_cowindow_api = NULL;
+static PyTypeObject *cotoolz_coiter_type = NULL;
+static PyTypeObject *cotoolz_comap_type = NULL;
+static PyTypeObject *cotoolz_cozip_type = NULL;
+
+/* Import the capsule of one module into ``*api``. If ``tpname`` is not NULL
+ * the type with that name is also looked up and stored into ``*type``.
+ */
+static inline int
+_cotoolz_import_one(const char *modname,
+                    const char *tpname,
+                    const char *capsule,
+                    void **api,
+                    PyTypeObject **type)
+{
+    PyObject *m;
+    PyObject *tp;
+    PyObject *version;
+    long v;
+
+    if (!(m = PyImport_ImportModule(modname))) {
+        return -1;
+    }
+    if (!(version = PyObject_GetAttrString(m, "_api_version"))) {
+        if (!PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            Py_DECREF(m);
+            return -1;
+        }
+        /* modules from before the API was versioned */
+        PyErr_Clear();
+        v = 1;
+    }
+    else {
+        v = PyLong_AsLong(version);
+        Py_DECREF(version);
+        if (v == -1 && PyErr_Occurred()) {
+            Py_DECREF(m);
+            return -1;
+        }
+    }
+    if (v < COTOOLZ_API_VERSION) {
+        PyErr_Format(PyExc_ImportError,
+                     "%s has API version %ld but this extension was compiled"
+                     " against version %d, upgrade cotoolz",
+                     modname,
+                     v,
+                     COTOOLZ_API_VERSION);
+        Py_DECREF(m);
+        return -1;
+    }
+    if (!tpname) {
+        Py_DECREF(m);
+        return (*api = PyCapsule_Import(capsule, 0)) ? 0 : -1;
+    }
+    tp = PyObject_GetAttrString(m, tpname);
+    Py_DECREF(m);
+    if (!tp) {
+        return -1;
+    }
+    if (!PyType_Check(tp)) {
+        PyErr_Format(PyExc_TypeError,
+                     "%s.%s is not a type",
+                     modname,
+                     tpname);
+        Py_DECREF(tp);
+        return -1;
+    }
+    if (!(*api = PyCapsule_Import(capsule, 0))) {
+        Py_DECREF(tp);
+        return -1;
+    }
+    /* The module keeps the type alive for the life of the interpreter. */
+    *type = (PyTypeObject*) tp;
+    Py_DECREF(tp);
+    return 0;
+}
+
+/* Import the C APIs of all of the cotoolz modules.
+ *
+ * This must be called before using any of the ``cotoolz_*`` functions, for
+ * example in the init function of the module using them. This fails with an
+ * ImportError if the installed cotoolz is older than the headers this was
+ * compiled against.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static inline int
+cotoolz_import(void)
+{
+    if (_cotoolz_import_one("cotoolz._coiter",
+                            "coiter",
+                            "cotoolz._coiter._exported_symbols",
+                            (void**) &cotoolz_coiter_api,
+                            &cotoolz_coiter_type) ||
+        _cotoolz_import_one("cotoolz._comap",
+                            "comap",
+                            "cotoolz._comap._exported_symbols",
+                            (void**) &cotoolz_comap_api,
+                            &cotoolz_comap_type) ||
+        _cotoolz_import_one("cotoolz._cozip",
+                            "cozip",
+                            "cotoolz._cozip._exported_symbols",
+                            (void**) &cotoolz_cozip_api,
+                            &cotoolz_cozip_type) ||
+        _cotoolz_import_one("cotoolz._coaggregate",
+                            NULL,
+                            "cotoolz._coaggregate._exported_symbols",
+                            (void**) &cotoolz_coaggregate_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._cochain",
+                            NULL,
+                            "cotoolz._cochain._exported_symbols",
+                            (void**) &cotoolz_cochain_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._cochannel",
+                            NULL,
+                            "cotoolz._cochannel._exported_symbols",
+                            (void**) &cotoolz_cochannel_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._cointerleave",
+                            NULL,
+                            "cotoolz._cointerleave._exported_symbols",
+                            (void**) &cotoolz_cointerleave_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._comerge",
+                            NULL,
+                            "cotoolz._comerge._exported_symbols",
+                            (void**) &cotoolz_comerge_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._copartition",
+                            NULL,
+                            "cotoolz._copartition._exported_symbols",
+                            (void**) &cotoolz_copartition_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._copool",
+                            NULL,
+                            "cotoolz._copool._exported_symbols",
+                            (void**) &cotoolz_copool_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._coprefetch",
+                            NULL,
+                            "cotoolz._coprefetch._exported_symbols",
+                            (void**) &cotoolz_coprefetch_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._coroute",
+                            NULL,
+                            "cotoolz._coroute._exported_symbols",
+                            (void**) &cotoolz_coroute_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._coscheduler",
+                            NULL,
+                            "cotoolz._coscheduler._exported_symbols",
+                            (void**) &cotoolz_coscheduler_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._coshm",
+                            NULL,
+                            "cotoolz._coshm._exported_symbols",
+                            (void**) &cotoolz_coshm_api,
+                            NULL) ||
+        _cotoolz_import_one("cotoolz._cowindow",
+                            NULL,
+                            "cotoolz._cowindow._exported_symbols",
+                            (void**) &cotoolz_cowindow_api,
+                            NULL)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Send a value into any coroutine.
+ *
+ * coiter, comap, and cozip objects are dispatched directly to their C
+ * implementation, anything else goes through ``ob.send(value)``.
+ *
+ * Returns
+ * -------
+ * y : any
+ *     A new reference to the next yielded value.
+ */
+static inline PyObject *
+cotoolz_send(PyObject *ob, PyObject *value)
+{
+    PyTypeObject *tp = Py_TYPE(ob);
+
+    if (tp == cotoolz_coiter_type) {
+        return cotoolz_coiter_api->send(ob, value);
+    }
+    if (tp == cotoolz_comap_type) {
+        return cotoolz_comap_api->PyComap_Send(ob, value);
+    }
+    if (tp == cotoolz_cozip_type) {
+        return cotoolz_cozip_api->send(ob, value);
+    }
+    return PyObject_CallMethod(ob, "send", "O", value);
+}
+
+/* Throw an exception into any coroutine.
+ *
+ * Paramaters
+ * ----------
+ * excinfo : tuple
+ *     The arguments to ``throw``.
+ *
+ * Returns
+ * -------
+ * y : any
+ *     A new reference to the next yielded value.
+ */
+static inline PyObject *
+cotoolz_throw(PyObject *ob, PyObject *excinfo)
+{
+    PyTypeObject *tp = Py_TYPE(ob);
+    PyObject *meth;
+    PyObject *ret;
+
+    if (tp == cotoolz_coiter_type) {
+        return cotoolz_coiter_api->CTZ_THROW(ob, excinfo);
+    }
+    if (tp == cotoolz_comap_type) {
+        return cotoolz_comap_api->PyComap_Throw(ob, excinfo);
+    }
+    if (tp == cotoolz_cozip_type) {
+        return cotoolz_cozip_api->CTZ_THROW(ob, excinfo);
+    }
+    if (!(meth = PyObject_GetAttrString(ob, "throw"))) {
+        return NULL;
+    }
+    ret = PyObject_Call(meth, excinfo, NULL);
+    Py_DECREF(meth);
+    return ret;
+}
+
+/* Close any coroutine.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, -1 on failure.
+ */
+static inline int
+cotoolz_close(PyObject *ob)
+{
+    PyTypeObject *tp = Py_TYPE(ob);
+    PyObject *ret;
+
+    if (tp == cotoolz_coiter_type) {
+        return cotoolz_coiter_api->close(ob) ? -1 : 0;
+    }
+    if (tp == cotoolz_comap_type) {
+        return cotoolz_comap_api->PyComap_Close(ob) ? -1 : 0;
+    }
+    if (tp == cotoolz_cozip_type) {
+        return cotoolz_cozip_api->close(ob) ? -1 : 0;
+    }
+    if (!(ret = PyObject_CallMethod(ob, "close", NULL))) {
+        return -1;
+    }
+    Py_DECREF(ret);
+    return 0;
+}
 
 #endif
@@ -0,0 +1,460 @@
+#ifndef COTOOLZ_HPP
+#define COTOOLZ_HPP
+
+/* Header-only C++14 interface to cotoolz.
+ *
+ * This provides:
+ *
+ * - ``cotoolz::ref``: a move-only owning reference to a Python object.
+ * - ``cotoolz::coroutine``, ``cotoolz::coiter``, ``cotoolz::comap``, and
+ *   ``cotoolz::cozip``: RAII handles over the cotoolz types.
+ * - Pipeline stages which compose native C++ callables with Python
+ *   coroutines, for example:
+ *
+ *       auto p = (cotoolz::native([](long a) { return a + 1; }) |
+ *                 cotoolz::python<long>(std::move(cr)) |
+ *                 cotoolz::native([](long a) { return a * 2; }));
+ *       long out = p(1);
+ *
+ *   Adjacent native stages are composed at compile time and inlined, Python
+ *   is only called at the ``python`` stages.
+ *
+ * ``cotoolz::import()`` must be called (with the GIL held) before using
+ * anything else in this header. Python errors are reported by throwing
+ * ``cotoolz::error`` with the Python exception still set;
+ * ``cotoolz::stop_iteration`` is thrown when a coroutine is exhausted.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <Python.h>
+
+#include "cotoolz.h"
+
+namespace cotoolz {
+
+/* A Python exception has been set. */
+class error : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "a Python exception was raised";
+    }
+};
+
+/* The coroutine is exhausted, ``StopIteration`` is set. */
+class stop_iteration : public error {
+public:
+    const char *what() const noexcept override {
+        return "StopIteration";
+    }
+};
+
+/* Throw the C++ exception which matches the currently set Python exception.
+ */
+[[noreturn]] inline void raise_current() {
+    if (PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        throw stop_iteration();
+    }
+    throw error();
+}
+
+/* A move-only owning reference to a Python object. */
+class ref {
+private:
+    PyObject *m_ob;
+
+    explicit ref(PyObject *ob) noexcept : m_ob(ob) {}
+
+public:
+    ref() noexcept : m_ob(nullptr) {}
+    ref(const ref&) = delete;
+    ref& operator=(const ref&) = delete;
+
+    ref(ref&& other) noexcept : m_ob(other.m_ob) {
+        other.m_ob = nullptr;
+    }
+
+    ref& operator=(ref&& other) noexcept {
+        if (this != &other) {
+            Py_XDECREF(m_ob);
+            m_ob = other.m_ob;
+            other.m_ob = nullptr;
+        }
+        return *this;
+    }
+
+    ~ref() {
+        Py_XDECREF(m_ob);
+    }
+
+    /* Take ownership of a new reference. */
+    static ref steal(PyObject *ob) noexcept {
+        return ref(ob);
+    }
+
+    /* Take ownership of a new reference, throwing if it is NULL. */
+    static ref checked(PyObject *ob) {
+        if (!ob) {
+            raise_current();
+        }
+        return ref(ob);
+    }
+
+    /* Create a new reference to a borrowed reference. */
+    static ref borrow(PyObject *ob) noexcept {
+        Py_XINCREF(ob);
+        return ref(ob);
+    }
+
+    /* Explicitly copy this reference. */
+    ref copy() const noexcept {
+        return borrow(m_ob);
+    }
+
+    PyObject *get() const noexcept {
+        return m_ob;
+    }
+
+    /* Give up ownership of the reference without decrementing it. */
+    PyObject *release() noexcept {
+        PyObject *ob = m_ob;
+        m_ob = nullptr;
+        return ob;
+    }
+
+    explicit operator bool() const noexcept {
+        return m_ob != nullptr;
+    }
+};
+
+/* Import the cotoolz C API. */
+inline void import() {
+    if (cotoolz_import()) {
+        raise_current();
+    }
+}
+
+/* Conversions between C++ and Python ------------------------------------ */
+
+template<typename T, typename = void>
+struct convert;
+
+template<>
+struct convert<ref> {
+    static ref to_python(ref&& ob) {
+        return std::move(ob);
+    }
+
+    static ref to_python(const ref& ob) {
+        return ob.copy();
+    }
+
+    static ref from_python(ref&& ob) {
+        return std::move(ob);
+    }
+};
+
+template<typename T>
+struct convert<T, typename std::enable_if<std::is_integral<T>::value &&
+                                          !std::is_same<T, bool>::value>::type> {
+    static ref to_python(T value) {
+        return ref::checked(PyLong_FromLongLong(value));
+    }
+
+    static T from_python(ref&& ob) {
+        long long value = PyLong_AsLongLong(ob.get());
+        if (value == -1 && PyErr_Occurred()) {
+            raise_current();
+        }
+        return static_cast<T>(value);
+    }
+};
+
+template<typename T>
+struct convert<T, typename std::enable_if<
+                      std::is_floating_point<T>::value>::type> {
+    static ref to_python(T value) {
+        return ref::checked(PyFloat_FromDouble(value));
+    }
+
+    static T from_python(ref&& ob) {
+        double value = PyFloat_AsDouble(ob.get());
+        if (value == -1.0 && PyErr_Occurred()) {
+            raise_current();
+        }
+        return static_cast<T>(value);
+    }
+};
+
+template<>
+struct convert<bool> {
+    static ref to_python(bool value) {
+        return ref::borrow(value ? Py_True : Py_False);
+    }
+
+    static bool from_python(ref&& ob) {
+        int value = PyObject_IsTrue(ob.get());
+        if (value < 0) {
+            raise_current();
+        }
+        return value;
+    }
+};
+
+template<>
+struct convert<std::string> {
+    static ref to_python(const std::string& value) {
+        return ref::checked(PyUnicode_FromStringAndSize(value.data(),
+                                                        value.size()));
+    }
+
+    static std::string from_python(ref&& ob) {
+        Py_ssize_t size;
+        const char *data = PyUnicode_AsUTF8AndSize(ob.get(), &size);
+        if (!data) {
+            raise_current();
+        }
+        return std::string(data, size);
+    }
+};
+
+template<typename T>
+ref to_python(T&& value) {
+    return convert<typename std::decay<T>::type>::to_python(
+        std::forward<T>(value));
+}
+
+template<typename T>
+T from_python(ref&& ob) {
+    return convert<T>::from_python(std::move(ob));
+}
+
+/* Handles --------------------------------------------------------------- */
+
+/* An owning handle to any object which implements the coroutine protocol.
+ * Sends into coiter, comap, and cozip objects call directly into their C
+ * implementation.
+ */
+class coroutine {
+protected:
+    ref m_ob;
+
+public:
+    coroutine() = default;
+    explicit coroutine(ref&& ob) noexcept : m_ob(std::move(ob)) {}
+
+    PyObject *get() const noexcept {
+        return m_ob.get();
+    }
+
+    ref release() noexcept {
+        return std::move(m_ob);
+    }
+
+    ref send(PyObject *value) {
+        return ref::checked(cotoolz_send(m_ob.get(), value));
+    }
+
+    ref send(const ref& value) {
+        return send(value.get());
+    }
+
+    ref next() {
+        return send(Py_None);
+    }
+
+    ref throw_(PyObject *excinfo) {
+        return ref::checked(cotoolz_throw(m_ob.get(), excinfo));
+    }
+
+    void close() {
+        if (cotoolz_close(m_ob.get())) {
+            raise_current();
+        }
+    }
+};
+
+class coiter : public coroutine {
+public:
+    using coroutine::coroutine;
+
+    /* Wrap an iterable in a new coiter. */
+    static coiter make(const ref& it) {
+        return coiter(ref::checked(cotoolz_coiter_api->new_(it.get())));
+    }
+};
+
+class comap : public coroutine {
+public:
+    using coroutine::coroutine;
+
+    /* Map ``func`` over the coroutines ``crs``. */
+    template<typename... Crs>
+    static comap make(const ref& func, const Crs&... crs) {
+        static_assert(sizeof...(Crs) > 0, "comap needs at least one coroutine");
+        return comap(ref::checked(cotoolz_comap_api->PyComap_New(
+            func.get(),
+            static_cast<Py_ssize_t>(sizeof...(Crs)),
+            crs.get()...)));
+    }
+};
+
+class cozip : public coroutine {
+public:
+    using coroutine::coroutine;
+
+    /* Zip together the coroutines ``crs``. */
+    template<typename... Crs>
+    static cozip make(const Crs&... crs) {
+        return cozip(ref::checked(cotoolz_cozip_api->new_(
+            static_cast<Py_ssize_t>(sizeof...(Crs)),
+            crs.get()...)));
+    }
+};
+
+/* Pipelines ------------------------------------------------------------- */
+
+struct stage_tag {};
+
+template<typename T>
+using is_stage = std::is_base_of<stage_tag, typename std::decay<T>::type>;
+
+/* A stage that calls a C++ callable. */
+template<typename F>
+class native_stage : public stage_tag {
+private:
+    F m_f;
+
+public:
+    explicit native_stage(F f) : m_f(std::move(f)) {}
+
+    template<typename T>
+    auto operator()(T&& value) -> decltype(m_f(std::forward<T>(value))) {
+        return m_f(std::forward<T>(value));
+    }
+};
+
+template<typename F>
+native_stage<typename std::decay<F>::type> native(F&& f) {
+    return native_stage<typename std::decay<F>::type>(std::forward<F>(f));
+}
+
+/* A stage that sends its input into a Python coroutine and converts the
+ * yielded value to ``Out``.
+ */
+template<typename Out = ref>
+class python_stage : public stage_tag {
+private:
+    coroutine m_cr;
+
+public:
+    explicit python_stage(coroutine&& cr) : m_cr(std::move(cr)) {}
+
+    template<typename T>
+    Out operator()(T&& value) {
+        ref in = to_python(std::forward<T>(value));
+        return from_python<Out>(m_cr.send(in));
+    }
+
+    coroutine& handle() noexcept {
+        return m_cr;
+    }
+};
+
+template<typename Out = ref>
+python_stage<Out> python(coroutine&& cr) {
+    return python_stage<Out>(std::move(cr));
+}
+
+template<typename Out = ref>
+python_stage<Out> python(ref&& ob) {
+    return python_stage<Out>(coroutine(std::move(ob)));
+}
+
+/* Two stages run one after the other. */
+template<typename A, typename B>
+class composed_stage : public stage_tag {
+private:
+    A m_a;
+    B m_b;
+
+public:
+    composed_stage(A a, B b) : m_a(std::move(a)), m_b(std::move(b)) {}
+
+    template<typename T>
+    auto operator()(T&& value)
+        -> decltype(m_b(m_a(std::forward<T>(value)))) {
+        return m_b(m_a(std::forward<T>(value)));
+    }
+};
+
+template<typename A,
+         typename B,
+         typename = typename std::enable_if<is_stage<A>::value &&
+                                            is_stage<B>::value>::type>
+composed_stage<typename std::decay<A>::type, typename std::decay<B>::type>
+operator|(A&& a, B&& b) {
+    return composed_stage<typename std::decay<A>::type,
+                          typename std::decay<B>::type>(std::forward<A>(a),
+                                                        std::forward<B>(b));
+}
+
+/* A pipeline pulling its input out of a Python iterator or coroutine. */
+template<typename In, typename Stage>
+class source_pipeline {
+private:
+    coroutine m_src;
+    Stage m_stage;
+
+public:
+    source_pipeline(coroutine&& src, Stage stage)
+        : m_src(std::move(src)), m_stage(std::move(stage)) {}
+
+    /* Pull the next value through the pipeline.
+     *
+     * Throws ``stop_iteration`` when the source is exhausted.
+     */
+    auto next() -> decltype(m_stage(std::declval<In>())) {
+        return m_stage(from_python<In>(m_src.next()));
+    }
+
+    /* Send a value into the source and run the result through the
+     * pipeline.
+     */
+    auto send(PyObject *value) -> decltype(m_stage(std::declval<In>())) {
+        return m_stage(from_python<In>(m_src.send(value)));
+    }
+
+    void close() {
+        m_src.close();
+    }
+};
+
+/* The start of a pipeline which pulls ``In`` values out of a coroutine. */
+template<typename In = ref>
+class source {
+private:
+    coroutine m_src;
+
+public:
+    explicit source(coroutine&& src) : m_src(std::move(src)) {}
+
+    template<typename Stage,
+             typename = typename std::enable_if<is_stage<Stage>::value>::type>
+    source_pipeline<In, typename std::decay<Stage>::type>
+    operator|(Stage&& stage) && {
+        return source_pipeline<In, typename std::decay<Stage>::type>(
+            std::move(m_src),
+            std::forward<Stage>(stage));
+    }
+};
+
+}  // namespace cotoolz
+
+#endif
@@ -0,0 +1,45 @@
+from cotoolz.coaggregate cimport PyCoaggregate_Exported
+from cotoolz.cochain cimport PyCochain_Exported
+from cotoolz.cochannel cimport PyCochannel_Exported
+from cotoolz.coiter cimport PyCoiter_Exported
+from cotoolz.cointerleave cimport PyCointerleave_Exported
+from cotoolz.comap cimport PyComap_Exported
+from cotoolz.comerge cimport PyComerge_Exported
+from cotoolz.copartition cimport PyCopartition_Exported
+from cotoolz.copool cimport PyCopool_Exported
+from cotoolz.coprefetch cimport PyCoprefetch_Exported
+from cotoolz.coroute cimport PyCoroute_Exported
+from cotoolz.coscheduler cimport PyCoscheduler_Exported
+from cotoolz.coshm cimport PyCoshm_Exported
+from cotoolz.cowindow cimport PyCowindow_Exported
+from cotoolz.cozip cimport PyCozip_Exported
+
+
+cdef extern from "cotoolz/cotoolz.h":
+    # Filled in by ``cotoolz_import``.
+    PyCoaggregate_Exported *cotoolz_coaggregate_api
+    PyCochain_Exported *cotoolz_cochain_api
+    PyCochannel_Exported *cotoolz_cochannel_api
+    PyCoiter_Exported *cotoolz_coiter_api
+    PyCointerleave_Exported *cotoolz_cointerleave_api
+    PyComap_Exported *cotoolz_comap_api
+    PyComerge_Exported *cotoolz_comerge_api
+    PyCopartition_Exported *cotoolz_copartition_api
+    PyCopool_Exported *cotoolz_copool_api
+    PyCoprefetch_Exported *cotoolz_coprefetch_api
+    PyCoroute_Exported *cotoolz_coroute_api
+    PyCoscheduler_Exported *cotoolz_coscheduler_api
+    PyCoshm_Exported *cotoolz_coshm_api
+    PyCowindow_Exported *cotoolz_cowindow_api
+    PyCozip_Exported *cotoolz_cozip_api
+
+    # Import the C APIs of all of the cotoolz modules. This must be called
+    # before using anything else declared here.
+    int cotoolz_import() except -1
+
+    # Call directly into the C implementation for coiter, comap, and cozip
+    # objects, falling back to the ``send``, ``throw``, and ``close``
+    # methods for anything else.
+    object cotoolz_send(object ob, object value)
+    object cotoolz_throw(object ob, tuple excinfo)
+    int cotoolz_close(object ob) except -1
@@ -0,0 +1,130 @@
+#ifndef COTOOLZ_COWINDOW_H
+#define COTOOLZ_COWINDOW_H
+
+#include "stats.h"
+#include "version.h"
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *wd_cr;            /* the coiter wrapped inner coroutine */
+    Py_ssize_t wd_size;         /* the number of values in a window */
+    Py_ssize_t wd_step;         /* the number of values pulled per step */
+    PyObject **wd_ring;         /* ring buffer of the last wd_size values */
+    Py_ssize_t wd_start;        /* the index of the oldest value in wd_ring */
+    Py_ssize_t wd_count;        /* the number of values in wd_ring */
+    int wd_view;                /* yield cowindow_view objects instead of
+                                   tuples */
+    PyObject *wd_res;           /* the last window yielded, recycled when
+                                   the caller has dropped it */
+    uint64_t wd_generation;     /* the number of windows produced */
+    CTZ_STATS_FIELD(wd_stats)
+} cowindow;
+
+/* A read-only sequence over the ring buffer of a cowindow.
+ *
+ * A view is only valid until the cowindow takes its next step.
+ */
+typedef struct {
+    PyObject_HEAD
+    cowindow *wv_window;
+    uint64_t wv_generation;     /* the generation of wv_window this views */
+} cowindow_view;
+
+extern PyTypeObject PyCowindow_Type;
+extern PyTypeObject PyCowindowView_Type;
+
+#define PyCowindow_Check(obj)                                   \
+    PyObject_IsInstance(obj, (PyObject*) &PyCowindow_Type)
+#define PyCowindow_CheckExact(obj) (Py_TYPE(obj) == &PyCowindow_Type)
+
+typedef struct{
+
+    /* Construct a new cowindow.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * cr : coroutine
+     *     The coroutine to window.
+     * size : Py_ssize_t
+     *     The number of values in each window.
+     * step : Py_ssize_t
+     *     The number of values to advance between windows.
+     *
+     * Returns
+     * -------
+     * wd : cowindow
+     *     A new reference to a cowindow.
+     */
+    PyObject *(*CTZ_NEW)(PyObject *cr, Py_ssize_t size, Py_ssize_t step);
+
+    /* Send a value into a cowindow.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * wd : cowindow
+     *     The cowindow to send the value into.
+     * value : any
+     *     The value to send into the inner coroutine.
+     *
+     * Returns
+     * -------
+     * window : tuple
+     *     A new reference to the next window.
+     */
+    PyObject *(*send)(PyObject *wd, PyObject *value);
+
+    /* Throw an exception into a cowindow.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * wd : cowindow
+     *     The cowindow to throw the exception into.
+     * excinfo : tuple
+     *     The arguments to ``throw``.
+     *
+     * Returns
+     * -------
+     * window : tuple
+     *     A new reference to the next window.
+     */
+    PyObject *(*CTZ_THROW)(PyObject *wd, PyObject *excinfo);
+
+    /* Close a cowindow.
+     * This closes the inner coroutine.
+     *
+     * Added in API version 3.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure.
+     */
+    int (*close)(PyObject *wd);
+
+    /* Read the runtime counters of a cowindow.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * wd : cowindow
+     *     The cowindow to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *wd, ctz_stats *out);
+}PyCowindow_Exported;
+
+#endif
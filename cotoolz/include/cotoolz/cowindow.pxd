@@ -0,0 +1,12 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/cowindow.h":
+    ctypedef struct PyCowindow_Exported:
+        PyObject *(*new "new")(PyObject *cr, Py_ssize_t size, Py_ssize_t step)
+        PyObject *(*send)(PyObject *wd, PyObject *value)
+        PyObject *(*throw)(PyObject *wd, PyObject *excinfo)
+        int (*close)(PyObject *wd)
+        int (*stats)(PyObject *wd, ctz_stats *out)
@@ -1,11 +1,38 @@
 #ifndef COTOOLZ_COZIP_H
 #define COTOOLZ_COZIP_H
 
+#include "stats.h"
+#include "version.h"
+
+/* How a cozip handles inner coroutines of different lengths. */
+typedef enum {
+    COZIP_SHORTEST = 0,  /* stop at the first exhausted coroutine, like zip */
+    COZIP_LONGEST,       /* fill in exhausted coroutines, like zip_longest */
+    COZIP_STRICT,        /* raise a ValueError if the lengths differ */
+} cozip_mode;
+
 typedef struct {
     PyObject_HEAD
     Py_ssize_t cz_tuplesize;
     PyObject *cz_crs;
     PyObject *cz_res;
+    cozip_mode cz_mode;
+    PyObject *cz_fillvalue;       /* the value for exhausted coroutines */
+    unsigned char *cz_finished;   /* bitmap of the exhausted coroutines */
+    Py_ssize_t cz_nfinished;      /* the number of bits set in cz_finished */
+    Py_ssize_t cz_nest;           /* the number of single-child cozips fused
+                                     around this one; each wraps the result
+                                     in another 1-tuple */
+    PyObject *cz_wrap;            /* the outermost 1-tuple of the last result
+                                     of a fused cozip, reused like cz_res */
+    int cz_done;                  /* no more values will be produced, set
+                                     when the cozip is exhausted or on
+                                     close */
+    int cz_closed;                /* close has been called */
+    PyTypeObject *cz_type;        /* the struct sequence type of the results
+                                     when the cozip was given ``names``, NULL
+                                     for plain tuples */
+    CTZ_STATS_FIELD(cz_stats)
 } cozip;
 
 extern PyTypeObject PyCozip_Type;
@@ -29,7 +56,7 @@ typedef struct{
      * cz : cozip
      *     A new reference to a cozip.
      */
-    PyObject *(*new)(Py_ssize_t n, ...);
+    PyObject *(*CTZ_NEW)(Py_ssize_t n, ...);
 
     /* Send a value into a cozip.
      *
@@ -75,10 +102,11 @@ typedef struct{
      *     In python:
      *     tuple(*map(methodcaller('throw', *excinfo), cz.cz_crs))
      */
-    PyObject *(*throw)(PyObject *cz, PyObject *excinfo);
+    PyObject *(*CTZ_THROW)(PyObject *cz, PyObject *excinfo);
 
     /* Close a cozip.
-     * This closes all of the inner coroutines.
+     * This closes all of the inner coroutines which are not already
+     * exhausted. Closing a cozip a second time does nothing.
      *
      * Returns
      * -------
@@ -86,6 +114,93 @@ typedef struct{
      *     zero on success, non-zero on failure.
      */
     int (*close)(PyObject *cz);
+
+    /* Read the runtime counters of a cozip.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * cz : cozip
+     *     The cozip to read the counters of.
+     * out : ctz_stats*
+     *     The struct to copy the counters into.
+     *
+     * Returns
+     * -------
+     * err : int
+     *     zero on success, non-zero on failure. This fails when cotoolz was
+     *     compiled without ``COTOOLZ_STATS``.
+     */
+    int (*stats)(PyObject *cz, ctz_stats *out);
+
+    /* Construct a new cozip from an array of coroutines.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * crs : PyObject**
+     *     The coroutines to zip together.
+     * n : Py_ssize_t
+     *     The number of coroutines.
+     *
+     * Returns
+     * -------
+     * cz : cozip
+     *     A new reference to a cozip.
+     */
+    PyObject *(*from_array)(PyObject **crs, Py_ssize_t n);
+
+    /* Send an array of values into a cozip one at a time.
+     *
+     * Added in API version 2.
+     *
+     * Paramaters
+     * ----------
+     * cz : cozip
+     *     The cozip to send the values into.
+     * values : PyObject**
+     *     The values to send in, in order.
+     * n : Py_ssize_t
+     *     The number of values to send.
+     * out : PyObject**
+     *     An array of at least ``n`` elements to write the new references to
+     *     the yielded values into.
+     *
+     * Returns
+     * -------
+     * count : Py_ssize_t
+     *     The number of values written into ``out``. If this is less than
+     *     ``n`` then an exception is set, for example StopIteration when the
+     *     cozip is exhausted.
+     */
+    Py_ssize_t (*send_n)(PyObject *cz,
+                         PyObject **values,
+                         Py_ssize_t n,
+                         PyObject **out);
+
+    /* Send a different value into each of the coroutines of a cozip.
+     *
+     * Added in API version 3.
+     *
+     * Paramaters
+     * ----------
+     * cz : cozip
+     *     The cozip to send the values into.
+     * values : PyObject**
+     *     One value for each coroutine, ``values[n]`` is sent into the
+     *     ``n``th coroutine.
+     * n : Py_ssize_t
+     *     The number of values. This must be the number of coroutines.
+     *
+     * Returns
+     * -------
+     * y : tuple
+     *     A new reference to the zipped results. Like ``send``, this reuses
+     *     the last result tuple if nothing else refers to it.
+     */
+    PyObject *(*send_each)(PyObject *cz, PyObject **values, Py_ssize_t n);
 }PyCozip_Exported;
 
 #endif
@@ -0,0 +1,18 @@
+from cpython.object cimport PyObject
+
+from cotoolz.stats cimport ctz_stats
+
+
+cdef extern from "cotoolz/cozip.h":
+    ctypedef struct PyCozip_Exported:
+        PyObject *(*new "new")(Py_ssize_t n, ...)
+        PyObject *(*send)(PyObject *cz, PyObject *value)
+        PyObject *(*throw)(PyObject *cz, PyObject *excinfo)
+        int (*close)(PyObject *cz)
+        int (*stats)(PyObject *cz, ctz_stats *out)
+        PyObject *(*from_array)(PyObject **crs, Py_ssize_t n)
+        Py_ssize_t (*send_n)(PyObject *cz,
+                             PyObject **values,
+                             Py_ssize_t n,
+                             PyObject **out)
+        PyObject *(*send_each)(PyObject *cz, PyObject **values, Py_ssize_t n)
@@ -0,0 +1,88 @@
+#ifndef COTOOLZ_FUSE_H
+#define COTOOLZ_FUSE_H
+
+/* Fusing nested nodes while they are being built.
+ *
+ * comap and cozip fuse an inner node into the node built around it only when
+ * nothing else can see the inner node. That is only known when the type is
+ * called with the interpreter's own stack as the arguments, so fusing is done
+ * from the types' ``tp_vectorcall`` and never from ``tp_new`` or the C API,
+ * where the caller may still hold a reference to the inner node.
+ */
+
+/* Whether an argument of a vectorcall is a temporary which only the caller's
+ * stack refers to.
+ *
+ * From 3.14 the interpreter may push borrowed references to local variables,
+ * so a named object can have a reference count of one while it is on the
+ * stack.
+ */
+static inline int
+_ctz_is_unique_temporary(PyObject *ob)
+{
+#if PY_VERSION_HEX >= 0x030E0000
+    return PyUnstable_Object_IsUniqueReferencedTemporary(ob);
+#else
+    return Py_REFCNT(ob) == 1;
+#endif
+}
+
+/* Build an object through ``tp_new`` from the arguments of a vectorcall.
+ *
+ * Paramaters
+ * ----------
+ * cls : PyTypeObject*
+ *     The type to build.
+ * args : PyObject *const*
+ *     The positional arguments followed by the values of the keyword
+ *     arguments.
+ * nargsf : size_t
+ *     The number of positional arguments, possibly with
+ *     ``PY_VECTORCALL_ARGUMENTS_OFFSET`` set.
+ * kwnames : tuple or NULL
+ *     The names of the keyword arguments.
+ *
+ * Returns
+ * -------
+ * ob : any
+ *     A new reference to the result of ``tp_new``.
+ */
+static inline PyObject *
+_ctz_vectorcall_new(PyTypeObject *cls,
+                    PyObject *const *args,
+                    size_t nargsf,
+                    PyObject *kwnames)
+{
+    Py_ssize_t nargs = PyVectorcall_NARGS(nargsf);
+    PyObject *argtuple;
+    PyObject *kwargs = NULL;
+    PyObject *ret = NULL;
+    Py_ssize_t n;
+
+    if (!(argtuple = PyTuple_New(nargs))) {
+        return NULL;
+    }
+    for (n = 0;n < nargs;++n) {
+        Py_INCREF(args[n]);
+        PyTuple_SET_ITEM(argtuple, n, args[n]);
+    }
+    if (kwnames && PyTuple_GET_SIZE(kwnames)) {
+        if (!(kwargs = PyDict_New())) {
+            goto error;
+        }
+        for (n = 0;n < PyTuple_GET_SIZE(kwnames);++n) {
+            if (PyDict_SetItem(kwargs,
+                               PyTuple_GET_ITEM(kwnames, n),
+                               args[nargs + n])) {
+                goto error;
+            }
+        }
+    }
+    ret = cls->tp_new(cls, argtuple, kwargs);
+error:
+    Py_DECREF(argtuple);
+    Py_XDECREF(kwargs);
+    return ret;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef COTOOLZ_FUTEX_H
+#define COTOOLZ_FUTEX_H
+
+/* Waiting on a 32 bit word for the lock-free rings in cochannel and coshm.
+ *
+ * On Linux these are futexes. Elsewhere ``_ctz_futex_wait`` polls the word
+ * and ``_ctz_futex_wake`` does nothing.
+ */
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* The longest a waiter sleeps before returning, in nanoseconds. Callers use
+   this to check for signals and for the other end going away. */
+#define CTZ_FUTEX_TIMEOUT_NS 50000000
+
+/* Sleep until ``*word`` is no longer ``expected``, a wake up, or
+ * ``CTZ_FUTEX_TIMEOUT_NS`` passes. This may also return spuriously. This
+ * must be called without the GIL.
+ *
+ * Paramaters
+ * ----------
+ * word : _Atomic uint32_t*
+ *     The word to wait on.
+ * expected : uint32_t
+ *     The value of ``*word`` to sleep while.
+ * shared : int
+ *     Whether ``word`` is in memory shared with another process.
+ */
+static inline void
+_ctz_futex_wait(_Atomic uint32_t *word, uint32_t expected, int shared)
+{
+#ifdef __linux__
+    struct timespec timeout = {0, CTZ_FUTEX_TIMEOUT_NS};
+
+    syscall(SYS_futex,
+            (uint32_t*) word,
+            shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE,
+            expected,
+            &timeout,
+            NULL,
+            0);
+#else
+    struct timespec nap = {0, 50000};
+    int n;
+
+    (void) shared;
+    for (n = 0;n < CTZ_FUTEX_TIMEOUT_NS / 50000;++n) {
+        if (atomic_load(word) != expected) {
+            return;
+        }
+        nanosleep(&nap, NULL);
+    }
+#endif
+}
+
+/* Wake everything waiting on ``word``.
+ *
+ * Paramaters
+ * ----------
+ * word : _Atomic uint32_t*
+ *     The word to wake the waiters of.
+ * shared : int
+ *     Whether ``word`` is in memory shared with another process.
+ */
+static inline void
+_ctz_futex_wake(_Atomic uint32_t *word, int shared)
+{
+#ifdef __linux__
+    syscall(SYS_futex,
+            (uint32_t*) word,
+            shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE,
+            INT_MAX,
+            NULL,
+            NULL,
+            0);
+#else
+    (void) word;
+    (void) shared;
+#endif
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef COTOOLZ_PROBES_H
+#define COTOOLZ_PROBES_H
+
+/* USDT probes on the send/throw/close paths.
+ *
+ * When cotoolz is compiled with ``COTOOLZ_USDT`` defined, each operation
+ * gets a ``cotoolz:<op>_entry`` and a ``cotoolz:<op>_return`` probe which
+ * can be attached to with bpftrace, perf, or systemtap. A probe which is not
+ * attached to costs a single nop.
+ *
+ * Entry probes take the arguments:
+ *     arg0 : PyObject*   The object being operated on.
+ *     arg1 : const char* The ``tp_name`` of the object's type.
+ *     arg2 : Py_ssize_t  The number of inner coroutines.
+ *
+ * Return probes take the same arguments followed by:
+ *     arg3 : PyObject*   The result of the operation, NULL on failure.
+ */
+
+#ifdef COTOOLZ_USDT
+
+#include <sys/sdt.h>
+
+#define CTZ_USDT_ENABLED 1
+#define CTZ_PROBE_ENTRY(op, ob, arity)                                  \
+    DTRACE_PROBE3(cotoolz,                                              \
+                  op ## _entry,                                         \
+                  (PyObject*) (ob),                                     \
+                  Py_TYPE(ob)->tp_name,                                 \
+                  (Py_ssize_t) (arity))
+#define CTZ_PROBE_RETURN(op, ob, arity, ret)                            \
+    DTRACE_PROBE4(cotoolz,                                              \
+                  op ## _return,                                        \
+                  (PyObject*) (ob),                                     \
+                  Py_TYPE(ob)->tp_name,                                 \
+                  (Py_ssize_t) (arity),                                 \
+                  (PyObject*) (ret))
+
+#else
+
+#define CTZ_USDT_ENABLED 0
+#define CTZ_PROBE_ENTRY(op, ob, arity) ((void) 0)
+#define CTZ_PROBE_RETURN(op, ob, arity, ret) ((void) 0)
+
+#endif
+
+#endif
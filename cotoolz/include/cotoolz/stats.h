@@ -0,0 +1,124 @@
+#ifndef COTOOLZ_STATS_H
+#define COTOOLZ_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/* Runtime counters for a single coroutine node.
+ *
+ * The counters only exist when cotoolz is compiled with ``COTOOLZ_STATS``
+ * defined. Otherwise both the instrumentation and the ``CTZ_STATS_FIELD`` of
+ * each node are compiled out, so the default build's objects are no larger
+ * than they would be without counters. The field is always the last member
+ * of a node's struct so the offsets of the other members are the same in
+ * both builds. Code outside of cotoolz should only read the counters
+ * through the ``stats`` entries of the exported APIs.
+ */
+typedef struct {
+    uint64_t st_sends;     /* number of calls to send (including next) */
+    uint64_t st_throws;    /* number of calls to throw */
+    uint64_t st_closes;    /* number of calls to close */
+    uint64_t st_stops;     /* number of times StopIteration was raised */
+    uint64_t st_child_ns;  /* nanoseconds spent in the inner coroutine(s) */
+    uint64_t st_func_ns;   /* nanoseconds spent in the mapped function */
+} ctz_stats;
+
+#ifdef COTOOLZ_STATS
+
+static inline uint64_t
+_ctz_stats_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+#define CTZ_STATS_ENABLED 1
+#define CTZ_STATS_FIELD(name) ctz_stats name;
+#define CTZ_STATS_PTR(stats) (&(stats))
+#define CTZ_STATS_CLEAR(stats) memset(&(stats), 0, sizeof(stats))
+#define CTZ_STATS_ADD(stats, field, n) ((stats).st_ ## field += (n))
+#define CTZ_STATS_DECL(start) uint64_t start = 0
+#define CTZ_STATS_INCR(stats, field) (++(stats).st_ ## field)
+#define CTZ_STATS_START(start) ((start) = _ctz_stats_now())
+#define CTZ_STATS_ELAPSED(stats, field, start)                          \
+    ((stats).st_ ## field ## _ns += _ctz_stats_now() - (start))
+#define CTZ_STATS_STOP(stats, ret)                                      \
+    do {                                                                \
+        if (!(ret) && PyErr_ExceptionMatches(PyExc_StopIteration)) {    \
+            ++(stats).st_stops;                                         \
+        }                                                               \
+    } while (0)
+
+#else
+
+#define CTZ_STATS_ENABLED 0
+#define CTZ_STATS_FIELD(name)
+#define CTZ_STATS_PTR(stats) NULL
+#define CTZ_STATS_CLEAR(stats) ((void) 0)
+#define CTZ_STATS_ADD(stats, field, n) ((void) 0)
+#define CTZ_STATS_DECL(start)
+#define CTZ_STATS_INCR(stats, field) ((void) 0)
+#define CTZ_STATS_START(start) ((void) 0)
+#define CTZ_STATS_ELAPSED(stats, field, start) ((void) 0)
+#define CTZ_STATS_STOP(stats, ret) ((void) 0)
+
+#endif
+
+/* Copy the counters out of ``stats`` into ``out``.
+ *
+ * Returns
+ * -------
+ * err : int
+ *     zero on success, non-zero on failure. This fails with a RuntimeError
+ *     when cotoolz was compiled without ``COTOOLZ_STATS``.
+ */
+static inline int
+_ctz_stats_copy(const ctz_stats *stats, ctz_stats *out)
+{
+    if (!CTZ_STATS_ENABLED) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cotoolz was compiled without COTOOLZ_STATS");
+        return 1;
+    }
+    *out = *stats;
+    return 0;
+}
+
+/* Build the dictionary returned from the ``stats`` methods. */
+static inline PyObject *
+_ctz_stats_as_dict(const ctz_stats *stats)
+{
+    ctz_stats st;
+
+    if (_ctz_stats_copy(stats, &st)) {
+        return NULL;
+    }
+    return Py_BuildValue("{sKsKsKsKsKsK}",
+                         "sends", (unsigned long long) st.st_sends,
+                         "throws", (unsigned long long) st.st_throws,
+                         "closes", (unsigned long long) st.st_closes,
+                         "stops", (unsigned long long) st.st_stops,
+                         "child_ns", (unsigned long long) st.st_child_ns,
+                         "func_ns", (unsigned long long) st.st_func_ns);
+}
+
+#define CTZ_STATS_DOC                                                   \
+    "Return the runtime counters for this node.\n"                      \
+    "\n"                                                                \
+    "Returns\n"                                                         \
+    "-------\n"                                                         \
+    "stats : dict\n"                                                    \
+    "    The number of ``sends``, ``throws``, ``closes`` and\n"         \
+    "    StopIterations (``stops``) along with the nanoseconds spent in\n" \
+    "    the inner coroutine(s) (``child_ns``) and in the mapped\n"     \
+    "    function (``func_ns``).\n"                                     \
+    "\n"                                                                \
+    "Raises\n"                                                          \
+    "------\n"                                                          \
+    "RuntimeError\n"                                                    \
+    "    Raised when cotoolz was compiled without ``COTOOLZ_STATS``.\n"
+
+#endif
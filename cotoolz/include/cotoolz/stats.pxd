@@ -0,0 +1,11 @@
+from libc.stdint cimport uint64_t
+
+
+cdef extern from "cotoolz/stats.h":
+    ctypedef struct ctz_stats:
+        uint64_t st_sends
+        uint64_t st_throws
+        uint64_t st_closes
+        uint64_t st_stops
+        uint64_t st_child_ns
+        uint64_t st_func_ns
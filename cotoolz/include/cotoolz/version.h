@@ -0,0 +1,32 @@
+#ifndef COTOOLZ_VERSION_H
+#define COTOOLZ_VERSION_H
+
+/* The version of the layout of the ``Py*_Exported`` structs.
+ *
+ * Entries are only ever appended to the exported symbol structs so that
+ * extension modules compiled against an older layout keep working. Each
+ * entry notes the version it was added in, and each module exposes the
+ * version it was compiled with as ``_api_version``. Code using an entry
+ * must check that the module's ``_api_version`` is at least the version
+ * the entry was added in; ``cotoolz_import`` does this for you.
+ *
+ * 1: new, send, throw, close
+ * 2: batched comap, stats, array constructors, send_n
+ * 3: send_each, the capsules of every module other than coiter, comap,
+ *    and cozip
+ */
+#define COTOOLZ_API_VERSION 3
+
+/* The names of the ``new`` and ``throw`` members of the exported symbol
+ * structs. These are keywords in C++ so C++ code sees them as ``new_`` and
+ * ``throw_``, the layout is the same either way.
+ */
+#ifdef __cplusplus
+#define CTZ_NEW new_
+#define CTZ_THROW throw_
+#else
+#define CTZ_NEW new
+#define CTZ_THROW throw
+#endif
+
+#endif
@@ -0,0 +1,144 @@
+/* Test module for cotoolz.hpp, built by test_hpp.py. */
+#include <vector>
+
+#include "cotoolz/cotoolz.hpp"
+
+namespace ctz = cotoolz;
+
+template<typename F>
+static PyObject *
+wrap(F f)
+{
+    try {
+        return f();
+    }
+    catch (const ctz::error&) {
+        return nullptr;
+    }
+}
+
+/* Pull ``n`` values out of ``src`` through two native stages. */
+static PyObject *
+native_only(PyObject *self, PyObject *args)
+{
+    PyObject *src;
+    Py_ssize_t n;
+
+    if (!PyArg_ParseTuple(args, "On", &src, &n)) {
+        return nullptr;
+    }
+    return wrap([&] {
+        auto p = (ctz::source<long>(ctz::coiter::make(ctz::ref::borrow(src))) |
+                  (ctz::native([](long a) { return a * 2; }) |
+                   ctz::native([](long a) { return a + 1; })));
+        ctz::ref out = ctz::ref::checked(PyList_New(0));
+        try {
+            for (Py_ssize_t m = 0; m < n; ++m) {
+                ctz::ref item = ctz::to_python(p.next());
+                if (PyList_Append(out.get(), item.get())) {
+                    throw ctz::error();
+                }
+            }
+        }
+        catch (const ctz::stop_iteration&) {
+            PyErr_Clear();
+        }
+        return out.release();
+    });
+}
+
+/* Send each value through ``native | python | native``. */
+static PyObject *
+mixed(PyObject *self, PyObject *args)
+{
+    PyObject *cr;
+    PyObject *values;
+
+    if (!PyArg_ParseTuple(args, "OO", &cr, &values)) {
+        return nullptr;
+    }
+    return wrap([&] {
+        auto p = (ctz::native([](long a) { return a + 1; }) |
+                  ctz::python<long>(ctz::ref::borrow(cr)) |
+                  ctz::native([](long a) { return std::to_string(a * 2); }));
+        ctz::ref out = ctz::ref::checked(PyList_New(0));
+        ctz::ref it = ctz::ref::checked(PyObject_GetIter(values));
+        while (ctz::ref value = ctz::ref::steal(PyIter_Next(it.get()))) {
+            ctz::ref item = ctz::to_python(
+                p(ctz::from_python<long>(std::move(value))));
+            if (PyList_Append(out.get(), item.get())) {
+                throw ctz::error();
+            }
+        }
+        if (PyErr_Occurred()) {
+            throw ctz::error();
+        }
+        return out.release();
+    });
+}
+
+/* Build ``comap(func, a, b)`` and ``cozip(a, b)`` through the handles. */
+static PyObject *
+handles(PyObject *self, PyObject *args)
+{
+    PyObject *func;
+    PyObject *a;
+    PyObject *b;
+
+    if (!PyArg_ParseTuple(args, "OOO", &func, &a, &b)) {
+        return nullptr;
+    }
+    return wrap([&] {
+        ctz::ref ra = ctz::ref::borrow(a);
+        ctz::ref rb = ctz::ref::borrow(b);
+        ctz::comap cm = ctz::comap::make(ctz::ref::borrow(func), ra, rb);
+        ctz::cozip cz = ctz::cozip::make(ra, rb);
+        return PyTuple_Pack(2, cm.get(), cz.get());
+    });
+}
+
+/* Send ``value`` into ``cr`` and then close it. */
+static PyObject *
+send_close(PyObject *self, PyObject *args)
+{
+    PyObject *cr;
+    PyObject *value;
+
+    if (!PyArg_ParseTuple(args, "OO", &cr, &value)) {
+        return nullptr;
+    }
+    return wrap([&] {
+        ctz::coroutine c(ctz::ref::borrow(cr));
+        ctz::ref out = c.send(value);
+        c.close();
+        return out.release();
+    });
+}
+
+static PyMethodDef methods[] = {
+    {"native_only", native_only, METH_VARARGS, ""},
+    {"mixed", mixed, METH_VARARGS, ""},
+    {"handles", handles, METH_VARARGS, ""},
+    {"send_close", send_close, METH_VARARGS, ""},
+    {nullptr},
+};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT,
+    "hpp_test",
+    "",
+    -1,
+    methods,
+};
+
+PyMODINIT_FUNC
+PyInit_hpp_test(void)
+{
+    try {
+        ctz::import();
+    }
+    catch (const ctz::error&) {
+        return nullptr;
+    }
+    return PyModule_Create(&module);
+}
@@ -0,0 +1,320 @@
+import subprocess
+import sys
+import textwrap
+
+import pytest
+
+import cotoolz
+from cotoolz import coiter, comap, cozip
+
+
+pytest.importorskip('Cython')
+
+
+SOURCE = '''
+from cpython.mem cimport PyMem_Free, PyMem_Malloc
+
+from cotoolz.cotoolz cimport (
+    cotoolz_close,
+    cotoolz_coaggregate_api,
+    cotoolz_cochain_api,
+    cotoolz_cochannel_api,
+    cotoolz_coiter_api,
+    cotoolz_cointerleave_api,
+    cotoolz_comap_api,
+    cotoolz_comerge_api,
+    cotoolz_copartition_api,
+    cotoolz_copool_api,
+    cotoolz_coprefetch_api,
+    cotoolz_coroute_api,
+    cotoolz_coscheduler_api,
+    cotoolz_coshm_api,
+    cotoolz_cowindow_api,
+    cotoolz_cozip_api,
+    cotoolz_import,
+    cotoolz_send,
+    cotoolz_throw,
+)
+
+cotoolz_import()
+
+
+def send(ob, value):
+    return cotoolz_send(ob, value)
+
+
+def throw(ob, *excinfo):
+    return cotoolz_throw(ob, excinfo)
+
+
+def close(ob):
+    cotoolz_close(ob)
+
+
+cdef extern from *:
+    """
+    static PyObject *steal(PyObject *ob) { return ob; }
+    """
+    # Take ownership of a new reference, raising if it is NULL.
+    object steal(PyObject *ob)
+
+
+def new_coiter(it):
+    return steal(cotoolz_coiter_api.new(<PyObject*> it))
+
+
+def imported():
+    return {
+        'coaggregate': cotoolz_coaggregate_api is not NULL,
+        'cochain': cotoolz_cochain_api is not NULL,
+        'cochannel': cotoolz_cochannel_api is not NULL,
+        'cointerleave': cotoolz_cointerleave_api is not NULL,
+        'comerge': cotoolz_comerge_api is not NULL,
+        'copartition': cotoolz_copartition_api is not NULL,
+        'copool': cotoolz_copool_api is not NULL,
+        'coprefetch': cotoolz_coprefetch_api is not NULL,
+        'coroute': cotoolz_coroute_api is not NULL,
+        'coscheduler': cotoolz_coscheduler_api is not NULL,
+        'coshm': cotoolz_coshm_api is not NULL,
+        'cowindow': cotoolz_cowindow_api is not NULL,
+    }
+
+
+def new_cochain(crs):
+    return steal(cotoolz_cochain_api.new(<PyObject*> crs))
+
+
+def from_array(func, *crs):
+    cdef Py_ssize_t n = len(crs)
+    cdef PyObject **arr = <PyObject**> PyMem_Malloc(n * sizeof(PyObject*))
+    cdef Py_ssize_t m
+    if arr is NULL:
+        raise MemoryError()
+    try:
+        for m in range(n):
+            arr[m] = <PyObject*> crs[m]
+        if func is None:
+            return steal(cotoolz_cozip_api.from_array(arr, n))
+        return steal(cotoolz_comap_api.PyComap_FromArray(
+            <PyObject*> func,
+            arr,
+            n,
+        ))
+    finally:
+        PyMem_Free(arr)
+
+
+def nest(func, it):
+    """Build ``comap(func, comap(func, it))``, or the same with cozip if
+    ``func`` is None, while still holding the only other reference to the
+    inner node.
+    """
+    cdef PyObject *itp = <PyObject*> it
+    cdef PyObject *inner
+    if func is None:
+        inner = cotoolz_cozip_api.from_array(&itp, 1)
+    else:
+        inner = cotoolz_comap_api.PyComap_FromArray(<PyObject*> func, &itp, 1)
+    inner_ob = steal(inner)
+    if func is None:
+        return steal(cotoolz_cozip_api.from_array(&inner, 1)), inner_ob
+    return steal(cotoolz_comap_api.PyComap_FromArray(
+        <PyObject*> func,
+        &inner,
+        1,
+    )), inner_ob
+
+
+def send_n(ob, values):
+    cdef Py_ssize_t n = len(values)
+    cdef PyObject **arr = <PyObject**> PyMem_Malloc(
+        2 * n * sizeof(PyObject*),
+    )
+    cdef PyObject **out = arr + n
+    cdef Py_ssize_t m
+    cdef Py_ssize_t count
+    if arr is NULL:
+        raise MemoryError()
+    try:
+        for m in range(n):
+            arr[m] = <PyObject*> values[m]
+        name = type(ob).__name__
+        if name == 'coiter':
+            count = cotoolz_coiter_api.send_n(<PyObject*> ob, arr, n, out)
+        elif name == 'comap':
+            count = cotoolz_comap_api.PyComap_SendN(
+                <PyObject*> ob,
+                arr,
+                n,
+                out,
+            )
+        else:
+            count = cotoolz_cozip_api.send_n(<PyObject*> ob, arr, n, out)
+        results = [steal(out[m]) for m in range(count)]
+        if count < n:
+            # raise the exception which stopped the sends
+            steal(NULL)
+        return results
+    finally:
+        PyMem_Free(arr)
+
+
+def send_each(ob, values):
+    cdef Py_ssize_t n = len(values)
+    cdef PyObject **arr = <PyObject**> PyMem_Malloc(n * sizeof(PyObject*))
+    cdef Py_ssize_t m
+    if arr is NULL:
+        raise MemoryError()
+    try:
+        for m in range(n):
+            arr[m] = <PyObject*> values[m]
+        if type(ob).__name__ == 'comap':
+            return steal(cotoolz_comap_api.PyComap_SendEach(
+                <PyObject*> ob,
+                arr,
+                n,
+            ))
+        return steal(cotoolz_cozip_api.send_each(<PyObject*> ob, arr, n))
+    finally:
+        PyMem_Free(arr)
+'''
+
+SETUP = '''
+from Cython.Build import cythonize
+from setuptools import setup, Extension
+
+setup(
+    ext_modules=cythonize(
+        [Extension('capi', ['capi.pyx'], include_dirs=[{include!r}])],
+        include_path=[{include!r}],
+        language_level=3,
+    ),
+)
+'''
+
+
+@pytest.fixture(scope='module')
+def capi(tmpdir_factory):
+    path = tmpdir_factory.mktemp('capi')
+    path.join('capi.pyx').write(
+        'from cpython.object cimport PyObject\n' + SOURCE,
+    )
+    path.join('setup.py').write(textwrap.dedent(SETUP).format(
+        include=cotoolz.get_include(),
+    ))
+    subprocess.check_call(
+        [sys.executable, 'setup.py', 'build_ext', '--inplace'],
+        cwd=str(path),
+        stdout=subprocess.DEVNULL,
+    )
+    sys.path.insert(0, str(path))
+    try:
+        import capi
+    finally:
+        sys.path.remove(str(path))
+    return capi
+
+
+def co():
+    yield (yield (yield 1))
+
+
+def co_throwable():
+    try:
+        yield 1
+    except Exception as e:
+        yield e
+
+
+@pytest.mark.parametrize('wrap,expected', [
+    (lambda c: c, 2),
+    (coiter, 2),
+    (lambda c: comap(lambda a: a, c), 2),
+    (cozip, (2,)),
+])
+def test_send(capi, wrap, expected):
+    cr = wrap(co())
+    next(cr)
+    assert capi.send(cr, 2) == expected
+
+
+def test_throw(capi):
+    e = ValueError()
+    for cr in co_throwable(), comap(lambda a: a, co_throwable()):
+        next(cr)
+        assert capi.throw(cr, e) is e
+
+    cz = cozip(co_throwable())
+    next(cz)
+    assert capi.throw(cz, e) == (e,)
+
+
+def test_close(capi):
+    for cr in coiter(co()), comap(int, co()), cozip(co()), co():
+        next(cr)
+        capi.close(cr)
+        assert tuple(cr) == ()
+
+
+def test_new(capi):
+    ci = capi.new_coiter((1, 2))
+    assert isinstance(ci, coiter)
+    assert tuple(ci) == (1, 2)
+
+
+def test_imported(capi):
+    assert capi.imported() == dict.fromkeys(capi.imported(), True)
+    assert len(capi.imported()) == 12
+
+
+def test_new_cochain(capi):
+    assert tuple(capi.new_cochain(((1, 2), (3,)))) == (1, 2, 3)
+
+
+def test_from_array(capi):
+    cm = capi.from_array(lambda a, b: a + b, (1, 2), (3, 4))
+    assert isinstance(cm, comap)
+    assert tuple(cm) == (4, 6)
+
+    cz = capi.from_array(None, (1, 2), (3, 4))
+    assert isinstance(cz, cozip)
+    assert tuple(cz) == ((1, 3), (2, 4))
+
+
+def test_c_api_never_fuses(capi):
+    cm, inner = capi.nest(str, range(3))
+    assert cm.fused == ()
+    assert cm.children[0].children[0] is inner
+    assert tuple(cm) == ('0', '1', '2')
+
+    cz, inner = capi.nest(None, range(2))
+    assert cz.fused == 0
+    assert cz.children[0].children[0] is inner
+    assert tuple(cz) == (((0,),), ((1,),))
+
+
+@pytest.mark.parametrize('wrap,expected', [
+    (coiter, [1, 2, 3]),
+    (lambda c: comap(lambda a: a, c), [1, 2, 3]),
+    (cozip, [(1,), (2,), (3,)]),
+])
+def test_send_n(capi, wrap, expected):
+    cr = wrap(co())
+    assert capi.send_n(cr, [None, 2, 3]) == expected
+
+    cr = wrap(co())
+    with pytest.raises(StopIteration):
+        capi.send_n(cr, [None, 2, 3, 4])
+
+
+@pytest.mark.parametrize('wrap,expected', [
+    (lambda *cs: comap(lambda *a: a, *cs), (2, 3)),
+    (cozip, (2, 3)),
+])
+def test_send_each(capi, wrap, expected):
+    cr = wrap(co(), co())
+    next(cr)
+    assert capi.send_each(cr, [2, 3]) == expected
+
+    with pytest.raises(ValueError):
+        capi.send_each(cr, [2])
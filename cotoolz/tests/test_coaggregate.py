@@ -0,0 +1,162 @@
+from array import array
+from fractions import Fraction
+import math
+import random
+import statistics
+
+import pytest
+
+from cotoolz import cocount, comax, comean, comin, cosum, covar, cozip
+
+
+def feed(sink, values):
+    ret = next(sink)
+    for value in values:
+        ret = sink.send(value)
+    return ret
+
+
+def floats(n, seed=0):
+    r = random.Random(seed)
+    return [r.uniform(-1e6, 1e6) for _ in range(n)]
+
+
+@pytest.mark.parametrize('values', [
+    [],
+    [1, 2, 3],
+    [2 ** 62, 2 ** 62, -5],
+    [1, 2.5, 3],
+    [0.1] * 10,
+    [True, True, 1],
+    [Fraction(1, 3), 1, 0.5],
+    [1e100, 1.0, -1e100],
+    floats(1000),
+])
+def test_cosum(values):
+    result = feed(cosum(), values)
+    if any(type(value) is float for value in values):
+        # floats use compensated summation so compare against fsum
+        assert type(result) is float
+        assert math.isclose(result, math.fsum(values), abs_tol=1e-9)
+    else:
+        assert result == sum(values)
+        assert type(result) is type(sum(values))
+
+
+def test_cosum_start():
+    assert feed(cosum(10), [1, 2]) == 13
+    assert feed(cosum(start=0.5), [1, 2]) == 3.5
+    assert feed(cosum([]), [[1], [2]]) == [1, 2]
+
+
+def test_cosum_type_error():
+    s = cosum()
+    next(s)
+    with pytest.raises(TypeError):
+        s.send('a')
+
+
+@pytest.mark.parametrize('values', [
+    [3, 1, 2],
+    [2.5, -1.0, 7.25],
+    [2 ** 70, 1, -2 ** 70],
+    ['b', 'a', 'c'],
+    [1, 1.0, True],
+    floats(1000),
+])
+def test_comin_comax(values):
+    assert feed(comin(), values) is min(values)
+    assert feed(comax(), values) is max(values)
+
+
+def test_comin_comax_empty():
+    assert next(comin()) is None
+    assert next(comax()) is None
+
+
+def test_cocount():
+    assert feed(cocount(), 'abc') == 3
+    assert feed(cocount(), [None, 1, None]) == 1
+
+
+@pytest.mark.parametrize('values', [
+    [1, 2, 3, 4],
+    [1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16],
+    floats(1000),
+])
+def test_comean_covar(values):
+    assert math.isclose(feed(comean(), values), statistics.fmean(values))
+    assert math.isclose(feed(covar(), values), statistics.pvariance(values))
+    assert math.isclose(
+        feed(covar(ddof=1), values),
+        statistics.variance(values),
+    )
+
+
+def test_comean_covar_empty():
+    assert next(comean()) is None
+    assert next(covar()) is None
+    assert feed(covar(ddof=1), [1]) is None
+    assert feed(covar(), [1]) == 0.0
+
+
+def test_covar_invalid_ddof():
+    with pytest.raises(ValueError):
+        covar(ddof=-1)
+
+
+@pytest.mark.parametrize('sink,reference', [
+    (cosum, sum),
+    (comin, min),
+    (comax, max),
+    (cocount, len),
+    (comean, statistics.fmean),
+    (covar, statistics.pvariance),
+])
+@pytest.mark.parametrize('chunk', [1, 3, 64, 1000])
+def test_send_many(sink, reference, chunk):
+    values = floats(1000)
+    s = sink()
+    for n in range(0, len(values), chunk):
+        ret = s.send_many(array('d', values[n:n + chunk]))
+    assert math.isclose(ret, reference(values), rel_tol=1e-9)
+
+    # the iterable path gives the same answer as the buffer path
+    assert math.isclose(sink().send_many(values), ret, rel_tol=1e-9)
+
+
+def test_send_many_mixed():
+    s = cosum()
+    s.send(1)
+    s.send_many(array('d', [0.5, 0.25]))
+    s.send_many([1, None, 2])
+    assert s.value == 4.75
+    assert s.count == 5
+
+    m = comin()
+    m.send(0)
+    assert m.send_many(array('d', [1.0, 2.0])) == 0
+    assert m.send_many(array('d', [-1.0])) == -1.0
+    assert m.send_many(array('i', [-5])) == -5
+
+
+def test_cozip_aggregates():
+    values = floats(100)
+    z = cozip(cosum(), comin(), comax(), cocount(), comean())
+    next(z)
+    for value in values:
+        ret = z.send(value)
+    assert ret[0] == sum(values)
+    assert ret[1:4] == (min(values), max(values), len(values))
+    assert math.isclose(ret[4], statistics.fmean(values))
+
+
+def test_throw_close():
+    s = cosum()
+    s.send(1)
+    with pytest.raises(ValueError):
+        s.throw(ValueError)
+    assert s.send(2) == 3
+    s.close()
+    assert s.value == 3
+    assert s.children == ()
@@ -0,0 +1,127 @@
+from itertools import chain, count, islice
+
+import pytest
+
+from cotoolz import cochain
+from cotoolz.tests.utils import recording
+
+
+def closing(values, closed):
+    try:
+        yield from values
+    finally:
+        closed.append(values)
+
+
+@pytest.mark.parametrize('inputs', [
+    (),
+    ('',),
+    ('ABC', 'D', 'EF'),
+    ('', 'ABC', '', '', 'DE', ''),
+    tuple(map(range, range(50))),
+])
+def test_cochain_chain(inputs):
+    assert list(cochain(*inputs)) == list(chain(*inputs))
+    assert list(cochain.from_iterable(inputs)) == list(
+        chain.from_iterable(inputs),
+    )
+
+
+def test_cochain_from_iterable_lazy():
+    pulled = []
+
+    def children():
+        for n in count():
+            pulled.append(n)
+            yield range(n, n + 2)
+
+    ch = cochain.from_iterable(children())
+    assert list(islice(ch, 5)) == [0, 1, 1, 2, 2]
+    assert pulled == [0, 1, 2]
+
+
+def test_cochain_send_forwards():
+    a = []
+    b = []
+    ch = cochain(recording((1, 2), a), recording((3, 4), b))
+    assert next(ch) == 1
+    assert ch.send('a1') == 2
+    # a is exhausted by this send so b is started with None
+    assert ch.send('a2') == 3
+    assert ch.send('b3') == 4
+    with pytest.raises(StopIteration):
+        ch.send('b4')
+    assert a == ['a1', 'a2']
+    assert b == ['b3', 'b4']
+
+
+def test_cochain_throw():
+    def handles():
+        try:
+            yield 1
+        except ValueError:
+            yield 'handled'
+        try:
+            yield 2
+        except ValueError:
+            pass
+
+    ch = cochain(handles(), 'AB')
+    assert next(ch) == 1
+    assert ch.throw(ValueError) == 'handled'
+    assert next(ch) == 2
+    # handles finishes by handling this throw so the chain moves on
+    assert ch.throw(ValueError) == 'A'
+    with pytest.raises(ValueError):
+        ch.throw(ValueError)
+    with pytest.raises(KeyError):
+        cochain('AB').throw(KeyError)
+
+
+def test_cochain_close():
+    closed = []
+    a = closing('ab', closed)
+    b = closing('cd', closed)
+    c = closing('ef', closed)
+    ch = cochain(a, b, c)
+    assert next(ch) == 'a'
+    ch.close()
+    # b and c were never started so only a runs its finally block
+    assert closed == ['ab']
+    for cr in (b, c):
+        with pytest.raises(StopIteration):
+            next(cr)
+    with pytest.raises(StopIteration):
+        next(ch)
+
+
+def test_cochain_close_from_iterable():
+    closed = []
+
+    def children():
+        try:
+            while True:
+                yield 'ab'
+        finally:
+            closed.append(True)
+
+    ch = cochain.from_iterable(children())
+    assert next(ch) == 'a'
+    ch.close()
+    assert closed == [True]
+
+
+def test_cochain_not_iterable():
+    ch = cochain('a', 1)
+    assert next(ch) == 'a'
+    with pytest.raises(TypeError):
+        next(ch)
+
+
+def test_cochain_children():
+    ch = cochain('ab', 'c')
+    assert ch.children == ()
+    next(ch)
+    children = ch.children
+    assert len(children) == 1
+    assert list(children[0]) == ['b']
@@ -0,0 +1,200 @@
+import gc
+import sys
+import threading
+import time
+import weakref
+
+import pytest
+
+from cotoolz import cochannel, comap, cozip
+
+
+def producer(sink, values):
+    def run():
+        for value in values:
+            sink.send(value)
+        sink.close()
+
+    thread = threading.Thread(target=run)
+    thread.start()
+    return thread
+
+
+@pytest.mark.parametrize('capacity', [1, 2, 7, 1024])
+def test_cochannel_values(capacity):
+    sink, source = cochannel(capacity)
+    thread = producer(sink, range(10000))
+    assert list(source) == list(range(10000))
+    thread.join()
+
+
+def test_cochannel_capacity():
+    sink, source = cochannel(5)
+    assert sink.capacity == source.capacity == 8
+    assert cochannel()[0].capacity == 1024
+    with pytest.raises(ValueError):
+        cochannel(0)
+    with pytest.raises(OverflowError):
+        cochannel(1 << 40)
+
+
+def test_cochannel_same_thread():
+    sink, source = cochannel(4)
+    for n in range(4):
+        assert sink.send(n) is None
+    assert source.size == 4
+    assert [next(source) for _ in range(4)] == [0, 1, 2, 3]
+    assert source.size == 0
+
+
+def test_cochannel_sink_close_drains():
+    sink, source = cochannel(4)
+    sink.send('a')
+    sink.send('b')
+    sink.close()
+    with pytest.raises(StopIteration):
+        sink.send('c')
+    assert list(source) == ['a', 'b']
+    with pytest.raises(StopIteration):
+        next(source)
+
+
+def test_cochannel_source_close():
+    sink, source = cochannel(4)
+    sink.send('a')
+    source.close()
+    with pytest.raises(StopIteration):
+        sink.send('b')
+    with pytest.raises(StopIteration):
+        next(source)
+
+
+def test_cochannel_full_blocks():
+    sink, source = cochannel(2)
+    sent = []
+
+    def run():
+        for n in range(4):
+            sink.send(n)
+            sent.append(n)
+
+    thread = threading.Thread(target=run)
+    thread.start()
+    time.sleep(0.05)
+    assert sent == [0, 1]
+    assert next(source) == 0
+    assert next(source) == 1
+    thread.join(5)
+    assert not thread.is_alive()
+    assert sent == [0, 1, 2, 3]
+
+
+def test_cochannel_empty_blocks_until_close():
+    sink, source = cochannel(2)
+    result = []
+
+    thread = threading.Thread(target=lambda: result.extend(source))
+    thread.start()
+    time.sleep(0.05)
+    assert thread.is_alive()
+    sink.send(1)
+    sink.close()
+    thread.join(5)
+    assert not thread.is_alive()
+    assert result == [1]
+
+
+def test_cochannel_close_wakes_blocked_sink():
+    sink, source = cochannel(1)
+    sink.send(0)
+    raised = []
+
+    def run():
+        try:
+            sink.send(1)
+        except StopIteration:
+            raised.append(True)
+
+    thread = threading.Thread(target=run)
+    thread.start()
+    time.sleep(0.05)
+    source.close()
+    thread.join(5)
+    assert raised == [True]
+
+
+def test_cochannel_dealloc_releases_values():
+    class Obj:
+        pass
+
+    ob = Obj()
+    sink, source = cochannel(4)
+    sink.send(ob)
+    del sink, source
+    assert sys.getrefcount(ob) == 2
+
+
+def test_cochannel_second_sender_raises():
+    sink, source = cochannel(1)
+    sink.send(0)
+
+    thread = threading.Thread(target=sink.send, args=(1,))
+    thread.start()
+    time.sleep(0.05)
+    with pytest.raises(RuntimeError):
+        sink.send(2)
+    assert next(source) == 0
+    thread.join(5)
+    assert not thread.is_alive()
+    assert next(source) == 1
+
+
+class Holder:
+    pass
+
+
+def test_cochannel_cycle_through_ring_collected():
+    sink, source = cochannel(4)
+    ob = Holder()
+    ob.ends = sink, source
+    sink.send(ob)
+    ref = weakref.ref(ob)
+    del sink, source, ob
+    gc.collect()
+    assert ref() is None
+
+
+def test_cochannel_cycle_through_sink_collected():
+    # once the source is gone the sink owns the values left in the ring
+    sink, source = cochannel(4)
+    ob = Holder()
+    ob.sink = sink
+    sink.send(ob)
+    ref = weakref.ref(ob)
+    del source, sink, ob
+    gc.collect()
+    assert ref() is None
+
+
+def test_cochannel_throw():
+    sink, source = cochannel(4)
+    sink.send(1)
+    with pytest.raises(KeyError):
+        sink.throw(KeyError)
+    with pytest.raises(ValueError):
+        source.throw(ValueError('source'))
+    assert next(source) == 1
+
+
+def test_cochannel_in_comap_and_cozip():
+    sink, source = cochannel(8)
+    thread = producer(sink, range(5))
+    assert list(comap(lambda a: a * 2, source)) == [0, 2, 4, 6, 8]
+    thread.join()
+
+    a_sink, a_source = cochannel(8)
+    b_sink, b_source = cochannel(8)
+    threads = [producer(a_sink, 'abc'), producer(b_sink, range(3))]
+    assert list(cozip(a_source, b_source)) == [('a', 0), ('b', 1), ('c', 2)]
+    for thread in threads:
+        thread.join()
@@ -0,0 +1,105 @@
+from itertools import count, cycle, islice
+
+import pytest
+
+from cotoolz import cointerleave
+from cotoolz.tests.utils import recording
+
+
+def roundrobin(*iterables):
+    # the itertools recipe
+    num_active = len(iterables)
+    nexts = cycle(iter(it).__next__ for it in iterables)
+    while num_active:
+        try:
+            for next in nexts:
+                yield next()
+        except StopIteration:
+            num_active -= 1
+            nexts = cycle(islice(nexts, num_active))
+
+
+@pytest.mark.parametrize('inputs', [
+    (),
+    ('',),
+    ('ABC', 'D', 'EF'),
+    ('AB', 'CDE', 'FG', 'H'),
+    ('', 'ABC', '', 'DE'),
+    tuple(map(range, range(50))),
+])
+def test_cointerleave_roundrobin(inputs):
+    assert list(cointerleave(*inputs)) == list(roundrobin(*inputs))
+
+
+def test_cointerleave_many():
+    inputs = [range(n % 7) for n in range(5000)]
+    assert list(cointerleave(*inputs)) == list(roundrobin(*inputs))
+
+
+def test_cointerleave_send_routes_to_advanced():
+    a = []
+    b = []
+    il = cointerleave(recording((1, 2, 3), a), recording((4,), b))
+    assert next(il) == 1
+    assert next(il) == 4
+    assert il.send('a1') == 2
+    # b is exhausted by this send so a is advanced in its place
+    assert il.send('b4') == 3
+    with pytest.raises(StopIteration):
+        il.send('a3')
+    assert a == ['a1', 'b4', 'a3']
+    assert b == ['b4']
+
+
+def test_cointerleave_throw():
+    def co():
+        try:
+            yield 1
+        except ValueError as e:
+            yield e
+
+    il = cointerleave(co(), co())
+    assert next(il) == 1
+    assert next(il) == 1
+    e = ValueError()
+    assert il.throw(e) is e
+
+
+def test_cointerleave_error_drops():
+    def bad():
+        yield 1
+        raise ValueError()
+
+    il = cointerleave(bad(), 'ab')
+    assert next(il) == 1
+    assert next(il) == 'a'
+    with pytest.raises(ValueError):
+        next(il)
+    assert list(il) == ['b']
+
+
+def test_cointerleave_close():
+    def co():
+        yield from count()
+
+    a = co()
+    b = co()
+    il = cointerleave(a, b)
+    assert next(il) == 0
+    il.close()
+    assert a.gi_frame is None
+    assert b.gi_frame is None
+    with pytest.raises(StopIteration):
+        next(il)
+
+
+def test_cointerleave_bad_args():
+    with pytest.raises(TypeError):
+        cointerleave(1)
+
+    with pytest.raises(TypeError):
+        cointerleave((), kwarg=1)
+
+
+def test_cointerleave_children():
+    assert len(cointerleave((1,), (2,)).children) == 2
@@ -67,3 +67,312 @@ def test_comap_close():
     assert next(cm) == 1
     cm.close()
     assert tuple(cm) == ()
+
+
+def counter():
+    n = 0
+    while True:
+        sent = yield n
+        n = n + 1 if sent is None else sent
+
+
+def test_comap_batch():
+    calls = []
+
+    def f(*batches):
+        calls.append(batches)
+        return [sum(vs) for vs in zip(*batches)]
+
+    cm = comap(f, range(5), range(5), batch=2)
+    assert tuple(cm) == (0, 2, 4, 6, 8)
+    assert calls == [
+        ([0, 1], [0, 1]),
+        ([2, 3], [2, 3]),
+        ([4], [4]),
+    ]
+
+
+def test_comap_batch_no_flatten():
+    cm = comap(tuple, range(5), batch=2, flatten=False)
+    assert tuple(cm) == ((0, 1), (2, 3), (4,))
+
+
+def test_comap_batch_send():
+    cm = comap(lambda vs: [v * 2 for v in vs], counter(), batch=3)
+    assert next(cm) == 0
+    # the sent value is ignored until the current batch is finished
+    assert cm.send(10) == 2
+    assert cm.send(10) == 4
+    # the sent value is forwarded into the first step of the next batch
+    assert cm.send(10) == 20
+    assert next(cm) == 22
+
+    dm = comap(list, counter(), batch=3, flatten=False)
+    assert next(dm) == [0, 1, 2]
+    assert dm.send(10) == [10, 11, 12]
+
+
+def test_comap_batch_throw():
+    cm = comap(list, co_throwable(), batch=2, flatten=False)
+    assert next(cm) == [1]
+    e = ValueError()
+    with pytest.raises(ValueError) as exc:
+        cm.throw(e)
+    assert exc.value is e
+
+
+def test_comap_batch_empty():
+    cm = comap(lambda vs: [v for v in vs if v % 3 == 0], range(10), batch=2)
+    assert tuple(cm) == (0, 3, 6, 9)
+
+
+def test_comap_batch_invalid():
+    with pytest.raises(ValueError):
+        comap(identity, (1, 2, 3), batch=-1)
+
+
+def test_comap_fuse():
+    cm = comap(op.add(1), comap(op.mul(2), comap(op.add, co(), co())))
+    assert cm.fused == (op.add, op.mul(2))
+    assert cm.func == op.add(1)
+    assert len(cm.children) == 2
+    assert next(cm) == 5
+    assert cm.send(3) == 13
+
+    # a comap which is referenced elsewhere is left alone
+    inner = comap(op.mul(2), co())
+    cm = comap(op.add(1), inner)
+    assert cm.fused == ()
+    assert cm.children[0].children[0] is inner
+    assert next(cm) == 3
+
+    # batched comaps are never fused
+    cm = comap(op.add(1), comap(sum, range(4), batch=2, flatten=False))
+    assert cm.fused == ()
+    assert tuple(cm) == (2, 6)
+
+
+def test_comap_fuse_throw_and_close():
+    cm = comap(identity, comap(identity, co_throwable()))
+    assert cm.fused == (identity,)
+    assert next(cm) == 1
+    e = ValueError()
+    assert cm.throw(e) is e
+
+    closed = []
+
+    def closing():
+        try:
+            yield 1
+            yield 2  # pragma: no cover
+        finally:
+            closed.append(True)
+
+    cm = comap(op.add(1), comap(op.mul(2), closing()))
+    assert next(cm) == 3
+    cm.close()
+    assert closed == [True]
+    assert tuple(cm) == ()
+
+
+def test_comap_fuse_matches_unfused():
+    def fail_at_3(a):
+        if a == 3:
+            raise KeyError(a)
+        return a
+
+    def run(make):
+        out = []
+        try:
+            for a in make():
+                out.append(a)
+        except KeyError as e:
+            out.append(e.args)
+        return out
+
+    def fused():
+        return comap(str, comap(fail_at_3, range(10)))
+
+    def unfused():
+        inner = comap(fail_at_3, range(10))
+        return comap(str, inner)
+
+    assert fused().fused == (fail_at_3,)
+    assert unfused().fused == ()
+    assert run(fused) == run(unfused) == ['0', '1', '2', (3,)]
+
+
+def test_comap_fuse_stop_iteration_matches_unfused():
+    def stop_at_3(a):
+        if a == 3:
+            raise StopIteration
+        return a
+
+    def run(make):
+        cm = make()
+        out = list(cm)
+        return out, cm.finished, list(cm)
+
+    def fused():
+        return comap(str, comap(stop_at_3, range(10)))
+
+    def unfused():
+        inner = comap(stop_at_3, range(10))
+        return comap(str, inner)
+
+    def unfused_star():
+        crs = [comap(stop_at_3, range(10))]
+        return comap(str, *crs)
+
+    assert fused().fused == (stop_at_3,)
+    assert unfused().fused == ()
+    assert unfused_star().fused == ()
+    assert (
+        run(fused) ==
+        run(unfused) ==
+        run(unfused_star) ==
+        (['0', '1', '2'], True, [])
+    )
+
+
+class Child:
+    """A coroutine which records every call made on it and is exhausted
+    after ``n`` sends.
+    """
+    def __init__(self, n, close_error=None):
+        self.n = n
+        self.calls = []
+        self.close_error = close_error
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        return self.send(None)
+
+    def send(self, value):
+        self.calls.append('send')
+        if len(self.calls) > self.n:
+            raise StopIteration
+        return value
+
+    def throw(self, e):
+        self.calls.append('throw')
+        raise e
+
+    def close(self):
+        self.calls.append('close')
+        if self.close_error is not None:
+            raise self.close_error
+
+
+def test_comap_finished():
+    a = Child(5)
+    b = Child(1)
+    cm = comap(lambda *a: a, a, b)
+    assert not cm.finished
+    assert cm.send(1) == (1, 1)
+    with pytest.raises(StopIteration):
+        next(cm)
+    assert cm.finished
+    calls = a.calls[:], b.calls[:]
+
+    # a finished comap does not step its coroutines again
+    with pytest.raises(StopIteration):
+        cm.send(2)
+    assert tuple(cm) == ()
+    e = ValueError()
+    with pytest.raises(ValueError) as exc:
+        cm.throw(e)
+    assert exc.value is e
+    assert (a.calls, b.calls) == calls
+
+    # only the coroutine which is not exhausted is closed
+    cm.close()
+    assert a.calls[-1] == 'close'
+    assert b.calls == calls[1]
+
+
+def test_comap_finished_batch():
+    a = Child(3)
+    cm = comap(identity, a, batch=2)
+    assert list(cm) == [None, None, None]
+    assert cm.finished
+    calls = len(a.calls)
+    assert tuple(cm) == ()
+    assert len(a.calls) == calls
+
+    cm = comap(identity, Child(3), batch=2, flatten=False)
+    assert list(cm) == [[None, None], [None]]
+    assert cm.finished
+
+
+def test_comap_close_idempotent():
+    a = Child(5)
+    cm = comap(identity, a)
+    assert next(cm) is None
+    cm.close()
+    cm.close()
+    assert a.calls == ['send', 'close']
+    assert cm.finished
+    with pytest.raises(StopIteration):
+        cm.send(None)
+
+
+def test_comap_close_error(monkeypatch):
+    unraisable = []
+    monkeypatch.setattr('sys.unraisablehook', unraisable.append)
+    children = [
+        Child(5, KeyError('a')),
+        Child(5),
+        Child(5, KeyError('c')),
+    ]
+    cm = comap(lambda *a: a, *children)
+    next(cm)
+    # the coroutines are closed last to first, the first error is raised
+    with pytest.raises(KeyError, match='c'):
+        cm.close()
+    assert all(child.calls[-1] == 'close' for child in children)
+    assert len(unraisable) == 1
+    assert unraisable[0].exc_value.args == ('a',)
+    assert cm.finished
+    cm.close()
+
+
+def test_comap_send_each():
+    cm = comap(lambda *a: a, co(), co(), co())
+    assert next(cm) == (1, 1, 1)
+    assert cm.send_each((2, 3, 4)) == (2, 3, 4)
+    assert cm.send_each([5, 6, 7]) == (5, 6, 7)
+    with pytest.raises(StopIteration):
+        cm.send_each((8, 9, 10))
+    assert cm.finished
+
+
+def test_comap_send_each_invalid():
+    cm = comap(op.add, co(), co())
+    with pytest.raises(ValueError):
+        cm.send_each((1,))
+    with pytest.raises(ValueError):
+        cm.send_each((1, 2, 3))
+    with pytest.raises(TypeError):
+        cm.send_each(1)
+    # nothing was sent in
+    assert next(cm) == 2
+
+
+def test_comap_send_each_batch():
+    a = counter()
+    b = counter()
+    next(a)
+    next(b)
+    cm = comap(
+        lambda a, b: [x + y for x, y in zip(a, b)],
+        a,
+        b,
+        batch=2,
+    )
+    assert cm.send_each((10, 20)) == 30
+    # the rest of the batch ignores the values
+    assert cm.send_each((0, 0)) == 32
+    assert cm.send_each((0, 100)) == 100
@@ -0,0 +1,160 @@
+import heapq
+from itertools import count
+import random
+
+import pytest
+
+from cotoolz import comerge
+from cotoolz.tests.utils import recording
+
+
+def co(values):
+    """Yield ``values`` in order and record what was sent in.
+    """
+    sent = []
+    for v in values:
+        sent.append((yield v))
+    return sent
+
+
+def co_throwable(values):
+    values = list(values)
+    while values:
+        try:
+            yield values.pop(0)
+        except ValueError as e:
+            values.insert(0, e.args[0])
+
+
+@pytest.mark.parametrize('make', [
+    lambda r: r.randrange(-2 ** 70, 2 ** 70),
+    lambda r: r.randrange(-10, 10),
+    lambda r: r.random(),
+    lambda r: str(r.randrange(1000)),
+    lambda r: (r.randrange(5), r.randrange(5)),
+])
+@pytest.mark.parametrize('k', [0, 1, 2, 7, 32])
+def test_comerge_heapq_like(make, k):
+    r = random.Random(k)
+    inputs = [
+        sorted(make(r) for _ in range(r.randrange(20)))
+        for _ in range(k)
+    ]
+    assert list(comerge(*inputs)) == list(heapq.merge(*inputs))
+
+
+def test_comerge_stable():
+    inputs = [
+        [(1, 'a'), (2, 'a')],
+        [(1, 'b'), (2, 'b')],
+        [(1, 'c')],
+    ]
+    expected = list(heapq.merge(*inputs, key=lambda t: t[0]))
+    assert list(comerge(*inputs, key=lambda t: t[0])) == expected
+    assert [t[1] for t in expected] == ['a', 'b', 'c', 'a', 'b']
+
+    expected = list(heapq.merge(
+        *map(reversed, inputs),
+        key=lambda t: t[0],
+        reverse=True
+    ))
+    assert list(comerge(
+        *map(reversed, inputs),
+        key=lambda t: t[0],
+        reverse=True
+    )) == expected
+
+
+def test_comerge_reverse():
+    assert list(comerge((5, 3, 1), (6, 4), (2,), reverse=True)) == [
+        6, 5, 4, 3, 2, 1,
+    ]
+
+
+def test_comerge_mixed_types():
+    assert list(comerge((1, 2.5, 3), (2, 3.5))) == [1, 2, 2.5, 3, 3.5]
+
+
+def test_comerge_send_routes_to_selected():
+    a = []
+    b = []
+    mg = comerge(recording((1, 4), a), recording((2, 3), b))
+    assert next(mg) == 1
+    assert mg.send('a1') == 2
+    assert mg.send('b2') == 3
+    assert mg.send('b3') == 4
+    with pytest.raises(StopIteration):
+        mg.send('a4')
+    assert a == ['a1', 'a4']
+    assert b == ['b2', 'b3']
+
+
+def test_comerge_send_non_none_first():
+    mg = comerge(co((1,)))
+    with pytest.raises(TypeError):
+        mg.send(1)
+    assert next(mg) == 1
+
+
+def test_comerge_throw():
+    mg = comerge(co_throwable((1, 10)), co_throwable((2, 20)))
+    assert next(mg) == 1
+    assert mg.throw(ValueError(5)) == 2
+    assert next(mg) == 5
+    assert next(mg) == 10
+    assert next(mg) == 20
+
+
+def test_comerge_throw_unhandled():
+    mg = comerge(co((1, 3)), co((2,)))
+    assert next(mg) == 1
+    with pytest.raises(ValueError):
+        mg.throw(ValueError())
+    # the coroutine which raised is dropped
+    assert list(mg) == [2]
+
+
+def test_comerge_throw_not_started():
+    mg = comerge(co((1,)))
+    with pytest.raises(ValueError):
+        mg.throw(ValueError())
+
+
+def test_comerge_close():
+    a = co(count())
+    b = co(count())
+    mg = comerge(a, b)
+    assert next(mg) == 0
+    mg.close()
+    assert a.gi_frame is None
+    assert b.gi_frame is None
+    with pytest.raises(StopIteration):
+        next(mg)
+
+
+def test_comerge_key_error():
+    def key(a):
+        if a == 2:
+            raise ValueError(a)
+        return a
+
+    mg = comerge((1, 2, 3), (4,), key=key)
+    assert next(mg) == 1
+    with pytest.raises(ValueError):
+        next(mg)
+    assert list(mg) == [4]
+
+
+def test_comerge_bad_args():
+    with pytest.raises(TypeError):
+        comerge(1)
+
+    with pytest.raises(TypeError):
+        comerge((), not_a_kwarg=1)
+
+
+def test_comerge_children():
+    mg = comerge((1,), (2,))
+    assert len(mg.children) == 2
+    assert mg.key is None
+    assert comerge(key=abs).key is abs
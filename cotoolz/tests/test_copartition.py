@@ -0,0 +1,176 @@
+import sys
+
+import pytest
+
+from cotoolz import coiter, copartition
+from cotoolz.tests.utils import primed
+
+
+def sink(out):
+    while True:
+        out.append((yield))
+
+
+class ManySink:
+    def __init__(self):
+        self.batches = []
+        self.closed = False
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        return None
+
+    def send(self, value):  # pragma: no cover
+        raise AssertionError('send_many should be used')
+
+    def send_many(self, values):
+        self.batches.append(values)
+
+    def close(self):
+        self.closed = True
+
+
+def test_copartition_n():
+    pt = copartition(4)
+    values = list(range(100))
+    assert [pt.send(v) for v in values] == [hash(v) % 4 for v in values]
+    assert sum(pt.counts) == 100
+    assert pt.children == ()
+
+
+def test_copartition_key():
+    pt = copartition(3, key=len)
+    for word in ('a', 'bb', 'ccc', 'dd'):
+        assert pt.send(word) == hash(len(word)) % 3
+    assert pt.key is len
+
+
+def test_copartition_sinks():
+    outs = [[], [], []]
+    pt = copartition([primed(sink(out)) for out in outs])
+    values = ['a', 'b', 'c', 'd', 'e', 'f', 'g'] * 3
+    for v in values:
+        pt.send(v)
+    for n, out in enumerate(outs):
+        assert out == [v for v in values if hash(v) % 3 == n]
+    assert len(pt.children) == 3
+
+
+def test_copartition_batch():
+    outs = [[], []]
+    pt = copartition([primed(sink(out)) for out in outs], batch=4)
+    values = list(range(20))
+    for v in values[:3]:
+        pt.send(v)
+    assert outs == [[], []]
+    for v in values[3:]:
+        pt.send(v)
+    pt.flush()
+    for n, out in enumerate(outs):
+        assert out == [v for v in values if hash(v) % 2 == n]
+
+
+def test_copartition_send_many():
+    sinks = [ManySink(), ManySink()]
+    pt = copartition(sinks, batch=2)
+    for v in range(6):
+        pt.send(v)
+    pt.send(6)
+    assert sinks[0].batches == [[0, 2], [4, 6]]
+    assert sinks[1].batches == [[1, 3]]
+    pt.close()
+    assert sinks[1].batches == [[1, 3], [5]]
+    assert all(s.closed for s in sinks)
+
+
+def test_copartition_close_flushes():
+    out = []
+    g = primed(sink(out))
+    pt = copartition([g], batch=10)
+    pt.send(1)
+    pt.send(2)
+    assert out == []
+    pt.close()
+    assert out == [1, 2]
+    assert g.gi_frame is None
+
+
+def test_copartition_send_many_through_coiter():
+    sinks = [ManySink()]
+    pt = copartition([coiter(sinks[0])], batch=2)
+    for v in range(4):
+        pt.send(v)
+    assert sinks[0].batches == [[0, 1], [2, 3]]
+
+
+def test_copartition_dealloc_flushes():
+    out = []
+    many = ManySink()
+    pt = copartition([primed(sink(out)), many], key=lambda v: v, batch=10)
+    for v in range(5):
+        pt.send(v)
+    assert out == [] and many.batches == []
+    del pt
+    assert out == [0, 2, 4]
+    assert many.batches == [[1, 3]]
+
+
+def test_copartition_dealloc_flush_error(monkeypatch):
+    def bad():
+        yield
+        raise ValueError('boom')
+
+    unraisable = []
+    monkeypatch.setattr(sys, 'unraisablehook', unraisable.append)
+    pt = copartition([primed(bad())], batch=10)
+    pt.send(1)
+    del pt
+    assert len(unraisable) == 1
+    assert isinstance(unraisable[0].exc_value, ValueError)
+
+
+def test_copartition_skew():
+    pt = copartition(2)
+    assert pt.skew == 0.0
+    pt.send(0)
+    pt.send(1)
+    assert pt.skew == 1.0
+    pt.send(0)
+    pt.send(0)
+    assert pt.counts == (3, 1)
+    assert pt.skew == 1.5
+
+
+def test_copartition_sink_error():
+    def bad():
+        yield
+        raise ValueError()
+
+    pt = copartition([primed(bad())])
+    with pytest.raises(ValueError):
+        pt.send(1)
+
+
+def test_copartition_throw():
+    pt = copartition(1)
+    with pytest.raises(ValueError):
+        pt.throw(ValueError())
+
+
+def test_copartition_bad_args():
+    with pytest.raises(ValueError):
+        copartition(0)
+
+    with pytest.raises(ValueError):
+        copartition([])
+
+    with pytest.raises(ValueError):
+        copartition(1, batch=0)
+
+    with pytest.raises(TypeError):
+        copartition(object())
+
+    with pytest.raises(TypeError):
+        copartition(1).send([])
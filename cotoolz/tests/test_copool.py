@@ -0,0 +1,265 @@
+import sys
+import threading
+from time import perf_counter, sleep
+
+import pytest
+
+from cotoolz import comap, copool, cozip
+
+
+def count_to(n):
+    total = 0
+    for m in range(n):
+        total += m
+        yield
+    return total
+
+
+@pytest.mark.parametrize('workers', [1, 2, 4])
+@pytest.mark.parametrize('batch', [1, 3, 64])
+def test_copool_runs_everything(workers, batch):
+    pool = copool(workers, batch)
+    tasks = [pool.spawn(count_to(n)) for n in range(20)]
+    # each task takes one more step to raise StopIteration
+    assert pool.run() == sum(range(20)) + 20
+    for n, task in enumerate(tasks):
+        assert task.done
+        assert task.result == sum(range(n))
+        assert task.steps == n + 1
+        assert task.exception is None
+        assert task.children == ()
+    assert pool.pending == ()
+    assert pool.run() == 0
+
+
+def test_copool_invalid():
+    with pytest.raises(ValueError):
+        copool(0)
+    with pytest.raises(ValueError):
+        copool(2, batch=0)
+    with pytest.raises(TypeError):
+        copool(2).spawn(1)
+
+
+def test_copool_defaults():
+    pool = copool()
+    assert pool.workers >= 1
+    assert pool.batch == 64
+
+
+def test_copool_pipelines():
+    pool = copool(3)
+    outs = [[] for _ in range(5)]
+    tasks = [
+        pool.spawn(comap(out.append, cozip(range(n), range(n, 2 * n))))
+        for n, out in zip(range(10, 15), outs)
+    ]
+    pool.run()
+    assert all(task.done for task in tasks)
+    for n, out in zip(range(10, 15), outs):
+        assert out == list(zip(range(n), range(n, 2 * n)))
+
+
+def test_copool_task_on_one_thread_at_a_time():
+    running = set()
+    overlaps = []
+    threads = set()
+
+    def gen(name):
+        for _ in range(200):
+            if name in running:
+                overlaps.append(name)
+            running.add(name)
+            threads.add(threading.get_ident())
+            yield
+            running.discard(name)
+
+    pool = copool(4, 7)
+    for name in range(8):
+        pool.spawn(gen(name))
+    pool.run()
+    assert not overlaps
+    assert threads
+
+
+def test_copool_exception():
+    def fail():
+        yield
+        raise ValueError('bad')
+
+    pool = copool(2, 1)
+    bad = pool.spawn(fail())
+    good = [pool.spawn(count_to(100)) for _ in range(3)]
+    with pytest.raises(ValueError, match='bad'):
+        pool.run()
+    assert bad.done
+    assert isinstance(bad.exception, ValueError)
+    assert bad not in pool.pending
+    pool.run()
+    assert all(task.done for task in good)
+    assert [task.result for task in good] == [sum(range(100))] * 3
+
+
+def test_copool_spawn_while_running():
+    pool = copool(2, 1)
+    children = []
+
+    def parent():
+        for n in range(10):
+            children.append(pool.spawn(count_to(n)))
+            yield
+
+    pool.spawn(parent())
+    pool.run()
+    assert len(children) == 10
+    assert all(task.done for task in children)
+
+
+def test_copool_reentrant_run():
+    pool = copool(2)
+
+    def gen():
+        with pytest.raises(RuntimeError):
+            pool.run()
+        yield
+
+    pool.spawn(gen())
+    pool.run()
+
+
+def test_copool_close_task():
+    closed = []
+
+    def gen():
+        try:
+            while True:
+                yield
+        finally:
+            closed.append(True)
+
+    pool = copool(2, 4)
+    task = pool.spawn(gen())
+    other = pool.spawn(count_to(3))
+    task.close()
+    # never started, so there is no finally to run
+    assert closed == []
+    assert task.done
+    pool.run()
+    assert other.done
+    assert task.steps == 0
+
+    task = pool.spawn(gen())
+
+    def stop():
+        yield
+        raise KeyError('stop')
+
+    pool.spawn(stop())
+    # the error stops the run with task part way through
+    with pytest.raises(KeyError):
+        pool.run()
+    assert not task.done
+    assert pool.pending == (task,)
+    task.close()
+    assert task.done
+    assert closed == ([True] if task.steps else [])
+    # close is idempotent
+    task.close()
+    assert pool.run() == 0
+
+
+def test_copool_close_running():
+    handles = []
+
+    def gen():
+        with pytest.raises(RuntimeError):
+            handles[0].close()
+        yield
+
+    pool = copool(2)
+    handles.append(pool.spawn(gen()))
+    pool.run()
+    assert handles[0].done
+
+
+def test_copool_stats():
+    pool = copool(3, 5)
+    for n in range(12):
+        pool.spawn(count_to(n * 10))
+    steps = pool.run()
+    stats = pool.stats()
+    assert stats['steps'] == steps
+    assert len(stats['workers']) == 3
+    assert sum(w['steps'] for w in stats['workers']) == steps
+    assert sum(w['steals'] for w in stats['workers']) == stats['steals']
+    assert stats['batches'] >= steps / 5
+    assert stats['idle_ns'] >= 0
+
+    # counters accumulate across runs
+    pool.spawn(count_to(5))
+    pool.run()
+    assert pool.stats()['steps'] == steps + 6
+    assert len(pool.stats()['workers']) == 1
+
+
+def test_copool_pending():
+    pool = copool(2)
+    tasks = [pool.spawn(iter(())) for _ in range(3)]
+    assert pool.pending == tuple(tasks)
+    pool.run()
+    assert pool.pending == ()
+
+
+@pytest.mark.skipif(
+    not hasattr(sys, '_is_gil_enabled'),
+    reason='sys._is_gil_enabled was added in Python 3.13',
+)
+def test_copool_is_not_parallel():
+    # copool and the other modules are not marked as safe without the GIL,
+    # so even a free-threaded build runs with the GIL once cotoolz is
+    # imported and the workers take turns
+    assert sys._is_gil_enabled()
+
+
+def test_copool_overlaps_blocking_steps():
+    def blocking():
+        for _ in range(2):
+            sleep(0.05)
+            yield
+
+    pool = copool(4, batch=1)
+    for _ in range(4):
+        pool.spawn(blocking())
+    start = perf_counter()
+    pool.run()
+    # the eight sleeps take 0.4s one after another
+    assert perf_counter() - start < 0.3
+
+
+def test_copool_spawn_from_another_pools_worker():
+    outer = copool(1)
+    inner = copool(4, batch=1)
+    spawned = []
+
+    def child():
+        spawned.append(None)
+        yield
+
+    def spawner():
+        for _ in range(4):
+            # not a worker of ``outer``, so this goes to the deque of the
+            # thread which called ``outer.run``
+            outer.spawn(child())
+            # let the other workers of ``inner`` pick up tasks
+            sleep(0.001)
+            yield
+
+    def driver():
+        for _ in range(8):
+            inner.spawn(spawner())
+        inner.run()
+        yield
+
+    outer.spawn(driver())
+    outer.run()
+    assert len(spawned) == 32
@@ -0,0 +1,146 @@
+import threading
+import time
+
+import pytest
+
+from cotoolz import comap, coprefetch, cozip
+
+
+@pytest.mark.parametrize('depth', [1, 2, 7, 64, 1000])
+def test_coprefetch_values(depth):
+    assert list(coprefetch(range(500), depth=depth)) == list(range(500))
+
+
+def test_coprefetch_empty():
+    pf = coprefetch(())
+    for _ in range(3):
+        with pytest.raises(StopIteration):
+            next(pf)
+
+
+def test_coprefetch_invalid():
+    with pytest.raises(ValueError):
+        coprefetch(range(3), depth=0)
+    with pytest.raises(TypeError):
+        coprefetch(1)
+
+
+def test_coprefetch_runs_on_another_thread():
+    idents = []
+
+    def gen():
+        for n in range(3):
+            idents.append(threading.get_ident())
+            yield n
+
+    assert list(coprefetch(gen())) == [0, 1, 2]
+    assert set(idents) and threading.get_ident() not in idents
+
+
+def test_coprefetch_exception():
+    def gen():
+        yield 1
+        yield 2
+        raise ValueError('inner')
+
+    pf = coprefetch(gen())
+    assert next(pf) == 1
+    assert next(pf) == 2
+    with pytest.raises(ValueError, match='inner'):
+        next(pf)
+    with pytest.raises(StopIteration):
+        next(pf)
+
+
+def test_coprefetch_bounded():
+    pulled = []
+
+    def gen():
+        for n in range(100):
+            pulled.append(n)
+            yield n
+
+    pf = coprefetch(gen(), depth=4)
+    assert next(pf) == 0
+    time.sleep(0.05)
+    # the ring holds at most depth values and one more may be in flight
+    assert len(pulled) <= 6
+    assert pf.depth == 4
+    assert pf.buffered <= 4
+    pf.close()
+
+
+def test_coprefetch_close():
+    closed = []
+
+    def gen():
+        try:
+            n = 0
+            while True:
+                yield n
+                n += 1
+        finally:
+            closed.append(True)
+
+    before = threading.active_count()
+    pf = coprefetch(gen(), depth=8)
+    assert next(pf) == 0
+    pf.close()
+    assert closed == [True]
+    assert pf.buffered == 0
+    with pytest.raises(StopIteration):
+        next(pf)
+    # close is idempotent
+    pf.close()
+    assert threading.active_count() == before
+
+
+def test_coprefetch_dealloc_stops_producer():
+    def gen():
+        n = 0
+        while True:
+            yield n
+            n += 1
+
+    pf = coprefetch(gen(), depth=2)
+    next(pf)
+    del pf
+
+
+def test_coprefetch_overlaps():
+    def slow(n, delay):
+        for m in range(n):
+            time.sleep(delay)
+            yield m
+
+    def consume(it, delay):
+        for _ in it:
+            time.sleep(delay)
+
+    start = time.perf_counter()
+    consume(slow(10, 0.01), 0.01)
+    serial = time.perf_counter() - start
+
+    start = time.perf_counter()
+    consume(coprefetch(slow(10, 0.01)), 0.01)
+    prefetched = time.perf_counter() - start
+
+    assert prefetched < serial * 0.8
+
+
+def test_coprefetch_in_comap_and_cozip():
+    assert list(comap(lambda a: a * 2, coprefetch(range(5)))) == [
+        0, 2, 4, 6, 8,
+    ]
+    assert list(cozip(coprefetch('abc'), coprefetch(range(3)))) == [
+        ('a', 0), ('b', 1), ('c', 2),
+    ]
+
+
+def test_coprefetch_send_ignores_value():
+    pf = coprefetch(range(3))
+    assert pf.send('ignored') == 0
+    assert pf.send(None) == 1
+    with pytest.raises(KeyError):
+        pf.throw(KeyError)
+    assert next(pf) == 2
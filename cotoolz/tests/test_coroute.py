@@ -0,0 +1,154 @@
+import gc
+
+import pytest
+
+from cotoolz import coroute, curried
+from cotoolz.tests.utils import primed
+
+
+def collector(out):
+    """A handler which records what it is sent and yields the count.
+    """
+    n = 0
+    while True:
+        out.append((yield n))
+        n += 1
+
+
+def test_coroute_mapping():
+    evens = []
+    odds = []
+    rt = coroute(
+        lambda a: a % 2,
+        {0: primed(collector(evens)), 1: primed(collector(odds))},
+    )
+    assert [rt.send(n) for n in range(6)] == [1, 1, 2, 2, 3, 3]
+    assert evens == [0, 2, 4]
+    assert odds == [1, 3, 5]
+
+    with pytest.raises(KeyError):
+        coroute(None, {}).send(1)
+
+    with pytest.raises(KeyError) as e:
+        coroute(None, {}).send((1, 2))
+    assert e.value.args == ((1, 2),)
+
+
+def test_coroute_no_keyfunc():
+    out = {}
+
+    def factory(key):
+        out[key] = []
+        return collector(out[key])
+
+    rt = coroute(None, factory, prime=True)
+    for v in 'abacab':
+        rt.send(v)
+    assert out == {'a': list('aaa'), 'b': list('bb'), 'c': list('c')}
+    assert len(rt.children) == 3
+
+
+def test_coroute_lru():
+    made = []
+    closed = []
+
+    def factory(key):
+        made.append(key)
+
+        def handler():
+            try:
+                while True:
+                    yield key
+            finally:
+                closed.append(key)
+        return handler()
+
+    rt = coroute(None, factory, maxsize=2, prime=True)
+    assert rt.send(1) == 1
+    assert rt.send(2) == 2
+    assert rt.send(1) == 1  # 2 is now the least recently used
+    assert rt.send(3) == 3
+    assert closed == [2]
+    assert made == [1, 2, 3]
+    assert rt.send(1) == 1
+    assert rt.send(2) == 2
+    assert closed == [2, 3]
+    assert made == [1, 2, 3, 2]
+    assert len(rt.children) == 2
+
+    for n in range(100):
+        rt.send(n % 7)
+    assert len(rt.children) == 2
+
+
+def test_coroute_exhausted_handler_recreated():
+    made = []
+
+    def factory(key):
+        made.append(key)
+        return iter((key,))
+
+    rt = coroute(None, factory, maxsize=3)
+    assert rt.send('a') == 'a'
+    with pytest.raises(StopIteration):
+        rt.send('a')
+    assert rt.send('a') == 'a'
+    assert made == ['a', 'a']
+
+    rt = coroute(None, factory)
+    assert rt.send('b') == 'b'
+    with pytest.raises(StopIteration):
+        rt.send('b')
+    assert rt.send('b') == 'b'
+
+
+def test_coroute_throw():
+    def handler():
+        while True:
+            try:
+                yield
+            except ValueError as e:
+                yield e
+
+    rt = coroute(None, {1: primed(handler())})
+    with pytest.raises(ValueError):
+        rt.throw(ValueError())
+    assert rt.send(1) is None
+    e = ValueError()
+    assert rt.throw(e) is e
+
+
+def test_coroute_close():
+    handlers = [primed(collector([])) for _ in range(3)]
+    rt = coroute(None, dict(enumerate(handlers)))
+    rt.close()
+    assert all(h.gi_frame is None for h in handlers)
+
+
+def test_coroute_bad_args():
+    with pytest.raises(ValueError):
+        coroute(None, {}, maxsize=1)
+
+    with pytest.raises(ValueError):
+        coroute(None, list, maxsize=0)
+
+    with pytest.raises(TypeError):
+        coroute(None, 1)
+
+
+def test_coroute_gc():
+    cycle = []
+
+    def factory(key):
+        return collector(cycle)
+
+    rt = coroute(None, factory, prime=True)
+    cycle.append(rt)
+    rt.send(1)
+    del rt, cycle[:]
+    gc.collect()
+
+
+def test_coroute_curried():
+    rt = curried.coroute(None)(lambda key: iter(range(3)))
+    assert rt.send(1) == 0
@@ -0,0 +1,316 @@
+import gc
+
+import pytest
+
+from cotoolz import coscheduler, stats_enabled
+
+
+park = coscheduler.park
+
+
+def record(log, name, n):
+    for m in range(n):
+        log.append((name, m))
+        yield
+
+
+def test_coscheduler_round_robin():
+    log = []
+    sc = coscheduler()
+    sc.spawn(record(log, 'a', 3))
+    sc.spawn(record(log, 'b', 2))
+    assert len(sc) == 2
+    sc.run()
+    assert log == [('a', 0), ('b', 0), ('a', 1), ('b', 1), ('a', 2)]
+    assert len(sc) == 0
+    assert sc.runnable == 0
+
+
+def test_coscheduler_batch():
+    log = []
+    sc = coscheduler(batch=2)
+    assert sc.batch == 2
+    sc.spawn(record(log, 'a', 3))
+    sc.spawn(record(log, 'b', 3))
+    sc.run()
+    assert log == [
+        ('a', 0), ('a', 1),
+        ('b', 0), ('b', 1),
+        ('a', 2), ('b', 2),
+    ]
+
+
+def test_coscheduler_invalid():
+    with pytest.raises(ValueError):
+        coscheduler(batch=0)
+    with pytest.raises(TypeError):
+        coscheduler().spawn(1)
+    with pytest.raises(ValueError):
+        coscheduler().run(-1)
+
+
+def test_coscheduler_max_steps():
+    log = []
+    sc = coscheduler()
+    sc.spawn(record(log, 'a', 10))
+    assert sc.run(3) == 3
+    assert len(log) == 3
+    assert sc.run(0) == 0
+    # the final step raises StopIteration
+    assert sc.run() == 8
+    assert len(log) == 10
+    assert sc.steps == 11
+
+
+def test_coscheduler_result():
+    def gen():
+        yield
+        return 'result'
+
+    sc = coscheduler()
+    task = sc.spawn(gen())
+    assert task.state == 'runnable'
+    assert not task.done
+    assert task.result is None
+    sc.run()
+    assert task.done
+    assert task.state == 'done'
+    assert task.result == 'result'
+    assert task.exception is None
+    assert task.children == ()
+
+
+def test_coscheduler_task_steps():
+    sc = coscheduler()
+    short = sc.spawn(iter(range(2)))
+    long = sc.spawn(iter(range(5)))
+    sc.run()
+    assert short.steps == 3
+    assert long.steps == 6
+
+
+def test_coscheduler_exception():
+    def fail():
+        yield
+        raise ValueError('bad')
+
+    log = []
+    sc = coscheduler()
+    bad = sc.spawn(fail())
+    good = sc.spawn(record(log, 'a', 4))
+    with pytest.raises(ValueError, match='bad'):
+        sc.run()
+    assert bad.done
+    assert isinstance(bad.exception, ValueError)
+    assert not good.done
+    sc.run()
+    assert good.done
+    assert len(log) == 4
+
+
+def test_coscheduler_park_and_wake():
+    received = []
+
+    def waiter():
+        received.append((yield park))
+        received.append((yield park))
+
+    sc = coscheduler()
+    task = sc.spawn(waiter())
+    assert sc.run() == 1
+    assert task.state == 'parked'
+    assert sc.parked == 1
+    assert sc.runnable == 0
+    assert len(sc) == 1
+    # nothing to run while parked
+    assert sc.run() == 0
+
+    assert task.wake('first')
+    assert task.state == 'runnable'
+    assert sc.parked == 0
+    sc.run()
+    assert received == ['first']
+    assert task.state == 'parked'
+
+    task.wake()
+    sc.run()
+    assert received == ['first', None]
+    assert task.done
+    assert not task.wake()
+
+
+def test_coscheduler_wake_while_running():
+    handles = []
+    received = []
+
+    def selfwake():
+        handles[0].wake('early')
+        received.append((yield park))
+
+    sc = coscheduler()
+    handles.append(sc.spawn(selfwake()))
+    sc.run()
+    # the wake was not lost, so the task never parked
+    assert received == ['early']
+    assert handles[0].done
+    assert sc.parked == 0
+
+
+def test_coscheduler_wake_while_runnable():
+    log = []
+
+    def a():
+        log.append((yield))
+        log.append((yield park))
+
+    def b(task):
+        task.wake('woken')
+        yield
+
+    sc = coscheduler()
+    task = sc.spawn(a())
+    waker = sc.spawn(b(task))
+    assert sc.run(2) == 2
+    # ``a`` was woken while it was waiting to run, so its next park returns
+    # immediately instead of waiting for another wake
+    sc.run()
+    assert log == ['woken', None]
+    assert task.done
+    assert waker.done
+    assert sc.parked == 0
+
+
+def test_coscheduler_wake_from_other_task():
+    log = []
+
+    def consumer():
+        while True:
+            value = yield park
+            if value is None:
+                return
+            log.append(value)
+
+    def producer(task):
+        for n in range(3):
+            task.wake(n)
+            yield
+        task.wake(None)
+
+    sc = coscheduler()
+    c = sc.spawn(consumer())
+    sc.spawn(producer(c))
+    sc.run()
+    assert log == [0, 1, 2]
+    assert c.done
+
+
+def test_coscheduler_other_yields_ignored():
+    sc = coscheduler()
+    task = sc.spawn(iter(['a', park, 'b']))
+    sc.run()
+    assert task.state == 'parked'
+    task.wake()
+    sc.run()
+    assert task.done
+
+
+def test_coscheduler_close_task():
+    closed = []
+
+    def gen():
+        try:
+            while True:
+                yield park
+        finally:
+            closed.append(True)
+
+    sc = coscheduler()
+    parked = sc.spawn(gen())
+    runnable = sc.spawn(gen())
+    sc.run(1)
+    assert parked.state == 'parked'
+    assert runnable.state == 'runnable'
+    parked.close()
+    runnable.close()
+    assert closed == [True]  # runnable was never started
+    assert parked.done and runnable.done
+    assert sc.parked == 0
+    assert len(sc) == 0
+    assert sc.run() == 0
+    # close is idempotent
+    parked.close()
+
+
+def test_coscheduler_close_running():
+    handles = []
+
+    def gen():
+        with pytest.raises(RuntimeError):
+            handles[0].close()
+        yield
+
+    sc = coscheduler()
+    handles.append(sc.spawn(gen()))
+    sc.run()
+    assert handles[0].done
+
+
+def test_coscheduler_reentrant_run():
+    sc = coscheduler()
+
+    def gen():
+        with pytest.raises(RuntimeError):
+            sc.run()
+        yield
+
+    sc.spawn(gen())
+    sc.run()
+
+
+def test_coscheduler_spawn_while_running():
+    log = []
+    sc = coscheduler()
+
+    def parent():
+        for n in range(20):
+            sc.spawn(record(log, n, 1))
+            yield
+
+    sc.spawn(parent())
+    sc.run()
+    assert sorted(log) == [(n, 0) for n in range(20)]
+
+
+def test_coscheduler_dropped_parked_task():
+    sc = coscheduler()
+    task = sc.spawn(iter([park]))
+    sc.run()
+    assert sc.parked == 1
+    del task
+    gc.collect()
+    assert sc.parked == 0
+    assert len(sc) == 0
+
+
+def test_coscheduler_cycle_collected():
+    def gen(sc):
+        yield sc
+
+    sc = coscheduler()
+    sc.spawn(gen(sc))
+    gc.collect()
+    count = len(gc.get_objects())
+    del sc
+    gc.collect()
+    assert len(gc.get_objects()) < count
+
+
+@pytest.mark.skipif(not stats_enabled, reason='compiled without stats')
+def test_coscheduler_stats():
+    sc = coscheduler()
+    sc.spawn(iter(range(3)))
+    sc.spawn(iter(range(1)))
+    sc.run()
+    stats = sc.stats()
+    assert stats['sends'] == 6
+    assert stats['stops'] == 2
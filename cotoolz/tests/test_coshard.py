@@ -0,0 +1,174 @@
+import multiprocessing
+import os
+import signal
+import time
+
+import pytest
+
+from cotoolz import comap, coshard, graph
+from cotoolz._coshard import RemoteTraceback
+
+
+pytestmark = pytest.mark.skipif(
+    'fork' not in multiprocessing.get_all_start_methods(),
+    reason='coshard forks its workers',
+)
+
+
+def double(a):
+    return a * 2
+
+
+@pytest.mark.parametrize('workers', [1, 2, 3])
+@pytest.mark.parametrize('chunksize', [1, 4, 100])
+def test_coshard_ordered(workers, chunksize):
+    assert list(coshard(double, range(50), workers, chunksize)) == [
+        a * 2 for a in range(50)
+    ]
+
+
+def test_coshard_unordered():
+    def slow_first(a):
+        if a < 4:
+            time.sleep(0.1)
+        return a
+
+    result = list(coshard(slow_first, range(40), 2, 4, ordered=False))
+    assert sorted(result) == list(range(40))
+    # the slow first chunk does not hold up the rest
+    assert result[:4] != [0, 1, 2, 3]
+
+
+def test_coshard_empty():
+    cs = coshard(double, (), 2)
+    for _ in range(3):
+        with pytest.raises(StopIteration):
+            next(cs)
+
+
+def test_coshard_invalid():
+    with pytest.raises(ValueError):
+        coshard(double, range(3), workers=0)
+    with pytest.raises(ValueError):
+        coshard(double, range(3), chunksize=0)
+    with pytest.raises(ValueError):
+        coshard(double, range(3), window=0)
+    with pytest.raises(TypeError):
+        coshard(double, 1)
+
+
+def test_coshard_runs_in_workers():
+    pids = set(coshard(lambda a: os.getpid(), range(20), 2, 1))
+    assert pids and os.getpid() not in pids
+
+
+def test_coshard_exception():
+    def fail_at_5(a):
+        if a == 5:
+            raise ValueError('bad %d' % a)
+        return a
+
+    cs = coshard(fail_at_5, range(10), 2, 3)
+    out = []
+    with pytest.raises(ValueError, match='bad 5') as excinfo:
+        for a in cs:
+            out.append(a)
+    assert out == [0, 1, 2, 3, 4]
+    cause = excinfo.value.__cause__
+    assert isinstance(cause, RemoteTraceback)
+    assert 'fail_at_5' in cause.tb
+    assert not multiprocessing.active_children()
+    with pytest.raises(StopIteration):
+        next(cs)
+
+
+def test_coshard_source_exception():
+    def gen():
+        yield 1
+        yield 2
+        raise KeyError('source')
+
+    cs = coshard(double, gen(), 2, 4)
+    assert next(cs) == 2
+    assert next(cs) == 4
+    with pytest.raises(KeyError, match='source'):
+        next(cs)
+
+
+def test_coshard_unpicklable_result():
+    cs = coshard(lambda a: lambda: a, range(3), 1)
+    with pytest.raises(RuntimeError, match='failed to send'):
+        next(cs)
+
+
+def test_coshard_window():
+    pulled = []
+
+    def gen():
+        for a in range(1000):
+            pulled.append(a)
+            yield a
+
+    cs = coshard(double, gen(), 2, 5, window=3)
+    assert next(cs) == 0
+    assert len(pulled) <= 3 * 5 + 1
+    assert cs.window == 3
+    cs.close()
+
+
+def test_coshard_close():
+    closed = []
+
+    def gen():
+        try:
+            a = 0
+            while True:
+                yield a
+                a += 1
+        finally:
+            closed.append(True)
+
+    cs = coshard(double, gen(), 2, 2)
+    assert next(cs) == 0
+    assert len(multiprocessing.active_children()) == 2
+    cs.close()
+    assert closed == [True]
+    assert not multiprocessing.active_children()
+    with pytest.raises(StopIteration):
+        next(cs)
+    # close is idempotent
+    cs.close()
+
+
+def test_coshard_worker_dies():
+    def die(a):
+        if a == 3:
+            os.kill(os.getpid(), signal.SIGKILL)
+        return a
+
+    with pytest.raises(RuntimeError, match='died'):
+        list(coshard(die, range(10), 1, 1))
+    assert not multiprocessing.active_children()
+
+
+def test_coshard_exhaustion_joins_workers():
+    assert list(coshard(double, range(10), 2, 3)) == list(range(0, 20, 2))
+    assert not multiprocessing.active_children()
+
+
+def test_coshard_send_and_throw():
+    cs = coshard(double, range(3), 1)
+    assert cs.send('ignored') == 0
+    with pytest.raises(KeyError):
+        cs.throw(KeyError)
+    assert next(cs) == 2
+    cs.close()
+
+
+def test_coshard_in_pipeline():
+    cs = coshard(double, range(5), 2)
+    cm = comap(lambda a: a + 1, cs)
+    assert graph(cm).children[0].children[0].obj is cs
+    assert graph(cs).kind == 'coshard'
+    assert cs.func is double
+    assert list(cm) == [1, 3, 5, 7, 9]
@@ -0,0 +1,216 @@
+from array import array
+import mmap
+import multiprocessing
+from multiprocessing.shared_memory import SharedMemory
+import threading
+import time
+
+import pytest
+
+from cotoolz import comap, coshm, coshm_sink, coshm_source, cozip
+
+
+def make_buffer(size=1 << 16):
+    return mmap.mmap(-1, size)
+
+
+def test_coshm_values():
+    sink, source = coshm(make_buffer())
+    payloads = [b'', b'a', b'hello world', bytes(range(256)) * 4]
+    for payload in payloads:
+        assert sink.send(payload) is None
+    sink.close()
+    assert [bytes(view) for view in source] == payloads
+
+
+def test_coshm_buffer_types():
+    sink, source = coshm(make_buffer())
+    sink.send(bytearray(b'abc'))
+    sink.send(memoryview(b'defg')[1:])
+    sink.send(array('d', [1.5, 2.5]))
+    assert bytes(next(source)) == b'abc'
+    assert bytes(next(source)) == b'efg'
+    assert next(source).cast('d').tolist() == [1.5, 2.5]
+    with pytest.raises(TypeError):
+        sink.send('str')
+    # None primes the sink like any other coroutine
+    assert next(sink) is None
+    # the last payload takes up space until the next read
+    assert source.size == 8 + 16
+
+
+def test_coshm_wraps():
+    sink, source = coshm(make_buffer(4096))
+    for n in range(2000):
+        payload = bytes([n % 256]) * (n % 500)
+        sink.send(payload)
+        assert bytes(next(source)) == payload
+
+
+def test_coshm_views():
+    sink, source = coshm(make_buffer())
+    sink.send(b'abc')
+    sink.send(b'def')
+    sink.send(b'ghi')
+    first = next(source)
+    assert first.readonly
+    with pytest.raises(TypeError):
+        first[0] = 0
+    second = next(source)
+    # reading the next payload releases the last view
+    with pytest.raises(ValueError):
+        first[0]
+    assert bytes(second) == b'def'
+
+    # slices keep the payload alive, so they block the next read
+    part = second[1:]
+    with pytest.raises(BufferError):
+        next(source)
+    del part
+    assert bytes(next(source)) == b'ghi'
+
+    with pytest.raises(BufferError):
+        memoryview(source)
+
+
+def test_coshm_payload_too_large():
+    sink, source = coshm(make_buffer(4096))
+    assert sink.capacity == source.capacity == 2048
+    with pytest.raises(ValueError) as e:
+        sink.send(b'x' * 1024)
+    assert str(e.value) == (
+        'a payload of 1024 bytes is larger than the 504 byte limit of a'
+        ' coshm ring of 2048 bytes'
+    )
+
+    # the limit itself fits
+    sink.send(b'x' * 504)
+    assert bytes(next(source)) == b'x' * 504
+    with pytest.raises(ValueError):
+        sink.send(b'x' * 505)
+
+
+def test_coshm_attach():
+    buf = make_buffer()
+    with pytest.raises(ValueError):
+        coshm_source(buf)
+    with pytest.raises(ValueError):
+        coshm(bytearray(64))
+    with pytest.raises(BufferError):
+        coshm(b'read only' * 100)
+
+    sink, source = coshm(buf)
+    other_sink = coshm_sink(buf)
+    other_source = coshm_source(buf)
+    assert other_source.capacity == source.capacity
+    other_sink.send(b'shared')
+    assert bytes(next(source)) == b'shared'
+
+
+def test_coshm_sink_close_drains():
+    sink, source = coshm(make_buffer())
+    sink.send(b'a')
+    sink.send(b'b')
+    sink.close()
+    assert sink.capacity is None
+    with pytest.raises(StopIteration):
+        sink.send(b'c')
+    assert [bytes(view) for view in source] == [b'a', b'b']
+    with pytest.raises(StopIteration):
+        next(source)
+
+
+def test_coshm_source_close():
+    sink, source = coshm(make_buffer())
+    sink.send(b'a')
+    view = next(source)
+    source.close()
+    with pytest.raises(ValueError):
+        view[0]
+    with pytest.raises(StopIteration):
+        sink.send(b'b')
+    with pytest.raises(StopIteration):
+        next(source)
+    # close is idempotent
+    source.close()
+
+
+def test_coshm_close_releases_shared_memory():
+    shm = SharedMemory(create=True, size=1 << 16)
+    try:
+        sink, source = coshm(shm.buf)
+        sink.send(b'a')
+        next(source)
+        sink.close()
+        source.close()
+        shm.close()
+    finally:
+        shm.unlink()
+
+
+def test_coshm_full_blocks():
+    sink, source = coshm(make_buffer(4096))
+    sent = []
+
+    def run():
+        for n in range(8):
+            sink.send(bytes([n]) * 400)
+            sent.append(n)
+
+    thread = threading.Thread(target=run)
+    thread.start()
+    time.sleep(0.05)
+    assert len(sent) < 8
+    got = [bytes(view)[0] for _, view in zip(range(8), source)]
+    thread.join(5)
+    assert not thread.is_alive()
+    assert got == sent == list(range(8))
+
+
+def test_coshm_throw():
+    sink, source = coshm(make_buffer())
+    sink.send(b'a')
+    with pytest.raises(KeyError):
+        sink.throw(KeyError)
+    with pytest.raises(ValueError):
+        source.throw(ValueError('source'))
+    assert bytes(next(source)) == b'a'
+
+
+def test_coshm_in_comap_and_cozip():
+    sink, source = coshm(make_buffer())
+    for payload in (b'a', b'bc', b'def'):
+        sink.send(payload)
+    sink.close()
+    assert list(comap(bytes, source)) == [b'a', b'bc', b'def']
+
+    sink, source = coshm(make_buffer())
+    for payload in (b'a', b'bc'):
+        sink.send(payload)
+    sink.close()
+    assert list(cozip(comap(len, source), 'xy')) == [(1, 'x'), (2, 'y')]
+
+
+def _produce(buf, n):
+    sink = coshm_sink(buf)
+    for m in range(n):
+        sink.send(m.to_bytes(4, 'little') * (m % 64))
+    sink.close()
+
+
+@pytest.mark.skipif(
+    'fork' not in multiprocessing.get_all_start_methods(),
+    reason='fork is required to share an anonymous mmap',
+)
+def test_coshm_across_processes():
+    buf = make_buffer(1 << 14)
+    # the child attaches its own sink, closing this one would end the ring
+    sink, source = coshm(buf)
+    ctx = multiprocessing.get_context('fork')
+    proc = ctx.Process(target=_produce, args=(buf, 5000))
+    proc.start()
+    for m, view in enumerate(source):
+        assert view == m.to_bytes(4, 'little') * (m % 64)
+    proc.join(10)
+    assert proc.exitcode == 0
+    assert m == 4999
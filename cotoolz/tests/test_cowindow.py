@@ -0,0 +1,150 @@
+from collections import deque
+from itertools import islice
+
+import pytest
+
+from cotoolz import cowindow
+from cotoolz.tests.utils import recording
+
+
+def windows(iterable, size, step=1):
+    it = iter(iterable)
+    window = deque(islice(it, size), maxlen=size)
+    if len(window) < size:
+        return
+    yield tuple(window)
+    while True:
+        chunk = tuple(islice(it, step))
+        if len(chunk) < step:
+            return
+        window.extend(chunk)
+        yield tuple(window)
+
+
+@pytest.mark.parametrize('size,step', [
+    (1, 1),
+    (3, 1),
+    (3, 2),
+    (3, 3),
+    (2, 5),
+    (10, 1),
+    (11, 1),
+])
+def test_cowindow_windows(size, step):
+    assert list(cowindow(range(10), size, step)) == list(
+        windows(range(10), size, step),
+    )
+
+
+def test_cowindow_view_windows():
+    assert [tuple(w) for w in cowindow(range(10), 3, 2, view=True)] == list(
+        windows(range(10), 3, 2),
+    )
+
+
+@pytest.mark.parametrize('size,step', [(0, 1), (-1, 1), (1, 0), (1, -1)])
+def test_cowindow_invalid(size, step):
+    with pytest.raises(ValueError):
+        cowindow(range(10), size, step)
+
+
+def test_cowindow_not_iterable():
+    with pytest.raises(TypeError):
+        cowindow(1, 2)
+
+
+def test_cowindow_recycles_tuple():
+    wd = cowindow(range(10), 3)
+    ids = set()
+    for _ in range(5):
+        ids.add(id(next(wd)))
+    assert len(ids) == 1
+
+    held = next(wd)
+    assert next(wd) is not held
+    assert held == (5, 6, 7)
+
+
+def test_cowindow_view_invalidated():
+    wd = cowindow(range(10), 3, view=True)
+    view = next(wd)
+    assert list(view) == [0, 1, 2]
+    assert len(view) == 3
+    assert view[-1] == 2
+    with pytest.raises(IndexError):
+        view[3]
+
+    next(wd)
+    with pytest.raises(RuntimeError):
+        len(view)
+    with pytest.raises(RuntimeError):
+        view[0]
+
+
+def test_cowindow_view_invalidated_when_step_raises():
+    def co():
+        yield from range(4)
+        raise ValueError('boom')
+
+    wd = cowindow(co(), 3, 2, view=True)
+    view = next(wd)
+    assert list(view) == [0, 1, 2]
+    # the step pushes 3 and then raises before the next window is ready
+    with pytest.raises(ValueError):
+        next(wd)
+    with pytest.raises(RuntimeError):
+        list(view)
+
+
+def test_cowindow_send_forwards():
+    sent = []
+    wd = cowindow(recording(range(6), sent), 2, 2)
+    assert next(wd) == (0, 1)
+    assert wd.send('a') == (2, 3)
+    assert wd.send('b') == (4, 5)
+    # the first pull of each step gets the sent value, the rest get None
+    assert sent == [None, 'a', None, 'b', None]
+
+
+def test_cowindow_throw():
+    def co():
+        n = 0
+        while True:
+            try:
+                yield n
+            except ValueError:
+                n = -n
+            n += 1
+
+    wd = cowindow(co(), 2)
+    assert next(wd) == (0, 1)
+    assert wd.throw(ValueError) == (1, 0)
+
+    with pytest.raises(KeyError):
+        wd.throw(KeyError)
+
+
+def test_cowindow_close():
+    closed = []
+
+    def co():
+        try:
+            yield from range(10)
+        finally:
+            closed.append(True)
+
+    wd = cowindow(co(), 3)
+    next(wd)
+    wd.close()
+    assert closed == [True]
+    with pytest.raises(StopIteration):
+        next(wd)
+
+
+def test_cowindow_children():
+    wd = cowindow(range(3), 2)
+    children = wd.children
+    assert len(children) == 1
+    assert list(children[0]) == [0, 1, 2]
+    assert wd.size == 2
+    assert wd.step == 1
@@ -1,3 +1,8 @@
+import gc
+from itertools import repeat
+import sys
+import weakref
+
 import pytest
 
 from cotoolz._cozip import cozip
@@ -71,3 +76,421 @@ def test_cozip_close():
     assert next(dz) == (1, 1)
     dz.close()
     assert tuple(dz) == ()
+
+
+def test_cozip_longest():
+    cz = cozip((1, 2, 3), (1,), mode='longest')
+    assert tuple(cz) == ((1, 1), (2, None), (3, None))
+
+    cz = cozip((1, 2), (1, 2, 3), (), mode='longest', fillvalue=0)
+    assert tuple(cz) == ((1, 1, 0), (2, 2, 0), (0, 3, 0))
+
+    cz = cozip(co(), co(), mode='longest', fillvalue='f')
+    assert next(cz) == (1, 1)
+    assert cz.send(2) == (2, 2)
+    assert cz.send(3) == (3, 3)
+    with pytest.raises(StopIteration):
+        cz.send(4)
+
+
+def test_cozip_longest_recycles():
+    cz = cozip((1, 2, 3), (1,), mode='longest')
+    ids = set()
+    for _ in range(3):
+        ids.add(id(next(cz)))
+    assert len(ids) == 1
+
+
+def test_cozip_strict():
+    cz = cozip((1, 2), (1, 2), mode='strict')
+    assert tuple(cz) == ((1, 1), (2, 2))
+
+    cz = cozip((1, 2, 3), (1, 2), mode='strict')
+    assert next(cz) == (1, 1)
+    assert next(cz) == (2, 2)
+    with pytest.raises(ValueError) as e:
+        next(cz)
+    assert str(e.value) == 'cozip() argument 2 is shorter than argument 1'
+
+    cz = cozip((1,), (1, 2), (1, 2), mode='strict')
+    assert next(cz) == (1, 1, 1)
+    with pytest.raises(ValueError) as e:
+        next(cz)
+    assert str(e.value) == 'cozip() argument 2 is longer than argument 1'
+
+    cz = cozip((1, 2), (1, 2), (1,), mode='strict')
+    next(cz)
+    with pytest.raises(ValueError) as e:
+        next(cz)
+    assert str(e.value) == 'cozip() argument 3 is shorter than arguments 1-2'
+
+
+def test_cozip_strict_throw():
+    cz = cozip(co_throwable(), co_throwable(), mode='strict')
+    assert next(cz) == (1, 1)
+    e = ValueError()
+    assert cz.throw(e) == (e, e)
+
+
+def test_cozip_bad_mode():
+    with pytest.raises(ValueError):
+        cozip((), mode='ayy')
+
+    with pytest.raises(TypeError):
+        cozip((), mode=1)
+
+    with pytest.raises(TypeError):
+        cozip((), not_a_kwarg=1)
+
+
+def test_cozip_fuse():
+    cz = cozip(cozip(cozip(co(), co())))
+    assert cz.fused == 2
+    assert len(cz.children) == 2
+    assert next(cz) == (((1, 1),),)
+    assert cz.send(2) == (((2, 2),),)
+
+    e = ValueError()
+    cz = cozip(cozip(co_throwable()))
+    assert cz.fused == 1
+    assert next(cz) == ((1,),)
+    assert cz.throw(e) == ((e,),)
+
+    cz = cozip(cozip(gen()))
+    assert next(cz) == ((1,),)
+    cz.close()
+    assert tuple(cz) == ()
+
+    # a cozip which is referenced elsewhere is left alone
+    inner = cozip(range(3))
+    cz = cozip(inner)
+    assert cz.fused == 0
+    assert cz.children[0].children[0] is inner
+    assert tuple(cz) == (((0,),), ((1,),), ((2,),))
+
+    # the inner mode is kept by not fusing
+    cz = cozip(cozip((1, 2), (1,), mode='longest'))
+    assert cz.fused == 0
+    assert tuple(cz) == (((1, 1),), ((2, None),))
+
+
+def test_cozip_fuse_recycles():
+    cz = cozip(cozip(range(3), range(3)))
+    ids = set()
+    for _ in range(3):
+        ids.add(id(next(cz)[0]))
+    assert len(ids) == 1
+
+    # the 1-tuples are reused as well
+    cz = cozip(cozip(cozip(range(4), range(4))))
+    ids = set()
+    for _ in range(2):
+        ids.add(id(next(cz)))
+    assert len(ids) == 1
+
+    # but not while anything refers to them
+    kept = next(cz)
+    inner = kept[0]
+    assert next(cz) == (((3, 3),),)
+    assert kept == (((2, 2),),)
+    assert inner is kept[0]
+
+
+class Child:
+    """A coroutine which records every call made on it and is exhausted
+    after ``n`` sends.
+    """
+    def __init__(self, n, close_error=None):
+        self.n = n
+        self.calls = []
+        self.close_error = close_error
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        return self.send(None)
+
+    def send(self, value):
+        self.calls.append('send')
+        if len(self.calls) > self.n:
+            raise StopIteration
+        return value
+
+    def throw(self, e):
+        self.calls.append('throw')
+        raise e
+
+    def close(self):
+        self.calls.append('close')
+        if self.close_error is not None:
+            raise self.close_error
+
+
+@pytest.mark.parametrize('mode', ['shortest', 'strict'])
+def test_cozip_finished(mode):
+    a = Child(1)
+    b = Child(5)
+    cz = cozip(a, b, mode=mode)
+    assert not cz.finished
+    assert cz.send(1) == (1, 1)
+    with pytest.raises(StopIteration if mode == 'shortest' else ValueError):
+        next(cz)
+    assert cz.finished
+    calls = a.calls[:], b.calls[:]
+
+    # a finished cozip does not step its coroutines again
+    with pytest.raises(StopIteration):
+        cz.send(2)
+    assert tuple(cz) == ()
+    e = ValueError()
+    with pytest.raises(ValueError) as exc:
+        cz.throw(e)
+    assert exc.value is e
+    assert (a.calls, b.calls) == calls
+
+    # only the coroutine which is not exhausted is closed
+    cz.close()
+    assert a.calls == calls[0]
+    assert b.calls[-1] == 'close'
+
+
+def test_cozip_finished_longest():
+    a = Child(1)
+    b = Child(2)
+    cz = cozip(a, b, mode='longest')
+    assert list(cz) == [(None, None), (None, None)]
+    assert cz.finished
+    assert a.calls == ['send', 'send']
+    assert b.calls == ['send', 'send', 'send']
+    cz.close()
+    assert a.calls == ['send', 'send']
+    assert b.calls == ['send', 'send', 'send']
+
+
+def test_cozip_empty_finished():
+    cz = cozip()
+    assert cz.finished
+    with pytest.raises(StopIteration):
+        cz.send(None)
+    assert tuple(cz) == ()
+
+
+def test_cozip_close_idempotent():
+    a = Child(5)
+    cz = cozip(a)
+    assert next(cz) == (None,)
+    cz.close()
+    cz.close()
+    assert a.calls == ['send', 'close']
+    assert cz.finished
+    with pytest.raises(StopIteration):
+        cz.send(None)
+
+
+def test_cozip_close_error(monkeypatch):
+    unraisable = []
+    monkeypatch.setattr('sys.unraisablehook', unraisable.append)
+    children = [
+        Child(5, KeyError('a')),
+        Child(5),
+        Child(5, KeyError('c')),
+    ]
+    cz = cozip(*children)
+    next(cz)
+    # the coroutines are closed last to first, the first error is raised
+    with pytest.raises(KeyError, match='c'):
+        cz.close()
+    assert all(child.calls[-1] == 'close' for child in children)
+    assert len(unraisable) == 1
+    assert unraisable[0].exc_value.args == ('a',)
+    assert cz.finished
+    cz.close()
+
+
+def test_cozip_send_each():
+    cz = cozip(co(), co(), co())
+    assert next(cz) == (1, 1, 1)
+    assert cz.send_each((2, 3, 4)) == (2, 3, 4)
+    assert cz.send_each([5, 6, 7]) == (5, 6, 7)
+    with pytest.raises(StopIteration):
+        cz.send_each((8, 9, 10))
+    assert cz.finished
+
+
+def test_cozip_send_each_invalid():
+    cz = cozip(co(), co())
+    with pytest.raises(ValueError):
+        cz.send_each((1,))
+    with pytest.raises(ValueError):
+        cz.send_each((1, 2, 3))
+    with pytest.raises(TypeError):
+        cz.send_each(1)
+    # nothing was sent in
+    assert next(cz) == (1, 1)
+
+
+def test_cozip_send_each_recycles():
+    cz = cozip(Child(5), Child(5))
+    res = cz.send_each((1, 2))
+    assert res == (1, 2)
+    res_id = id(res)
+    del res
+    res = cz.send_each((3, 4))
+    assert res == (3, 4)
+    assert id(res) == res_id
+
+    # a result which is still referenced is not overwritten
+    other = cz.send_each((5, 6))
+    assert res == (3, 4)
+    assert other == (5, 6)
+
+
+@pytest.mark.parametrize('mode', ['longest', 'strict'])
+def test_cozip_send_each_mode(mode):
+    cz = cozip(Child(1), Child(2), mode=mode, fillvalue='fill')
+    assert cz.send_each(('a', 'b')) == ('a', 'b')
+    if mode == 'longest':
+        assert cz.send_each(('c', 'd')) == ('fill', 'd')
+        with pytest.raises(StopIteration):
+            cz.send_each(('e', 'f'))
+    else:
+        with pytest.raises(ValueError):
+            cz.send_each(('c', 'd'))
+    assert cz.finished
+
+
+def test_cozip_send_each_fused():
+    cz = cozip(cozip(Child(5), Child(5)))
+    assert cz.fused == 1
+    assert cz.send_each((1, 2)) == ((1, 2),)
+
+
+def test_cozip_names():
+    cz = cozip(range(3), 'abc', names=('n', 'c'))
+    rows = list(cz)
+    assert rows == [(0, 'a'), (1, 'b'), (2, 'c')]
+    assert [(row.n, row.c) for row in rows] == rows
+    assert all(type(row) is cz.record_type for row in rows)
+    assert isinstance(rows[0], tuple)
+    assert repr(rows[0]).endswith("(n=0, c='a')")
+
+    # the type is shared by cozips with the same names
+    assert cozip((), (), names=['n', 'c']).record_type is cz.record_type
+    assert cozip((), (), names=('c', 'n')).record_type is not cz.record_type
+    assert cozip(()).record_type is None
+
+
+def test_cozip_names_recycles():
+    cz = cozip(range(3), range(3), names=('a', 'b'))
+    ids = set()
+    for _ in range(3):
+        ids.add(id(next(cz)))
+    assert len(ids) == 1
+
+    cz = cozip(range(3), range(3), names=('a', 'b'))
+    held = [next(cz) for _ in range(3)]
+    assert [row.a for row in held] == [0, 1, 2]
+
+
+@pytest.mark.parametrize('mode', ['shortest', 'longest', 'strict'])
+def test_cozip_names_gc_tracked(mode):
+    cz = cozip(co(), co(), mode=mode, names=('a', 'b'))
+    held = next(cz)
+    assert gc.is_tracked(held)
+    # a fresh row while ``held`` is alive, then a recycled one
+    assert gc.is_tracked(cz.send(2))
+    assert gc.is_tracked(cz.send(3))
+
+    # a cycle through a row is collected
+    class Box:
+        pass
+
+    box = Box()
+    cz = cozip(repeat(box), names=('box',))
+    box.row = next(cz)
+    ref = weakref.ref(box)
+    del box, cz
+    gc.collect()
+    assert ref() is None
+
+
+def test_cozip_names_cache_is_bounded():
+    old = cozip(range(2), names=('first',))
+    old_type = old.record_type
+    for n in range(300):
+        cozip((), names=('f%d' % n,))
+    assert cozip((), names=('first',)).record_type is not old_type
+
+    # rows of a type which was dropped from the cache still work
+    row = next(old)
+    assert row.first == 0
+    assert repr(row).endswith('(first=0)')
+    assert old_type._fields == ('first',)
+
+
+def test_cozip_names_outlive_fields():
+    # build the names at runtime so nothing but the record type holds them
+    names = [''.join(['fir', 'st']), ''.join(['sec', 'ond'])]
+    cz = cozip(range(2), range(2), names=names)
+    del names
+    cz.record_type._fields = None
+    for n in range(300):
+        cozip((), names=('f%d' % n,))
+    gc.collect()
+    junk = [''.join(['x', str(n)]) * 2 for n in range(1000)]  # noqa
+
+    row = next(cz)
+    assert repr(row).endswith('(first=0, second=0)')
+
+
+def test_cozip_names_freed_with_type():
+    name = ''.join(['fre', 'ed'])
+    cozip((), names=(name,))
+    for n in range(300):
+        cozip((), names=('f%d' % n,))
+    gc.collect()
+    assert sys.getrefcount(name) == 2
+
+
+@pytest.mark.parametrize('mode', ['shortest', 'longest', 'strict'])
+def test_cozip_names_send(mode):
+    cz = cozip(co(), co(), mode=mode, names=('x', 'y'))
+    assert next(cz).x == 1
+    row = cz.send(2)
+    assert (row.x, row.y) == (2, 2)
+    row = cz.send_each((3, 4))
+    assert (row.x, row.y) == (3, 4)
+    e = ValueError()
+    cz = cozip(co_throwable(), names=('x',))
+    next(cz)
+    assert cz.throw(e).x is e
+
+
+def test_cozip_names_not_fused():
+    cz = cozip(cozip((1, 2), names=('a',)))
+    assert cz.fused == 0
+    assert next(cz)[0].a == 1
+
+    cz = cozip(cozip((1, 2)), names=('a',))
+    assert cz.fused == 0
+    assert next(cz).a == (1,)
+
+
+def test_cozip_names_invalid():
+    with pytest.raises(ValueError):
+        cozip((), (), names=('a',))
+    with pytest.raises(ValueError):
+        cozip((), names=('not valid',))
+    with pytest.raises(ValueError):
+        cozip((), names=(1,))
+    with pytest.raises(ValueError):
+        cozip((), (), names=('a', 'a'))
+    with pytest.raises(TypeError):
+        cozip((), names=1)
+    for reserved in '_fields', '_a', '__class__':
+        with pytest.raises(ValueError):
+            cozip((), names=(reserved,))
+    for reserved in 'n_fields', 'n_sequence_fields', 'n_unnamed_fields':
+        with pytest.raises(ValueError):
+            cozip((), names=(reserved,))
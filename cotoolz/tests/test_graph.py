@@ -0,0 +1,85 @@
+import pytest
+
+from cotoolz import coiter, comap, cozip, graph, profile, stats_enabled
+
+
+def co():
+    yield (yield (yield 1))
+
+
+def add(a, b):
+    return a + b
+
+
+def test_children():
+    src = co()
+    ci = coiter(src)
+    assert ci.children == (src,)
+
+    cm = comap(add, ci, (1, 2))
+    assert cm.func is add
+    assert len(cm.children) == 2
+    assert all(isinstance(c, coiter) for c in cm.children)
+    assert cm.children[0].children == (ci,)
+
+    cz = cozip(cm, (1, 2))
+    assert len(cz.children) == 2
+    assert cz.children[0].children == (cm,)
+
+    with pytest.raises(AttributeError):
+        cm.func = None
+    with pytest.raises(AttributeError):
+        cz.children = ()
+
+
+def test_graph():
+    a = co()
+    b = co()
+    cm = comap(add, cozip(a), b)
+    root = graph(cm)
+    assert root.obj is cm
+    assert root.kind == 'comap'
+    assert root.func is add
+    assert [n.kind for n in root.walk()] == [
+        'comap',
+        'coiter',
+        'cozip',
+        'coiter',
+        'generator',
+        'coiter',
+        'generator',
+    ]
+    assert root.children[1].children[0].obj is b
+    assert root.children[1].children[0].children == ()
+
+
+def test_graph_dot():
+    dot = graph(comap(add, (1,), (2,))).to_dot()
+    assert dot.startswith('digraph pipeline {')
+    assert '[label="comap(add)"]' in dot
+    assert dot.count('->') == 4
+
+
+@pytest.mark.skipif(stats_enabled, reason='cotoolz compiled with stats')
+def test_profile_disabled():
+    with pytest.raises(RuntimeError):
+        profile(comap(add, (1,), (2,)), 1)
+
+
+@pytest.mark.skipif(
+    not stats_enabled,
+    reason='cotoolz was compiled without COTOOLZ_STATS',
+)
+def test_profile():
+    inner = comap(add, range(100), range(100))
+    outer = comap(str, inner)
+    p = profile(outer, 10)
+    assert p.steps == 10
+    assert [n.node.obj for n in p.nodes] == [outer, inner]
+    assert [n.calls for n in p.nodes] == [10, 10]
+    outer_p, inner_p = p.nodes
+    assert outer_p.total_ns >= inner_p.total_ns
+    assert outer_p.self_ns == outer_p.total_ns - inner_p.total_ns
+    assert p.throughput(outer_p) > 0
+    assert 'comap(str)' in str(p)
+    assert 'calls/s' in p.to_dot()
@@ -0,0 +1,91 @@
+import os
+import subprocess
+import sys
+import textwrap
+
+import pytest
+
+import cotoolz
+from cotoolz import comap, cozip
+
+
+SETUP = '''
+from setuptools import setup, Extension
+
+setup(
+    ext_modules=[
+        Extension(
+            'hpp_test',
+            [{source!r}],
+            include_dirs=[{include!r}],
+            language='c++',
+            extra_compile_args=['-std=c++14'],
+        ),
+    ],
+)
+'''
+
+
+@pytest.fixture(scope='module')
+def hpp(tmpdir_factory):
+    path = tmpdir_factory.mktemp('hpp')
+    path.join('setup.py').write(textwrap.dedent(SETUP).format(
+        source=os.path.join(os.path.dirname(__file__), 'hpp_test.cpp'),
+        include=cotoolz.get_include(),
+    ))
+    try:
+        subprocess.check_call(
+            [sys.executable, 'setup.py', 'build_ext', '--inplace'],
+            cwd=str(path),
+            stdout=subprocess.DEVNULL,
+        )
+    except (OSError, subprocess.CalledProcessError):  # pragma: no cover
+        pytest.skip('could not build the C++ test module')
+    sys.path.insert(0, str(path))
+    try:
+        import hpp_test
+    finally:
+        sys.path.remove(str(path))
+    return hpp_test
+
+
+def counter():
+    n = 0
+    while True:
+        n = yield n
+
+
+def test_native_only(hpp):
+    assert hpp.native_only(range(3), 5) == [1, 3, 5]
+    assert hpp.native_only(range(10), 2) == [1, 3]
+
+
+def test_mixed(hpp):
+    cr = counter()
+    next(cr)
+    assert hpp.mixed(cr, [1, 2, 3]) == ['4', '6', '8']
+
+
+def test_mixed_error(hpp):
+    cr = counter()
+    next(cr)
+    with pytest.raises(OverflowError):
+        hpp.mixed(cr, [2 ** 100])
+
+    cr.close()
+    with pytest.raises(StopIteration):
+        hpp.mixed(cr, [1])
+
+
+def test_handles(hpp):
+    cm, cz = hpp.handles(lambda a, b: a + b, (1, 2), (3, 4))
+    assert isinstance(cm, comap)
+    assert isinstance(cz, cozip)
+    assert tuple(cm) == (4, 6)
+
+
+def test_send_close(hpp):
+    cr = counter()
+    next(cr)
+    assert hpp.send_close(cr, 5) == 5
+    assert tuple(cr) == ()
@@ -0,0 +1,64 @@
+import pytest
+
+from cotoolz import coiter, comap, cozip, stats_enabled
+
+
+def co():
+    yield (yield (yield 1))
+
+
+requires_stats = pytest.mark.skipif(
+    not stats_enabled,
+    reason='cotoolz was compiled without COTOOLZ_STATS',
+)
+
+
+@pytest.mark.skipif(stats_enabled, reason='cotoolz compiled with stats')
+@pytest.mark.parametrize('node', [
+    lambda: coiter(co()),
+    lambda: comap(int, co()),
+    lambda: cozip(co()),
+])
+def test_stats_disabled(node):
+    with pytest.raises(RuntimeError):
+        node().stats()
+
+
+@requires_stats
+def test_coiter_stats():
+    ci = coiter((1, 2))
+    assert tuple(ci) == (1, 2)
+    stats = ci.stats()
+    assert stats['sends'] == 3
+    assert stats['stops'] == 1
+    assert stats['func_ns'] == 0
+
+
+@requires_stats
+def test_comap_stats():
+    cm = comap(lambda a, b: a + b, co(), co())
+    assert next(cm) == 2
+    assert cm.send(2) == 4
+    with pytest.raises(ValueError):
+        cm.throw(ValueError)
+    cm.close()
+
+    stats = cm.stats()
+    assert stats['sends'] == 2
+    assert stats['throws'] == 1
+    assert stats['closes'] == 1
+    assert stats['stops'] == 0
+    assert stats['child_ns'] > 0
+    assert stats['func_ns'] > 0
+
+
+@requires_stats
+def test_cozip_stats():
+    cz = cozip((1,), (1, 2))
+    assert tuple(cz) == ((1, 1),)
+
+    stats = cz.stats()
+    assert stats['sends'] == 2
+    assert stats['stops'] == 1
+    assert stats['child_ns'] > 0
+    assert stats['func_ns'] == 0
@@ -0,0 +1,67 @@
+from shutil import which
+import subprocess
+
+import pytest
+
+from cotoolz import (
+    _coaggregate,
+    _cochain,
+    _cochannel,
+    _coiter,
+    _cointerleave,
+    _comap,
+    _comerge,
+    _copartition,
+    _coprefetch,
+    _coroute,
+    _coscheduler,
+    _coshm,
+    _cowindow,
+    _cozip,
+    usdt_enabled,
+)
+
+
+pytestmark = [
+    pytest.mark.skipif(
+        not usdt_enabled,
+        reason='cotoolz was compiled without COTOOLZ_USDT',
+    ),
+    pytest.mark.skipif(not which('readelf'), reason='readelf is required'),
+]
+
+
+@pytest.mark.parametrize('module,name', [
+    (_coiter, 'coiter'),
+    (_comap, 'comap'),
+    (_cozip, 'cozip'),
+    (_comerge, 'comerge'),
+    (_cointerleave, 'cointerleave'),
+    (_coroute, 'coroute'),
+    (_copartition, 'copartition'),
+    (_cowindow, 'cowindow'),
+    (_coaggregate, 'coaggregate'),
+    (_cochain, 'cochain'),
+    (_coprefetch, 'coprefetch'),
+    (_cochannel, 'cochannel'),
+    (_coshm, 'coshm'),
+])
+def test_probes_exist(module, name):
+    notes = subprocess.check_output(
+        ['readelf', '-n', module.__file__],
+        universal_newlines=True,
+    )
+    assert 'stapsdt' in notes
+    for op in ('send', 'throw', 'close'):
+        for point in ('entry', 'return'):
+            assert 'Name: %s_%s_%s\n' % (name, op, point) in notes
+
+
+def test_coscheduler_probes_exist():
+    notes = subprocess.check_output(
+        ['readelf', '-n', _coscheduler.__file__],
+        universal_newlines=True,
+    )
+    for op in ('send', 'close'):
+        for point in ('entry', 'return'):
+            assert 'Name: cotask_%s_%s\n' % (op, point) in notes
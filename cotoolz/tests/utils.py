@@ -0,0 +1,17 @@
+"""Helpers shared between the tests.
+"""
+
+
+def recording(values, sent):
+    """A coroutine which yields each of ``values`` and appends everything
+    sent into it to ``sent``.
+    """
+    for v in values:
+        sent.append((yield v))
+
+
+def primed(g):
+    """Advance a generator to its first ``yield`` so it can be sent into.
+    """
+    next(g)
+    return g
@@ -1,10 +1,21 @@
 #!/usr/bin/env python
+import os
+
 from setuptools import setup, Extension
 
 
 with open('README.rst') as f:
     long_description = f.read()
 
+define_macros = []
+if os.environ.get('COTOOLZ_STATS'):
+    # compile in the per-node runtime counters exposed through ``stats()``
+    define_macros.append(('COTOOLZ_STATS', None))
+if os.environ.get('COTOOLZ_USDT'):
+    # compile in the USDT probes on the send/throw/close paths, this requires
+    # ``sys/sdt.h`` from systemtap
+    define_macros.append(('COTOOLZ_USDT', None))
+
 setup(
     name='cotoolz',
     version='0.1.6',
@@ -12,6 +23,7 @@ setup(
     author='Joe Jevnik',
     author_email='joejev@gmail.com',
     packages=['cotoolz'],
+    python_requires='>=3.9',
     include_package_data=True,
     long_description=long_description,
     license='GPL-2',
@@ -21,8 +33,11 @@ setup(
         'Intended Audience :: Developers',
         'Natural Language :: English',
         'Programming Language :: Python :: 3 :: Only',
-        'Programming Language :: Python :: 3.4',
-        'Programming Language :: Python :: 3.5',
+        'Programming Language :: Python :: 3.9',
+        'Programming Language :: Python :: 3.10',
+        'Programming Language :: Python :: 3.11',
+        'Programming Language :: Python :: 3.12',
+        'Programming Language :: Python :: 3.13',
         'Programming Language :: Python :: Implementation :: CPython',
         'Operating System :: POSIX',
         'Topic :: Software Development',
@@ -34,21 +49,97 @@ setup(
             'cotoolz._emptycoroutine',
             ['cotoolz/_emptycoroutine.c'],
             include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
         ),
         Extension(
             'cotoolz._coiter',
             ['cotoolz/_coiter.c'],
             include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
         ),
         Extension(
             'cotoolz._comap',
             ['cotoolz/_comap.c'],
             include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
         ),
         Extension(
             'cotoolz._cozip',
             ['cotoolz/_cozip.c'],
             include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._comerge',
+            ['cotoolz/_comerge.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._cointerleave',
+            ['cotoolz/_cointerleave.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._coroute',
+            ['cotoolz/_coroute.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._copartition',
+            ['cotoolz/_copartition.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._cochain',
+            ['cotoolz/_cochain.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._coaggregate',
+            ['cotoolz/_coaggregate.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._cochannel',
+            ['cotoolz/_cochannel.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._copool',
+            ['cotoolz/_copool.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._coprefetch',
+            ['cotoolz/_coprefetch.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._coscheduler',
+            ['cotoolz/_coscheduler.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._coshm',
+            ['cotoolz/_coshm.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
+        ),
+        Extension(
+            'cotoolz._cowindow',
+            ['cotoolz/_cowindow.c'],
+            include_dirs=['cotoolz/include'],
+            define_macros=define_macros,
         ),
     ],
     install_requires=[